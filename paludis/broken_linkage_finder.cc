@@ -36,6 +36,7 @@
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/join.hh>
+#include <paludis/util/task_scheduler.hh>
 
 #include <paludis/contents.hh>
 #include <paludis/environment.hh>
@@ -74,6 +75,7 @@ namespace paludis
         std::set<FSPath, FSPathComparator> extra_lib_dirs;
 
         std::mutex mutex;
+        TaskScheduler * scheduler;
 
         bool has_files;
         Files files;
@@ -85,6 +87,7 @@ namespace paludis
 
         void walk_directory(const FSPath &);
         void check_file(const FSPath &);
+        void check_regular_file(const FSPath &);
 
         void add_breakage(const FSPath &, const std::string &);
         void gather_package(const std::shared_ptr<const PackageID> &);
@@ -93,6 +96,7 @@ namespace paludis
             env(the_env),
             config(the_env->preferred_root_key()->parse_value()),
             libraries(the_libraries),
+            scheduler(nullptr),
             has_files(false)
         {
         }
@@ -141,13 +145,20 @@ namespace
 }
 
 BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::shared_ptr<const Sequence<std::string>> & libraries) :
+    BrokenLinkageFinder(env, libraries, nullptr)
+{
+}
+
+BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::shared_ptr<const Sequence<std::string>> & libraries,
+        const std::shared_ptr<const FSPath> & maybe_cache_file) :
     _imp(env, libraries)
 {
     using namespace std::placeholders;
 
     Context ctx("When checking for broken linkage in '" + stringify(env->preferred_root_key()->parse_value()) + "':");
 
-    _imp->checkers.push_back(std::shared_ptr<LinkageChecker>(std::make_shared<ElfLinkageChecker>(env->preferred_root_key()->parse_value(), libraries)));
+    auto elf_checker(std::make_shared<ElfLinkageChecker>(env->preferred_root_key()->parse_value(), libraries, maybe_cache_file));
+    _imp->checkers.push_back(elf_checker);
     if (libraries->empty())
         _imp->checkers.push_back(std::shared_ptr<LinkageChecker>(std::make_shared<LibtoolLinkageChecker>(env->preferred_root_key()->parse_value())));
 
@@ -171,8 +182,18 @@ BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::sha
                    std::inserter(_imp->extra_lib_dirs, _imp->extra_lib_dirs.begin()),
                    std::bind(realpath_with_current_and_root, _1, FSPath("/"), env->preferred_root_key()->parse_value()));
 
-    std::for_each(search_dirs_pruned.begin(), search_dirs_pruned.end(),
-                      std::bind(&Imp<BrokenLinkageFinder>::search_directory, _imp.get(), _1));
+    {
+        /* subdirectories and files are handed to the scheduler as we find
+         * them, so both the walk and the checking happen in parallel */
+        TaskScheduler scheduler;
+        _imp->scheduler = &scheduler;
+        std::for_each(search_dirs_pruned.begin(), search_dirs_pruned.end(),
+                          std::bind(&Imp<BrokenLinkageFinder>::search_directory, _imp.get(), _1));
+        scheduler.wait();
+        _imp->scheduler = nullptr;
+    }
+
+    elf_checker->save_cache();
 
     for (std::set<FSPath>::const_iterator it(_imp->extra_lib_dirs.begin()),
              it_end(_imp->extra_lib_dirs.end()); it_end != it; ++it)
@@ -272,18 +293,31 @@ Imp<BrokenLinkageFinder>::check_file(const FSPath & file)
         }
 
         else if (file_stat.is_directory())
-            walk_directory(file);
+            scheduler->post(std::bind(&Imp<BrokenLinkageFinder>::walk_directory, this, file));
 
         else if (file_stat.is_regular_file())
-        {
-            env->trigger_notifier_callback(NotifierCallbackLinkageStepEvent(file));
+            scheduler->post(std::bind(&Imp<BrokenLinkageFinder>::check_regular_file, this, file));
+    }
+    catch (const FSError & ex)
+    {
+        Log::get_instance()->message("broken_linkage_finder.failure", ll_warning, lc_no_context) << ex.message();
+    }
+}
 
-            if (indirect_iterator(checkers.end()) ==
-                    std::find_if(indirect_iterator(checkers.begin()), indirect_iterator(checkers.end()),
-                        std::bind(&LinkageChecker::check_file, _1, file)))
-                Log::get_instance()->message("broken_linkage_finder.unrecognised", ll_debug, lc_context)
-                    << "'" << file << "' is not a recognised file type";
-        }
+void
+Imp<BrokenLinkageFinder>::check_regular_file(const FSPath & file)
+{
+    using namespace std::placeholders;
+
+    try
+    {
+        env->trigger_notifier_callback(NotifierCallbackLinkageStepEvent(file));
+
+        if (indirect_iterator(checkers.end()) ==
+                std::find_if(indirect_iterator(checkers.begin()), indirect_iterator(checkers.end()),
+                    std::bind(&LinkageChecker::check_file, _1, file)))
+            Log::get_instance()->message("broken_linkage_finder.unrecognised", ll_debug, lc_context)
+                << "'" << file << "' is not a recognised file type";
     }
     catch (const FSError & ex)
     {
@@ -40,6 +40,16 @@ namespace paludis
 
         public:
             BrokenLinkageFinder(const Environment *, const std::shared_ptr<const Sequence<std::string>> &);
+
+            /**
+             * If maybe_cache_file is not null, information about ELF files is
+             * kept there between runs, and only files which have changed are
+             * parsed again.
+             *
+             * \since 2.4
+             */
+            BrokenLinkageFinder(const Environment *, const std::shared_ptr<const Sequence<std::string>> &,
+                    const std::shared_ptr<const FSPath> & maybe_cache_file);
             ~BrokenLinkageFinder();
 
             BrokenLinkageFinder(const BrokenLinkageFinder &) = delete;
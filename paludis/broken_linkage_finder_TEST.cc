@@ -0,0 +1,186 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/broken_linkage_finder.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+
+#include <paludis/package_id.hh>
+
+#include <fcntl.h>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    const FSPath dir(FSPath::cwd() / "broken_linkage_finder_TEST_dir");
+    const FSPath binary(dir / "root" / "usr" / "bin" / "binary");
+
+    std::string broken(const std::shared_ptr<const FSPath> & maybe_cache_file)
+    {
+        TestEnvironment env(dir / "root");
+        BrokenLinkageFinder finder(&env, std::make_shared<Sequence<std::string>>(), maybe_cache_file);
+
+        std::string result;
+        for (auto p(finder.begin_broken_packages()), p_end(finder.end_broken_packages()) ; p != p_end ; ++p)
+            result.append(stringify(**p) + " ");
+
+        std::shared_ptr<const PackageID> no_package;
+        for (auto f(finder.begin_broken_files(no_package)), f_end(finder.end_broken_files(no_package)) ; f != f_end ; ++f)
+            result.append(stringify(*f) + ": " + join(finder.begin_missing_requirements(no_package, *f),
+                        finder.end_missing_requirements(no_package, *f), " ") + "; ");
+
+        return result;
+    }
+
+    std::string read(const FSPath & f)
+    {
+        SafeIFStream s(f);
+        return std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    }
+
+    void write(const FSPath & f, const std::string & contents, const int flags)
+    {
+        SafeOFStream s(f, O_CREAT | O_WRONLY | flags, true);
+        s << contents;
+    }
+
+    /* claim that our binary needs another library, so we can tell whether
+     * what is stored in the cache is being used */
+    std::string tampered(const std::string & cache)
+    {
+        std::string::size_type p(cache.find(stringify(binary) + "\t"));
+        EXPECT_NE(std::string::npos, p);
+        p = cache.find('\n', p);
+        EXPECT_NE(std::string::npos, p);
+        return cache.substr(0, p) + "\tlibtampered.so.1" + cache.substr(p);
+    }
+}
+
+TEST(BrokenLinkageFinder, Cache)
+{
+    std::shared_ptr<const FSPath> cache_file(std::make_shared<FSPath>(dir / "cache"));
+
+    std::string uncached(broken(nullptr));
+    EXPECT_NE(std::string::npos, uncached.find("/usr/bin/binary: "));
+    EXPECT_NE(std::string::npos, uncached.find("libc.so.6"));
+    EXPECT_FALSE(cache_file->stat().exists());
+
+    EXPECT_EQ(uncached, broken(cache_file));
+    ASSERT_TRUE(cache_file->stat().is_regular_file());
+    std::string cache(read(*cache_file));
+    EXPECT_NE(std::string::npos, cache.find(stringify(binary) + "\t"));
+
+    EXPECT_EQ(uncached, broken(cache_file));
+    EXPECT_EQ(cache, read(*cache_file));
+
+    write(*cache_file, tampered(cache), O_TRUNC);
+    std::string from_cache(broken(cache_file));
+    EXPECT_NE(uncached, from_cache);
+    EXPECT_NE(std::string::npos, from_cache.find("libtampered.so.1"));
+}
+
+TEST(BrokenLinkageFinder, CacheMtimeChanged)
+{
+    std::shared_ptr<const FSPath> cache_file(std::make_shared<FSPath>(dir / "cache-mtime"));
+
+    std::string uncached(broken(nullptr));
+    EXPECT_EQ(uncached, broken(cache_file));
+    write(*cache_file, tampered(read(*cache_file)), O_TRUNC);
+    EXPECT_NE(std::string::npos, broken(cache_file).find("libtampered.so.1"));
+
+    Timestamp mtime(binary.stat().mtim());
+    ASSERT_TRUE(binary.utime(Timestamp(mtime.seconds() + 10, mtime.nanoseconds())));
+    EXPECT_EQ(uncached, broken(cache_file));
+    EXPECT_EQ(std::string::npos, read(*cache_file).find("libtampered.so.1"));
+}
+
+TEST(BrokenLinkageFinder, CacheSizeChanged)
+{
+    std::shared_ptr<const FSPath> cache_file(std::make_shared<FSPath>(dir / "cache-size"));
+
+    std::string uncached(broken(nullptr));
+    EXPECT_EQ(uncached, broken(cache_file));
+    write(*cache_file, tampered(read(*cache_file)), O_TRUNC);
+    EXPECT_NE(std::string::npos, broken(cache_file).find("libtampered.so.1"));
+
+    /* keep the mtime as it was, so only the size tells us to look again */
+    Timestamp mtime(binary.stat().mtim());
+    write(binary, "trailing junk", O_APPEND);
+    ASSERT_TRUE(binary.utime(mtime));
+    ASSERT_TRUE(binary.stat().mtim() == mtime);
+    EXPECT_EQ(uncached, broken(cache_file));
+    EXPECT_EQ(std::string::npos, read(*cache_file).find("libtampered.so.1"));
+}
+
+TEST(BrokenLinkageFinder, CacheTruncated)
+{
+    std::shared_ptr<const FSPath> cache_file(std::make_shared<FSPath>(dir / "cache-truncated"));
+
+    std::string uncached(broken(nullptr));
+    EXPECT_EQ(uncached, broken(cache_file));
+
+    /* cut off part way through the name of the extra library, which would
+     * give us a bogus 'libtamp' if we believed it */
+    std::string cache(tampered(read(*cache_file)));
+    std::string::size_type p(cache.find("libtampered.so.1"));
+    ASSERT_NE(std::string::npos, p);
+    write(*cache_file, cache.substr(0, p + 7), O_TRUNC);
+
+    std::string result;
+    EXPECT_NO_THROW(result = broken(cache_file));
+    EXPECT_EQ(uncached, result);
+    EXPECT_EQ(std::string::npos, read(*cache_file).find("libtamp"));
+}
+
+TEST(BrokenLinkageFinder, CacheCorrupt)
+{
+    std::shared_ptr<const FSPath> cache_file(std::make_shared<FSPath>(dir / "cache-corrupt"));
+
+    std::string uncached(broken(nullptr));
+    EXPECT_EQ(uncached, broken(cache_file));
+
+    write(*cache_file, tampered(read(*cache_file)) + "this\tis\tnot\ta\tcache\tentry\n", O_TRUNC);
+    std::string result;
+    EXPECT_NO_THROW(result = broken(cache_file));
+    EXPECT_EQ(uncached, result);
+    EXPECT_EQ(std::string::npos, read(*cache_file).find("libtampered.so.1"));
+
+    write(*cache_file, "rubbish\n" + tampered(read(*cache_file)), O_TRUNC);
+    EXPECT_NO_THROW(result = broken(cache_file));
+    EXPECT_EQ(uncached, result);
+
+    write(*cache_file, "", O_TRUNC);
+    EXPECT_NO_THROW(result = broken(cache_file));
+    EXPECT_EQ(uncached, result);
+}
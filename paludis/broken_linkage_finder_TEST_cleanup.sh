@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+if [ -d broken_linkage_finder_TEST_dir ] ; then
+    rm -fr broken_linkage_finder_TEST_dir
+else
+    true
+fi
+
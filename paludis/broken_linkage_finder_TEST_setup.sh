@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir broken_linkage_finder_TEST_dir || exit 1
+cd broken_linkage_finder_TEST_dir || exit 1
+
+mkdir -p root/etc root/usr/bin root/usr/lib || exit 2
+touch root/etc/ld.so.conf || exit 3
+
+# any dynamically linked binary will do, since nothing it needs is inside
+# our root
+cp ../stripper_TEST_binary root/usr/bin/binary || exit 4
+
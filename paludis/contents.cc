@@ -20,13 +20,19 @@
 #include <paludis/contents.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/exception.hh>
 #include <paludis/literal_metadata_key.hh>
-#include <list>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <limits>
 
 using namespace paludis;
 
-typedef std::list<std::shared_ptr<const ContentsEntry> > Entries;
-
 namespace paludis
 {
     template <>
@@ -150,18 +156,205 @@ ContentsSymEntry::part_key() const
     return _imp->part_key;
 }
 
+namespace
+{
+    enum CompactEntryKind
+    {
+        cek_full,
+        cek_file,
+        cek_dir,
+        cek_sym,
+        cek_other
+    };
+
+    const unsigned no_dir(std::numeric_limits<unsigned>::max());
+
+    /* an entry as added by one of the compact add methods. strings are
+     * offsets into the owning Contents' string arena, and the path is split
+     * into a directory, shared with every other entry in that directory, and
+     * a name. */
+    struct CompactEntry
+    {
+        CompactEntryKind kind;
+        bool is_volatile;
+        unsigned dir;
+        unsigned name;
+        unsigned target;
+        unsigned part;
+        unsigned md5;
+        time_t mtime_seconds;
+        long mtime_nanoseconds;
+    };
+}
+
 namespace paludis
 {
     template<>
     struct Imp<Contents>
     {
-        Entries c;
+        std::vector<CompactEntry> compact_entries;
+
+        /* entries added with add, and compact entries once they have been
+         * looked at. always the same size as compact_entries, so that
+         * iterators can hand out references. */
+        mutable std::vector<std::shared_ptr<const ContentsEntry> > entries;
+        mutable std::mutex entries_mutex;
+
+        /* NUL terminated strings, with offset zero being the empty string */
+        std::string strings;
+
+        std::unordered_map<std::string, unsigned, Hash<std::string> > dir_indices;
+        std::vector<const std::string *> dirs;
+
+        Imp() :
+            strings(1, '\0')
+        {
+        }
+
+        unsigned add_string(const std::string & s)
+        {
+            if (s.empty())
+                return 0;
+
+            unsigned result(strings.length());
+            strings.append(s.c_str(), s.length() + 1);
+            return result;
+        }
+
+        const char * string_at(unsigned offset) const
+        {
+            return strings.c_str() + offset;
+        }
+
+        CompactEntry & add_compact(const CompactEntryKind kind, const FSPath & f)
+        {
+            std::string path(stringify(f));
+            std::string::size_type p(path.rfind('/'));
+
+            unsigned dir(no_dir), name;
+            if (std::string::npos == p)
+                name = add_string(path);
+            else
+            {
+                auto d(dir_indices.find(path.substr(0, p)));
+                if (d == dir_indices.end())
+                {
+                    d = dir_indices.insert(std::make_pair(path.substr(0, p), dirs.size())).first;
+                    dirs.push_back(&d->first);
+                }
+                dir = d->second;
+                name = add_string(path.substr(p + 1));
+            }
+
+            compact_entries.push_back(CompactEntry{ kind, false, dir, name, 0, 0, 0, 0, 0 });
+            entries.push_back(nullptr);
+            return compact_entries.back();
+        }
+
+        FSPath path_of(const CompactEntry & e) const
+        {
+            if (no_dir == e.dir)
+                return FSPath(string_at(e.name));
+            else
+                return FSPath(*dirs[e.dir] + "/" + string_at(e.name));
+        }
+
+        std::shared_ptr<const ContentsEntry> make_entry(const CompactEntry & e) const
+        {
+            switch (e.kind)
+            {
+                case cek_file:
+                    {
+                        auto result(std::make_shared<ContentsFileEntry>(path_of(e), string_at(e.part)));
+                        result->add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string>>("md5", "md5", mkt_normal, string_at(e.md5)));
+                        result->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
+                                    Timestamp(e.mtime_seconds, e.mtime_nanoseconds)));
+                        if (e.is_volatile)
+                            result->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, true));
+                        return result;
+                    }
+
+                case cek_dir:
+                    return std::make_shared<ContentsDirEntry>(path_of(e));
+
+                case cek_sym:
+                    {
+                        auto result(std::make_shared<ContentsSymEntry>(path_of(e), string_at(e.target), string_at(e.part)));
+                        result->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
+                                    Timestamp(e.mtime_seconds, e.mtime_nanoseconds)));
+                        if (e.is_volatile)
+                            result->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, true));
+                        return result;
+                    }
+
+                case cek_other:
+                    return std::make_shared<ContentsOtherEntry>(path_of(e));
+
+                case cek_full:
+                    break;
+            }
+
+            throw InternalError(PALUDIS_HERE, "Bad CompactEntryKind");
+        }
+
+        const std::shared_ptr<const ContentsEntry> & entry(unsigned n) const
+        {
+            std::unique_lock<std::mutex> lock(entries_mutex);
+            if (! entries[n])
+                entries[n] = make_entry(compact_entries[n]);
+            return entries[n];
+        }
     };
+}
+
+namespace
+{
+    struct ContentsUnderlyingIterator
+    {
+        const Imp<Contents> * imp;
+        unsigned n;
 
+        ContentsUnderlyingIterator() :
+            imp(nullptr),
+            n(0)
+        {
+        }
+
+        ContentsUnderlyingIterator(const Imp<Contents> * const i, const unsigned m) :
+            imp(i),
+            n(m)
+        {
+        }
+
+        const std::shared_ptr<const ContentsEntry> & operator* () const
+        {
+            return imp->entry(n);
+        }
+
+        const std::shared_ptr<const ContentsEntry> * operator-> () const
+        {
+            return &imp->entry(n);
+        }
+
+        ContentsUnderlyingIterator & operator++ ()
+        {
+            ++n;
+            return *this;
+        }
+
+        bool operator== (const ContentsUnderlyingIterator & other) const
+        {
+            return n == other.n;
+        }
+    };
+}
+
+namespace paludis
+{
     template <>
     struct WrappedForwardIteratorTraits<Contents::ConstIteratorTag>
     {
-        typedef Entries::const_iterator UnderlyingIterator;
+        typedef ContentsUnderlyingIterator UnderlyingIterator;
     };
 }
 
@@ -177,19 +370,56 @@ Contents::~Contents()
 void
 Contents::add(const std::shared_ptr<const ContentsEntry> & c)
 {
-    _imp->c.push_back(c);
+    _imp->compact_entries.push_back(CompactEntry{ cek_full, false, no_dir, 0, 0, 0, 0, 0, 0 });
+    _imp->entries.push_back(c);
+}
+
+void
+Contents::add_file(const FSPath & f, const std::string & part, const std::string & md5,
+        const Timestamp & mtime, const bool is_volatile)
+{
+    CompactEntry & e(_imp->add_compact(cek_file, f));
+    e.part = _imp->add_string(part);
+    e.md5 = _imp->add_string(md5);
+    e.mtime_seconds = mtime.seconds();
+    e.mtime_nanoseconds = mtime.nanoseconds();
+    e.is_volatile = is_volatile;
+}
+
+void
+Contents::add_dir(const FSPath & f)
+{
+    _imp->add_compact(cek_dir, f);
+}
+
+void
+Contents::add_sym(const FSPath & f, const std::string & target, const std::string & part,
+        const Timestamp & mtime, const bool is_volatile)
+{
+    CompactEntry & e(_imp->add_compact(cek_sym, f));
+    e.target = _imp->add_string(target);
+    e.part = _imp->add_string(part);
+    e.mtime_seconds = mtime.seconds();
+    e.mtime_nanoseconds = mtime.nanoseconds();
+    e.is_volatile = is_volatile;
+}
+
+void
+Contents::add_other(const FSPath & f)
+{
+    _imp->add_compact(cek_other, f);
 }
 
 Contents::ConstIterator
 Contents::begin() const
 {
-    return ConstIterator(_imp->c.begin());
+    return ConstIterator(ContentsUnderlyingIterator(_imp.get(), 0));
 }
 
 Contents::ConstIterator
 Contents::end() const
 {
-    return ConstIterator(_imp->c.end());
+    return ConstIterator(ContentsUnderlyingIterator(_imp.get(), _imp->compact_entries.size()));
 }
 
 namespace paludis
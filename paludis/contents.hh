@@ -26,6 +26,7 @@
 #include <paludis/util/type_list.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/fs_path-fwd.hh>
+#include <paludis/util/timestamp-fwd.hh>
 #include <paludis/metadata_key_holder.hh>
 #include <memory>
 #include <string>
@@ -232,6 +233,47 @@ namespace paludis
             /// Add a new entry.
             void add(const std::shared_ptr<const ContentsEntry> & c);
 
+            ///\name Add entries compactly
+            ///\{
+
+            /**
+             * Add a file entry, with md5 and mtime keys, and a volatile key
+             * if it is volatile.
+             *
+             * Entries added this way are held in a compact form, and are only
+             * turned into ContentsEntry instances when they are iterated
+             * over.
+             *
+             * \since 2.4
+             */
+            void add_file(const FSPath &, const std::string & part, const std::string & md5,
+                    const Timestamp & mtime, const bool is_volatile);
+
+            /**
+             * Add a directory entry, compactly.
+             *
+             * \since 2.4
+             */
+            void add_dir(const FSPath &);
+
+            /**
+             * Add a sym entry, with an mtime key, and a volatile key if it is
+             * volatile, compactly.
+             *
+             * \since 2.4
+             */
+            void add_sym(const FSPath &, const std::string & target, const std::string & part,
+                    const Timestamp & mtime, const bool is_volatile);
+
+            /**
+             * Add an other entry, compactly.
+             *
+             * \since 2.4
+             */
+            void add_other(const FSPath &);
+
+            ///\}
+
             ///\name Iterate over our entries
             ///\{
 
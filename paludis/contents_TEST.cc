@@ -0,0 +1,118 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/contents.hh>
+#include <paludis/metadata_key.hh>
+
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/visitor_cast.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    std::string value_of(const ContentsEntry & e, const std::string & k)
+    {
+        auto i(e.find_metadata(k));
+        if (i == e.end_metadata())
+            return "(none)";
+
+        if (auto s = visitor_cast<const MetadataValueKey<std::string> >(**i))
+            return s->parse_value();
+        else if (auto t = visitor_cast<const MetadataTimeKey>(**i))
+            return stringify(t->parse_value().seconds());
+        else if (auto b = visitor_cast<const MetadataValueKey<bool> >(**i))
+            return stringify(b->parse_value());
+        return "(unknown)";
+    }
+}
+
+TEST(Contents, Compact)
+{
+    Contents c;
+    c.add_dir(FSPath("/"));
+    c.add_dir(FSPath("/usr"));
+    c.add_dir(FSPath("/usr/bin"));
+    c.add_file(FSPath("/usr/bin/foo"), "", "abc123", Timestamp(1234, 0), false);
+    c.add_sym(FSPath("/usr/bin/bar"), "foo", "runtime", Timestamp(5678, 0), true);
+    c.add(std::make_shared<ContentsOtherEntry>(FSPath("/usr/bin/fifo")));
+    c.add_other(FSPath("/usr/bin/dev"));
+    c.add_file(FSPath("/usr/bin/baz"), "docs", "def456", Timestamp(9012, 0), true);
+
+    std::string types, paths;
+    for (auto i(c.begin()), i_end(c.end()) ; i != i_end ; ++i)
+    {
+        if (visitor_cast<const ContentsFileEntry>(**i))
+            types.append("f");
+        else if (visitor_cast<const ContentsDirEntry>(**i))
+            types.append("d");
+        else if (visitor_cast<const ContentsSymEntry>(**i))
+            types.append("s");
+        else if (visitor_cast<const ContentsOtherEntry>(**i))
+            types.append("o");
+
+        paths.append(stringify((*i)->location_key()->parse_value()) + " ");
+    }
+
+    EXPECT_EQ("dddfsoof", types);
+    EXPECT_EQ("/ /usr /usr/bin /usr/bin/foo /usr/bin/bar /usr/bin/fifo /usr/bin/dev /usr/bin/baz ", paths);
+
+    auto i(c.begin());
+    std::advance(i, 3);
+    const ContentsFileEntry * file(visitor_cast<const ContentsFileEntry>(**i));
+    ASSERT_TRUE(file);
+    EXPECT_FALSE(file->part_key());
+    EXPECT_EQ("abc123", value_of(*file, "md5"));
+    EXPECT_EQ("1234", value_of(*file, "mtime"));
+    EXPECT_EQ("(none)", value_of(*file, "volatile"));
+
+    ++i;
+    const ContentsSymEntry * sym(visitor_cast<const ContentsSymEntry>(**i));
+    ASSERT_TRUE(sym);
+    EXPECT_EQ("foo", sym->target_key()->parse_value());
+    ASSERT_TRUE(sym->part_key());
+    EXPECT_EQ("runtime", sym->part_key()->parse_value());
+    EXPECT_EQ("5678", value_of(*sym, "mtime"));
+    EXPECT_EQ("true", value_of(*sym, "volatile"));
+
+    std::advance(i, 3);
+    const ContentsFileEntry * baz(visitor_cast<const ContentsFileEntry>(**i));
+    ASSERT_TRUE(baz);
+    ASSERT_TRUE(baz->part_key());
+    EXPECT_EQ("docs", baz->part_key()->parse_value());
+    EXPECT_EQ("def456", value_of(*baz, "md5"));
+    EXPECT_EQ("true", value_of(*baz, "volatile"));
+}
+
+TEST(Contents, SameEntries)
+{
+    Contents c;
+    c.add_file(FSPath("/foo"), "", "abc123", Timestamp(1234, 0), false);
+
+    auto a(*c.begin()), b(*c.begin());
+    EXPECT_EQ(a, b);
+    EXPECT_TRUE(c.begin()++ == c.begin());
+    EXPECT_TRUE(++c.begin() == c.end());
+}
+
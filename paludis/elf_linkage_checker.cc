@@ -35,8 +35,14 @@
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/destringify.hh>
 
 #include <algorithm>
 #include <cerrno>
@@ -45,6 +51,7 @@
 #include <set>
 #include <vector>
 #include <mutex>
+#include <unordered_map>
 
 using namespace paludis;
 
@@ -75,6 +82,14 @@ namespace
             return arch;
         }
 
+        ElfArchitecture(const unsigned machine, const unsigned char elf_class, const bool bigendian, const bool mips_n32) :
+            _machine(machine),
+            _class(elf_class),
+            _bigendian(bigendian),
+            _mips_n32(mips_n32)
+        {
+        }
+
         template <typename ElfType_>
         ElfArchitecture(const ElfObject<ElfType_> & elf) :
             _machine(normalise_arch(elf.get_arch())),
@@ -96,6 +111,38 @@ namespace
             return _bigendian < other._bigendian;
         return _mips_n32 < other._mips_n32;
     }
+
+    enum ElfFileKind
+    {
+        efk_not_elf,
+        efk_other,
+        efk_executable,
+        efk_library
+    };
+
+    /* everything we need to know about a file, so that we can avoid parsing
+     * it again if it is in the cache */
+    struct ElfFileInfo
+    {
+        ElfFileKind kind;
+        ElfArchitecture arch;
+        std::vector<std::string> needed;
+    };
+
+    typedef std::unordered_map<std::string, std::pair<std::string, ElfFileInfo> > ElfCache;
+
+    const std::string cache_magic("paludis-elf-linkage-cache-1");
+
+    std::string signature(const FSStat & s)
+    {
+        return stringify(s.lowlevel_id().first) + ":" + stringify(s.lowlevel_id().second) + ":" +
+            stringify(s.mtim().seconds()) + "." + stringify(s.mtim().nanoseconds()) + ":" + stringify(s.file_size());
+    }
+
+    bool cacheable(const std::string & s)
+    {
+        return std::string::npos == s.find_first_of("\t\n");
+    }
 }
 
 typedef std::multimap<FSPath, FSPath, FSPathComparator> Symlinks;
@@ -108,6 +155,10 @@ namespace paludis
     {
         FSPath root;
         std::set<std::string> check_libraries;
+        std::shared_ptr<const FSPath> maybe_cache_file;
+
+        /* only read once loaded, so does not need the mutex */
+        ElfCache old_cache;
 
         std::mutex mutex;
 
@@ -117,14 +168,20 @@ namespace paludis
         std::map<ElfArchitecture, std::vector<std::string> > libraries;
         Needed needed;
 
+        ElfCache new_cache;
+
         std::vector<FSPath> extra_lib_dirs;
 
-        template <typename> bool check_elf(const FSPath &, std::istream &);
+        template <typename> bool read_elf(const FSPath &, const std::shared_ptr<const MappedFile> &, ElfFileInfo &, bool &);
+        void record(const FSPath &, const ElfFileInfo &, const std::string &);
         void handle_library(const FSPath &, const ElfArchitecture &);
-        template <typename> bool check_extra_elf(const FSPath &, std::istream &, std::set<ElfArchitecture> &);
+        template <typename> bool check_extra_elf(const FSPath &, const std::shared_ptr<const MappedFile> &, std::set<ElfArchitecture> &);
+        void load_cache();
 
-        Imp(const FSPath & the_root, const std::shared_ptr<const Sequence<std::string>> & the_libraries) :
-            root(the_root)
+        Imp(const FSPath & the_root, const std::shared_ptr<const Sequence<std::string>> & the_libraries,
+                const std::shared_ptr<const FSPath> & c) :
+            root(the_root),
+            maybe_cache_file(c)
         {
             for (auto it(the_libraries->begin()), it_end(the_libraries->end()); it_end != it; ++it)
                 check_libraries.insert(*it);
@@ -132,9 +189,12 @@ namespace paludis
     };
 }
 
-ElfLinkageChecker::ElfLinkageChecker(const FSPath & root, const std::shared_ptr<const Sequence<std::string>> & libraries) :
-    _imp(root, libraries)
+ElfLinkageChecker::ElfLinkageChecker(const FSPath & root, const std::shared_ptr<const Sequence<std::string>> & libraries,
+        const std::shared_ptr<const FSPath> & maybe_cache_file) :
+    _imp(root, libraries, maybe_cache_file)
 {
+    if (_imp->maybe_cache_file)
+        _imp->load_cache();
 }
 
 ElfLinkageChecker::~ElfLinkageChecker()
@@ -150,22 +210,51 @@ ElfLinkageChecker::check_file(const FSPath & file)
            (0 != (file.stat().permissions() & S_IXUSR))))
         return false;
 
-    SafeIFStream stream(file);
-    return _imp->check_elf<Elf32Type>(file, stream) || _imp->check_elf<Elf64Type>(file, stream);
+    std::string file_signature;
+    if (_imp->maybe_cache_file)
+    {
+        file_signature = signature(file.stat());
+        ElfCache::const_iterator c(_imp->old_cache.find(stringify(file)));
+        if (_imp->old_cache.end() != c && c->second.first == file_signature)
+        {
+            _imp->record(file, c->second.second, file_signature);
+            return efk_not_elf != c->second.second.kind;
+        }
+    }
+
+    ElfFileInfo info{ efk_not_elf, ElfArchitecture(0, 0, false, false), { } };
+    bool valid(true);
+    try
+    {
+        std::shared_ptr<const MappedFile> mapped(std::make_shared<MappedFile>(file));
+        if (! (_imp->read_elf<Elf32Type>(file, mapped, info, valid) || _imp->read_elf<Elf64Type>(file, mapped, info, valid)))
+            info.kind = efk_not_elf;
+    }
+    catch (const MappedFileError & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.failure", ll_warning, lc_no_context)
+            << "Error reading '" << file << "': '" << e.message() << "' (" << e.what() << ")";
+        return false;
+    }
+
+    _imp->record(file, info, valid ? file_signature : "");
+    return efk_not_elf != info.kind;
 }
 
 template <typename ElfType_>
 bool
-Imp<ElfLinkageChecker>::check_elf(const FSPath & file, std::istream & stream)
+Imp<ElfLinkageChecker>::read_elf(const FSPath & file, const std::shared_ptr<const MappedFile> & mapped, ElfFileInfo & info, bool & valid)
 {
-    if (! ElfObject<ElfType_>::is_valid_elf(stream))
+    if (! ElfObject<ElfType_>::is_valid_elf(*mapped))
         return false;
 
+    info.kind = efk_other;
+
     try
     {
         Context ctx("When checking '" + stringify(file) + "' as a " +
                     stringify<int>(ElfType_::elf_class * 32) + "-bit ELF file:");
-        ElfObject<ElfType_> elf(stream);
+        ElfObject<ElfType_> elf(mapped);
         if (ET_EXEC != elf.get_type() && ET_DYN != elf.get_type())
         {
             Log::get_instance()->message("broken_linkage_finder.not_interesting", ll_debug, lc_context)
@@ -173,14 +262,9 @@ Imp<ElfLinkageChecker>::check_elf(const FSPath & file, std::istream & stream)
             return true;
         }
 
-        ElfArchitecture arch(elf);
+        info.arch = ElfArchitecture(elf);
         elf.resolve_all_strings();
 
-        std::unique_lock<std::mutex> l(mutex);
-
-        if (check_libraries.empty() && ET_DYN == elf.get_type())
-            handle_library(file, arch);
-
         for (typename ElfObject<ElfType_>::SectionIterator sec_it(elf.section_begin()),
                  sec_it_end(elf.section_end()); sec_it_end != sec_it; ++sec_it)
         {
@@ -193,27 +277,149 @@ Imp<ElfLinkageChecker>::check_elf(const FSPath & file, std::istream & stream)
                     const DynamicEntryString<ElfType_> * ent_str(visitor_cast<const DynamicEntryString<ElfType_> >(*ent_it));
 
                     if (nullptr != ent_str && "NEEDED" == ent_str->tag_name())
-                    {
-                        const std::string & req((*ent_str)());
-                        if (check_libraries.empty() || check_libraries.end() != check_libraries.find(req))
-                        {
-                            Log::get_instance()->message("broken_linkage_finder.depends", ll_debug, lc_context)
-                                << "File depends on " << req;
-                            needed[arch][req].push_back(file);
-                        }
-                    }
+                        info.needed.push_back((*ent_str)());
                 }
         }
+
+        info.kind = ET_DYN == elf.get_type() ? efk_library : efk_executable;
     }
     catch (const InvalidElfFileError & e)
     {
         Log::get_instance()->message("broken_linkage_finder.invalid", ll_warning, lc_no_context)
             << "'" << file << "' appears to be invalid or corrupted: " << e.message();
+        info.kind = efk_other;
+        info.needed.clear();
+        valid = false;
     }
 
     return true;
 }
 
+void
+Imp<ElfLinkageChecker>::record(const FSPath & file, const ElfFileInfo & info, const std::string & file_signature)
+{
+    std::unique_lock<std::mutex> l(mutex);
+
+    if ((! file_signature.empty()) && cacheable(stringify(file)) &&
+            info.needed.end() == std::find_if(info.needed.begin(), info.needed.end(),
+                [] (const std::string & n) { return ! cacheable(n); }))
+        new_cache.insert(std::make_pair(stringify(file), std::make_pair(file_signature, info)));
+
+    if (efk_executable != info.kind && efk_library != info.kind)
+        return;
+
+    if (check_libraries.empty() && efk_library == info.kind)
+        handle_library(file, info.arch);
+
+    for (std::vector<std::string>::const_iterator it(info.needed.begin()), it_end(info.needed.end()) ;
+            it_end != it ; ++it)
+        if (check_libraries.empty() || check_libraries.end() != check_libraries.find(*it))
+        {
+            Log::get_instance()->message("broken_linkage_finder.depends", ll_debug, lc_context)
+                << "'" << file << "' depends on " << *it;
+            needed[info.arch][*it].push_back(file);
+        }
+}
+
+void
+Imp<ElfLinkageChecker>::load_cache()
+{
+    Context ctx("When loading ELF cache '" + stringify(*maybe_cache_file) + "':");
+
+    if (! maybe_cache_file->stat().is_regular_file_or_symlink_to_regular_file())
+        return;
+
+    try
+    {
+        SafeIFStream file(*maybe_cache_file);
+
+        std::string line;
+        if ((! std::getline(file, line)) || cache_magic != line)
+        {
+            Log::get_instance()->message("broken_linkage_finder.cache.bad_format", ll_debug, lc_context)
+                << "Not using ELF cache '" << *maybe_cache_file << "' because it is not in a format we understand";
+            return;
+        }
+
+        while (std::getline(file, line))
+        {
+            /* a last line with no newline means we were cut off part way
+             * through writing an entry, so its list of needed libraries
+             * can't be trusted */
+            if (file.eof())
+                throw DestringifyError(line);
+
+            std::vector<std::string> tokens;
+            tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(line, "\t", "", std::back_inserter(tokens));
+            if (tokens.size() < 7 || destringify<unsigned>(tokens[2]) > efk_library)
+                throw DestringifyError(line);
+
+            ElfFileInfo info{
+                static_cast<ElfFileKind>(destringify<unsigned>(tokens[2])),
+                ElfArchitecture(destringify<unsigned>(tokens[3]), destringify<unsigned>(tokens[4]),
+                        0 != destringify<unsigned>(tokens[5]), 0 != destringify<unsigned>(tokens[6])),
+                std::vector<std::string>(std::next(tokens.begin(), 7), tokens.end())
+            };
+            old_cache.insert(std::make_pair(tokens[0], std::make_pair(tokens[1], info)));
+        }
+    }
+    catch (const SafeIFStreamError & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.cache.load_failure", ll_warning, lc_context)
+            << "Couldn't read ELF cache '" << *maybe_cache_file << "': " << e.message() << " (" << e.what() << ")";
+        old_cache.clear();
+    }
+    catch (const DestringifyError &)
+    {
+        Log::get_instance()->message("broken_linkage_finder.cache.bad_format", ll_debug, lc_context)
+            << "Not using ELF cache '" << *maybe_cache_file << "' because it is not in a format we understand";
+        old_cache.clear();
+    }
+}
+
+void
+ElfLinkageChecker::save_cache() const
+{
+    if (! _imp->maybe_cache_file)
+        return;
+
+    Context ctx("When saving ELF cache '" + stringify(*_imp->maybe_cache_file) + "':");
+
+    FSPath temp(stringify(*_imp->maybe_cache_file) + ".new");
+    try
+    {
+        {
+            SafeOFStream file(temp, -1, true);
+            file << cache_magic << '\n';
+
+            for (ElfCache::const_iterator c(_imp->new_cache.begin()), c_end(_imp->new_cache.end()) ;
+                    c_end != c ; ++c)
+            {
+                const ElfFileInfo & info(c->second.second);
+                file << c->first << '\t' << c->second.first << '\t' << static_cast<unsigned>(info.kind) << '\t'
+                    << info.arch._machine << '\t' << static_cast<unsigned>(info.arch._class) << '\t'
+                    << info.arch._bigendian << '\t' << info.arch._mips_n32;
+                for (std::vector<std::string>::const_iterator n(info.needed.begin()), n_end(info.needed.end()) ;
+                        n_end != n ; ++n)
+                    file << '\t' << *n;
+                file << '\n';
+            }
+        }
+
+        temp.rename(*_imp->maybe_cache_file);
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.cache.save_failure", ll_warning, lc_context)
+            << "Couldn't write ELF cache '" << *_imp->maybe_cache_file << "': " << e.message() << " (" << e.what() << ")";
+    }
+    catch (const FSError & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.cache.save_failure", ll_warning, lc_context)
+            << "Couldn't write ELF cache '" << *_imp->maybe_cache_file << "': " << e.message() << " (" << e.what() << ")";
+    }
+}
+
 void
 Imp<ElfLinkageChecker>::handle_library(const FSPath & file, const ElfArchitecture & arch)
 {
@@ -313,14 +519,14 @@ ElfLinkageChecker::need_breakage_added(
 
             try
             {
-                SafeIFStream stream(file);
+                std::shared_ptr<const MappedFile> mapped(std::make_shared<MappedFile>(file));
 
-                if (! (_imp->check_extra_elf<Elf32Type>(file, stream, missing_it->second) ||
-                       _imp->check_extra_elf<Elf64Type>(file, stream, missing_it->second)))
+                if (! (_imp->check_extra_elf<Elf32Type>(file, mapped, missing_it->second) ||
+                       _imp->check_extra_elf<Elf64Type>(file, mapped, missing_it->second)))
                     Log::get_instance()->message("broken_linkage_finder.not_an_elf", ll_debug, lc_no_context)
                         << "'" << file << "' is not an ELF file";
             }
-            catch (const SafeIFStreamError & e)
+            catch (const MappedFileError & e)
             {
                 Log::get_instance()->message("broken_linkage_finder.failure", ll_warning, lc_no_context)
                     << "Error opening '" << file << "': '" << e.message() << "' (" << e.what() << ")";
@@ -341,16 +547,16 @@ ElfLinkageChecker::need_breakage_added(
 
 template <typename ElfType_>
 bool
-Imp<ElfLinkageChecker>::check_extra_elf(const FSPath & file, std::istream & stream, std::set<ElfArchitecture> & arches)
+Imp<ElfLinkageChecker>::check_extra_elf(const FSPath & file, const std::shared_ptr<const MappedFile> & mapped, std::set<ElfArchitecture> & arches)
 {
-    if (! ElfObject<ElfType_>::is_valid_elf(stream))
+    if (! ElfObject<ElfType_>::is_valid_elf(*mapped))
         return false;
 
     Context ctx("When checking '" + stringify(file) + "' as a " + stringify<int>(ElfType_::elf_class * 32) + "-bit ELF file");
 
     try
     {
-        ElfObject<ElfType_> elf(stream);
+        ElfObject<ElfType_> elf(mapped);
         if (ET_DYN == elf.get_type())
         {
             Log::get_instance()->message("broken_linkage_finder.is_library", ll_debug, lc_context)
@@ -34,9 +34,21 @@ namespace paludis
             Pimp<ElfLinkageChecker> _imp;
 
         public:
-            ElfLinkageChecker(const FSPath &, const std::shared_ptr<const Sequence<std::string>> &);
+            /**
+             * If maybe_cache_file is not null, what we learn about each file
+             * is remembered there, and files whose inode, mtime and size have not
+             * changed are not parsed again.
+             */
+            ElfLinkageChecker(const FSPath &, const std::shared_ptr<const Sequence<std::string>> &,
+                    const std::shared_ptr<const FSPath> & maybe_cache_file);
             virtual ~ElfLinkageChecker();
 
+            /**
+             * Write out the cache, if we have one. Only files checked since
+             * we were created are included.
+             */
+            void save_cache() const;
+
             virtual bool check_file(const FSPath &) PALUDIS_ATTRIBUTE((warn_unused_result));
             virtual void note_symlink(const FSPath &, const FSPath &);
 
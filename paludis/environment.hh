@@ -31,6 +31,7 @@
 #include <paludis/package_id-fwd.hh>
 #include <paludis/mask-fwd.hh>
 #include <paludis/selection-fwd.hh>
+#include <paludis/selection_cache-fwd.hh>
 #include <paludis/metadata_key_holder.hh>
 #include <paludis/choice-fwd.hh>
 #include <paludis/create_output_manager_info-fwd.hh>
@@ -378,6 +379,24 @@ namespace paludis
             virtual std::shared_ptr<PackageIDSequence> operator[] (const Selection &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
 
+            /**
+             * Use a SelectionCache for operator[], until it is removed.
+             *
+             * If several caches are added, the most recent is used.
+             *
+             * \see ScopedSelectionCache
+             * \since 2.4
+             */
+            virtual void add_selection_cache(const std::shared_ptr<const SelectionCache> &) = 0;
+
+            /**
+             * Stop using a SelectionCache previously passed to
+             * add_selection_cache.
+             *
+             * \since 2.4
+             */
+            virtual void remove_selection_cache(const std::shared_ptr<const SelectionCache> &) = 0;
+
             /**
              * Create a repository from a particular file.
              *
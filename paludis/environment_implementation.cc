@@ -23,6 +23,8 @@
 #include <paludis/hook.hh>
 #include <paludis/distribution.hh>
 #include <paludis/selection.hh>
+#include <paludis/selection_cache.hh>
+#include <paludis/notifier_callback.hh>
 #include <paludis/repository.hh>
 #include <paludis/generator.hh>
 #include <paludis/filter.hh>
@@ -44,6 +46,7 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/sequence-impl.hh>
 #include <paludis/util/set-impl.hh>
+#include <paludis/util/visitor_cast.hh>
 
 #include <algorithm>
 #include <mutex>
@@ -136,6 +139,9 @@ namespace paludis
         mutable std::shared_ptr<SetNameSet> set_names;
         mutable SetsStore sets;
 
+        mutable std::mutex selection_caches_mutex;
+        std::list<std::shared_ptr<const SelectionCache> > selection_caches;
+
         Imp() :
             loaded_sets(false)
         {
@@ -199,7 +205,40 @@ EnvironmentImplementation::is_paludis_package(const QualifiedPackageName & n) co
 std::shared_ptr<PackageIDSequence>
 EnvironmentImplementation::operator[] (const Selection & selection) const
 {
-    return selection.perform_select(this);
+    std::shared_ptr<const SelectionCache> cache;
+    {
+        std::unique_lock<std::mutex> lock(_imp->selection_caches_mutex);
+        if (! _imp->selection_caches.empty())
+            cache = _imp->selection_caches.back();
+    }
+
+    if (cache)
+        return cache->perform_select(this, selection);
+    else
+        return selection.perform_select(this);
+}
+
+void
+EnvironmentImplementation::add_selection_cache(const std::shared_ptr<const SelectionCache> & c)
+{
+    std::unique_lock<std::mutex> lock(_imp->selection_caches_mutex);
+    _imp->selection_caches.push_back(c);
+}
+
+void
+EnvironmentImplementation::remove_selection_cache(const std::shared_ptr<const SelectionCache> & c)
+{
+    std::unique_lock<std::mutex> lock(_imp->selection_caches_mutex);
+    _imp->selection_caches.remove(c);
+}
+
+void
+EnvironmentImplementation::clear_selection_caches() const
+{
+    std::unique_lock<std::mutex> lock(_imp->selection_caches_mutex);
+    for (auto c(_imp->selection_caches.begin()), c_end(_imp->selection_caches.end()) ;
+            c != c_end ; ++c)
+        (*c)->clear();
 }
 
 NotifierCallbackID
@@ -222,6 +261,9 @@ EnvironmentImplementation::remove_notifier_callback(const NotifierCallbackID i)
 void
 EnvironmentImplementation::trigger_notifier_callback(const NotifierCallbackEvent & e) const
 {
+    if (visitor_cast<const NotifierCallbackRepositoryInvalidatedEvent>(e))
+        clear_selection_caches();
+
     for (std::map<unsigned, NotifierCallbackFunction>::const_iterator i(_imp->notifier_callbacks.begin()),
             i_end(_imp->notifier_callbacks.end()) ;
             i != i_end ; ++i)
@@ -379,6 +421,7 @@ EnvironmentImplementation::add_repository(int importance, const std::shared_ptr<
         }
 
     _imp->repository_importances.insert(std::make_pair(importance, _imp->repositories.insert(q, repository)));
+    clear_selection_caches();
 }
 
 const std::shared_ptr<const Repository>
@@ -60,6 +60,14 @@ namespace paludis
             virtual void populate_standard_sets() const;
             void set_always_exists(const SetName &) const;
 
+            /**
+             * Clear any selection caches. Must be called whenever something
+             * which could change the result of a Selection is changed.
+             *
+             * \since 2.4
+             */
+            void clear_selection_caches() const;
+
         public:
             ///\name Basic operations
             ///\{
@@ -87,6 +95,10 @@ namespace paludis
             virtual std::shared_ptr<PackageIDSequence> operator[] (const Selection &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual void add_selection_cache(const std::shared_ptr<const SelectionCache> &);
+
+            virtual void remove_selection_cache(const std::shared_ptr<const SelectionCache> &);
+
             virtual NotifierCallbackID add_notifier_callback(const NotifierCallbackFunction &);
 
             virtual void remove_notifier_callback(const NotifierCallbackID);
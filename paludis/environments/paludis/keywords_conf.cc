@@ -24,6 +24,7 @@
 #include <paludis/spec_tree.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/match_package.hh>
+#include <paludis/package_dep_spec_collection.hh>
 #include <paludis/util/config_file.hh>
 #include <paludis/util/options.hh>
 #include <paludis/package_id.hh>
@@ -47,11 +48,13 @@ using namespace paludis::paludis_environment;
 
 typedef std::list<KeywordName> KeywordsList;
 typedef std::map<std::shared_ptr<const PackageDepSpec>, KeywordsList> PDSToKeywordsList;
-typedef std::pair<std::shared_ptr<const SetSpecTree>, KeywordsList> SetNameEntry;
+typedef std::pair<std::shared_ptr<const PackageDepSpecCollection>, KeywordsList> SetNameEntry;
 
 typedef std::unordered_map<QualifiedPackageName, PDSToKeywordsList, Hash<QualifiedPackageName> > SpecificMap;
 typedef PDSToKeywordsList UnspecificMap;
 typedef std::unordered_map<SetName, SetNameEntry, Hash<SetName> > NamedSetMap;
+typedef std::unordered_map<QualifiedPackageName, std::vector<UnspecificMap::const_iterator>,
+        Hash<QualifiedPackageName> > UnspecificByNameMap;
 
 namespace paludis
 {
@@ -63,12 +66,56 @@ namespace paludis
         SpecificMap qualified;
         UnspecificMap unqualified;
         mutable NamedSetMap set;
+        mutable bool set_loaded;
         mutable std::mutex set_mutex;
+        mutable UnspecificByNameMap unqualified_by_name;
+        mutable std::mutex unqualified_by_name_mutex;
 
         Imp(const PaludisEnvironment * const e) :
-            env(e)
+            env(e),
+            set_loaded(false)
         {
         }
+
+        void need_sets() const
+        {
+            std::unique_lock<std::mutex> lock(set_mutex);
+            if (set_loaded)
+                return;
+
+            /* the environment keeps the same set for its lifetime, so we only
+             * need to flatten each one once */
+            for (NamedSetMap::iterator i(set.begin()), i_end(set.end()) ;
+                     i != i_end ; ++i)
+            {
+                std::shared_ptr<PackageDepSpecCollection> c(std::make_shared<PackageDepSpecCollection>(nullptr));
+                const std::shared_ptr<const SetSpecTree> s(env->set(i->first));
+                if (s)
+                    c->insert_set(env, *s);
+                else
+                    Log::get_instance()->message("paludis_environment.keywords_conf.unknown_set", ll_warning, lc_no_context) << "Set name '"
+                        << i->first << "' does not exist";
+                i->second.first = c;
+            }
+
+            set_loaded = true;
+        }
+
+        const std::vector<UnspecificMap::const_iterator> & unqualified_for(const QualifiedPackageName & name) const
+        {
+            std::unique_lock<std::mutex> lock(unqualified_by_name_mutex);
+            UnspecificByNameMap::iterator i(unqualified_by_name.find(name));
+            if (i == unqualified_by_name.end())
+            {
+                i = unqualified_by_name.insert(std::make_pair(name, std::vector<UnspecificMap::const_iterator>())).first;
+                for (UnspecificMap::const_iterator j(unqualified.begin()), j_end(unqualified.end()) ;
+                        j != j_end ; ++j)
+                    if (match_package_name(*j->first, name))
+                        i->second.push_back(j);
+            }
+
+            return i->second;
+        }
     };
 }
 
@@ -90,6 +137,16 @@ KeywordsConf::add(const FSPath & filename)
     if (! f)
         return;
 
+    {
+        std::unique_lock<std::mutex> lock(_imp->unqualified_by_name_mutex);
+        _imp->unqualified_by_name.clear();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_imp->set_mutex);
+        _imp->set_loaded = false;
+    }
+
     for (LineConfigFile::ConstIterator line(f->begin()), line_end(f->end()) ;
             line != line_end ; ++line)
     {
@@ -171,53 +228,40 @@ KeywordsConf::query(const std::shared_ptr<const KeywordNameSet> & k, const std::
         return false;
 
     /* next: named sets */
+    _imp->need_sets();
+    for (NamedSetMap::const_iterator i(_imp->set.begin()), i_end(_imp->set.end()) ;
+             i != i_end ; ++i)
     {
-        std::unique_lock<std::mutex> lock(_imp->set_mutex);
+        if (! i->second.first->match_any(_imp->env, e, { }))
+            continue;
 
-        for (NamedSetMap::iterator i(_imp->set.begin()), i_end(_imp->set.end()) ;
-                 i != i_end ; ++i)
+        for (KeywordsList::const_iterator l(i->second.second.begin()), l_end(i->second.second.end()) ;
+                l != l_end ; ++l)
         {
-            if (! i->second.first)
-            {
-                i->second.first = _imp->env->set(i->first);
-                if (! i->second.first)
-                {
-                    Log::get_instance()->message("paludis_environment.keywords_conf.unknown_set", ll_warning, lc_no_context) << "Set name '"
-                        << i->first << "' does not exist";
-                    i->second.first = std::make_shared<SetSpecTree>(std::make_shared<AllDepSpec>());
-                }
-            }
-
-            if (! match_package_in_set(*_imp->env, *i->second.first, e, { }))
-                continue;
-
-            for (KeywordsList::const_iterator l(i->second.second.begin()), l_end(i->second.second.end()) ;
-                    l != l_end ; ++l)
-            {
-                if (k->end() != k->find(*l))
-                    return true;
+            if (k->end() != k->find(*l))
+                return true;
 
-                if (*l == star_keyword)
-                    return true;
+            if (*l == star_keyword)
+                return true;
 
-                if (*l == minus_star_keyword)
-                    break_when_done = true;
-            }
+            if (*l == minus_star_keyword)
+                break_when_done = true;
         }
     }
 
-
     if (break_when_done)
         return false;
 
     /* last: unspecific */
-    for (PDSToKeywordsList::const_iterator j(_imp->unqualified.begin()), j_end(_imp->unqualified.end()) ;
-            j != j_end ; ++j)
+    const std::vector<UnspecificMap::const_iterator> & unqualified(_imp->unqualified_for(e->name()));
+    for (std::vector<UnspecificMap::const_iterator>::const_iterator u(unqualified.begin()), u_end(unqualified.end()) ;
+            u != u_end ; ++u)
     {
-        if (! match_package(*_imp->env, *j->first, e, nullptr, { }))
+        const PDSToKeywordsList::value_type & j(**u);
+        if (! match_package(*_imp->env, *j.first, e, nullptr, { }))
             continue;
 
-        for (KeywordsList::const_iterator l(j->second.begin()), l_end(j->second.end()) ;
+        for (KeywordsList::const_iterator l(j.second.begin()), l_end(j.second.end()) ;
                 l != l_end ; ++l)
         {
             if (k->end() != k->find(*l))
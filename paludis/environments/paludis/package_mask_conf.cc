@@ -24,6 +24,7 @@
 #include <paludis/spec_tree.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/match_package.hh>
+#include <paludis/package_dep_spec_collection.hh>
 #include <paludis/util/config_file.hh>
 #include <paludis/package_id.hh>
 #include <paludis/environments/paludis/paludis_environment.hh>
@@ -40,12 +41,26 @@
 #include <list>
 #include <mutex>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 using namespace paludis;
 using namespace paludis::paludis_environment;
 
-typedef std::list<std::pair<SetName, std::pair<std::shared_ptr<const SetSpecTree>, std::set<std::string> > > > Sets;
+typedef std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::set<std::string> > > Masks;
+typedef std::unordered_map<QualifiedPackageName, std::vector<Masks::const_iterator>, Hash<QualifiedPackageName> > MasksByName;
+typedef std::list<std::pair<SetName, std::pair<std::shared_ptr<const PackageDepSpecCollection>, std::set<std::string> > > > Sets;
+
+namespace
+{
+    bool reasons_match(const std::set<std::string> & reasons, const std::string & r)
+    {
+        if (r.empty())
+            return reasons.empty();
+        else
+            return reasons.empty() || (reasons.end() != reasons.find(r));
+    }
+}
 
 namespace paludis
 {
@@ -54,15 +69,57 @@ namespace paludis
     {
         const PaludisEnvironment * const env;
         const bool allow_reasons;
-        std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::set<std::string> > > masks;
+        Masks masks;
+        mutable MasksByName masks_by_name;
+        mutable std::mutex masks_by_name_mutex;
         mutable Sets sets;
+        mutable bool sets_loaded;
         mutable std::mutex set_mutex;
 
         Imp(const PaludisEnvironment * const e, const bool a) :
             env(e),
-            allow_reasons(a)
+            allow_reasons(a),
+            sets_loaded(false)
         {
         }
+
+        const std::vector<Masks::const_iterator> & masks_for(const QualifiedPackageName & name) const
+        {
+            std::unique_lock<std::mutex> lock(masks_by_name_mutex);
+            MasksByName::iterator i(masks_by_name.find(name));
+            if (i == masks_by_name.end())
+            {
+                i = masks_by_name.insert(std::make_pair(name, std::vector<Masks::const_iterator>())).first;
+                for (Masks::const_iterator m(masks.begin()), m_end(masks.end()) ;
+                        m != m_end ; ++m)
+                    if (match_package_name(*m->first, name))
+                        i->second.push_back(m);
+            }
+
+            return i->second;
+        }
+
+        void need_sets() const
+        {
+            std::unique_lock<std::mutex> lock(set_mutex);
+            if (sets_loaded)
+                return;
+
+            for (Sets::iterator it(sets.begin()), it_end(sets.end()) ;
+                    it_end != it ; ++it)
+            {
+                std::shared_ptr<PackageDepSpecCollection> c(std::make_shared<PackageDepSpecCollection>(nullptr));
+                const std::shared_ptr<const SetSpecTree> s(env->set(it->first));
+                if (s)
+                    c->insert_set(env, *s);
+                else
+                    Log::get_instance()->message("paludis_environment.package_mask.unknown_set", ll_warning, lc_no_context) << "Set name '"
+                        << it->first << "' does not exist";
+                it->second.first = c;
+            }
+
+            sets_loaded = true;
+        }
     };
 }
 
@@ -84,6 +141,16 @@ PackageMaskConf::add(const FSPath & filename)
     if (! f)
         return;
 
+    {
+        std::unique_lock<std::mutex> lock(_imp->masks_by_name_mutex);
+        _imp->masks_by_name.clear();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_imp->set_mutex);
+        _imp->sets_loaded = false;
+    }
+
     for (LineConfigFile::ConstIterator line(f->begin()), line_end(f->end()) ;
             line != line_end ; ++line)
     {
@@ -116,56 +183,17 @@ PackageMaskConf::add(const FSPath & filename)
 bool
 PackageMaskConf::query(const std::shared_ptr<const PackageID> & e, const std::string & r) const
 {
-    using namespace std::placeholders;
-
-    for (auto i(_imp->masks.begin()), i_end(_imp->masks.end()) ;
+    const std::vector<Masks::const_iterator> & masks(_imp->masks_for(e->name()));
+    for (auto i(masks.begin()), i_end(masks.end()) ;
             i != i_end ; ++i)
-        if (match_package(*_imp->env, *i->first, e, nullptr, MatchPackageOptions()))
-        {
-            if (r.empty())
-            {
-                if (i->second.empty())
-                    return true;
-            }
-            else
-            {
-                if (i->second.empty() || (i->second.end() != i->second.find(r)))
-                    return true;
-            }
-        }
-
-    {
-        std::unique_lock<std::mutex> lock(_imp->set_mutex);
-
-        for (Sets::iterator it(_imp->sets.begin()),
-                 it_end(_imp->sets.end()); it_end != it; ++it)
-        {
-            if (! it->second.first)
-            {
-                it->second.first = _imp->env->set(it->first);
-                if (! it->second.first)
-                {
-                    Log::get_instance()->message("paludis_environment.package_mask.unknown_set", ll_warning, lc_no_context) << "Set name '"
-                        << it->first << "' does not exist";
-                    it->second.first = std::make_shared<SetSpecTree>(std::make_shared<AllDepSpec>());
-                }
-            }
-
-            if (match_package_in_set(*_imp->env, *it->second.first, e, { }))
-            {
-                if (r.empty())
-                {
-                    if (it->second.second.empty())
-                        return true;
-                }
-                else
-                {
-                    if (it->second.second.empty() || (it->second.second.end() != it->second.second.find(r)))
-                        return true;
-                }
-            }
-        }
-    }
+        if (reasons_match((*i)->second, r) && match_package(*_imp->env, *(*i)->first, e, nullptr, MatchPackageOptions()))
+            return true;
+
+    _imp->need_sets();
+    for (Sets::const_iterator it(_imp->sets.begin()),
+             it_end(_imp->sets.end()); it_end != it; ++it)
+        if (reasons_match(it->second.second, r) && it->second.first->match_any(_imp->env, e, { }))
+            return true;
 
     return false;
 }
@@ -35,6 +35,8 @@
 #include <paludis/selection.hh>
 #include <paludis/metadata_key.hh>
 #include <paludis/choice.hh>
+#include <paludis/mask.hh>
+#include <paludis/name.hh>
 
 #include <cstdlib>
 #include <gtest/gtest.h>
@@ -158,6 +160,45 @@ TEST(PaludisEnvironment, UseMinusPartialStar)
     EXPECT_TRUE(get_use("third_exp_two", three));
 }
 
+TEST(PaludisEnvironment, SetsAndWildcards)
+{
+    setenv("PALUDIS_HOME", stringify(FSPath::cwd() / "paludis_environment_TEST_dir" / "home6").c_str(), 1);
+    unsetenv("PALUDIS_SKIP_CONFIG");
+
+    std::shared_ptr<Environment> env(std::make_shared<PaludisEnvironment>(""));
+
+    const std::shared_ptr<const PackageID> one(*(*env)[selection::RequireExactlyOne(
+                generator::Matches(PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                            env.get(), { })), nullptr, { }))]->begin());
+    const std::shared_ptr<const PackageID> three(*(*env)[selection::RequireExactlyOne(
+                generator::Matches(PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-two-3",
+                            env.get(), { })), nullptr, { }))]->begin());
+
+    EXPECT_TRUE(get_use("foo", one));
+    EXPECT_TRUE(get_use("foofoo", one));
+    EXPECT_TRUE(! get_use("quoted-name", one));
+    EXPECT_TRUE(get_use("foo", three));
+    EXPECT_TRUE(! get_use("foofoo", three));
+    EXPECT_TRUE(get_use("quoted-name", three));
+
+    std::shared_ptr<KeywordNameSet> setkeyword(std::make_shared<KeywordNameSet>());
+    setkeyword->insert(KeywordName("setkeyword"));
+    std::shared_ptr<KeywordNameSet> catkeyword(std::make_shared<KeywordNameSet>());
+    catkeyword->insert(KeywordName("catkeyword"));
+    std::shared_ptr<KeywordNameSet> pkgkeyword(std::make_shared<KeywordNameSet>());
+    pkgkeyword->insert(KeywordName("pkgkeyword"));
+
+    EXPECT_TRUE(env->accept_keywords(setkeyword, one));
+    EXPECT_TRUE(! env->accept_keywords(setkeyword, three));
+    EXPECT_TRUE(env->accept_keywords(catkeyword, one));
+    EXPECT_TRUE(env->accept_keywords(catkeyword, three));
+    EXPECT_TRUE(! env->accept_keywords(pkgkeyword, one));
+    EXPECT_TRUE(env->accept_keywords(pkgkeyword, three));
+
+    EXPECT_TRUE(bool(env->mask_for_user(one, false)));
+    EXPECT_TRUE(! env->mask_for_user(three, false));
+}
+
 TEST(PaludisEnvironment, Repositories)
 {
     setenv("PALUDIS_HOME", stringify(FSPath::cwd() / "paludis_environment_TEST_dir" / "home4").c_str(), 1);
@@ -228,3 +228,30 @@ profiles = `pwd`/sixthrepo/profile
 cache = /var/empty
 END
 
+mkdir -p home6/.paludis/{repositories,sets}
+cat <<END > home6/.paludis/sets/myset.conf
+* cat-one/pkg-one
+END
+cat <<END > home6/.paludis/use.conf
+*/* foo
+myset foofoo
+*/pkg-two quoted-name
+END
+cat <<END > home6/.paludis/keywords.conf
+myset setkeyword
+cat-one/* catkeyword
+*/pkg-two pkgkeyword
+END
+cat <<END > home6/.paludis/licenses.conf
+*/* *
+END
+cat <<END > home6/.paludis/package_mask.conf
+myset
+END
+cat <<END > home6/.paludis/repositories/foo.conf
+format = e
+names_cache = /var/empty
+location = `pwd`/repo
+profiles = `pwd`/repo/profile
+cache = /var/empty
+END
@@ -280,6 +280,7 @@ void
 TestEnvironment::set_want_choice_enabled(const ChoicePrefixName & p, const UnprefixedChoiceName & n, const Tribool v)
 {
     _imp->override_want_choice_enabled[stringify(p) + ":" + stringify(n)] = v;
+    clear_selection_caches();
 }
 
 Tribool
@@ -310,5 +311,6 @@ void
 TestEnvironment::set_system_root(const FSPath & p)
 {
     _imp->system_root_key->change_value(p);
+    clear_selection_caches();
 }
 
@@ -15,7 +15,7 @@ add(`action_names',                                `hh', `cc', `fwd')
 add(`additional_package_dep_spec_requirement',     `hh', `cc', `fwd')
 add(`always_enabled_dependency_label',             `hh', `cc', `fwd')
 add(`broken_linkage_configuration',                `hh', `cc', `gtest', `testscript')
-add(`broken_linkage_finder',                       `hh', `cc')
+add(`broken_linkage_finder',                       `hh', `cc', `gtest', `testscript')
 add(`buffer_output_manager',                       `hh', `cc', `fwd')
 add(`call_pretty_printer',                         `hh', `cc', `fwd')
 add(`changed_choices',                             `hh', `cc', `fwd')
@@ -24,7 +24,7 @@ add(`comma_separated_dep_parser',                  `hh', `cc', `gtest')
 add(`comma_separated_dep_pretty_printer',          `hh', `cc', `fwd')
 add(`command_output_manager',                      `hh', `cc', `fwd')
 add(`common_sets',                                 `hh', `cc', `fwd')
-add(`contents',                                    `hh', `cc', `fwd')
+add(`contents',                                    `hh', `cc', `fwd', `gtest')
 add(`create_output_manager_info',                  `hh', `cc', `fwd', `se')
 add(`dep_label',                                   `hh', `cc', `fwd')
 add(`dep_spec',                                    `hh', `cc', `gtest', `fwd')
@@ -67,7 +67,7 @@ add(`match_package',                               `hh', `cc', `se', `fwd')
 add(`merger',                                      `hh', `cc', `se', `fwd')
 add(`merger_entry_type',                           `hh', `cc', `se')
 add(`metadata_key',                                `hh', `cc', `se', `fwd')
-add(`metadata_key_holder',                         `hh', `cc', `fwd')
+add(`metadata_key_holder',                         `hh', `cc', `fwd', `gtest')
 add(`name',                                        `hh', `cc', `fwd', `gtest')
 add(`ndbam',                                       `hh', `cc', `fwd')
 add(`ndbam_merger',                                `hh', `cc')
@@ -89,9 +89,11 @@ add(`pretty_printer',                              `hh', `cc', `fwd')
 add(`repository',                                  `hh', `fwd', `cc', `se')
 add(`repository_factory',                          `hh', `fwd', `cc')
 add(`repository_name_cache',                       `hh', `cc', `gtest', `testscript')
+add(`repository_owners_cache',                     `hh', `cc')
 add(`selection',                                   `hh', `cc', `fwd', `gtest')
+add(`selection_cache',                             `hh', `cc', `fwd', `gtest')
 add(`selection_handler',                           `hh', `cc', `fwd')
-add(`serialise',                                   `hh', `cc', `fwd', `impl')
+add(`serialise',                                   `hh', `cc', `fwd', `impl', `se')
 add(`set_file',                                    `hh', `cc', `se', `gtest', `testscript')
 add(`slot',                                        `hh', `fwd', `cc')
 add(`slot_requirement',                            `hh', `fwd', `cc')
@@ -35,6 +35,7 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/enum_iterator.hh>
 
 using namespace paludis;
 
@@ -120,6 +121,12 @@ Filter::as_string() const
     return _imp->handler->as_string();
 }
 
+std::string
+Filter::cache_key() const
+{
+    return _imp->handler->cache_key();
+}
+
 namespace
 {
     struct AllFilterHandler :
@@ -129,6 +136,11 @@ namespace
         {
             return "all matches";
         }
+
+        virtual std::string cache_key() const
+        {
+            return "all";
+        }
     };
 
     template <typename A_>
@@ -171,6 +183,11 @@ namespace
         {
             return "supports action " + stringify(ActionNames<A_>::value);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "supports_action:" + stringify(ActionNames<A_>::value);
+        }
     };
 
     struct NotMaskedFilterHandler :
@@ -215,6 +232,11 @@ namespace
         {
             return "not masked";
         }
+
+        virtual std::string cache_key() const
+        {
+            return "not_masked";
+        }
     };
 
     struct InstalledAtFilterHandler :
@@ -268,6 +290,11 @@ namespace
         {
             return "installed " + std::string(equal ? "" : "not ") + "at root " + stringify(root);
         }
+
+        virtual std::string cache_key() const
+        {
+            return std::string(equal ? "installed_at_root:" : "not_installed_at_root:") + stringify(root);
+        }
     };
 
     struct AndFilterHandler :
@@ -322,6 +349,14 @@ namespace
         {
             return stringify(f1) + " filtered through " + stringify(f2);
         }
+
+        virtual std::string cache_key() const
+        {
+            std::string k1(f1.cache_key()), k2(f2.cache_key());
+            if (k1.empty() || k2.empty())
+                return "";
+            return "and:" + stringify(k1.length()) + ":" + k1 + k2;
+        }
     };
 
     struct SameSlotHandler :
@@ -365,6 +400,11 @@ namespace
         {
             return "same slot as " + stringify(*as_id);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "same_slot:" + stringify(*as_id);
+        }
     };
 
     struct SlotHandler :
@@ -400,6 +440,11 @@ namespace
         {
             return "slot is " + stringify(slot);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "slot:" + stringify(slot);
+        }
     };
 
     struct NoSlotHandler :
@@ -428,6 +473,11 @@ namespace
         {
             return "has no slot";
         }
+
+        virtual std::string cache_key() const
+        {
+            return "no_slot";
+        }
     };
 
     struct MatchesHandler :
@@ -472,6 +522,23 @@ namespace
                 suffix = " (ignoring additional requirements)";
             return "packages matching " + stringify(spec) + suffix;
         }
+
+        virtual std::string cache_key() const
+        {
+            std::string result("matches:");
+            for (EnumIterator<MatchPackageOption> o, o_end(last_mpo) ; o != o_end ; ++o)
+                result.append(options[*o] ? "+" : "-");
+
+            if (from_id)
+            {
+                std::string f(stringify(*from_id));
+                result.append(stringify(f.length()) + ":" + f);
+            }
+            else
+                result.append("-");
+
+            return result + stringify(spec);
+        }
     };
 
     struct ByFunctionHandler :
@@ -80,6 +80,14 @@ namespace paludis
              */
             std::string as_string() const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            /**
+             * A string which uniquely identifies what we select, for use as
+             * a cache key, or an empty string if we cannot be cached.
+             *
+             * \since 2.4
+             */
+            std::string cache_key() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             ///\name For use by Selection
             ///\{
 
@@ -26,6 +26,12 @@ FilterHandler::~FilterHandler()
 {
 }
 
+std::string
+FilterHandler::cache_key() const
+{
+    return "";
+}
+
 std::shared_ptr<const RepositoryNameSet>
 AllFilterHandlerBase::repositories(const Environment * const,
         const std::shared_ptr<const RepositoryNameSet> & s) const
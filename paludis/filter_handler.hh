@@ -38,6 +38,14 @@ namespace paludis
 
             virtual std::string as_string() const = 0;
 
+            /**
+             * A string which uniquely identifies what we select, for use as
+             * a cache key, or an empty string if we cannot be cached.
+             *
+             * \since 2.4
+             */
+            virtual std::string cache_key() const;
+
             virtual const RepositoryContentMayExcludes may_excludes() const = 0;
 
             virtual std::shared_ptr<const RepositoryNameSet> repositories(
@@ -21,6 +21,7 @@
 #include <paludis/filter.hh>
 #include <paludis/generator.hh>
 #include <paludis/util/pimp-impl.hh>
+#include <paludis/util/stringify.hh>
 #include <ostream>
 
 using namespace paludis;
@@ -83,6 +84,15 @@ FilteredGenerator::filter() const
     return _imp->filter;
 }
 
+std::string
+FilteredGenerator::cache_key() const
+{
+    std::string g(_imp->generator.cache_key()), f(_imp->filter.cache_key());
+    if (g.empty() || f.empty())
+        return "";
+    return stringify(g.length()) + ":" + g + f;
+}
+
 FilteredGenerator
 paludis::operator| (const FilteredGenerator & g, const Filter & f)
 {
@@ -24,6 +24,7 @@
 #include <paludis/util/pimp.hh>
 #include <paludis/filter-fwd.hh>
 #include <paludis/generator-fwd.hh>
+#include <string>
 
 /** \file
  * Declarations for the FilteredGenerator class.
@@ -71,6 +72,14 @@ namespace paludis
              * Return our Filter.
              */
             const Filter & filter() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * A string which uniquely identifies what we select, for use as
+             * a cache key, or an empty string if we cannot be cached.
+             *
+             * \since 2.4
+             */
+            std::string cache_key() const PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
     extern template class Pimp<FilteredGenerator>;
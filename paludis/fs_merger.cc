@@ -44,6 +44,8 @@
 #include <cstring>
 #include <cstdio>
 #include <list>
+#include <mutex>
+#include <vector>
 #include <set>
 #include <unordered_map>
 
@@ -57,6 +59,15 @@
 #  include <linux/falloc.h>
 #endif
 
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
+#ifdef HAVE_FICLONE
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
+#endif
+
 using namespace paludis;
 
 #include <paludis/fs_merger-se.cc>
@@ -72,11 +83,37 @@ namespace paludis
         FSMergerParams params;
         std::set<FSPath, FSPathComparator> elided_paths;
 
+        /* protects merged_ids and elided_paths, for mo_parallel */
+        std::mutex mutex;
+
+        /* held whilst installing anything with more than one link, so that
+         * mo_parallel doesn't lose hardlinks */
+        std::mutex hardlinks_mutex;
+
         Imp(const FSMergerParams & p) :
             params(p)
         {
         }
 
+        /* returns true if we haven't merged this id before */
+        bool add_merged_id(const std::pair<dev_t, ino_t> & id, const std::string & path)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool result(merged_ids.end() == merged_ids.find(id));
+            merged_ids.insert(std::make_pair(id, path));
+            return result;
+        }
+
+        std::list<std::string> merged_paths_for(const std::pair<dev_t, ino_t> & id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::list<std::string> result;
+            std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(merged_ids.equal_range(id));
+            for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+                result.push_back(i->second);
+            return result;
+        }
+
         bool is_elided_directory(const FSPath & dir) const
         {
             for (FSIterator dentry(dir, { fsio_include_dotfiles }), invalid;
@@ -98,6 +135,94 @@ namespace paludis
     };
 }
 
+namespace
+{
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+    /* true if the kernel or filesystem can't do this kind of copy between
+     * these two fds, and we should try something else */
+    bool copy_not_supported(int e)
+    {
+        switch (e)
+        {
+            case ENOSYS:
+            case EXDEV:
+            case EINVAL:
+            case EOPNOTSUPP:
+            case ENOTTY:
+            case EBADF:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+#endif
+
+    bool try_to_clone(int input_fd, int output_fd)
+    {
+#ifdef HAVE_FICLONE
+        if (0 == ::ioctl(output_fd, FICLONE, input_fd))
+            return true;
+
+        Log::get_instance()->message("merger.file.clone_failed", ll_debug, lc_context) <<
+            "FICLONE failed: " << ::strerror(errno);
+#else
+        (void) input_fd;
+        (void) output_fd;
+#endif
+        return false;
+    }
+
+    /* copy everything from the current offset of input_fd to the current
+     * offset of output_fd, using in-kernel copies where possible */
+    void copy_contents(int input_fd, int output_fd, const FSPath & dst)
+    {
+#ifdef HAVE_COPY_FILE_RANGE
+        while (true)
+        {
+            ssize_t count(::copy_file_range(input_fd, nullptr, output_fd, nullptr, 1 << 30, 0));
+            if (0 == count)
+                return;
+            else if (-1 == count)
+            {
+                if (copy_not_supported(errno))
+                    break;
+                throw FSMergerError("copy_file_range to '" + stringify(dst) + "' failed: " + stringify(::strerror(errno)));
+            }
+        }
+#endif
+
+#ifdef HAVE_SENDFILE
+        while (true)
+        {
+            ssize_t count(::sendfile(output_fd, input_fd, nullptr, 1 << 30));
+            if (0 == count)
+                return;
+            else if (-1 == count)
+            {
+                if (copy_not_supported(errno))
+                    break;
+                throw FSMergerError("sendfile to '" + stringify(dst) + "' failed: " + stringify(::strerror(errno)));
+            }
+        }
+#endif
+
+        std::vector<char> buf(1 << 16);
+        ssize_t count;
+        while ((count = ::read(input_fd, &buf[0], buf.size())) > 0)
+            for (ssize_t written(0) ; written < count ; )
+            {
+                ssize_t w(::write(output_fd, &buf[written], count - written));
+                if (-1 == w)
+                    throw FSMergerError("write failed: " + stringify(::strerror(errno)));
+                written += w;
+            }
+
+        if (-1 == count)
+            throw FSMergerError("read failed: " + stringify(::strerror(errno)));
+    }
+}
+
 FSMergerError::FSMergerError(const std::string & s) throw () :
     MergerError(s)
 {
@@ -367,13 +492,16 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
 
     bool do_copy(false);
 
+    std::unique_lock<std::mutex> hardlinks_lock(_imp->hardlinks_mutex, std::defer_lock);
+    if (src_stat.link_count() > 1)
+        hardlinks_lock.lock();
+
     if ((! _imp->params.options()[mo_nondestructive]) &&
             0 == std::rename(stringify(src).c_str(), stringify(dst_real).c_str()))
     {
         result += msi_rename;
 
-        bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(src_stat.lowlevel_id()));
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        bool touch(_imp->add_merged_id(src_stat.lowlevel_id(), stringify(dst_real)));
 
         FSPath d(stringify(dst_real));
         if (touch && ! _imp->params.options()[mo_preserve_mtimes])
@@ -386,10 +514,10 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
     else
     {
         do_copy = true;
-        std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(_imp->merged_ids.equal_range(src_stat.lowlevel_id()));
-        for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+        auto merged_paths(_imp->merged_paths_for(src_stat.lowlevel_id()));
+        for (auto i(merged_paths.begin()), i_end(merged_paths.end()) ; i != i_end ; ++i)
         {
-            if (0 == ::link(i->second.c_str(), stringify(dst).c_str()))
+            if (0 == ::link(i->c_str(), stringify(dst).c_str()))
             {
                 if (0 != std::rename(stringify(dst).c_str(), stringify(dst_real).c_str()))
                     throw FSMergerError("rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
@@ -398,7 +526,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
                 break;
             }
             Log::get_instance()->message("merger.file.link_failed", ll_debug, lc_context)
-                    << "link(" << i->second << ", " << dst_real << ") failed: "
+                    << "link(" << *i << ", " << dst_real << ") failed: "
                     << ::strerror(errno);
         }
     }
@@ -406,7 +534,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
     if (do_copy)
     {
         Log::get_instance()->message("merger.file.will_copy", ll_debug, lc_context) <<
-            "rename/link failed: " << ::strerror(errno) << ". Falling back to regular read/write copy";
+            "rename/link failed: " << ::strerror(errno) << ". Falling back to copying";
 
         FDHolder input_fd(::open(stringify(src).c_str(), O_RDONLY), false);
         if (-1 == input_fd)
@@ -420,8 +548,11 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
             if (0 != ::fchown(output_fd, src_stat.owner(), src_stat.group()))
                 throw FSMergerError("Cannot fchown '" + stringify(dst) + "': " + stringify(::strerror(errno)));
 
+        /* a reflink shares the data blocks, so there's nothing to preallocate */
+        bool cloned(try_to_clone(input_fd, output_fd));
+
 #ifdef HAVE_FALLOCATE
-        if (0 != ::fallocate(output_fd, FALLOC_FL_KEEP_SIZE, 0, src_stat.file_size()))
+        if ((! cloned) && 0 != ::fallocate(output_fd, FALLOC_FL_KEEP_SIZE, 0, src_stat.file_size()))
             switch (errno)
             {
                 case EOPNOTSUPP:
@@ -443,13 +574,8 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
             throw FSMergerError("Cannot fchmod '" + stringify(dst) + "': " + stringify(::strerror(errno)));
         try_to_copy_xattrs(src, output_fd, result);
 
-        char buf[4096];
-        ssize_t count;
-        while ((count = read(input_fd, buf, 4096)) > 0)
-            if (-1 == write(output_fd, buf, count))
-                throw FSMergerError("write failed: " + stringify(::strerror(errno)));
-        if (-1 == count)
-            throw FSMergerError("read failed: " + stringify(::strerror(errno)));
+        if (! cloned)
+            copy_contents(input_fd, output_fd, dst);
 
         /* might need to copy mtime */
         if (_imp->params.options()[mo_preserve_mtimes])
@@ -465,9 +591,12 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
             throw FSMergerError(
                     "rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
 
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        _imp->add_merged_id(src_stat.lowlevel_id(), stringify(dst_real));
     }
 
+    if (hardlinks_lock.owns_lock())
+        hardlinks_lock.unlock();
+
     if (fixed_ownership_for(src))
         result += msi_fixed_ownership;
 
@@ -497,14 +626,13 @@ FSMerger::track_renamed_dir_recursive(const FSPath & dst)
             case et_sym:
                 rewrite_symlink_as_needed(*d, dst);
                 track_install_sym(*d, dst, merged_how);
-                _imp->merged_ids.insert(make_pair(d->stat().lowlevel_id(), stringify(*d)));
+                _imp->add_merged_id(d->stat().lowlevel_id(), stringify(*d));
                 continue;
 
             case et_file:
                 {
                     FSStat d_star_stat(*d);
-                    bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(d_star_stat.lowlevel_id()));
-                    _imp->merged_ids.insert(make_pair(d_star_stat.lowlevel_id(), stringify(*d)));
+                    bool touch(_imp->add_merged_id(d_star_stat.lowlevel_id(), stringify(*d)));
 
                     if (touch && ! _imp->params.options()[mo_preserve_mtimes])
                         if (! d->utime(Timestamp::now()))
@@ -557,14 +685,17 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
     FSMergerStatusFlags result;
     FSStat src_stat(src);
 
-    if (! _imp->elided_paths.empty())
+    bool elided(false);
     {
-        const auto path = dst.strip_leading(_imp->params.root());
-        if (_imp->elided_paths.find(path) != _imp->elided_paths.end())
-        {
-            set_skipped_dir(true);
-            return { msi_unselected_part };
-        }
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        if (! _imp->elided_paths.empty())
+            elided = _imp->elided_paths.end() != _imp->elided_paths.find(dst.strip_leading(_imp->params.root()));
+    }
+
+    if (elided)
+    {
+        set_skipped_dir(true);
+        return { msi_unselected_part };
     }
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
@@ -665,19 +796,22 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
 
     bool do_sym(true);
 
+    std::unique_lock<std::mutex> hardlinks_lock(_imp->hardlinks_mutex, std::defer_lock);
+    if (src_stat.link_count() > 1)
+        hardlinks_lock.lock();
+
     FSCreateCon createcon(MatchPathCon::get_instance()->match(stringify(dst), S_IFLNK));
-    std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(
-            _imp->merged_ids.equal_range(src_stat.lowlevel_id()));
-    for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+    auto merged_paths(_imp->merged_paths_for(src_stat.lowlevel_id()));
+    for (auto i(merged_paths.begin()), i_end(merged_paths.end()) ; i != i_end ; ++i)
     {
-        if (0 == ::link(i->second.c_str(), stringify(dst).c_str()))
+        if (0 == ::link(i->c_str(), stringify(dst).c_str()))
         {
             do_sym = false;
             result += msi_as_hardlink;
             break;
         }
         Log::get_instance()->message("merger.sym.link_failed", ll_debug, lc_context)
-            << "link(" << i->second + ", " << stringify(dst) << ") failed: "
+            << "link(" << *i << ", " << stringify(dst) << ") failed: "
             << ::strerror(errno);
     }
 
@@ -686,9 +820,12 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
         if (0 != ::symlink(stringify(src.readlink()).c_str(), stringify(dst).c_str()))
             throw FSMergerError("Couldn't create symlink at '" + stringify(dst) + "': "
                     + stringify(::strerror(errno)));
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst)));
+        _imp->add_merged_id(src_stat.lowlevel_id(), stringify(dst));
     }
 
+    if (hardlinks_lock.owns_lock())
+        hardlinks_lock.unlock();
+
     if (! _imp->params.no_chown())
     {
         dst.lchown(src_stat.owner(), src_stat.group());
@@ -898,7 +1035,8 @@ FSMerger::track_install_file(const FSPath & src, const FSPath & dst_dir, const s
         return display_merge(et_file, dst_dir / src.basename(), flags,
                              src.basename() == dst_name ? "" : dst_name);
 
-    _imp->params.merged_entries()->insert(dst_dir / dst_name);
+    const FSPath merged(dst_dir / dst_name);
+    in_order([this, merged] () { _imp->params.merged_entries()->insert(merged); });
     record_install_file(src, dst_dir, dst_name, flags);
 }
 
@@ -908,14 +1046,15 @@ FSMerger::track_install_dir(const FSPath & src, const FSPath & dst_dir, const FS
     if (flags[msi_unselected_part])
         return display_merge(et_dir, dst_dir / src.basename(), flags);
 
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
+    const FSPath merged(dst_dir / src.basename());
+    in_order([this, merged] () { _imp->params.merged_entries()->insert(merged); });
     record_install_dir(src, dst_dir, flags);
 }
 
 void
 FSMerger::track_install_under_dir(const FSPath & dst, const FSMergerStatusFlags & flags)
 {
-    _imp->params.merged_entries()->insert(dst);
+    in_order([this, dst] () { _imp->params.merged_entries()->insert(dst); });
     record_install_under_dir(dst, flags);
 }
 
@@ -925,7 +1064,8 @@ FSMerger::track_install_sym(const FSPath & src, const FSPath & dst_dir, const FS
     if (flags[msi_unselected_part])
         return display_merge(et_sym, dst_dir / src.basename(), flags);
 
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
+    const FSPath merged(dst_dir / src.basename());
+    in_order([this, merged] () { _imp->params.merged_entries()->insert(merged); });
     record_install_sym(src, dst_dir, flags);
 }
 
@@ -1013,7 +1153,10 @@ FSMerger::on_enter_dir(bool is_check, const FSPath src)
     for (FSIterator dentry(src, { fsio_want_directories }), invalid;
             dentry != invalid; ++dentry)
         if (_imp->is_elided_directory(*dentry))
+        {
+            std::unique_lock<std::mutex> lock(_imp->mutex);
             _imp->elided_paths.insert(dentry->strip_leading(_imp->params.image()));
+        }
 }
 
 void
@@ -38,6 +38,7 @@
 #include <functional>
 #include <iterator>
 #include <list>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -102,21 +103,29 @@ namespace
     struct TestMerger :
         FSMerger
     {
+        std::list<std::string> recorded;
+
         TestMerger(const FSMergerParams & p) :
             FSMerger(p)
         {
         }
 
-        void record_install_file(const FSPath &, const FSPath &, const std::string &, const FSMergerStatusFlags &)
+        void record_install_file(const FSPath & src, const FSPath &, const std::string &, const FSMergerStatusFlags &)
         {
+            const std::string r("file " + stringify(src));
+            in_order([this, r] () { recorded.push_back(r); });
         }
 
-        void record_install_dir(const FSPath &, const FSPath &, const FSMergerStatusFlags &)
+        void record_install_dir(const FSPath & src, const FSPath &, const FSMergerStatusFlags &)
         {
+            const std::string r("dir " + stringify(src));
+            in_order([this, r] () { recorded.push_back(r); });
         }
 
-        void record_install_sym(const FSPath &, const FSPath &, const FSMergerStatusFlags &)
+        void record_install_sym(const FSPath & src, const FSPath &, const FSMergerStatusFlags &)
         {
+            const std::string r("sym " + stringify(src));
+            in_order([this, r] () { recorded.push_back(r); });
         }
 
         virtual void record_install_under_dir(const FSPath &, const FSMergerStatusFlags &)
@@ -478,6 +487,63 @@ TEST(Merger, EmptyRootDisallowed)
     ASSERT_TRUE(data->merger.check());
 }
 
+TEST(Merger, Copy)
+{
+    auto data(make_merger("copy", { mo_nondestructive }));
+
+    ASSERT_TRUE(data->merger.check());
+    data->merger.merge();
+
+    ASSERT_TRUE((data->image_dir / "small_file").stat().is_regular_file());
+    ASSERT_TRUE((data->root_dir / "dir" / "big_file").stat().file_size() > 65536);
+
+    for (auto & f : { "small_file", "empty_file", "dir/big_file" })
+    {
+        SafeIFStream i(data->image_dir / f);
+        ASSERT_TRUE(bool(i));
+        std::string is((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>());
+
+        SafeIFStream r(data->root_dir / f);
+        ASSERT_TRUE(bool(r));
+        std::string rs((std::istreambuf_iterator<char>(r)), std::istreambuf_iterator<char>());
+
+        EXPECT_EQ(is, rs) << f;
+    }
+}
+
+TEST(Merger, Parallel)
+{
+    auto serial(make_merger("parallel_serial", { mo_nondestructive }));
+    auto parallel(make_merger("parallel_parallel", { mo_nondestructive, mo_parallel }));
+
+    for (auto & data : std::vector<std::shared_ptr<MergerAndFriends> >{ serial, parallel })
+    {
+        ASSERT_TRUE(data->merger.check());
+        data->merger.merge();
+    }
+
+    ASSERT_EQ(4u + 4u * 3u * 5u + 2u, serial->merger.recorded.size());
+    ASSERT_EQ(serial->merger.recorded.size(), parallel->merger.recorded.size());
+    for (auto s(serial->merger.recorded.begin()), s_end(serial->merger.recorded.end()), p(parallel->merger.recorded.begin()) ;
+            s != s_end ; ++s, ++p)
+    {
+        std::string ss(*s), pp(*p);
+        ss.replace(ss.find("parallel_serial"), 15, "X");
+        pp.replace(pp.find("parallel_parallel"), 17, "X");
+        EXPECT_EQ(ss, pp);
+    }
+
+    for (auto & data : std::vector<std::shared_ptr<MergerAndFriends> >{ serial, parallel })
+    {
+        EXPECT_EQ("a 2 sub\n", [&] () {
+                SafeIFStream r(data->root_dir / "a" / "2" / "sub" / "file");
+                return std::string((std::istreambuf_iterator<char>(r)), std::istreambuf_iterator<char>());
+                }());
+        EXPECT_EQ((data->root_dir / "a" / "1" / "linked").stat().lowlevel_id(),
+                (data->root_dir / "d" / "3" / "linked").stat().lowlevel_id());
+    }
+}
+
 TEST(Merger, Mtimes)
 {
     auto data(make_merger("mtimes", { mo_preserve_mtimes }));
@@ -110,6 +110,25 @@ touch -d '3 years ago' mtimes_fix/image/dodgy_file
 touch -d '3 years ago' mtimes_fix/image/dir/dodgy_file
 > mtimes_fix/root/existing_file
 
+mkdir -p copy/{image/dir,root}
+echo "small contents" > copy/image/small_file
+> copy/image/empty_file
+for (( i = 0 ; i < 20000 ; i++ )) ; do echo "line $i of a file bigger than one copy buffer" ; done > copy/image/dir/big_file
+
+for t in serial parallel ; do
+    mkdir -p parallel_${t}/{image,root}
+    for d in a b c d ; do
+        for e in 1 2 3 ; do
+            mkdir -p parallel_${t}/image/${d}/${e}/sub
+            echo "${d} ${e}" > parallel_${t}/image/${d}/${e}/file
+            echo "${d} ${e} sub" > parallel_${t}/image/${d}/${e}/sub/file
+            ln -s file parallel_${t}/image/${d}/${e}/sym
+        done
+    done
+    echo "linked" > parallel_${t}/image/a/1/linked
+    ln parallel_${t}/image/a/1/linked parallel_${t}/image/d/3/linked
+done
+
 mkdir hooks
 cd hooks
 mkdir \
@@ -37,6 +37,7 @@
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/enum_iterator.hh>
 
 #include <algorithm>
 #include <functional>
@@ -127,6 +128,12 @@ Generator::as_string() const
     return _imp->handler->as_string();
 }
 
+std::string
+Generator::cache_key() const
+{
+    return _imp->handler->cache_key();
+}
+
 namespace
 {
     struct InRepositoryGeneratorHandler :
@@ -154,6 +161,11 @@ namespace
         {
             return "packages with repository " + stringify(name);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "in_repository:" + stringify(name);
+        }
     };
 
     struct FromRepositoryGeneratorHandler :
@@ -174,23 +186,15 @@ namespace
         {
             std::shared_ptr<PackageIDSet> result(std::make_shared<PackageIDSet>());
 
-            for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
-                    r != r_end ; ++r)
-            {
-                for (QualifiedPackageNameSet::ConstIterator q(qpns->begin()), q_end(qpns->end()) ;
-                        q != q_end ; ++q)
+            std::shared_ptr<const PackageIDSequence> id(ids_in_repositories(env, repos, qpns, x));
+            for (PackageIDSequence::ConstIterator i(id->begin()), i_end(id->end()) ;
+                    i != i_end ; ++i)
+                if ((*i)->from_repositories_key())
                 {
-                    std::shared_ptr<const PackageIDSequence> id(env->fetch_repository(*r)->package_ids(*q, x));
-                    for (PackageIDSequence::ConstIterator i(id->begin()), i_end(id->end()) ;
-                            i != i_end ; ++i)
-                        if ((*i)->from_repositories_key())
-                        {
-                            auto v((*i)->from_repositories_key()->parse_value());
-                            if (v->end() != v->find(stringify(name)))
-                                result->insert(*i);
-                        }
+                    auto v((*i)->from_repositories_key()->parse_value());
+                    if (v->end() != v->find(stringify(name)))
+                        result->insert(*i);
                 }
-            }
 
             return result;
         }
@@ -199,6 +203,11 @@ namespace
         {
             return "packages originally from repository " + stringify(name);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "from_repository:" + stringify(name);
+        }
     };
 
     struct CategoryGeneratorHandler :
@@ -234,6 +243,11 @@ namespace
         {
             return "packages with category " + stringify(name);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "category:" + stringify(name);
+        }
     };
 
     struct PackageGeneratorHandler :
@@ -286,6 +300,11 @@ namespace
         {
             return "packages named " + stringify(name);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "package:" + stringify(name);
+        }
     };
 
     struct MatchesGeneratorHandler :
@@ -456,20 +475,11 @@ namespace
         {
             std::shared_ptr<PackageIDSet> result(std::make_shared<PackageIDSet>());
 
-            for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
-                    r != r_end ; ++r)
-            {
-                for (QualifiedPackageNameSet::ConstIterator q(qpns->begin()), q_end(qpns->end()) ;
-                        q != q_end ; ++q)
-                {
-                    std::shared_ptr<const PackageIDSequence> id(
-                            env->fetch_repository(*r)->package_ids(*q, x));
-                    for (PackageIDSequence::ConstIterator i(id->begin()), i_end(id->end()) ;
-                            i != i_end ; ++i)
-                        if (match_package(*env, spec, *i, from_id, options))
-                            result->insert(*i);
-                }
-            }
+            std::shared_ptr<const PackageIDSequence> id(ids_in_repositories(env, repos, qpns, x));
+            for (PackageIDSequence::ConstIterator i(id->begin()), i_end(id->end()) ;
+                    i != i_end ; ++i)
+                if (match_package(*env, spec, *i, from_id, options))
+                    result->insert(*i);
 
             return result;
         }
@@ -481,6 +491,23 @@ namespace
                 suffix = " (ignoring additional requirements)";
             return "packages matching " + stringify(spec) + suffix;
         }
+
+        virtual std::string cache_key() const
+        {
+            std::string result("matches:");
+            for (EnumIterator<MatchPackageOption> o, o_end(last_mpo) ; o != o_end ; ++o)
+                result.append(options[*o] ? "+" : "-");
+
+            if (from_id)
+            {
+                std::string f(stringify(*from_id));
+                result.append(stringify(f.length()) + ":" + f);
+            }
+            else
+                result.append("-");
+
+            return result + stringify(spec);
+        }
     };
 
     struct IntersectionGeneratorHandler :
@@ -585,6 +612,14 @@ namespace
         {
             return stringify(g1) + " intersected with " + stringify(g2);
         }
+
+        virtual std::string cache_key() const
+        {
+            std::string k1(g1.cache_key()), k2(g2.cache_key());
+            if (k1.empty() || k2.empty())
+                return "";
+            return "intersection:" + stringify(k1.length()) + ":" + k1 + k2;
+        }
     };
 
     struct UnionGeneratorHandler :
@@ -665,6 +700,14 @@ namespace
         {
             return stringify(g1) + " unioned with " + stringify(g2);
         }
+
+        virtual std::string cache_key() const
+        {
+            std::string k1(g1.cache_key()), k2(g2.cache_key());
+            if (k1.empty() || k2.empty())
+                return "";
+            return "union:" + stringify(k1.length()) + ":" + k1 + k2;
+        }
     };
 
     struct AllGeneratorHandler :
@@ -674,6 +717,11 @@ namespace
         {
             return "all packages";
         }
+
+        virtual std::string cache_key() const
+        {
+            return "all";
+        }
     };
 
     template <typename A_>
@@ -697,6 +745,11 @@ namespace
         {
             return "packages that might support action " + stringify(ActionNames<A_>::value);
         }
+
+        virtual std::string cache_key() const
+        {
+            return "might_support_action:" + stringify(ActionNames<A_>::value);
+        }
     };
 
     struct NothingGeneratorHandler :
@@ -739,6 +792,11 @@ namespace
         {
             return "no packages";
         }
+
+        virtual std::string cache_key() const
+        {
+            return "nothing";
+        }
     };
 }
 
@@ -24,18 +24,96 @@
 
 #include <paludis/util/set.hh>
 #include <paludis/util/sequence.hh>
+#include <paludis/util/task_scheduler.hh>
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 
 #include <functional>
 #include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
 
 using namespace paludis;
 
+namespace
+{
+    PALUDIS_TLS bool in_scan_task = false;
+
+    /* Scanning is mostly waiting for the filesystem, so we use a few more
+     * workers than we have hardware threads. */
+    TaskScheduler & scan_scheduler()
+    {
+        static TaskScheduler scheduler(std::max(4u, std::thread::hardware_concurrency()));
+        return scheduler;
+    }
+
+    /* Call f once for each repository, and return the results in repository
+     * order. Each call is made on its own task if there is more than one
+     * repository, unless we are already inside such a task. */
+    template <typename T_>
+    std::vector<T_> for_each_repository(
+            const Environment * const env,
+            const std::shared_ptr<const RepositoryNameSet> & repos,
+            const std::function<T_ (const Repository &)> & f)
+    {
+        std::vector<T_> result;
+        result.reserve(repos->size());
+
+        if (in_scan_task || repos->size() < 2)
+        {
+            for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
+                    r != r_end ; ++r)
+                result.push_back(f(*env->fetch_repository(*r)));
+            return result;
+        }
+
+        std::vector<std::future<T_> > futures;
+        futures.reserve(repos->size());
+        for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
+                r != r_end ; ++r)
+        {
+            std::shared_ptr<const Repository> repo(env->fetch_repository(*r));
+            auto promise(std::make_shared<std::promise<T_> >());
+            futures.push_back(promise->get_future());
+
+            /* we catch everything ourselves, so that a failure does not
+             * cancel anyone else's tasks */
+            scan_scheduler().post([promise, repo, &f] () {
+                    in_scan_task = true;
+                    try
+                    {
+                        promise->set_value(f(*repo));
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+        }
+
+        /* f refers to our caller's locals, so everything must finish before
+         * we rethrow anything */
+        for (auto & future : futures)
+            future.wait();
+
+        for (auto & future : futures)
+            result.push_back(future.get());
+
+        return result;
+    }
+}
+
 GeneratorHandler::~GeneratorHandler()
 {
 }
 
+std::string
+GeneratorHandler::cache_key() const
+{
+    return "";
+}
+
 std::shared_ptr<const RepositoryNameSet>
 AllGeneratorHandlerBase::repositories(
         const Environment * const env,
@@ -56,12 +134,12 @@ AllGeneratorHandlerBase::categories(
 {
     std::shared_ptr<CategoryNamePartSet> result(std::make_shared<CategoryNamePartSet>());
 
-    for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
-            r != r_end ; ++r)
-    {
-        std::shared_ptr<const CategoryNamePartSet> cats(env->fetch_repository(*r)->category_names(may_exclude));
-        std::copy(cats->begin(), cats->end(), result->inserter());
-    }
+    auto cats(for_each_repository<std::shared_ptr<const CategoryNamePartSet> >(env, repos,
+                [&] (const Repository & repo) { return repo.category_names(may_exclude); }));
+
+    for (auto c(cats.begin()), c_end(cats.end()) ;
+            c != c_end ; ++c)
+        std::copy((*c)->begin(), (*c)->end(), result->inserter());
 
     return result;
 }
@@ -75,17 +153,21 @@ AllGeneratorHandlerBase::packages(
 {
     std::shared_ptr<QualifiedPackageNameSet> result(std::make_shared<QualifiedPackageNameSet>());
 
-    for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
-            r != r_end ; ++r)
-    {
-        for (CategoryNamePartSet::ConstIterator c(cats->begin()), c_end(cats->end()) ;
-                c != c_end ; ++c)
-        {
-            std::shared_ptr<const QualifiedPackageNameSet> pkgs(
-                    env->fetch_repository(*r)->package_names(*c, may_exclude));
-            std::copy(pkgs->begin(), pkgs->end(), result->inserter());
-        }
-    }
+    auto pkgs(for_each_repository<std::shared_ptr<const QualifiedPackageNameSet> >(env, repos,
+                [&] (const Repository & repo) {
+                    std::shared_ptr<QualifiedPackageNameSet> repo_result(std::make_shared<QualifiedPackageNameSet>());
+                    for (CategoryNamePartSet::ConstIterator c(cats->begin()), c_end(cats->end()) ;
+                            c != c_end ; ++c)
+                    {
+                        std::shared_ptr<const QualifiedPackageNameSet> p(repo.package_names(*c, may_exclude));
+                        std::copy(p->begin(), p->end(), repo_result->inserter());
+                    }
+                    return std::shared_ptr<const QualifiedPackageNameSet>(repo_result);
+                }));
+
+    for (auto p(pkgs.begin()), p_end(pkgs.end()) ;
+            p != p_end ; ++p)
+        std::copy((*p)->begin(), (*p)->end(), result->inserter());
 
     return result;
 }
@@ -98,17 +180,35 @@ AllGeneratorHandlerBase::ids(
         const RepositoryContentMayExcludes & may_exclude) const
 {
     std::shared_ptr<PackageIDSet> result(std::make_shared<PackageIDSet>());
+    std::shared_ptr<const PackageIDSequence> i(ids_in_repositories(env, repos, qpns, may_exclude));
+    std::copy(i->begin(), i->end(), result->inserter());
+    return result;
+}
 
-    for (RepositoryNameSet::ConstIterator r(repos->begin()), r_end(repos->end()) ;
-            r != r_end ; ++r)
-    {
-        for (QualifiedPackageNameSet::ConstIterator q(qpns->begin()), q_end(qpns->end()) ;
-                q != q_end ; ++q)
-        {
-            std::shared_ptr<const PackageIDSequence> i(env->fetch_repository(*r)->package_ids(*q, may_exclude));
-            std::copy(i->begin(), i->end(), result->inserter());
-        }
-    }
+std::shared_ptr<const PackageIDSequence>
+AllGeneratorHandlerBase::ids_in_repositories(
+        const Environment * const env,
+        const std::shared_ptr<const RepositoryNameSet> & repos,
+        const std::shared_ptr<const QualifiedPackageNameSet> & qpns,
+        const RepositoryContentMayExcludes & may_exclude) const
+{
+    std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
+
+    auto ids(for_each_repository<std::shared_ptr<const PackageIDSequence> >(env, repos,
+                [&] (const Repository & repo) {
+                    std::shared_ptr<PackageIDSequence> repo_result(std::make_shared<PackageIDSequence>());
+                    for (QualifiedPackageNameSet::ConstIterator q(qpns->begin()), q_end(qpns->end()) ;
+                            q != q_end ; ++q)
+                    {
+                        std::shared_ptr<const PackageIDSequence> i(repo.package_ids(*q, may_exclude));
+                        std::copy(i->begin(), i->end(), repo_result->back_inserter());
+                    }
+                    return std::shared_ptr<const PackageIDSequence>(repo_result);
+                }));
+
+    for (auto i(ids.begin()), i_end(ids.end()) ;
+            i != i_end ; ++i)
+        std::copy((*i)->begin(), (*i)->end(), result->back_inserter());
 
     return result;
 }
@@ -62,6 +62,14 @@ namespace paludis
                 PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
 
             virtual std::string as_string() const = 0;
+
+            /**
+             * A string which uniquely identifies what we select, for use as
+             * a cache key, or an empty string if we cannot be cached.
+             *
+             * \since 2.4
+             */
+            virtual std::string cache_key() const;
     };
 
     class PALUDIS_VISIBLE AllGeneratorHandlerBase :
@@ -88,6 +96,22 @@ namespace paludis
                     const std::shared_ptr<const RepositoryNameSet> & repos,
                     const std::shared_ptr<const QualifiedPackageNameSet> & qpns,
                     const RepositoryContentMayExcludes &) const;
+
+        protected:
+            /**
+             * Return every ID with any of the given names in any of the given
+             * repositories, in repository order and then name order.
+             *
+             * Different repositories may be asked concurrently, but each
+             * repository is only asked by one thread at a time.
+             *
+             * \since 2.4
+             */
+            std::shared_ptr<const PackageIDSequence> ids_in_repositories(
+                    const Environment * const env,
+                    const std::shared_ptr<const RepositoryNameSet> & repos,
+                    const std::shared_ptr<const QualifiedPackageNameSet> & qpns,
+                    const RepositoryContentMayExcludes &) const;
     };
 }
 
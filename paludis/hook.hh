@@ -167,4 +167,8 @@ extern "C" void PALUDIS_VISIBLE paludis_hook_add_dependencies(
 extern "C" const std::shared_ptr<const paludis::Sequence<std::string> > PALUDIS_VISIBLE paludis_hook_auto_phases(
     const paludis::Environment *);
 
+///\since 2.4
+extern "C" void PALUDIS_VISIBLE paludis_hook_finish_batch(
+    const paludis::Environment *, const std::string & hook_name);
+
 #endif
@@ -29,6 +29,47 @@ if ! source $1 ; then
     exit 123
 fi
 
+hook_batch_command()
+{
+    local r
+    printf '%s\0' "${*}" >&${PALUDIS_HOOK_BATCH_WRITE_FD} || return 1
+    IFS= read -r -d '' r <&${PALUDIS_HOOK_BATCH_READ_FD} || return 1
+    [[ ${r:0:1} == O ]] || return 1
+    hook_batch_record=${r:1}
+}
+
+hook_batch()
+{
+    local n supported= status= output=
+
+    if [[ $(type -t hook_batch_names 2>/dev/null ) == "function" ]] && \
+            [[ $(type -t $1 2>/dev/null ) == "function" ]] ; then
+        for n in $(hook_batch_names ) ; do
+            [[ ${n} == ${HOOK} ]] && supported=yes
+        done
+    fi
+
+    if [[ -z ${supported} ]] ; then
+        hook_batch_command UNSUPPORTED
+        return
+    fi
+
+    while hook_batch_command NEXT "${status}" "${output}" ; do
+        [[ -z ${hook_batch_record} ]] && break
+        if [[ ${2} == batch_grab ]] ; then
+            output=$(eval "${hook_batch_record}" ; $1 )
+        else
+            ( eval "${hook_batch_record}" ; $1 )
+        fi
+        status=${?}
+    done
+}
+
+if [[ -n ${3} ]] ; then
+    hook_batch "${2}" "${3}"
+    exit 0
+fi
+
 if [[ $(type -t $2 2>/dev/null ) != "function" ]] ; then
     if [[ ${2#hook_depend} != ${2} ]] ; then
         exit 0
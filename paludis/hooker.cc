@@ -41,10 +41,14 @@
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/env_var_names.hh>
+#include <paludis/util/destringify.hh>
 
+#include <condition_variable>
 #include <list>
 #include <iterator>
 #include <mutex>
+#include <set>
+#include <thread>
 #include <dlfcn.h>
 #include <stdint.h>
 
@@ -56,11 +60,175 @@ HookFile::~HookFile()
 {
 }
 
+HookResult
+HookFile::run_batched(const Hook & hook, const std::shared_ptr<OutputManager> & optional_output_manager) const
+{
+    return run(hook, optional_output_manager);
+}
+
+void
+HookFile::finish_batch() const
+{
+}
+
 namespace
 {
     static const std::string so_suffix("_" + stringify(PALUDIS_PC_SLOT)
             + ".so." + stringify(100 * PALUDIS_VERSION_MAJOR + PALUDIS_VERSION_MINOR));
 
+    bool is_per_entry_hook(const std::string & name)
+    {
+        if (0 != name.compare(0, 7, "merger_") && 0 != name.compare(0, 9, "unmerger_"))
+            return false;
+
+        for (auto & t : { "_file_", "_dir_", "_sym_", "_misc_" })
+            if (std::string::npos != name.find(t))
+                return true;
+
+        return false;
+    }
+
+    std::string quote(const std::string & s)
+    {
+        std::string result("'");
+        for (auto c : s)
+            if ('\'' == c)
+                result.append("'\\''");
+            else
+                result.append(1, c);
+        result.append("'");
+        return result;
+    }
+
+    /**
+     * A running hooker.bash which is handling a batch of calls to one hook.
+     *
+     * The script asks for each record using a pipe command, passing back the
+     * result of the previous record, and exits when it is given an empty
+     * record.
+     */
+    struct FancyHookBatch
+    {
+        const std::string hook_name;
+        const HookOutputDestination output_dest;
+        const std::shared_ptr<OutputManager> output_manager;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::string record;
+        HookResult result;
+        bool have_record, have_result, unsupported, finished, stopping;
+
+        std::unique_ptr<RunningProcessHandle> handle;
+        std::thread monitor;
+
+        FancyHookBatch(const Hook & hook, const std::shared_ptr<OutputManager> & m) :
+            hook_name(hook.name()),
+            output_dest(hook.output_dest),
+            output_manager(m),
+            result(make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "")),
+            have_record(false),
+            have_result(false),
+            unsupported(false),
+            finished(false),
+            stopping(false)
+        {
+        }
+
+        bool matches(const Hook & hook, const std::shared_ptr<OutputManager> & m) const
+        {
+            return hook_name == hook.name() && output_dest == hook.output_dest && output_manager == m;
+        }
+
+        std::string handle_command(const std::string & s)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if ("UNSUPPORTED" == s)
+            {
+                unsupported = true;
+                condition.notify_all();
+                return "O";
+            }
+            else if (0 != s.compare(0, 5, "NEXT "))
+                return "Eunknown command '" + s + "'";
+
+            std::string::size_type p(s.find(' ', 5));
+            std::string status(s.substr(5, std::string::npos == p ? std::string::npos : p - 5));
+            if (! status.empty())
+            {
+                try
+                {
+                    result.max_exit_status() = destringify<int>(status);
+                }
+                catch (const DestringifyError &)
+                {
+                    result.max_exit_status() = 1;
+                }
+
+                result.output() = strip_trailing(std::string::npos == p ? "" : s.substr(p + 1), " \t\n");
+                have_result = true;
+                condition.notify_all();
+            }
+
+            condition.wait(lock, [&] () { return have_record || stopping; });
+            if (! have_record)
+                return "O";
+
+            have_record = false;
+            return "O" + record;
+        }
+
+        void monitor_process()
+        {
+            int exit_status(-1);
+            try
+            {
+                exit_status = handle->wait();
+            }
+            catch (const Exception &)
+            {
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            finished = true;
+            condition.notify_all();
+
+            if (! (stopping || unsupported))
+                Log::get_instance()->message("hook.fancy.batch_died", ll_warning, lc_no_context)
+                    << "Batch for hook '" << hook_name << "' exited unexpectedly with status '" << exit_status << "'";
+        }
+
+        bool submit(const std::string & r, HookResult & r_result)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            record = r;
+            have_record = true;
+            have_result = false;
+            condition.notify_all();
+
+            condition.wait(lock, [&] () { return have_result || unsupported || finished; });
+            have_record = false;
+            if (! have_result)
+                return false;
+
+            r_result = result;
+            return true;
+        }
+
+        void finish()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopping = true;
+                condition.notify_all();
+            }
+
+            if (monitor.joinable())
+                monitor.join();
+        }
+    };
+
     class BashHookFile :
         public HookFile
     {
@@ -104,7 +272,13 @@ namespace
             const bool _run_prefixed;
             const Environment * const _env;
 
+            mutable std::mutex _batch_mutex;
+            mutable std::unique_ptr<FancyHookBatch> _batch;
+            mutable std::set<std::string> _unbatchable;
+
             void _add_dependency_class(const Hook &, DirectedGraph<std::string, int> &, bool);
+            std::unique_ptr<FancyHookBatch> _start_batch(const Hook &, const std::shared_ptr<OutputManager> &) const;
+            void _finish_batch() const;
 
         public:
             FancyHookFile(const FSPath & f, const bool r, const Environment * const e) :
@@ -114,10 +288,21 @@ namespace
             {
             }
 
+            ~FancyHookFile()
+            {
+                finish_batch();
+            }
+
             virtual HookResult run(
                     const Hook &,
                     const std::shared_ptr<OutputManager> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual HookResult run_batched(
+                    const Hook &,
+                    const std::shared_ptr<OutputManager> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            virtual void finish_batch() const;
+
             virtual const FSPath file_name() const
             {
                 return _file_name;
@@ -139,6 +324,10 @@ namespace
             HookResult (*_run)(const Environment *, const Hook &, const std::shared_ptr<OutputManager> &);
             void (*_add_dependencies)(const Environment *, const Hook &, DirectedGraph<std::string, int> &);
             const std::shared_ptr<const Sequence<std::string > > (*_auto_hook_names)(const Environment *);
+            void (*_finish_batch)(const Environment *, const std::string &);
+
+            mutable std::mutex _batch_mutex;
+            mutable std::set<std::string> _batched_hook_names;
 
         public:
             SoHookFile(const FSPath &, const bool, const Environment * const);
@@ -147,6 +336,12 @@ namespace
                     const Hook &,
                     const std::shared_ptr<OutputManager> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual HookResult run_batched(
+                    const Hook &,
+                    const std::shared_ptr<OutputManager> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            virtual void finish_batch() const;
+
             virtual const FSPath file_name() const
             {
                 return _file_name;
@@ -280,6 +475,117 @@ FancyHookFile::run(const Hook & hook,
             );
 }
 
+HookResult
+FancyHookFile::run_batched(const Hook & hook,
+        const std::shared_ptr<OutputManager> & optional_output_manager) const
+{
+    Context c("When running hook script '" + stringify(file_name()) + "' for hook '" + hook.name() + "' as part of a batch:");
+
+    std::unique_lock<std::mutex> lock(_batch_mutex);
+
+    if (_unbatchable.end() != _unbatchable.find(hook.name()))
+        return run(hook, optional_output_manager);
+
+    if (_batch && ! _batch->matches(hook, optional_output_manager))
+        _finish_batch();
+
+    if (! _batch)
+        _batch = _start_batch(hook, optional_output_manager);
+
+    std::string record("export HOOK=" + quote(hook.name()) + "\n");
+    for (Hook::ConstIterator x(hook.begin()), x_end(hook.end()) ; x != x_end ; ++x)
+        record.append("export " + x->first + "=" + quote(x->second) + "\n");
+
+    HookResult result(make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = ""));
+    if ((! _batch) || (! _batch->submit(record, result)))
+    {
+        if (_batch && ! _batch->unsupported)
+            Log::get_instance()->message("hook.fancy.batch_failed", ll_warning, lc_context)
+                << "Could not run hook '" << file_name() << "' as part of a batch, running it directly instead";
+
+        _finish_batch();
+        _unbatchable.insert(hook.name());
+        return run(hook, optional_output_manager);
+    }
+
+    if (0 == result.max_exit_status())
+        Log::get_instance()->message("hook.fancy.success", ll_debug, lc_no_context) << "Hook '" << file_name()
+            << "' returned success '" << result.max_exit_status() << "'";
+    else
+        Log::get_instance()->message("hook.fancy.failure", ll_warning, lc_no_context) << "Hook '" << file_name()
+            << "' returned failure '" << result.max_exit_status() << "'";
+
+    return result;
+}
+
+std::unique_ptr<FancyHookBatch>
+FancyHookFile::_start_batch(const Hook & hook,
+        const std::shared_ptr<OutputManager> & optional_output_manager) const
+{
+    using namespace std::placeholders;
+
+    Log::get_instance()->message("hook.fancy.starting_batch", ll_debug, lc_no_context) << "Starting hook script '"
+        << file_name() << "' for a batch of '" << hook.name() << "'";
+
+    std::unique_ptr<FancyHookBatch> batch(new FancyHookBatch(hook, optional_output_manager));
+
+    Process process(ProcessCommand({ "sh", "-c", getenv_with_default(env_vars::hooker_dir, LIBEXECDIR "/paludis") +
+                "/hooker.bash '" + stringify(file_name()) + "' 'hook_run_" + stringify(hook.name()) + "' '" +
+                (hook.output_dest == hod_grab ? "batch_grab" : "batch") + "'" }));
+
+    process
+        .setenv("ROOT", stringify(_env->preferred_root_key()->parse_value()))
+        .setenv("HOOK", hook.name())
+        .setenv("HOOK_FILE", stringify(file_name()))
+        .setenv("HOOK_LOG_LEVEL", stringify(Log::get_instance()->log_level()))
+        .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
+        .setenv("PALUDIS_REDUCED_GID", stringify(_env->reduced_gid()))
+        .setenv("PALUDIS_REDUCED_UID", stringify(_env->reduced_uid()))
+        .pipe_command_handler("PALUDIS_HOOK_BATCH", std::bind(&FancyHookBatch::handle_command, batch.get(), _1));
+
+    if (hook.output_dest == hod_stdout && _run_prefixed)
+        process
+            .prefix_stdout(strip_trailing_string(file_name().basename(), ".hook") + "> ")
+            .prefix_stderr(strip_trailing_string(file_name().basename(), ".hook") + "> ");
+
+    if (optional_output_manager)
+    {
+        process.capture_stdout(optional_output_manager->stdout_stream());
+        process.capture_stderr(optional_output_manager->stderr_stream());
+    }
+
+    try
+    {
+        batch->handle.reset(new RunningProcessHandle(process.run()));
+        batch->monitor = std::thread(&FancyHookBatch::monitor_process, batch.get());
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("hook.fancy.batch_start_failed", ll_warning, lc_context)
+            << "Could not start hook script '" << file_name() << "' for a batch: '" << e.message() << "' (" << e.what() << ")";
+        return nullptr;
+    }
+
+    return batch;
+}
+
+void
+FancyHookFile::_finish_batch() const
+{
+    if (_batch)
+    {
+        _batch->finish();
+        _batch.reset();
+    }
+}
+
+void
+FancyHookFile::finish_batch() const
+{
+    std::unique_lock<std::mutex> lock(_batch_mutex);
+    _finish_batch();
+}
+
 const std::shared_ptr<const Sequence<std::string > >
 FancyHookFile::auto_hook_names() const
 {
@@ -399,7 +705,9 @@ SoHookFile::SoHookFile(const FSPath & f, const bool, const Environment * const e
     _env(e),
     _dl(0),
     _run(0),
-    _add_dependencies(0)
+    _add_dependencies(0),
+    _auto_hook_names(0),
+    _finish_batch(0)
 {
     /* don't use RTLD_LOCAL, g++ is over happy about template instantiations, and it
      * can lead to multiple singleton instances. */
@@ -422,6 +730,9 @@ SoHookFile::SoHookFile(const FSPath & f, const bool, const Environment * const e
         _auto_hook_names = reinterpret_cast<const std::shared_ptr<const Sequence<std::string> > (*)(
             const Environment *)>(
                 reinterpret_cast<uintptr_t>(dlsym(_dl, "paludis_hook_auto_phases")));
+
+        _finish_batch = reinterpret_cast<void (*)(const Environment *, const std::string &)>(
+                reinterpret_cast<uintptr_t>(dlsym(_dl, "paludis_hook_finish_batch")));
     }
     else
         Log::get_instance()->message("hook.so.dlopen_failed", ll_warning, lc_no_context)
@@ -443,6 +754,35 @@ SoHookFile::run(const Hook & hook,
     return _run(_env, hook, optional_output_manager);
 }
 
+HookResult
+SoHookFile::run_batched(const Hook & hook,
+        const std::shared_ptr<OutputManager> & optional_output_manager) const
+{
+    if (_finish_batch)
+    {
+        std::unique_lock<std::mutex> lock(_batch_mutex);
+        _batched_hook_names.insert(hook.name());
+    }
+
+    return run(hook, optional_output_manager);
+}
+
+void
+SoHookFile::finish_batch() const
+{
+    std::set<std::string> names;
+    {
+        std::unique_lock<std::mutex> lock(_batch_mutex);
+        std::swap(names, _batched_hook_names);
+    }
+
+    for (const auto & name : names)
+    {
+        Context c("When finishing a batch for .so hook '" + stringify(file_name()) + "' for hook '" + name + "':");
+        _finish_batch(_env, name);
+    }
+}
+
 void
 SoHookFile::add_dependencies(const Hook & hook, DirectedGraph<std::string, int> & g)
 {
@@ -474,12 +814,23 @@ namespace paludis
         mutable std::map<std::string, std::map<std::string, std::shared_ptr<HookFile> > > auto_hook_files;
         mutable bool has_auto_hook_files;
 
+        mutable std::set<std::shared_ptr<HookFile> > batched_hook_files;
+
         Imp(const Environment * const e) :
             env(e),
             has_auto_hook_files(false)
         {
         }
 
+        void finish_batches() const
+        {
+            std::unique_lock<std::recursive_mutex> l(hook_files_mutex);
+
+            for (auto & f : batched_hook_files)
+                f->finish_batch();
+            batched_hook_files.clear();
+        }
+
         void need_auto_hook_files() const
         {
             std::unique_lock<std::recursive_mutex> l(hook_files_mutex);
@@ -538,6 +889,7 @@ Hooker::Hooker(const Environment * const e) :
 
 Hooker::~Hooker()
 {
+    _imp->finish_batches();
 }
 
 void
@@ -781,6 +1133,18 @@ Hooker::perform_hook(
     /* file hooks, but only if necessary */
 
     std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
+
+    const bool per_entry(is_per_entry_hook(hook.name()));
+    if (! per_entry)
+        _imp->finish_batches();
+
+    auto run_hook_file([&] (const std::shared_ptr<HookFile> & f) -> HookResult {
+            if (! per_entry)
+                return f->run(hook, optional_output_manager);
+
+            _imp->batched_hook_files.insert(f);
+            return f->run_batched(hook, optional_output_manager);
+        });
     std::map<std::string, std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > >::iterator h(_imp->hook_files.find(hook.name()));
 
     if (h == _imp->hook_files.end())
@@ -796,7 +1160,7 @@ Hooker::perform_hook(
                     for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(h->second->begin()),
                             f_end(h->second->end()) ; f != f_end ; ++f)
                         if ((*f)->file_name().stat().is_regular_file_or_symlink_to_regular_file())
-                            result.max_exit_status() = std::max(result.max_exit_status(), (*f)->run(hook, optional_output_manager).max_exit_status());
+                            result.max_exit_status() = std::max(result.max_exit_status(), run_hook_file(*f).max_exit_status());
                         else
                             Log::get_instance()->message("hook.not_regular_file", ll_warning, lc_context) << "Hook file '" <<
                                 (*f)->file_name() << "' is not a regular file or has been removed";
@@ -813,7 +1177,7 @@ Hooker::perform_hook(
                             continue;
                         }
 
-                        HookResult tmp((*f)->run(hook, optional_output_manager));
+                        HookResult tmp(run_hook_file(*f));
                         if (tmp.max_exit_status() > result.max_exit_status())
                             result = tmp;
                         else if (! tmp.output().empty())
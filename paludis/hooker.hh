@@ -72,6 +72,26 @@ namespace paludis
                     const Hook &,
                     const std::shared_ptr<OutputManager> & optional_output_manager) const PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
 
+            /**
+             * Run a hook which is called once per merged or unmerged entry.
+             *
+             * Implementations may keep state, such as a running process,
+             * between calls, until finish_batch() is called. By default,
+             * this just calls run().
+             *
+             * \since 2.4
+             */
+            virtual HookResult run_batched(
+                    const Hook &,
+                    const std::shared_ptr<OutputManager> & optional_output_manager) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Finish any batch started by run_batched().
+             *
+             * \since 2.4
+             */
+            virtual void finish_batch() const;
+
             virtual const FSPath file_name() const = 0;
 
             virtual void add_dependencies(const Hook &, DirectedGraph<std::string, int> &) = 0;
@@ -107,6 +127,11 @@ namespace paludis
             /**
              * Perform a hook, return HookResult.
              *
+             * Hooks which are called once per merged or unmerged entry are
+             * run using HookFile::run_batched. Any batches are finished
+             * when a hook which is not of this kind is performed, or when
+             * we are destroyed.
+             *
              * \since 0.53 takes optional_output_manager
              */
             HookResult perform_hook(
@@ -24,6 +24,7 @@
 
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_stat.hh>
 
 #include <iterator>
 
@@ -214,4 +215,52 @@ TEST(Hooker, BadOutput)
     EXPECT_EQ("one\ntwo\nthree\n", line);
 }
 
+TEST(Hooker, Batched)
+{
+    TestEnvironment env;
+    HookResult result(make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = ""));
 
+    FSPath("hooker_TEST_dir/batch.out").unlink();
+    FSPath("hooker_TEST_dir/batch_so.out").unlink();
+    FSPath("hooker_TEST_dir/unbatched.out").unlink();
+
+    {
+        Hooker hooker(&env);
+        hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+
+        result = hooker.perform_hook(Hook("merger_batch_file_post")("ENTRY", "a"), nullptr);
+        EXPECT_EQ(0, result.max_exit_status());
+        result = hooker.perform_hook(Hook("merger_batch_file_post")("ENTRY", "b"), nullptr);
+        EXPECT_EQ(3, result.max_exit_status());
+        result = hooker.perform_hook(Hook("merger_batch_file_post")("ENTRY", "c"), nullptr);
+        EXPECT_EQ(0, result.max_exit_status());
+
+        result = hooker.perform_hook(Hook("merger_batch_file_override")("ENTRY", "d")
+                .grab_output(Hook::AllowedOutputValues()), nullptr);
+        EXPECT_EQ(0, result.max_exit_status());
+        EXPECT_EQ("d", result.output());
+
+        EXPECT_TRUE(! FSPath("hooker_TEST_dir/batch_so.out").stat().exists());
+
+        result = hooker.perform_hook(Hook("merger_batch_post"), nullptr);
+        EXPECT_EQ(0, result.max_exit_status());
+    }
+
+    SafeIFStream f(FSPath("hooker_TEST_dir/batch.out"));
+    std::string entry, pid, first_pid;
+    std::string entries;
+    while (f >> entry >> pid)
+    {
+        entries.append(entry);
+        if (first_pid.empty())
+            first_pid = pid;
+        EXPECT_EQ(first_pid, pid);
+    }
+    EXPECT_EQ("abc", entries);
+
+    SafeIFStream u(FSPath("hooker_TEST_dir/unbatched.out"));
+    EXPECT_EQ("a\nb\nc\n", std::string((std::istreambuf_iterator<char>(u)), std::istreambuf_iterator<char>()));
+
+    SafeIFStream s(FSPath("hooker_TEST_dir/batch_so.out"));
+    EXPECT_EQ("merger_batch_file_post\n", std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>()));
+}
@@ -293,3 +293,36 @@ for a in a b c d e f g h i ; do
     ln -s ../cycles.common cycles/${a}.hook
 done
 
+mkdir merger_batch_file_post
+cat <<"END" > merger_batch_file_post/batched.hook
+hook_run_merger_batch_file_post() {
+    echo "${ENTRY} $$" >> hooker_TEST_dir/batch.out
+    [[ ${ENTRY} == b ]] && return 3
+    return 0
+}
+
+hook_batch_names() {
+    echo merger_batch_file_post merger_batch_file_override
+}
+END
+chmod +x merger_batch_file_post/batched.hook
+
+cat <<"END" > merger_batch_file_post/unbatched.hook
+hook_run_merger_batch_file_post() {
+    echo "${ENTRY}" >> hooker_TEST_dir/unbatched.out
+}
+END
+chmod +x merger_batch_file_post/unbatched.hook
+ln -s ../../.libs/libpaludissohooks_TEST_${PALUDIS_PC_SLOT}.so.${SO_SUFFIX} merger_batch_file_post
+
+mkdir merger_batch_file_override
+cat <<"END" > merger_batch_file_override/batched.hook
+hook_run_merger_batch_file_override() {
+    echo "${ENTRY}"
+}
+
+hook_batch_names() {
+    echo merger_batch_file_override
+}
+END
+chmod +x merger_batch_file_override/batched.hook
@@ -102,13 +102,7 @@ paludis::match_package_with_maybe_changes(
         const ChangedChoices * const maybe_changes_to_target,
         const MatchPackageOptions & options)
 {
-    if (spec.package_ptr() && *spec.package_ptr() != id->name())
-        return false;
-
-    if (spec.package_name_part_ptr() && *spec.package_name_part_ptr() != id->name().package())
-        return false;
-
-    if (spec.category_name_part_ptr() && *spec.category_name_part_ptr() != id->name().category())
+    if (! match_package_name(spec, id->name()))
         return false;
 
     if (spec.version_requirements_ptr())
@@ -245,6 +239,23 @@ paludis::match_package(
     return match_package_with_maybe_changes(env, spec, 0, id, from_id, 0, options);
 }
 
+bool
+paludis::match_package_name(
+        const PackageDepSpec & spec,
+        const QualifiedPackageName & name)
+{
+    if (spec.package_ptr() && *spec.package_ptr() != name)
+        return false;
+
+    if (spec.package_name_part_ptr() && *spec.package_name_part_ptr() != name.package())
+        return false;
+
+    if (spec.category_name_part_ptr() && *spec.category_name_part_ptr() != name.category())
+        return false;
+
+    return true;
+}
+
 bool
 paludis::match_package_in_set(
         const Environment & env,
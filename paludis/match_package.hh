@@ -37,6 +37,7 @@
 #include <paludis/environment-fwd.hh>
 #include <paludis/package_id-fwd.hh>
 #include <paludis/changed_choices-fwd.hh>
+#include <paludis/name-fwd.hh>
 
 namespace paludis
 {
@@ -96,6 +97,21 @@ namespace paludis
             const std::shared_ptr<const PackageID> & id,
             const MatchPackageOptions & options)
         PALUDIS_ATTRIBUTE((warn_unused_result)) PALUDIS_VISIBLE;
+
+    /**
+     * Return whether the specified PackageDepSpec could match a package with
+     * the specified name, considering only the name parts of the spec.
+     *
+     * This is useful for discarding candidate specs before doing a full
+     * match_package for each PackageID with that name.
+     *
+     * \ingroup g_query
+     * \since 2.4
+     */
+    bool match_package_name(
+            const PackageDepSpec & spec,
+            const QualifiedPackageName & name)
+        PALUDIS_ATTRIBUTE((warn_unused_result)) PALUDIS_VISIBLE;
 }
 
 #endif
@@ -25,15 +25,64 @@
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/task_scheduler.hh>
 #include <paludis/selinux/security_context.hh>
 #include <paludis/environment.hh>
 #include <paludis/hook.hh>
+#include <atomic>
+#include <exception>
+#include <list>
 #include <set>
 #include <istream>
 #include <ostream>
 
 using namespace paludis;
 
+namespace
+{
+    /* When merging in parallel, each subtree is handled by a Job. Anything
+     * that must happen in merge order goes into the journal, along with
+     * the jobs for subdirectories, so that it can be replayed afterwards in
+     * the order a serial merge would have used. */
+    struct Job
+    {
+        bool skip_dir;
+        std::list<std::pair<std::function<void ()>, std::shared_ptr<Job> > > journal;
+
+        Job() :
+            skip_dir(false)
+        {
+        }
+
+        void replay()
+        {
+            for (auto & e : journal)
+                if (e.second)
+                    e.second->replay();
+                else
+                    e.first();
+        }
+    };
+
+    PALUDIS_TLS Job * current_job = 0;
+
+    struct SetCurrentJob
+    {
+        Job * const old_job;
+
+        SetCurrentJob(Job * const j) :
+            old_job(current_job)
+        {
+            current_job = j;
+        }
+
+        ~SetCurrentJob()
+        {
+            current_job = old_job;
+        }
+    };
+}
+
 MergerError::MergerError(const std::string & m) throw () :
     Exception(m)
 {
@@ -45,17 +94,67 @@ namespace paludis
     struct Imp<Merger>
     {
         MergerParams params;
-        bool result;
+        std::atomic<bool> result;
         bool skip_dir;
+        TaskScheduler * scheduler;
 
         std::set<FSPath, FSPathComparator> fixed_entries;
 
         Imp(const MergerParams & p) :
             params(p),
             result(true),
-            skip_dir(false)
+            skip_dir(false),
+            scheduler(0)
         {
         }
+
+        bool & skip_dir_flag()
+        {
+            return current_job ? current_job->skip_dir : skip_dir;
+        }
+
+        void run(const std::function<void ()> & f)
+        {
+            if (! params.options()[mo_parallel])
+                return f();
+
+            Job root;
+            std::exception_ptr exception;
+
+            {
+                TaskScheduler s;
+                scheduler = &s;
+
+                try
+                {
+                    SetCurrentJob set_current_job(&root);
+                    f();
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                    s.cancel();
+                }
+
+                try
+                {
+                    s.wait();
+                }
+                catch (...)
+                {
+                    if (! exception)
+                        exception = std::current_exception();
+                }
+
+                scheduler = 0;
+            }
+
+            /* even if something went wrong, record what we did manage */
+            root.replay();
+
+            if (exception)
+                std::rethrow_exception(exception);
+        }
     };
 }
 
@@ -87,7 +186,8 @@ Merger::check()
                 _imp->params.maybe_output_manager()).max_exit_status())
         make_check_fail();
 
-    do_dir_recursive(true, _imp->params.image(), _imp->params.root() / _imp->params.install_under());
+    _imp->run(std::bind(&Merger::do_dir_recursive, this, true, _imp->params.image(),
+                _imp->params.root() / _imp->params.install_under()));
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_post")
@@ -118,7 +218,8 @@ Merger::merge()
     if (! _imp->params.no_chown())
         do_ownership_fixes_recursive(_imp->params.image());
 
-    do_dir_recursive(false, _imp->params.image(), canonicalise_root_path(_imp->params.root() / _imp->params.install_under()));
+    _imp->run(std::bind(&Merger::do_dir_recursive, this, false, _imp->params.image(),
+                canonicalise_root_path(_imp->params.root() / _imp->params.install_under())));
     on_done_merge();
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
@@ -137,6 +238,15 @@ Merger::make_check_fail()
     _imp->result = false;
 }
 
+void
+Merger::in_order(const std::function<void ()> & f) const
+{
+    if (current_job)
+        current_job->journal.push_back(std::make_pair(f, std::shared_ptr<Job>()));
+    else
+        f();
+}
+
 void
 Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
 {
@@ -182,11 +292,26 @@ Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
                 on_dir(is_check, *d, dst);
                 if (_imp->result)
                 {
-                    if (! _imp->skip_dir)
-                        do_dir_recursive(is_check, *d,
-                                is_check ? (dst / d->basename()) : canonicalise_root_path(dst / d->basename()));
+                    bool & skip_dir(_imp->skip_dir_flag());
+                    if (skip_dir)
+                        skip_dir = false;
                     else
-                        _imp->skip_dir = false;
+                    {
+                        const FSPath sub_src(*d);
+                        const FSPath sub_dst(is_check ? (dst / d->basename()) : canonicalise_root_path(dst / d->basename()));
+
+                        if (_imp->scheduler)
+                        {
+                            std::shared_ptr<Job> job(std::make_shared<Job>());
+                            current_job->journal.push_back(std::make_pair(std::function<void ()>(), job));
+                            _imp->scheduler->post([this, job, is_check, sub_src, sub_dst] () {
+                                    SetCurrentJob set_current_job(job.get());
+                                    do_dir_recursive(is_check, sub_src, sub_dst);
+                                    });
+                        }
+                        else
+                            do_dir_recursive(is_check, sub_src, sub_dst);
+                    }
                 }
                 continue;
 
@@ -316,7 +441,7 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
         {
             std::string tidy(stringify(staged.strip_leading(_imp->params.root().realpath())));
             display_override("--- [skp] " + tidy);
-            _imp->skip_dir = true;
+            _imp->skip_dir_flag() = true;
             return;
         }
     }
@@ -406,7 +531,7 @@ Merger::symlink_needs_rewriting(const FSPath & sym)
 void
 Merger::set_skipped_dir(const bool value)
 {
-    _imp->skip_dir = value;
+    _imp->skip_dir_flag() = value;
 }
 
 void
@@ -102,8 +102,24 @@ namespace paludis
              */
             void make_check_fail();
 
+            /**
+             * Run something that must happen in merge order, such as
+             * recording or displaying an entry.
+             *
+             * Usually this happens immediately. If mo_parallel is set,
+             * it happens once every subtree has been handled, in the order
+             * a non-parallel merge would have used.
+             *
+             * \since 2.4
+             */
+            void in_order(const std::function<void ()> &) const;
+
             /**
              * Handle a directory, recursively.
+             *
+             * If mo_parallel is set, subdirectories may be handled by other
+             * threads, and may not have been handled by the time
+             * on_leave_dir is called.
              */
             virtual void do_dir_recursive(bool is_check, const FSPath &, const FSPath &);
 
@@ -18,30 +18,61 @@
  */
 
 #include <paludis/metadata_key_holder.hh>
-#include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/exception.hh>
 #include <paludis/util/pimp-impl.hh>
+#include <paludis/util/hashes.hh>
 #include <paludis/metadata_key.hh>
-#include <functional>
-#include <list>
+#include <vector>
 #include <algorithm>
 
 using namespace paludis;
 
 namespace paludis
 {
+    /* keys live in a vector in the order they were added, with a small open
+     * addressed table of indices into it for lookups by name. we remember
+     * each key's name hash, so finding a key only asks a key for its
+     * raw_name() when the hashes match. */
     template <>
     struct Imp<MetadataKeyHolder>
     {
-        mutable std::list<std::shared_ptr<const MetadataKey> > keys;
+        mutable std::vector<std::shared_ptr<const MetadataKey> > keys;
+        mutable std::vector<std::size_t> hashes;
+
+        /* zero for an empty slot, otherwise one more than the index into keys */
+        mutable std::vector<unsigned> slots;
+
+        std::vector<unsigned>::size_type find_slot(const std::string & name, const std::size_t hash) const
+        {
+            const std::size_t mask(slots.size() - 1);
+            for (std::size_t p(hash & mask) ; ; p = (p + 1) & mask)
+            {
+                unsigned s(slots[p]);
+                if (0 == s || (hashes[s - 1] == hash && keys[s - 1]->raw_name() == name))
+                    return p;
+            }
+        }
+
+        void rehash(const std::vector<unsigned>::size_type n) const
+        {
+            slots.assign(n, 0);
+            const std::size_t mask(n - 1);
+            for (unsigned i(0), i_end(keys.size()) ; i != i_end ; ++i)
+            {
+                std::size_t p(hashes[i] & mask);
+                while (0 != slots[p])
+                    p = (p + 1) & mask;
+                slots[p] = i + 1;
+            }
+        }
     };
 
     template <>
     struct WrappedForwardIteratorTraits<MetadataKeyHolder::MetadataConstIteratorTag>
     {
-        typedef std::list<std::shared_ptr<const MetadataKey> >::const_iterator UnderlyingIterator;
+        typedef std::vector<std::shared_ptr<const MetadataKey> >::const_iterator UnderlyingIterator;
     };
 }
 
@@ -57,13 +88,19 @@ MetadataKeyHolder::~MetadataKeyHolder()
 void
 MetadataKeyHolder::add_metadata_key(const std::shared_ptr<const MetadataKey> & k) const
 {
-    using namespace std::placeholders;
+    const std::string name(k->raw_name());
+    const std::size_t hash(Hash<std::string>()(name));
 
-    if (indirect_iterator(_imp->keys.end()) != std::find_if(indirect_iterator(_imp->keys.begin()), indirect_iterator(_imp->keys.end()),
-                std::bind(std::equal_to<std::string>(), k->raw_name(), std::bind(std::mem_fn(&MetadataKey::raw_name), _1))))
-        throw ConfigurationError("Tried to add duplicate key '" + k->raw_name() + "'");
+    if ((_imp->keys.size() + 1) * 2 > _imp->slots.size())
+        _imp->rehash(std::max<std::vector<unsigned>::size_type>(16, _imp->slots.size() * 2));
+
+    auto p(_imp->find_slot(name, hash));
+    if (0 != _imp->slots[p])
+        throw ConfigurationError("Tried to add duplicate key '" + name + "'");
 
     _imp->keys.push_back(k);
+    _imp->hashes.push_back(hash);
+    _imp->slots[p] = _imp->keys.size();
 }
 
 MetadataKeyHolder::MetadataConstIterator
@@ -83,25 +120,23 @@ MetadataKeyHolder::end_metadata() const
 MetadataKeyHolder::MetadataConstIterator
 MetadataKeyHolder::find_metadata(const std::string & s) const
 {
-    using namespace std::placeholders;
-
     need_keys_added();
 
-    // std::mem_fn on a sptr doesn't work with boost
-    // return std::find_if(begin_metadata(), end_metadata(),
-    //        std::bind(std::equal_to<std::string>(), s, std::bind(std::mem_fn(&MetadataKey::raw_name), _1)));
+    if (_imp->keys.empty())
+        return MetadataConstIterator(_imp->keys.end());
 
-    for (MetadataConstIterator i(begin_metadata()), i_end(end_metadata()) ;
-            i != i_end ; ++i)
-        if ((*i)->raw_name() == s)
-            return i;
-    return end_metadata();
+    unsigned slot(_imp->slots[_imp->find_slot(s, Hash<std::string>()(s))]);
+    if (0 == slot)
+        return MetadataConstIterator(_imp->keys.end());
+    return MetadataConstIterator(_imp->keys.begin() + (slot - 1));
 }
 
 void
 MetadataKeyHolder::clear_metadata_keys() const
 {
     _imp->keys.clear();
+    _imp->hashes.clear();
+    _imp->slots.clear();
 }
 
 namespace paludis
@@ -0,0 +1,101 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/metadata_key_holder.hh>
+#include <paludis/literal_metadata_key.hh>
+
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct TestHolder :
+        MetadataKeyHolder
+    {
+        void add(const std::string & name) const
+        {
+            add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string> >(name, name, mkt_normal, "value of " + name));
+        }
+
+        void clear() const
+        {
+            clear_metadata_keys();
+        }
+
+        void need_keys_added() const
+        {
+        }
+    };
+}
+
+TEST(MetadataKeyHolder, Empty)
+{
+    TestHolder h;
+    EXPECT_TRUE(h.begin_metadata() == h.end_metadata());
+    EXPECT_TRUE(h.find_metadata("FOO") == h.end_metadata());
+}
+
+TEST(MetadataKeyHolder, Find)
+{
+    TestHolder h;
+    for (int i(0) ; i < 100 ; ++i)
+        h.add("KEY" + stringify(i));
+
+    int n(0);
+    for (auto i(h.begin_metadata()), i_end(h.end_metadata()) ; i != i_end ; ++i)
+        EXPECT_EQ("KEY" + stringify(n++), (*i)->raw_name());
+    EXPECT_EQ(100, n);
+
+    for (int i(0) ; i < 100 ; ++i)
+    {
+        auto k(h.find_metadata("KEY" + stringify(i)));
+        ASSERT_TRUE(k != h.end_metadata());
+        EXPECT_EQ("KEY" + stringify(i), (*k)->raw_name());
+    }
+
+    EXPECT_TRUE(h.find_metadata("KEY100") == h.end_metadata());
+    EXPECT_TRUE(h.find_metadata("") == h.end_metadata());
+}
+
+TEST(MetadataKeyHolder, Duplicates)
+{
+    TestHolder h;
+    h.add("FOO");
+    h.add("BAR");
+    EXPECT_THROW(h.add("FOO"), ConfigurationError);
+    EXPECT_EQ(2, std::distance(h.begin_metadata(), h.end_metadata()));
+}
+
+TEST(MetadataKeyHolder, Clear)
+{
+    TestHolder h;
+    h.add("FOO");
+    h.clear();
+    EXPECT_TRUE(h.begin_metadata() == h.end_metadata());
+    EXPECT_TRUE(h.find_metadata("FOO") == h.end_metadata());
+
+    h.add("FOO");
+    EXPECT_TRUE(h.find_metadata("FOO") != h.end_metadata());
+}
+
@@ -241,7 +241,7 @@ namespace
     CategoryNamePart
     get_category_name_part(const std::string & s)
     {
-        Context c("When splitting out category and package names from '" + s + "':");
+        Context c("When splitting out category and package names from '", s, "':");
 
         std::string::size_type p(s.find('/'));
         if (std::string::npos == p)
@@ -254,7 +254,7 @@ namespace
     PackageNamePart
     get_package_name_part(const std::string & s)
     {
-        Context c("When splitting out category and package names from '" + s + "':");
+        Context c("When splitting out category and package names from '", s, "':");
 
         std::string::size_type p(s.find('/'));
         if (std::string::npos == p)
@@ -280,18 +280,18 @@ QualifiedPackageName::QualifiedPackageName(const CategoryNamePart & c, const Pac
 bool
 QualifiedPackageName::operator< (const QualifiedPackageName & other) const
 {
-    if (category() < other.category())
+    if (_cat < other._cat)
         return true;
-    if (category() > other.category())
+    if (! (_cat == other._cat))
         return false;
 
-    return package() < other.package();
+    return _pkg < other._pkg;
 }
 
 bool
 QualifiedPackageName::operator== (const QualifiedPackageName & other) const
 {
-    return category() == other.category() && package() == other.package();
+    return _cat == other._cat && _pkg == other._pkg;
 }
 
 bool
@@ -307,7 +307,7 @@ WrappedValueTraits<SetNameTag>::validate(const std::string & s)
 
     if (s.length() > 1 && '*' == s[s.length() - 1] && '*' != s[s.length() - 2])
     {
-        Context c("When validating set name '" + s + "':");
+        Context c("When validating set name '", s, "':");
         return validate(s.substr(0, s.length() - 1));
     }
 
@@ -358,6 +358,6 @@ WrappedValueTraits<PartNameTag>::validate(const std::string & name)
 std::size_t
 QualifiedPackageName::hash() const
 {
-    return Hash<std::string>()(stringify(*this));
+    return (_cat.hash() << 8) ^ _pkg.hash();
 }
 
@@ -70,6 +70,13 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    ///\since 2.4
+    template <>
+    struct WrappedValueInterned<PackageNamePartTag> :
+        std::true_type
+    {
+    };
+
     extern template class PALUDIS_VISIBLE WrappedValue<PackageNamePartTag>;
 
     /**
@@ -99,6 +106,13 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    ///\since 2.4
+    template <>
+    struct WrappedValueInterned<CategoryNamePartTag> :
+        std::true_type
+    {
+    };
+
     extern template class PALUDIS_VISIBLE WrappedValue<CategoryNamePartTag>;
 
     /**
@@ -166,6 +180,13 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    ///\since 2.4
+    template <>
+    struct WrappedValueInterned<SlotNameTag> :
+        std::true_type
+    {
+    };
+
     /**
      * A RepositoryNameError is thrown if an invalid value is assigned to
      * a RepositoryName.
@@ -192,6 +213,13 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    ///\since 2.4
+    template <>
+    struct WrappedValueInterned<RepositoryNameTag> :
+        std::true_type
+    {
+    };
+
     /**
      * A KeywordNameError is thrown if an invalid value is assigned to
      * a KeywordName.
@@ -218,6 +246,13 @@ namespace paludis
         static bool validate(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    ///\since 2.4
+    template <>
+    struct WrappedValueInterned<KeywordNameTag> :
+        std::true_type
+    {
+    };
+
     /**
      * A SetNameError is thrown if an invalid value is assigned to
      * a SetName.
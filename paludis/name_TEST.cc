@@ -59,6 +59,20 @@ TEST(QualifiedPackageName, Compare)
     EXPECT_TRUE( (foo2_bar1 >  foo1_bar2));
 }
 
+TEST(QualifiedPackageName, Interned)
+{
+    QualifiedPackageName a("foo/bar"), b(CategoryNamePart("foo") + PackageNamePart("bar")), c("foo/baz");
+
+    EXPECT_EQ(&a.category().value(), &b.category().value());
+    EXPECT_EQ(&a.package().value(), &b.package().value());
+    EXPECT_NE(&a.package().value(), &c.package().value());
+
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_TRUE(a != c);
+    EXPECT_TRUE(a < c);
+}
+
 TEST(CategoryNamePart, Create)
 {
     CategoryNamePart p("foo");
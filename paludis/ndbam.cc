@@ -32,6 +32,7 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_error.hh>
+#include <paludis/util/mapped_file.hh>
 #include <paludis/ndbam.hh>
 #include <paludis/package_id.hh>
 #include <paludis/metadata_key.hh>
@@ -43,6 +44,7 @@
 #include <functional>
 #include <vector>
 #include <map>
+#include <cstring>
 
 using namespace paludis;
 
@@ -432,184 +434,275 @@ NDBAM::remove_entry(const QualifiedPackageName & q, const FSPath & d)
     }
 }
 
-void
-NDBAM::parse_contents(const PackageID & id,
-        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_file,
-        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_dir,
-        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_sym
-        ) const
+namespace
 {
-    Context c("When fetching contents for '" + stringify(id) + "':");
-
-    if (! id.fs_location_key())
-        throw InternalError(PALUDIS_HERE, "No id.fs_location_key");
+    typedef std::function<bool (const std::string & path, const std::string & part, const std::string & md5,
+            const time_t mtime, const bool is_volatile)> OnFileData;
+    typedef std::function<bool (const std::string & path)> OnDirData;
+    typedef std::function<bool (const std::string & path, const std::string & target, const std::string & part,
+            const time_t mtime, const bool is_volatile)> OnSymData;
+
+    std::shared_ptr<const ContentsEntry> make_file_entry(const std::string & path, const std::string & part, const std::string & md5,
+            const time_t mtime, const bool is_volatile)
+    {
+        std::shared_ptr<ContentsFileEntry> entry(std::make_shared<ContentsFileEntry>(FSPath(path), part));
+        entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string>>("md5", "md5", mkt_normal, md5));
+        entry->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal, Timestamp(mtime, 0)));
+        if (is_volatile)
+            entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, is_volatile));
+        return entry;
+    }
 
-    FSPath ff(id.fs_location_key()->parse_value() / "contents");
-    if (! ff.stat().is_regular_file_or_symlink_to_regular_file())
+    std::shared_ptr<const ContentsEntry> make_sym_entry(const std::string & path, const std::string & target, const std::string & part,
+            const time_t mtime, const bool is_volatile)
     {
-        Log::get_instance()->message("ndbam.contents.skipping", ll_warning, lc_context)
-            << "Contents file '" << ff << "' not a regular file, skipping";
-        return;
+        std::shared_ptr<ContentsSymEntry> entry(std::make_shared<ContentsSymEntry>(FSPath(path), target, part));
+        entry->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal, Timestamp(mtime, 0)));
+        if (is_volatile)
+            entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, is_volatile));
+        return entry;
     }
 
-    LineConfigFile f(ff, { });
-    for (LineConfigFile::ConstIterator line(f.begin()), line_end(f.end()) ;
-            line != line_end ; ++line)
+    void parse_contents_data(const PackageID & id, const OnFileData & on_file, const OnDirData & on_dir, const OnSymData & on_sym)
     {
-        std::map<std::string, std::string> tokens;
-        std::string::size_type p(0);
-        bool error(false);
-        while ((! error) && (p < line->length()) && (std::string::npos != p))
+        Context c("When fetching contents for '" + stringify(id) + "':");
+
+        if (! id.fs_location_key())
+            throw InternalError(PALUDIS_HERE, "No id.fs_location_key");
+
+        FSPath ff(id.fs_location_key()->parse_value() / "contents");
+        if (! ff.stat().is_regular_file_or_symlink_to_regular_file())
         {
-            std::string::size_type q(line->find('=', p));
-            if (std::string::npos == q)
-            {
-                Log::get_instance()->message("ndbam.contents.invalid", ll_warning, lc_context)
-                    << "Malformed line '" << *line << "' in '" << ff << "'";
-                error = true;
+            Log::get_instance()->message("ndbam.contents.skipping", ll_warning, lc_context)
+                << "Contents file '" << ff << "' not a regular file, skipping";
+            return;
+        }
+
+        /* we only ever write one entry per line, with no continuations or
+         * runs of unescaped whitespace, so there's no need to go through
+         * LineConfigFile and hold every line in memory at once */
+        MappedFile m(ff);
+        for (const char * l(m.data()), * l_end(m.data() + m.size()) ; l != l_end ; )
+        {
+            const char * e(static_cast<const char *>(std::memchr(l, '\n', l_end - l)));
+            std::string line(l, e ? e : l_end);
+            l = e ? e + 1 : l_end;
+
+            std::string::size_type first(line.find_first_not_of(" \t"));
+            if (std::string::npos == first || '#' == line[first])
                 continue;
-            }
+            line.erase(0, first);
 
-            std::string key(line->substr(p, q - p)), value;
-            p = q + 1;
-            while (p < line->length() && std::string::npos != p)
+            std::map<std::string, std::string> tokens;
+            std::string::size_type p(0);
+            bool error(false);
+            while ((! error) && (p < line.length()) && (std::string::npos != p))
             {
-                if ('\\' == (*line)[p])
+                std::string::size_type q(line.find('=', p));
+                if (std::string::npos == q)
                 {
-                    ++p;
-                    if (p >= line->length() || std::string::npos == p)
+                    Log::get_instance()->message("ndbam.contents.invalid", ll_warning, lc_context)
+                        << "Malformed line '" << line << "' in '" << ff << "'";
+                    error = true;
+                    continue;
+                }
+
+                std::string key(line.substr(p, q - p)), value;
+                p = q + 1;
+                while (p < line.length() && std::string::npos != p)
+                {
+                    if ('\\' == line[p])
+                    {
+                        ++p;
+                        if (p >= line.length() || std::string::npos == p)
+                        {
+                            Log::get_instance()->message("ndbam.contents.invalid", ll_warning, lc_context)
+                                << "Malformed line '" << line << "' in '" << ff << "'";
+                            error = true;
+                            break;
+                        }
+                        if ('n' == line[p])
+                            value.append("\n");
+                        else
+                            value.append(1, line[p]);
+                        ++p;
+                    }
+                    else if (' ' == line[p])
                     {
-                        Log::get_instance()->message("ndbam.contents.invalid", ll_warning, lc_context)
-                            << "Malformed line '" << *line << "' in '" << ff << "'";
-                        error = true;
+                        if (! tokens.insert(std::make_pair(key, value)).second)
+                            Log::get_instance()->message("ndbam.contents.duplicate", ll_warning, lc_context)
+                                << "Duplicate token '" << key << "' on line '" << line << "' in '" << ff << "'";
+                        key.clear();
+                        value.clear();
+                        ++p;
                         break;
                     }
-                    if ('n' == (*line)[p])
-                        value.append("\n");
                     else
-                        value.append(1, (*line)[p]);
-                    ++p;
+                    {
+                        value.append(1, line[p]);
+                        ++p;
+                    }
                 }
-                else if (' ' == (*line)[p])
+
+                if ((! error) && (! key.empty()))
                 {
                     if (! tokens.insert(std::make_pair(key, value)).second)
                         Log::get_instance()->message("ndbam.contents.duplicate", ll_warning, lc_context)
-                            << "Duplicate token '" << key << "' on line '" << *line << "' in '" << ff << "'";
-                    key.clear();
-                    value.clear();
-                    ++p;
-                    break;
-                }
-                else
-                {
-                    value.append(1, (*line)[p]);
-                    ++p;
+                            << "Duplicate token '" << key << "' on line '" << line << "' in '" << ff << "'";
                 }
             }
 
-            if ((! error) && (! key.empty()))
+            if (error)
+                continue;
+
+            if (! tokens.count("type"))
             {
-                if (! tokens.insert(std::make_pair(key, value)).second)
-                    Log::get_instance()->message("ndbam.contents.duplicate", ll_warning, lc_context)
-                        << "Duplicate token '" << key << "' on line '" << *line << "' in '" << ff << "'";
+                Log::get_instance()->message("ndbam.contents.no_key.type", ll_warning, lc_context) <<
+                    "No key 'type' found on line '" << line << "' in '" << ff << "'";
+                continue;
             }
-        }
-
-        if (error)
-            continue;
-
-        if (! tokens.count("type"))
-        {
-            Log::get_instance()->message("ndbam.contents.no_key.type", ll_warning, lc_context) <<
-                "No key 'type' found on line '" << *line << "' in '" << ff << "'";
-            continue;
-        }
-        std::string type(tokens.find("type")->second);
+            std::string type(tokens.find("type")->second);
 
-        if (! tokens.count("path"))
-        {
-            Log::get_instance()->message("ndbam.contents.no_key.path", ll_warning, lc_context) <<
-                "No key 'path' found on line '" << *line << "' in '" << ff << "'";
-            continue;
-        }
-        std::string path(tokens.find("path")->second);
-
-        if ("file" == type)
-        {
-            if (! tokens.count("md5"))
+            if (! tokens.count("path"))
             {
-                Log::get_instance()->message("ndbam.contents.no_key.md5", ll_warning, lc_context) <<
-                    "No key 'md5' found on sym line '" << *line << "' in '" << ff << "'";
+                Log::get_instance()->message("ndbam.contents.no_key.path", ll_warning, lc_context) <<
+                    "No key 'path' found on line '" << line << "' in '" << ff << "'";
                 continue;
             }
-            std::string md5(tokens.find("md5")->second);
+            std::string path(tokens.find("path")->second);
+
+            if ("file" == type)
+            {
+                if (! tokens.count("md5"))
+                {
+                    Log::get_instance()->message("ndbam.contents.no_key.md5", ll_warning, lc_context) <<
+                        "No key 'md5' found on sym line '" << line << "' in '" << ff << "'";
+                    continue;
+                }
+                std::string md5(tokens.find("md5")->second);
 
-            std::string part;
-            if (tokens.count("part"))
-                part = tokens.find("part")->second;
+                std::string part;
+                if (tokens.count("part"))
+                    part = tokens.find("part")->second;
 
-            bool isvolatile = false;
-            if (tokens.count("volatile"))
-                isvolatile = destringify<bool>(tokens.find("volatile")->second);
+                bool isvolatile = false;
+                if (tokens.count("volatile"))
+                    isvolatile = destringify<bool>(tokens.find("volatile")->second);
 
-            if (! tokens.count("mtime"))
-            {
-                Log::get_instance()->message("ndbam.contents.no_key.mtime", ll_warning, lc_context) <<
-                    "No key 'mtime' found on sym line '" << *line << "' in '" << ff << "'";
-                continue;
+                if (! tokens.count("mtime"))
+                {
+                    Log::get_instance()->message("ndbam.contents.no_key.mtime", ll_warning, lc_context) <<
+                        "No key 'mtime' found on sym line '" << line << "' in '" << ff << "'";
+                    continue;
+                }
+                time_t mtime(destringify<time_t>(tokens.find("mtime")->second));
+
+                if (! on_file(path, part, md5, mtime, isvolatile))
+                    return;
             }
-            time_t mtime(destringify<time_t>(tokens.find("mtime")->second));
-
-            std::shared_ptr<ContentsFileEntry> entry(std::make_shared<ContentsFileEntry>(FSPath(path), part));
-            entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string>>("md5", "md5", mkt_normal, md5));
-            entry->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal, Timestamp(mtime, 0)));
-            if (isvolatile)
-                entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, isvolatile));
-            on_file(entry);
-        }
-        else if ("dir" == type)
-        {
-            std::shared_ptr<ContentsDirEntry> entry(std::make_shared<ContentsDirEntry>(FSPath(path)));
-            on_dir(entry);
-        }
-        else if ("sym" == type)
-        {
-            if (! tokens.count("target"))
+            else if ("dir" == type)
             {
-                Log::get_instance()->message("ndbam.contents.no_key.target", ll_warning, lc_context) <<
-                    "No key 'target' found on sym line '" << *line << "' in '" << ff << "'";
-                continue;
+                if (! on_dir(path))
+                    return;
             }
-            std::string target(tokens.find("target")->second);
-
-            if (! tokens.count("mtime"))
+            else if ("sym" == type)
             {
-                Log::get_instance()->message("ndbam.contents.no_key.mtime", ll_warning, lc_context) <<
-                    "No key 'mtime' found on sym line '" << *line << "' in '" << ff << "'";
-                continue;
-            }
-            time_t mtime(destringify<time_t>(tokens.find("mtime")->second));
+                if (! tokens.count("target"))
+                {
+                    Log::get_instance()->message("ndbam.contents.no_key.target", ll_warning, lc_context) <<
+                        "No key 'target' found on sym line '" << line << "' in '" << ff << "'";
+                    continue;
+                }
+                std::string target(tokens.find("target")->second);
 
-            std::string part;
-            if (tokens.count("part"))
-                part = tokens.find("part")->second;
+                if (! tokens.count("mtime"))
+                {
+                    Log::get_instance()->message("ndbam.contents.no_key.mtime", ll_warning, lc_context) <<
+                        "No key 'mtime' found on sym line '" << line << "' in '" << ff << "'";
+                    continue;
+                }
+                time_t mtime(destringify<time_t>(tokens.find("mtime")->second));
+
+                std::string part;
+                if (tokens.count("part"))
+                    part = tokens.find("part")->second;
 
-            bool isvolatile = false;
-            if (tokens.count("volatile"))
-                isvolatile = destringify<bool>(tokens.find("volatile")->second);
+                bool isvolatile = false;
+                if (tokens.count("volatile"))
+                    isvolatile = destringify<bool>(tokens.find("volatile")->second);
 
-            std::shared_ptr<ContentsSymEntry> entry(std::make_shared<ContentsSymEntry>(FSPath(path), target, part));
-            entry->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal, Timestamp(mtime, 0)));
-            if (isvolatile)
-                entry->add_metadata_key(std::make_shared<LiteralMetadataValueKey<bool> >("volatile", "volatile", mkt_normal, isvolatile));
-            on_sym(entry);
+                if (! on_sym(path, target, part, mtime, isvolatile))
+                    return;
+            }
+            else
+                Log::get_instance()->message("ndbam.contents.unknown_type", ll_warning, lc_context) <<
+                    "Unknown type '" << type << "' found on line '" << line << "' in '" << ff << "'";
         }
-        else
-            Log::get_instance()->message("ndbam.contents.unknown_type", ll_warning, lc_context) <<
-                "Unknown type '" << type << "' found on line '" << *line << "' in '" << ff << "'";
     }
 }
 
+void
+NDBAM::parse_contents(const PackageID & id,
+        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_file,
+        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_dir,
+        const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_sym
+        ) const
+{
+    parse_contents_data(id,
+            [&] (const std::string & path, const std::string & part, const std::string & md5,
+                const time_t mtime, const bool is_volatile) {
+                on_file(make_file_entry(path, part, md5, mtime, is_volatile));
+                return true;
+            },
+            [&] (const std::string & path) {
+                on_dir(std::make_shared<ContentsDirEntry>(FSPath(path)));
+                return true;
+            },
+            [&] (const std::string & path, const std::string & target, const std::string & part,
+                const time_t mtime, const bool is_volatile) {
+                on_sym(make_sym_entry(path, target, part, mtime, is_volatile));
+                return true;
+            });
+}
+
+void
+NDBAM::parse_contents(const PackageID & id, Contents & contents) const
+{
+    parse_contents_data(id,
+            [&] (const std::string & path, const std::string & part, const std::string & md5,
+                const time_t mtime, const bool is_volatile) {
+                contents.add_file(FSPath(path), part, md5, Timestamp(mtime, 0), is_volatile);
+                return true;
+            },
+            [&] (const std::string & path) {
+                contents.add_dir(FSPath(path));
+                return true;
+            },
+            [&] (const std::string & path, const std::string & target, const std::string & part,
+                const time_t mtime, const bool is_volatile) {
+                contents.add_sym(FSPath(path), target, part, Timestamp(mtime, 0), is_volatile);
+                return true;
+            });
+}
+
+void
+NDBAM::for_each_contents_entry(const PackageID & id,
+        const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> & f) const
+{
+    parse_contents_data(id,
+            [&] (const std::string & path, const std::string & part, const std::string & md5,
+                const time_t mtime, const bool is_volatile) {
+                return f(make_file_entry(path, part, md5, mtime, is_volatile));
+            },
+            [&] (const std::string & path) {
+                return f(std::make_shared<ContentsDirEntry>(FSPath(path)));
+            },
+            [&] (const std::string & path, const std::string & target, const std::string & part,
+                const time_t mtime, const bool is_volatile) {
+                return f(make_sym_entry(path, target, part, mtime, is_volatile));
+            });
+}
+
 std::shared_ptr<const CategoryNamePartSet>
 NDBAM::category_names_containing_package(const PackageNamePart & p) const
 {
@@ -124,6 +124,23 @@ namespace paludis
                     const std::function<void (const std::shared_ptr<const ContentsEntry> &)> & on_sym
                     ) const;
 
+            /**
+             * Parse the contents file for a given ID, adding entries to a
+             * Contents using its compact add methods.
+             *
+             * \since 2.4
+             */
+            void parse_contents(const PackageID &, Contents &) const;
+
+            /**
+             * Parse the contents file for a given ID an entry at a time,
+             * stopping early if the function returns false.
+             *
+             * \since 2.4
+             */
+            void for_each_contents_entry(const PackageID &,
+                    const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> &) const;
+
             /**
              * Index a newly added QualifiedPackageName, using the provided data directory
              * name part.
@@ -46,6 +46,7 @@
 #include <paludis/slot.hh>
 
 #include <iomanip>
+#include <sstream>
 #include <list>
 
 using namespace paludis;
@@ -183,15 +184,18 @@ NDBAMMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, con
     if (_imp->params.parts())
         part = _imp->params.parts()->classify(FSPath(tidy)).value();
 
-    *_imp->contents_file << "type=file";
-    *_imp->contents_file << " path=" << escape(tidy_real);
-    *_imp->contents_file << " md5=" << md5.hexsum();
-    *_imp->contents_file << " mtime=" << timestamp;
+    std::ostringstream line;
+    line << "type=file";
+    line << " path=" << escape(tidy_real);
+    line << " md5=" << md5.hexsum();
+    line << " mtime=" << timestamp;
     if (!part.empty())
-        *_imp->contents_file << " part=" << part;
+        line << " part=" << part;
     if (_imp->params.is_volatile()(FSPath(tidy)))
-        *_imp->contents_file << " volatile=true";
-    *_imp->contents_file << std::endl;
+        line << " volatile=true";
+
+    const std::string l(line.str());
+    in_order([this, l] () { *_imp->contents_file << l << std::endl; });
 }
 
 void
@@ -202,7 +206,8 @@ NDBAMMerger::record_install_dir(const FSPath & src, const FSPath & dst_dir, cons
 
     display_merge(et_dir, dir, flags);
 
-    *_imp->contents_file << "type=dir path=" << escape(tidy) << std::endl;
+    const std::string l("type=dir path=" + escape(tidy));
+    in_order([this, l] () { *_imp->contents_file << l << std::endl; });
 }
 
 void
@@ -212,7 +217,8 @@ NDBAMMerger::record_install_under_dir(const FSPath & dst, const FSMergerStatusFl
 
     display_merge(et_dir, dst, flags);
 
-    *_imp->contents_file << "type=dir path=" << escape(tidy) << std::endl;
+    const std::string l("type=dir path=" + escape(tidy));
+    in_order([this, l] () { *_imp->contents_file << l << std::endl; });
 }
 
 void
@@ -225,12 +231,15 @@ NDBAMMerger::record_install_sym(const FSPath & src, const FSPath & dst_dir, cons
 
     display_merge(et_sym, sym, flags);
 
-    *_imp->contents_file << "type=sym path=" << escape(tidy);
-    *_imp->contents_file << " target=" << escape(target);
-    *_imp->contents_file << " mtime=" << timestamp.seconds();
+    std::ostringstream line;
+    line << "type=sym path=" << escape(tidy);
+    line << " target=" << escape(target);
+    line << " mtime=" << timestamp.seconds();
     if (_imp->params.is_volatile()(FSPath(tidy)))
-        *_imp->contents_file << " volatile=true";
-    *_imp->contents_file << std::endl;
+        line << " volatile=true";
+
+    const std::string l(line.str());
+    in_order([this, l] () { *_imp->contents_file << l << std::endl; });
 }
 
 void
@@ -239,7 +248,7 @@ NDBAMMerger::on_error(bool is_check, const std::string & s)
     make_check_fail();
 
     if (is_check)
-        _imp->params.output_manager()->stdout_stream() << "." << std::endl << "!!! " << s << std::endl;
+        in_order([this, s] () { _imp->params.output_manager()->stdout_stream() << "." << std::endl << "!!! " << s << std::endl; });
     else
         throw FSMergerError(s);
 }
@@ -335,7 +344,7 @@ void
 NDBAMMerger::on_enter_dir(bool is_check, const FSPath src)
 {
     if (is_check)
-        _imp->params.output_manager()->stdout_stream() << "." << std::flush;
+        in_order([this] () { _imp->params.output_manager()->stdout_stream() << "." << std::flush; });
 
     FSMerger::on_enter_dir(is_check, src);
 }
@@ -343,6 +352,6 @@ NDBAMMerger::on_enter_dir(bool is_check, const FSPath src)
 void
 NDBAMMerger::display_override(const std::string & message) const
 {
-    _imp->params.output_manager()->stdout_stream() << message << std::endl;
+    in_order([this, message] () { _imp->params.output_manager()->stdout_stream() << message << std::endl; });
 }
 
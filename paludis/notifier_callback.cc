@@ -57,6 +57,17 @@ NotifierCallbackLinkageStepEvent::location() const
     return _location;
 }
 
+NotifierCallbackRepositoryInvalidatedEvent::NotifierCallbackRepositoryInvalidatedEvent(const RepositoryName & r) :
+    _repository(r)
+{
+}
+
+const RepositoryName
+NotifierCallbackRepositoryInvalidatedEvent::repository() const
+{
+    return _repository;
+}
+
 namespace paludis
 {
     template <>
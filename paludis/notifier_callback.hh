@@ -35,7 +35,8 @@ namespace paludis
             NotifierCallbackGeneratingMetadataEvent,
             NotifierCallbackResolverStepEvent,
             NotifierCallbackResolverStageEvent,
-            NotifierCallbackLinkageStepEvent>::Type>
+            NotifierCallbackLinkageStepEvent,
+            NotifierCallbackRepositoryInvalidatedEvent>::Type>
     {
     };
 
@@ -84,6 +85,19 @@ namespace paludis
             const FSPath location() const PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
+    class PALUDIS_VISIBLE NotifierCallbackRepositoryInvalidatedEvent :
+        public NotifierCallbackEvent,
+        public ImplementAcceptMethods<NotifierCallbackEvent, NotifierCallbackRepositoryInvalidatedEvent>
+    {
+        private:
+            const RepositoryName _repository;
+
+        public:
+            NotifierCallbackRepositoryInvalidatedEvent(const RepositoryName &);
+
+            const RepositoryName repository() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
     class PALUDIS_VISIBLE ScopedNotifierCallback
     {
         private:
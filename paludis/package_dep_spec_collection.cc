@@ -22,6 +22,11 @@
 #include <paludis/package_id.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/match_package.hh>
+#include <paludis/dep_spec_flattener.hh>
+#include <paludis/spec_tree.hh>
+#include <paludis/name.hh>
+#include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
 #include <list>
 #include <map>
 
@@ -34,6 +39,8 @@ namespace paludis
     {
         const std::shared_ptr<const PackageID> from_id;
         std::multimap<QualifiedPackageName, PackageDepSpec> by_name;
+        std::multimap<PackageNamePart, PackageDepSpec> by_package_name_part;
+        std::multimap<CategoryNamePart, PackageDepSpec> by_category_name_part;
         std::list<PackageDepSpec> unnamed;
 
         Imp(const std::shared_ptr<const PackageID> & i) :
@@ -55,10 +62,24 @@ PackageDepSpecCollection::insert(const PackageDepSpec & spec)
 {
     if (spec.package_ptr())
         _imp->by_name.insert(std::make_pair(*spec.package_ptr(), spec));
+    else if (spec.package_name_part_ptr())
+        _imp->by_package_name_part.insert(std::make_pair(*spec.package_name_part_ptr(), spec));
+    else if (spec.category_name_part_ptr())
+        _imp->by_category_name_part.insert(std::make_pair(*spec.category_name_part_ptr(), spec));
     else
         _imp->unnamed.push_back(spec);
 }
 
+void
+PackageDepSpecCollection::insert_set(const Environment * const env, const SetSpecTree & set)
+{
+    DepSpecFlattener<SetSpecTree, PackageDepSpec> f(env, nullptr);
+    set.top()->accept(f);
+    for (auto s(indirect_iterator(f.begin())), s_end(indirect_iterator(f.end())) ;
+            s != s_end ; ++s)
+        insert(*s);
+}
+
 bool
 PackageDepSpecCollection::match_any(
         const Environment * const env,
@@ -70,6 +91,16 @@ PackageDepSpecCollection::match_any(
         if (match_package(*env, named.first->second, id, _imp->from_id, opts))
             return true;
 
+    auto package_named(_imp->by_package_name_part.equal_range(id->name().package()));
+    for ( ; package_named.first != package_named.second ; ++package_named.first)
+        if (match_package(*env, package_named.first->second, id, _imp->from_id, opts))
+            return true;
+
+    auto category_named(_imp->by_category_name_part.equal_range(id->name().category()));
+    for ( ; category_named.first != category_named.second ; ++category_named.first)
+        if (match_package(*env, category_named.first->second, id, _imp->from_id, opts))
+            return true;
+
     for (auto u(_imp->unnamed.begin()), u_end(_imp->unnamed.end()) ;
             u != u_end ; ++u)
         if (match_package(*env, *u, id, _imp->from_id, opts))
@@ -26,6 +26,7 @@
 #include <paludis/environment-fwd.hh>
 #include <paludis/package_id-fwd.hh>
 #include <paludis/match_package-fwd.hh>
+#include <paludis/spec_tree-fwd.hh>
 #include <memory>
 
 namespace paludis
@@ -41,6 +42,14 @@ namespace paludis
 
             void insert(const PackageDepSpec &);
 
+            /**
+             * Insert every PackageDepSpec in a set, expanding any named sets
+             * it contains.
+             *
+             * \since 2.4
+             */
+            void insert_set(const Environment * const, const SetSpecTree &);
+
             bool match_any(
                     const Environment * const,
                     const std::shared_ptr<const PackageID> & id,
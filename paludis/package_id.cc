@@ -23,6 +23,7 @@
 #include <paludis/version_spec.hh>
 #include <paludis/repository.hh>
 #include <paludis/environment.hh>
+#include <paludis/contents.hh>
 
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/sequence.hh>
@@ -121,6 +122,18 @@ PackageID::masked() const
     return begin_masks() != end_masks();
 }
 
+void
+PackageID::for_each_contents_entry(const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> & f) const
+{
+    auto c(contents());
+    if (! c)
+        return;
+
+    for (auto i(c->begin()), i_end(c->end()) ; i != i_end ; ++i)
+        if (! f(*i))
+            break;
+}
+
 std::ostream &
 paludis::operator<< (std::ostream & s, const PackageID & i)
 {
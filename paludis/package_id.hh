@@ -45,6 +45,7 @@
 #include <paludis/slot-fwd.hh>
 
 #include <memory>
+#include <functional>
 
 /** \file
  * Declarations for PackageID classes.
@@ -324,6 +325,21 @@ namespace paludis
              */
             virtual const std::shared_ptr<const Contents> contents() const = 0;
 
+            /**
+             * Call the supplied function for each entry in our contents in
+             * turn, stopping early if it returns false. Does nothing if we
+             * have no contents.
+             *
+             * The default implementation iterates over contents(), but IDs
+             * that can read their contents an entry at a time override this,
+             * so that callers which only need to look at each entry once do
+             * not have to hold the whole contents in memory.
+             *
+             * \since 2.4
+             */
+            virtual void for_each_contents_entry(
+                    const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> &) const;
+
             ///\}
 
             ///\name Masks
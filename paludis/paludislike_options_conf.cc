@@ -37,6 +37,7 @@
 #include <paludis/name.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/match_package.hh>
+#include <paludis/package_dep_spec_collection.hh>
 #include <paludis/package_id.hh>
 #include <paludis/environment.hh>
 #include <paludis/spec_tree.hh>
@@ -44,6 +45,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <mutex>
 #include <vector>
 #include <algorithm>
 
@@ -122,7 +124,7 @@ namespace
     struct SetNameWithValuesGroups
     {
         NamedValue<n::set_name, SetName> set_name;
-        NamedValue<n::set_value, ActiveObjectPtr<DeferredConstructionPtr<std::shared_ptr<const SetSpecTree> > > > set_value;
+        NamedValue<n::set_value, ActiveObjectPtr<DeferredConstructionPtr<std::shared_ptr<const PackageDepSpecCollection> > > > set_value;
         NamedValue<n::values_groups, ValuesGroups> values_groups;
     };
 
@@ -130,21 +132,34 @@ namespace
 
     typedef std::unordered_map<QualifiedPackageName, SpecsWithValuesGroups, Hash<QualifiedPackageName> > SpecificSpecs;
 
-    const std::shared_ptr<const SetSpecTree> make_set_value(
+    typedef std::vector<const SpecWithValuesGroups *> SpecsWithValuesGroupsRefs;
+    typedef std::unordered_map<QualifiedPackageName, SpecsWithValuesGroupsRefs, Hash<QualifiedPackageName> > WildcardSpecsByName;
+
+    const std::shared_ptr<const PackageDepSpecCollection> make_set_value(
             const Environment * const env,
             const FSPath & from,
             const SetName name)
     {
-        std::shared_ptr<const SetSpecTree> result(env->set(name));
-        if (! result)
-        {
+        const std::shared_ptr<PackageDepSpecCollection> result(std::make_shared<PackageDepSpecCollection>(nullptr));
+        const std::shared_ptr<const SetSpecTree> set(env->set(name));
+        if (set)
+            result->insert_set(env, *set);
+        else
             Log::get_instance()->message("paludislike_options_conf.bad_set", ll_warning, lc_context)
                 << "Set '" << name << "' in '" << from << "' does not exist";
-            result = std::make_shared<SetSpecTree>(std::make_shared<AllDepSpec>());
-        }
 
         return result;
     }
+
+    const SpecWithValuesGroups & deref_spec(const SpecWithValuesGroups & s)
+    {
+        return s;
+    }
+
+    const SpecWithValuesGroups & deref_spec(const SpecWithValuesGroups * const s)
+    {
+        return *s;
+    }
 }
 
 namespace paludis
@@ -158,10 +173,30 @@ namespace paludis
         SetNamesWithValuesGroups set_specs;
         SpecsWithValuesGroups wildcard_specs;
 
+        mutable WildcardSpecsByName wildcard_specs_by_name;
+        mutable std::mutex wildcard_specs_by_name_mutex;
+
         Imp(const PaludisLikeOptionsConfParams & p) :
             params(p)
         {
         }
+
+        /* wildcards which could match a package with this name, in order */
+        const SpecsWithValuesGroupsRefs & wildcard_specs_for(const QualifiedPackageName & name) const
+        {
+            std::unique_lock<std::mutex> lock(wildcard_specs_by_name_mutex);
+            WildcardSpecsByName::iterator i(wildcard_specs_by_name.find(name));
+            if (i == wildcard_specs_by_name.end())
+            {
+                i = wildcard_specs_by_name.insert(std::make_pair(name, SpecsWithValuesGroupsRefs())).first;
+                for (SpecsWithValuesGroups::const_iterator s(wildcard_specs.begin()), s_end(wildcard_specs.end()) ;
+                        s != s_end ; ++s)
+                    if (match_package_name(s->spec(), name))
+                        i->second.push_back(&*s);
+            }
+
+            return i->second;
+        }
     };
 }
 
@@ -183,6 +218,11 @@ PaludisLikeOptionsConf::add_file(const FSPath & f)
     if (! file)
         return;
 
+    {
+        std::unique_lock<std::mutex> lock(_imp->wildcard_specs_by_name_mutex);
+        _imp->wildcard_specs_by_name.clear();
+    }
+
     for (LineConfigFile::ConstIterator line(file->begin()), line_end(file->end()) ;
             line != line_end ; ++line)
     {
@@ -234,7 +274,7 @@ PaludisLikeOptionsConf::add_file(const FSPath & f)
             values_groups = &_imp->set_specs.insert(_imp->set_specs.end(),
                     make_named_values<SetNameWithValuesGroups>(
                         n::set_name() = n,
-                        n::set_value() = DeferredConstructionPtr<std::shared_ptr<const SetSpecTree> >(
+                        n::set_value() = DeferredConstructionPtr<std::shared_ptr<const PackageDepSpecCollection> >(
                                 std::bind(&make_set_value, _imp->params.environment(), f, n)),
                         n::values_groups() = ValuesGroups()
                         ))->values_groups();
@@ -410,59 +450,63 @@ namespace
         }
     }
 
+    template <typename SpecsWithValuesGroups_>
     void check_specs_with_values_groups(
             const Environment * const env,
             const std::shared_ptr<const PackageID> & maybe_id,
             const ChoicePrefixName & prefix,
             const UnprefixedChoiceName & unprefixed_name,
-            const SpecsWithValuesGroups & specs_with_values_groups,
+            const SpecsWithValuesGroups_ & specs_with_values_groups,
             bool & seen_minus_star,
             std::pair<Tribool, bool> & result_state,
             std::string & result_value)
     {
-        for (SpecsWithValuesGroups::const_iterator i(specs_with_values_groups.begin()),
+        for (typename SpecsWithValuesGroups_::const_iterator i(specs_with_values_groups.begin()),
                 i_end(specs_with_values_groups.end()) ;
                 i != i_end ; ++i)
         {
+            const SpecWithValuesGroups & s(deref_spec(*i));
             if (maybe_id)
             {
-                if (! match_package(*env, i->spec(), maybe_id, nullptr, { }))
+                if (! match_package(*env, s.spec(), maybe_id, nullptr, { }))
                     continue;
             }
             else
             {
-                if (! match_anything(i->spec()))
+                if (! match_anything(s.spec()))
                     continue;
             }
 
-            check_values_groups(env, maybe_id, prefix, unprefixed_name, i->values_groups(),
+            check_values_groups(env, maybe_id, prefix, unprefixed_name, s.values_groups(),
                     seen_minus_star, result_state, result_value);
         }
     }
 
+    template <typename SpecsWithValuesGroups_>
     void collect_known_from_specs_with_values_groups(
             const Environment * const env,
             const std::shared_ptr<const PackageID> & maybe_id,
             const ChoicePrefixName & prefix,
-            const SpecsWithValuesGroups & specs_with_values_groups,
+            const SpecsWithValuesGroups_ & specs_with_values_groups,
             const std::shared_ptr<Set<UnprefixedChoiceName> > & known)
     {
-        for (SpecsWithValuesGroups::const_iterator i(specs_with_values_groups.begin()),
+        for (typename SpecsWithValuesGroups_::const_iterator i(specs_with_values_groups.begin()),
                 i_end(specs_with_values_groups.end()) ;
                 i != i_end ; ++i)
         {
+            const SpecWithValuesGroups & s(deref_spec(*i));
             if (maybe_id)
             {
-                if (! match_package(*env, i->spec(), maybe_id, nullptr, { }))
+                if (! match_package(*env, s.spec(), maybe_id, nullptr, { }))
                     continue;
             }
             else
             {
-                if (! match_anything(i->spec()))
+                if (! match_anything(s.spec()))
                     continue;
             }
 
-            collect_known_from_values_groups(env, maybe_id, prefix, i->values_groups(), known);
+            collect_known_from_values_groups(env, maybe_id, prefix, s.values_groups(), known);
         }
     }
 }
@@ -501,8 +545,7 @@ PaludisLikeOptionsConf::want_choice_enabled_locked(
         for (SetNamesWithValuesGroups::const_iterator r(_imp->set_specs.begin()), r_end(_imp->set_specs.end()) ;
                 r != r_end ; ++r)
         {
-            if (! match_package_in_set(*_imp->params.environment(), *r->set_value().value().value(),
-                        maybe_id, { }))
+            if (! r->set_value().value().value()->match_any(_imp->params.environment(), maybe_id, { }))
                 continue;
 
             check_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name, r->values_groups(),
@@ -516,8 +559,12 @@ PaludisLikeOptionsConf::want_choice_enabled_locked(
     /* Wildcards? */
     if (! seen_minus_star)
     {
-        check_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name,
-                _imp->wildcard_specs, seen_minus_star, result, dummy);
+        if (maybe_id)
+            check_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name,
+                    _imp->wildcard_specs_for(maybe_id->name()), seen_minus_star, result, dummy);
+        else
+            check_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix, unprefixed_name,
+                    _imp->wildcard_specs, seen_minus_star, result, dummy);
 
         if (! result.first.is_indeterminate())
             return result;
@@ -561,7 +608,7 @@ PaludisLikeOptionsConf::value_for_choice_parameter(
         for (SetNamesWithValuesGroups::const_iterator r(_imp->set_specs.begin()), r_end(_imp->set_specs.end()) ;
                 r != r_end ; ++r)
         {
-            if (! match_package_in_set(*_imp->params.environment(), *r->set_value().value().value(), id, { }))
+            if (! r->set_value().value().value()->match_any(_imp->params.environment(), id, { }))
                 continue;
 
             check_values_groups(_imp->params.environment(), id, prefix, unprefixed_name, r->values_groups(),
@@ -574,8 +621,8 @@ PaludisLikeOptionsConf::value_for_choice_parameter(
 
     /* Wildcards? */
     {
-        check_specs_with_values_groups(_imp->params.environment(), id, prefix, unprefixed_name, _imp->wildcard_specs,
-                dummy_seen_minus_star, dummy_result, equals_value);
+        check_specs_with_values_groups(_imp->params.environment(), id, prefix, unprefixed_name,
+                _imp->wildcard_specs_for(id->name()), dummy_seen_minus_star, dummy_result, equals_value);
 
         if (! equals_value.empty())
             return equals_value;
@@ -606,8 +653,7 @@ PaludisLikeOptionsConf::known_choice_value_names(
         for (SetNamesWithValuesGroups::const_iterator r(_imp->set_specs.begin()), r_end(_imp->set_specs.end()) ;
                 r != r_end ; ++r)
         {
-            if (! match_package_in_set(*_imp->params.environment(), *r->set_value().value().value(),
-                        maybe_id, { }))
+            if (! r->set_value().value().value()->match_any(_imp->params.environment(), maybe_id, { }))
                 continue;
 
             collect_known_from_values_groups(_imp->params.environment(), maybe_id, prefix, r->values_groups(), result);
@@ -616,8 +662,12 @@ PaludisLikeOptionsConf::known_choice_value_names(
 
     /* Wildcards? */
     {
-        collect_known_from_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix,
-                _imp->wildcard_specs, result);
+        if (maybe_id)
+            collect_known_from_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix,
+                    _imp->wildcard_specs_for(maybe_id->name()), result);
+        else
+            collect_known_from_specs_with_values_groups(_imp->params.environment(), maybe_id, prefix,
+                    _imp->wildcard_specs, result);
     }
 
     return result;
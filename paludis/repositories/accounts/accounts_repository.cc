@@ -269,6 +269,7 @@ AccountsRepository::invalidate()
     else
         _imp.reset(new Imp<AccountsRepository>(name(), *_imp->params_if_installed));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 void
@@ -247,6 +247,7 @@ CheckFetchedFilesVisitor::check_distfile_manifest(const FSPath & distfile)
 
             MemoisedHashes * hashes = MemoisedHashes::get_instance();
 
+            std::set<std::string> algos;
             for (Map<std::string, std::string>::ConstIterator it(m->hashes()->begin()),
                      it_end(m->hashes()->end()); it_end != it; ++it)
             {
@@ -257,7 +258,19 @@ CheckFetchedFilesVisitor::check_distfile_manifest(const FSPath & distfile)
                     continue;
                 }
 
-                std::string hexsum(hashes->get(it->first, distfile, file_stream));
+                algos.insert(it->first);
+            }
+
+            auto hexsums(hashes->get_all(algos, distfile, file_stream));
+
+            for (Map<std::string, std::string>::ConstIterator it(m->hashes()->begin()),
+                     it_end(m->hashes()->end()); it_end != it; ++it)
+            {
+                auto h(hexsums.find(it->first));
+                if (hexsums.end() == h)
+                    continue;
+
+                const std::string & hexsum(h->second);
 
                 if (hexsum != it->second)
                 {
@@ -41,6 +41,7 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/is_file_with_extension.hh>
+#include <paludis/util/task_scheduler.hh>
 
 #include <paludis/action.hh>
 #include <paludis/package_id.hh>
@@ -56,9 +57,24 @@
 #include <paludis/common_sets.hh>
 #include <paludis/output_manager.hh>
 
+#include <algorithm>
+#include <future>
+#include <thread>
+
 using namespace paludis;
 using namespace paludis::erepository;
 
+namespace
+{
+    /* Loading is mostly waiting for the filesystem, so we use a few more
+     * workers than we have hardware threads. */
+    TaskScheduler & load_scheduler()
+    {
+        static TaskScheduler scheduler(std::max(4u, std::thread::hardware_concurrency()));
+        return scheduler;
+    }
+}
+
 namespace paludis
 {
     template <>
@@ -193,6 +209,41 @@ EInstalledRepository::snoop_variable_from_environment_file(
     return result;
 }
 
+void
+EInstalledRepository::run_load_tasks(const std::vector<std::function<void ()> > & tasks) const
+{
+    std::vector<std::future<void> > futures;
+    futures.reserve(tasks.size());
+
+    for (const auto & task : tasks)
+    {
+        auto promise(std::make_shared<std::promise<void> >());
+        futures.push_back(promise->get_future());
+
+        /* the scheduler is shared between repositories, so we catch
+         * everything ourselves rather than cancelling anyone else's tasks */
+        load_scheduler().post([promise, &task] () {
+                try
+                {
+                    task();
+                    promise->set_value();
+                }
+                catch (...)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+    }
+
+    /* tasks refers to our caller's locals, so everything must finish before
+     * we rethrow anything */
+    for (auto & future : futures)
+        future.wait();
+
+    for (auto & future : futures)
+        future.get();
+}
+
 void
 EInstalledRepository::perform_config(
         const std::shared_ptr<const ERepositoryID> & id,
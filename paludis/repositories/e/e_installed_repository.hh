@@ -22,6 +22,8 @@
 
 #include <paludis/repository.hh>
 #include <paludis/repositories/e/e_repository_id.hh>
+#include <functional>
+#include <vector>
 
 namespace paludis
 {
@@ -58,6 +60,10 @@ namespace paludis
                         const std::string & var) const
                     PALUDIS_ATTRIBUTE((warn_unused_result));
 
+                /* Run each of the tasks, several at once, and wait for them
+                 * all to finish. Rethrows the first exception a task threw. */
+                void run_load_tasks(const std::vector<std::function<void ()> > &) const;
+
             public:
                 /* RepositoryEnvironmentVariableInterface */
 
@@ -39,6 +39,8 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/singleton-impl.hh>
 #include <paludis/util/strip.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/save.hh>
 
 #include <paludis/name.hh>
 #include <paludis/version_spec.hh>
@@ -54,6 +56,16 @@
 #include <paludis/slot.hh>
 
 #include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
 
 using namespace paludis;
 using namespace paludis::erepository;
@@ -67,6 +79,147 @@ namespace
         return strip_trailing(std::string((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>()), "\r\n");
     }
 
+    /* An ID's key files. Rather than statting every file we might want, we
+     * list the directory once, and open files relative to it. Small files
+     * can be read in advance, after which the directory is closed and
+     * anything else is read by path. */
+    class KeyFiles
+    {
+        private:
+            const FSPath _dir;
+            int _fd;
+            std::unordered_set<std::string> _names;
+            std::unordered_map<std::string, std::string> _contents;
+
+            /* returns false if the file is not a regular file of at most
+             * max_size bytes */
+            bool read_at(const std::string & name, std::string & result, const off_t max_size) const
+            {
+                Context c("When reading '" + stringify(_dir / name) + "':");
+
+                int fd(::openat(_fd, name.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY));
+                if (-1 == fd)
+                    throw FSError("Could not open '" + stringify(_dir / name) + "': " + std::strerror(errno));
+
+                struct stat st;
+                if (0 != ::fstat(fd, &st) || ! S_ISREG(st.st_mode) || (max_size >= 0 && st.st_size > max_size))
+                {
+                    ::close(fd);
+                    return false;
+                }
+
+                result.clear();
+                char buf[4096];
+                while (true)
+                {
+                    ssize_t n(::read(fd, buf, sizeof(buf)));
+                    if (0 == n)
+                        break;
+                    else if (-1 == n)
+                    {
+                        if (EINTR == errno)
+                            continue;
+                        int e(errno);
+                        ::close(fd);
+                        throw FSError("Could not read '" + stringify(_dir / name) + "': " + std::strerror(e));
+                    }
+                    result.append(buf, n);
+                }
+
+                ::close(fd);
+                result = strip_trailing(result, "\r\n");
+                return true;
+            }
+
+            void close_dir()
+            {
+                if (-1 != _fd)
+                    ::close(_fd);
+                _fd = -1;
+            }
+
+        public:
+            explicit KeyFiles(const FSPath & dir) :
+                _dir(dir),
+                _fd(::open(stringify(dir).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+            {
+                /* if we can't list the directory, nothing exists, which is
+                 * what statting each file would have told us */
+                if (-1 == _fd)
+                    return;
+
+                int list_fd(::fcntl(_fd, F_DUPFD_CLOEXEC, 0));
+                DIR * d(-1 == list_fd ? nullptr : ::fdopendir(list_fd));
+                if (! d)
+                {
+                    if (-1 != list_fd)
+                        ::close(list_fd);
+                    close_dir();
+                    return;
+                }
+
+                while (struct dirent * e = ::readdir(d))
+                    if (0 != std::strcmp(e->d_name, ".") && 0 != std::strcmp(e->d_name, ".."))
+                        _names.insert(e->d_name);
+
+                ::closedir(d);
+            }
+
+            ~KeyFiles()
+            {
+                close_dir();
+            }
+
+            KeyFiles(const KeyFiles &) = delete;
+            KeyFiles & operator= (const KeyFiles &) = delete;
+
+            /* Key files never have a '.' in their name, so we skip things
+             * like the ebuild and environment.bz2, along with the contents
+             * file and anything large. */
+            void read_small_files(const std::string & except, const off_t max_size)
+            {
+                if (-1 == _fd)
+                    return;
+
+                for (const auto & name : _names)
+                {
+                    if (name == except || std::string::npos != name.find('.'))
+                        continue;
+
+                    try
+                    {
+                        std::string value;
+                        if (read_at(name, value, max_size))
+                            _contents.insert(std::make_pair(name, value));
+                    }
+                    catch (const FSError &)
+                    {
+                        /* we'll try again, and complain, if it's needed */
+                    }
+                }
+
+                close_dir();
+            }
+
+            bool exists(const std::string & name) const
+            {
+                return _names.end() != _names.find(name);
+            }
+
+            std::string contents(const std::string & name) const
+            {
+                auto c(_contents.find(name));
+                if (_contents.end() != c)
+                    return c->second;
+
+                std::string result;
+                if (-1 != _fd && read_at(name, result, -1))
+                    return result;
+
+                return file_contents(_dir / name);
+            }
+    };
+
     struct EInstalledRepositoryIDKeys
     {
         std::shared_ptr<const MetadataValueKey<Slot> > slot;
@@ -152,6 +305,7 @@ namespace paludis
         const FSPath dir;
 
         mutable std::shared_ptr<EInstalledRepositoryIDKeys> keys;
+        mutable std::shared_ptr<KeyFiles> key_files;
 
         /* fs location and eapi are special */
         mutable std::shared_ptr<const MetadataValueKey<FSPath> > fs_location;
@@ -191,6 +345,14 @@ EInstalledRepositoryID::need_keys_added() const
         return;
     _imp->keys = std::make_shared<EInstalledRepositoryIDKeys>();
 
+    /* use anything preload_key_files read, and don't keep it afterwards */
+    std::shared_ptr<KeyFiles> key_files(_imp->key_files);
+    if (! key_files)
+        key_files = std::make_shared<KeyFiles>(_imp->dir);
+    _imp->key_files.reset();
+    Save<std::shared_ptr<KeyFiles> > save_key_files(&_imp->key_files, key_files);
+    const KeyFiles & files(*key_files);
+
     // fs_location key could have been loaded by the ::fs_location_key() already. keep this
     // at the top, other keys use it.
     if (! _imp->fs_location)
@@ -216,31 +378,31 @@ EInstalledRepositoryID::need_keys_added() const
     std::shared_ptr<const EAPIEbuildEnvironmentVariables> env(eapi()->supported()->ebuild_environment_variables());
 
     if (! env->env_use().empty())
-        if ((_imp->dir / env->env_use()).stat().exists())
+        if (files.exists(env->env_use()))
         {
-            _imp->keys->raw_use = EStringSetKeyStore::get_instance()->fetch(vars->use(), file_contents(_imp->dir / env->env_use()), mkt_internal);
+            _imp->keys->raw_use = EStringSetKeyStore::get_instance()->fetch(vars->use(), files.contents(env->env_use()), mkt_internal);
             add_metadata_key(_imp->keys->raw_use);
         }
 
     if (! vars->slot()->name().empty())
-        if ((_imp->dir / vars->slot()->name()).stat().exists())
+        if (files.exists(vars->slot()->name()))
         {
-            _imp->keys->slot = ESlotKeyStore::get_instance()->fetch(*eapi(), vars->slot(), file_contents(_imp->dir / vars->slot()->name()), mkt_internal);
+            _imp->keys->slot = ESlotKeyStore::get_instance()->fetch(*eapi(), vars->slot(), files.contents(vars->slot()->name()), mkt_internal);
             add_metadata_key(_imp->keys->slot);
         }
 
     if (! vars->inherited()->name().empty())
-        if ((_imp->dir / vars->inherited()->name()).stat().exists())
+        if (files.exists(vars->inherited()->name()))
         {
             _imp->keys->inherited = EStringSetKeyStore::get_instance()->fetch(vars->inherited(),
-                    file_contents(_imp->dir / vars->inherited()->name()), mkt_internal);
+                    files.contents(vars->inherited()->name()), mkt_internal);
             add_metadata_key(_imp->keys->inherited);
         }
 
     if (! vars->defined_phases()->name().empty())
-        if ((_imp->dir / vars->defined_phases()->name()).stat().exists())
+        if (files.exists(vars->defined_phases()->name()))
         {
-            std::string d(file_contents(_imp->dir / vars->defined_phases()->name()));
+            std::string d(files.contents(vars->defined_phases()->name()));
             if (! strip_leading(d, " \t\r\n").empty())
             {
                 _imp->keys->defined_phases = EStringSetKeyStore::get_instance()->fetch(vars->defined_phases(),
@@ -250,9 +412,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->scm_revision()->name().empty())
-        if ((_imp->dir / vars->scm_revision()->name()).stat().exists())
+        if (files.exists(vars->scm_revision()->name()))
         {
-            std::string d(file_contents(_imp->dir / vars->scm_revision()->name()));
+            std::string d(files.contents(vars->scm_revision()->name()));
             if (! d.empty())
             {
                 _imp->keys->scm_revision = std::make_shared<LiteralMetadataValueKey<std::string> >(vars->scm_revision()->name(),
@@ -263,9 +425,9 @@ EInstalledRepositoryID::need_keys_added() const
 
     if (! vars->iuse()->name().empty())
     {
-        if ((_imp->dir / vars->iuse()->name()).stat().exists())
+        if (files.exists(vars->iuse()->name()))
             _imp->keys->raw_iuse = EStringSetKeyStore::get_instance()->fetch(vars->iuse(),
-                    file_contents(_imp->dir / vars->iuse()->name()), mkt_internal);
+                    files.contents(vars->iuse()->name()), mkt_internal);
         else
         {
             /* hack: if IUSE doesn't exist, we still need an iuse_key to make the choices
@@ -278,26 +440,26 @@ EInstalledRepositoryID::need_keys_added() const
 
     if (! vars->iuse_effective()->name().empty())
     {
-        if ((_imp->dir / vars->iuse_effective()->name()).stat().exists())
+        if (files.exists(vars->iuse_effective()->name()))
         {
             _imp->keys->raw_iuse_effective = EStringSetKeyStore::get_instance()->fetch(vars->iuse_effective(),
-                    file_contents(_imp->dir / vars->iuse_effective()->name()), mkt_internal);
+                    files.contents(vars->iuse_effective()->name()), mkt_internal);
             add_metadata_key(_imp->keys->raw_iuse_effective);
         }
     }
 
     if (! vars->myoptions()->name().empty())
-        if ((_imp->dir / vars->myoptions()->name()).stat().exists())
+        if (files.exists(vars->myoptions()->name()))
         {
             _imp->keys->raw_myoptions = std::make_shared<EMyOptionsKey>(_imp->environment, vars->myoptions(),
-                        eapi(), file_contents(_imp->dir / vars->myoptions()->name()), mkt_internal, is_installed());
+                        eapi(), files.contents(vars->myoptions()->name()), mkt_internal, is_installed());
             add_metadata_key(_imp->keys->raw_myoptions);
         }
 
     if (! vars->required_use()->name().empty())
-        if ((_imp->dir / vars->required_use()->name()).stat().exists())
+        if (files.exists(vars->required_use()->name()))
         {
-            std::string v(file_contents(_imp->dir / vars->required_use()->name()));
+            std::string v(files.contents(vars->required_use()->name()));
             if (! strip_leading(v, " \t\r\n").empty())
             {
                 _imp->keys->required_use = std::make_shared<ERequiredUseKey>(_imp->environment, vars->required_use(),
@@ -307,34 +469,34 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->use_expand()->name().empty())
-        if ((_imp->dir / vars->use_expand()->name()).stat().exists())
+        if (files.exists(vars->use_expand()->name()))
         {
             _imp->keys->raw_use_expand = EStringSetKeyStore::get_instance()->fetch(vars->use_expand(),
-                    file_contents(_imp->dir / vars->use_expand()->name()), mkt_internal);
+                    files.contents(vars->use_expand()->name()), mkt_internal);
             add_metadata_key(_imp->keys->raw_use_expand);
         }
 
     if (! vars->use_expand_hidden()->name().empty())
-        if ((_imp->dir / vars->use_expand_hidden()->name()).stat().exists())
+        if (files.exists(vars->use_expand_hidden()->name()))
         {
             _imp->keys->raw_use_expand_hidden = EStringSetKeyStore::get_instance()->fetch(vars->use_expand_hidden(),
-                    file_contents(_imp->dir / vars->use_expand_hidden()->name()), mkt_internal);
+                    files.contents(vars->use_expand_hidden()->name()), mkt_internal);
             add_metadata_key(_imp->keys->raw_use_expand_hidden);
         }
 
     if (! vars->license()->name().empty())
-        if ((_imp->dir / vars->license()->name()).stat().exists())
+        if (files.exists(vars->license()->name()))
         {
             _imp->keys->license = std::make_shared<ELicenseKey>(_imp->environment, vars->license(), eapi(),
-                        file_contents(_imp->dir / vars->license()->name()), mkt_normal, is_installed());
+                        files.contents(vars->license()->name()), mkt_normal, is_installed());
             add_metadata_key(_imp->keys->license);
         }
 
     if (! vars->dependencies()->name().empty())
     {
-        if ((_imp->dir / vars->dependencies()->name()).stat().exists())
+        if (files.exists(vars->dependencies()->name()))
         {
-            std::string v(file_contents(_imp->dir / vars->dependencies()->name()));
+            std::string v(files.contents(vars->dependencies()->name()));
             if (! strip_leading(v, " \t\r\n").empty())
             {
                 _imp->keys->dependencies = std::make_shared<EDependenciesKey>(_imp->environment, shared_from_this(), vars->dependencies()->name(),
@@ -347,9 +509,9 @@ EInstalledRepositoryID::need_keys_added() const
     else
     {
         if (! vars->build_depend()->name().empty())
-            if ((_imp->dir / vars->build_depend()->name()).stat().exists())
+            if (files.exists(vars->build_depend()->name()))
             {
-                std::string v(file_contents(_imp->dir / vars->build_depend()->name()));
+                std::string v(files.contents(vars->build_depend()->name()));
                 if (! strip_leading(v, " \t\r\n").empty())
                 {
                     _imp->keys->build_dependencies = std::make_shared<EDependenciesKey>(_imp->environment, shared_from_this(), vars->build_depend()->name(),
@@ -360,9 +522,9 @@ EInstalledRepositoryID::need_keys_added() const
             }
 
         if (! vars->run_depend()->name().empty())
-            if ((_imp->dir / vars->run_depend()->name()).stat().exists())
+            if (files.exists(vars->run_depend()->name()))
             {
-                std::string v(file_contents(_imp->dir / vars->run_depend()->name()));
+                std::string v(files.contents(vars->run_depend()->name()));
                 if (! strip_leading(v, " \t\r\n").empty())
                 {
                     _imp->keys->run_dependencies = std::make_shared<EDependenciesKey>(_imp->environment, shared_from_this(), vars->run_depend()->name(),
@@ -374,9 +536,9 @@ EInstalledRepositoryID::need_keys_added() const
 
         if (! vars->pdepend()->name().empty())
         {
-            if ((_imp->dir / vars->pdepend()->name()).stat().exists())
+            if (files.exists(vars->pdepend()->name()))
             {
-                std::string v(file_contents(_imp->dir / vars->pdepend()->name()));
+                std::string v(files.contents(vars->pdepend()->name()));
                 if (! strip_leading(v, " \t\r\n").empty())
                 {
                     _imp->keys->post_dependencies = std::make_shared<EDependenciesKey>(_imp->environment, shared_from_this(), vars->pdepend()->name(),
@@ -389,9 +551,9 @@ EInstalledRepositoryID::need_keys_added() const
     }
 
     if (! vars->restrictions()->name().empty())
-        if ((_imp->dir / vars->restrictions()->name()).stat().exists())
+        if (files.exists(vars->restrictions()->name()))
         {
-            std::string v(file_contents(_imp->dir / vars->restrictions()->name()));
+            std::string v(files.contents(vars->restrictions()->name()));
             if (! strip_leading(v, " \t\r\n").empty())
             {
                 _imp->keys->restrictions = std::make_shared<EPlainTextSpecKey>(_imp->environment, vars->restrictions(),
@@ -401,9 +563,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->properties()->name().empty())
-        if ((_imp->dir / vars->properties()->name()).stat().exists())
+        if (files.exists(vars->properties()->name()))
         {
-            std::string v(file_contents(_imp->dir / vars->properties()->name()));
+            std::string v(files.contents(vars->properties()->name()));
             if (! strip_leading(v, " \t\r\n").empty())
             {
                 _imp->keys->properties = std::make_shared<EPlainTextSpecKey>(_imp->environment, vars->properties(),
@@ -413,25 +575,25 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->src_uri()->name().empty())
-        if ((_imp->dir / vars->src_uri()->name()).stat().exists())
+        if (files.exists(vars->src_uri()->name()))
         {
             _imp->keys->src_uri = std::make_shared<EFetchableURIKey>(_imp->environment, shared_from_this(), vars->src_uri(),
-                        file_contents(_imp->dir / vars->src_uri()->name()), mkt_dependencies);
+                        files.contents(vars->src_uri()->name()), mkt_dependencies);
             add_metadata_key(_imp->keys->src_uri);
         }
 
     if (! vars->short_description()->name().empty())
-        if ((_imp->dir / vars->short_description()->name()).stat().exists())
+        if (files.exists(vars->short_description()->name()))
         {
             _imp->keys->short_description = std::make_shared<LiteralMetadataValueKey<std::string> >(vars->short_description()->name(),
-                        vars->short_description()->description(), mkt_significant, file_contents(_imp->dir / vars->short_description()->name()));
+                        vars->short_description()->description(), mkt_significant, files.contents(vars->short_description()->name()));
             add_metadata_key(_imp->keys->short_description);
         }
 
     if (! vars->long_description()->name().empty())
-        if ((_imp->dir / vars->long_description()->name()).stat().exists())
+        if (files.exists(vars->long_description()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->long_description()->name()));
+            std::string value(files.contents(vars->long_description()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->long_description = std::make_shared<LiteralMetadataValueKey<std::string> >(vars->long_description()->name(),
@@ -441,9 +603,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->upstream_changelog()->name().empty())
-        if ((_imp->dir / vars->upstream_changelog()->name()).stat().exists())
+        if (files.exists(vars->upstream_changelog()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->upstream_changelog()->name()));
+            std::string value(files.contents(vars->upstream_changelog()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->upstream_changelog = std::make_shared<ESimpleURIKey>(_imp->environment,
@@ -453,9 +615,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->upstream_release_notes()->name().empty())
-        if ((_imp->dir / vars->upstream_release_notes()->name()).stat().exists())
+        if (files.exists(vars->upstream_release_notes()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->upstream_release_notes()->name()));
+            std::string value(files.contents(vars->upstream_release_notes()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->upstream_release_notes = std::make_shared<ESimpleURIKey>(_imp->environment,
@@ -465,9 +627,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->upstream_documentation()->name().empty())
-        if ((_imp->dir / vars->upstream_documentation()->name()).stat().exists())
+        if (files.exists(vars->upstream_documentation()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->upstream_documentation()->name()));
+            std::string value(files.contents(vars->upstream_documentation()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->upstream_documentation = std::make_shared<ESimpleURIKey>(_imp->environment,
@@ -477,9 +639,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->bugs_to()->name().empty())
-        if ((_imp->dir / vars->bugs_to()->name()).stat().exists())
+        if (files.exists(vars->bugs_to()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->bugs_to()->name()));
+            std::string value(files.contents(vars->bugs_to()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->bugs_to = std::make_shared<EPlainTextSpecKey>(_imp->environment, vars->bugs_to(), eapi(), value, mkt_normal, is_installed());
@@ -488,9 +650,9 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->remote_ids()->name().empty())
-        if ((_imp->dir / vars->remote_ids()->name()).stat().exists())
+        if (files.exists(vars->remote_ids()->name()))
         {
-            std::string value(file_contents(_imp->dir / vars->remote_ids()->name()));
+            std::string value(files.contents(vars->remote_ids()->name()));
             if (! strip_leading(value, " \t\r\n").empty())
             {
                 _imp->keys->remote_ids = std::make_shared<EPlainTextSpecKey>(_imp->environment,
@@ -500,10 +662,10 @@ EInstalledRepositoryID::need_keys_added() const
         }
 
     if (! vars->homepage()->name().empty())
-        if ((_imp->dir / vars->homepage()->name()).stat().exists())
+        if (files.exists(vars->homepage()->name()))
         {
             _imp->keys->homepage = std::make_shared<ESimpleURIKey>(_imp->environment, vars->homepage(), eapi(),
-                        file_contents(_imp->dir / vars->homepage()->name()), mkt_significant, is_installed());
+                        files.contents(vars->homepage()->name()), mkt_significant, is_installed());
             add_metadata_key(_imp->keys->homepage);
         }
 
@@ -522,12 +684,12 @@ EInstalledRepositoryID::need_keys_added() const
     add_metadata_key(_imp->keys->choices);
 
     std::shared_ptr<Set<std::string> > from_repositories_value(std::make_shared<Set<std::string>>());
-    if ((_imp->dir / "REPOSITORY").stat().exists())
-        from_repositories_value->insert(file_contents(_imp->dir / "REPOSITORY"));
-    if ((_imp->dir / "repository").stat().exists())
-        from_repositories_value->insert(file_contents(_imp->dir / "repository"));
-    if ((_imp->dir / "BINARY_REPOSITORY").stat().exists())
-        from_repositories_value->insert(file_contents(_imp->dir / "BINARY_REPOSITORY"));
+    if (files.exists("REPOSITORY"))
+        from_repositories_value->insert(files.contents("REPOSITORY"));
+    if (files.exists("repository"))
+        from_repositories_value->insert(files.contents("repository"));
+    if (files.exists("BINARY_REPOSITORY"))
+        from_repositories_value->insert(files.contents("BINARY_REPOSITORY"));
     if (! from_repositories_value->empty())
     {
         _imp->keys->from_repositories = std::make_shared<LiteralMetadataStringSetKey>("REPOSITORIES",
@@ -535,77 +697,90 @@ EInstalledRepositoryID::need_keys_added() const
         add_metadata_key(_imp->keys->from_repositories);
     }
 
-    if ((_imp->dir / "ASFLAGS").stat().exists())
+    if (files.exists("ASFLAGS"))
     {
         _imp->keys->asflags = std::make_shared<LiteralMetadataValueKey<std::string> >("ASFLAGS", "ASFLAGS",
-                    mkt_internal, file_contents(_imp->dir / "ASFLAGS"));
+                    mkt_internal, files.contents("ASFLAGS"));
         add_metadata_key(_imp->keys->asflags);
     }
 
-    if ((_imp->dir / "CBUILD").stat().exists())
+    if (files.exists("CBUILD"))
     {
         _imp->keys->cbuild = std::make_shared<LiteralMetadataValueKey<std::string> >("CBUILD", "CBUILD",
-                    mkt_internal, file_contents(_imp->dir / "CBUILD"));
+                    mkt_internal, files.contents("CBUILD"));
         add_metadata_key(_imp->keys->cbuild);
     }
 
-    if ((_imp->dir / "CFLAGS").stat().exists())
+    if (files.exists("CFLAGS"))
     {
         _imp->keys->cflags = std::make_shared<LiteralMetadataValueKey<std::string> >("CFLAGS", "CFLAGS",
-                    mkt_internal, file_contents(_imp->dir / "CFLAGS"));
+                    mkt_internal, files.contents("CFLAGS"));
         add_metadata_key(_imp->keys->cflags);
     }
 
-    if ((_imp->dir / "CHOST").stat().exists())
+    if (files.exists("CHOST"))
     {
         _imp->keys->chost = std::make_shared<LiteralMetadataValueKey<std::string> >("CHOST", "CHOST",
-                    mkt_internal, file_contents(_imp->dir / "CHOST"));
+                    mkt_internal, files.contents("CHOST"));
         add_metadata_key(_imp->keys->chost);
     }
 
-    if ((_imp->dir / "CONFIG_PROTECT").stat().exists())
+    if (files.exists("CONFIG_PROTECT"))
     {
         _imp->keys->config_protect = std::make_shared<LiteralMetadataValueKey<std::string> >("CONFIG_PROTECT", "CONFIG_PROTECT",
-                    mkt_internal, file_contents(_imp->dir / "CONFIG_PROTECT"));
+                    mkt_internal, files.contents("CONFIG_PROTECT"));
         add_metadata_key(_imp->keys->config_protect);
     }
 
-    if ((_imp->dir / "CONFIG_PROTECT_MASK").stat().exists())
+    if (files.exists("CONFIG_PROTECT_MASK"))
     {
         _imp->keys->config_protect_mask = std::make_shared<LiteralMetadataValueKey<std::string> >("CONFIG_PROTECT_MASK", "CONFIG_PROTECT_MASK",
-                    mkt_internal, file_contents(_imp->dir / "CONFIG_PROTECT_MASK"));
+                    mkt_internal, files.contents("CONFIG_PROTECT_MASK"));
         add_metadata_key(_imp->keys->config_protect_mask);
     }
 
-    if ((_imp->dir / "CXXFLAGS").stat().exists())
+    if (files.exists("CXXFLAGS"))
     {
         _imp->keys->cxxflags = std::make_shared<LiteralMetadataValueKey<std::string> >("CXXFLAGS", "CXXFLAGS",
-                    mkt_internal, file_contents(_imp->dir / "CXXFLAGS"));
+                    mkt_internal, files.contents("CXXFLAGS"));
         add_metadata_key(_imp->keys->cxxflags);
     }
 
-    if ((_imp->dir / "LDFLAGS").stat().exists())
+    if (files.exists("LDFLAGS"))
     {
         _imp->keys->ldflags = std::make_shared<LiteralMetadataValueKey<std::string> >("LDFLAGS", "LDFLAGS",
-                    mkt_internal, file_contents(_imp->dir / "LDFLAGS"));
+                    mkt_internal, files.contents("LDFLAGS"));
         add_metadata_key(_imp->keys->ldflags);
     }
 
-    if ((_imp->dir / "PKGMANAGER").stat().exists())
+    if (files.exists("PKGMANAGER"))
     {
         _imp->keys->pkgmanager = std::make_shared<LiteralMetadataValueKey<std::string> >("PKGMANAGER", "Installed using",
-                    mkt_normal, file_contents(_imp->dir / "PKGMANAGER"));
+                    mkt_normal, files.contents("PKGMANAGER"));
         add_metadata_key(_imp->keys->pkgmanager);
     }
 
-    if ((_imp->dir / "VDB_FORMAT").stat().exists())
+    if (files.exists("VDB_FORMAT"))
     {
         _imp->keys->vdb_format = std::make_shared<LiteralMetadataValueKey<std::string> >("VDB_FORMAT", "VDB Format",
-                    mkt_internal, file_contents(_imp->dir / "VDB_FORMAT"));
+                    mkt_internal, files.contents("VDB_FORMAT"));
         add_metadata_key(_imp->keys->vdb_format);
     }
 }
 
+void
+EInstalledRepositoryID::preload_key_files() const
+{
+    std::unique_lock<std::recursive_mutex> lock(_imp->mutex);
+
+    if (_imp->keys || _imp->key_files)
+        return;
+
+    std::shared_ptr<KeyFiles> key_files(std::make_shared<KeyFiles>(_imp->dir));
+    key_files->read_small_files(contents_filename(), 64 * 1024);
+    _imp->key_files = key_files;
+}
+
 void
 EInstalledRepositoryID::need_masks_added() const
 {
@@ -683,8 +858,9 @@ EInstalledRepositoryID::eapi() const
 
     Context context("When finding EAPI for '" + canonical_form(idcf_full) + "':");
 
-    if ((_imp->dir / "EAPI").stat().exists())
-        _imp->eapi = EAPIData::get_instance()->eapi_from_string(file_contents(_imp->dir / "EAPI"));
+    if (_imp->key_files ? _imp->key_files->exists("EAPI") : (_imp->dir / "EAPI").stat().exists())
+        _imp->eapi = EAPIData::get_instance()->eapi_from_string(_imp->key_files ?
+                _imp->key_files->contents("EAPI") : file_contents(_imp->dir / "EAPI"));
     else
     {
         Log::get_instance()->message("e.no_eapi", ll_debug, lc_context) << "No EAPI entry in '" << _imp->dir << "', pretending '"
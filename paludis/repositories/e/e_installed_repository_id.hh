@@ -110,6 +110,11 @@ namespace paludis
                 virtual void can_drop_in_memory_cache() const;
 
                 virtual void set_scm_revision(const std::string &) const PALUDIS_ATTRIBUTE((noreturn));
+
+                /* Read our small key files now, so that loading keys later
+                 * does not need to touch the filesystem. Used when an
+                 * installed repository loads its IDs in parallel. */
+                void preload_key_files() const;
         };
     }
 }
@@ -28,6 +28,8 @@
 
 #include <paludis/util/pretty_print.hh>
 #include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/hashes.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/join.hh>
@@ -52,10 +54,135 @@
 
 #include <algorithm>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
 
 using namespace paludis;
 using namespace paludis::erepository;
 
+namespace
+{
+    /* Nothing the parsers do depends upon the environment, so the EAPI, the
+     * installed flag and the string itself identify a parse result. */
+    typedef std::tuple<std::string, bool, std::string> SpecTreeStoreIndex;
+
+    template <typename T_>
+    using SpecTreeStoreMap = std::unordered_map<SpecTreeStoreIndex, std::shared_ptr<const T_>, Hash<SpecTreeStoreIndex> >;
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ESpecTreeStore>
+    {
+        mutable std::mutex mutex;
+        mutable SpecTreeStoreMap<DependencySpecTree> depend;
+        mutable SpecTreeStoreMap<FetchableURISpecTree> fetchable_uri;
+        mutable SpecTreeStoreMap<SimpleURISpecTree> simple_uri;
+        mutable SpecTreeStoreMap<PlainTextSpecTree> plain_text;
+        mutable SpecTreeStoreMap<PlainTextSpecTree> myoptions;
+        mutable SpecTreeStoreMap<RequiredUseSpecTree> required_use;
+        mutable SpecTreeStoreMap<LicenseSpecTree> license;
+
+        mutable std::atomic<unsigned long> parse_count;
+        mutable std::atomic<unsigned long> reuse_count;
+
+        Imp() :
+            parse_count(0),
+            reuse_count(0)
+        {
+        }
+
+        template <typename T_, typename P_>
+        const std::shared_ptr<const T_> fetch(SpecTreeStoreMap<T_> & map, const P_ & parser,
+                const std::string & s, const Environment * const env, const EAPI & eapi, const bool is_installed) const
+        {
+            SpecTreeStoreIndex x(eapi.name(), is_installed, s);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto i(map.find(x));
+                if (i != map.end())
+                {
+                    ++reuse_count;
+                    return i->second;
+                }
+            }
+
+            /* parse without holding the lock, so that other threads can carry
+             * on using the store. if someone else got there first, keep theirs. */
+            std::shared_ptr<const T_> result(parser(s, env, eapi, is_installed));
+            ++parse_count;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            return map.insert(std::make_pair(x, result)).first->second;
+        }
+    };
+}
+
+ESpecTreeStore::ESpecTreeStore() :
+    _imp()
+{
+}
+
+ESpecTreeStore::~ESpecTreeStore() = default;
+
+const std::shared_ptr<const DependencySpecTree>
+ESpecTreeStore::fetch_depend(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->depend, parse_depend, s, env, eapi, i);
+}
+
+const std::shared_ptr<const FetchableURISpecTree>
+ESpecTreeStore::fetch_fetchable_uri(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->fetchable_uri, parse_fetchable_uri, s, env, eapi, i);
+}
+
+const std::shared_ptr<const SimpleURISpecTree>
+ESpecTreeStore::fetch_simple_uri(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->simple_uri, parse_simple_uri, s, env, eapi, i);
+}
+
+const std::shared_ptr<const PlainTextSpecTree>
+ESpecTreeStore::fetch_plain_text(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->plain_text, parse_plain_text, s, env, eapi, i);
+}
+
+const std::shared_ptr<const PlainTextSpecTree>
+ESpecTreeStore::fetch_myoptions(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->myoptions, parse_myoptions, s, env, eapi, i);
+}
+
+const std::shared_ptr<const RequiredUseSpecTree>
+ESpecTreeStore::fetch_required_use(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->required_use, parse_required_use, s, env, eapi, i);
+}
+
+const std::shared_ptr<const LicenseSpecTree>
+ESpecTreeStore::fetch_license(const std::string & s, const Environment * const env, const EAPI & eapi, const bool i) const
+{
+    return _imp->fetch(_imp->license, parse_license, s, env, eapi, i);
+}
+
+unsigned long
+ESpecTreeStore::parse_count() const
+{
+    return _imp->parse_count;
+}
+
+unsigned long
+ESpecTreeStore::reuse_count() const
+{
+    return _imp->reuse_count;
+}
+
 namespace paludis
 {
     template <>
@@ -70,6 +197,9 @@ namespace paludis
         const std::string human_name;
         const MetadataKeyType type;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const DependencySpecTree> value;
+
         Imp(
                 const Environment * const e,
                 const std::shared_ptr<const ERepositoryID> & i, const std::string & v,
@@ -103,8 +233,13 @@ EDependenciesKey::~EDependenciesKey()
 const std::shared_ptr<const DependencySpecTree>
 EDependenciesKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "' from '" + stringify(*_imp->id) + "':");
-    return parse_depend(_imp->string_value, _imp->env, *_imp->id->eapi(), _imp->id->is_installed());
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->raw_name, "' from '", *_imp->id, "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_depend(_imp->string_value, _imp->env, *_imp->id->eapi(), _imp->id->is_installed());
+    }
+    return _imp->value;
 }
 
 const std::shared_ptr<const DependenciesLabelSequence>
@@ -154,6 +289,9 @@ namespace paludis
         const MetadataKeyType type;
         const bool is_installed;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const LicenseSpecTree> value;
+
         Imp(const Environment * const e,
                 const std::string & v,
                 const std::shared_ptr<const EAPIMetadataVariable> & m,
@@ -188,8 +326,13 @@ ELicenseKey::~ELicenseKey()
 const std::shared_ptr<const LicenseSpecTree>
 ELicenseKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "':");
-    return parse_license(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->variable->name(), "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_license(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    }
+    return _imp->value;
 }
 
 const std::string
@@ -231,6 +374,9 @@ namespace paludis
         const std::string string_value;
         const MetadataKeyType type;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const FetchableURISpecTree> value;
+
         Imp(const Environment * const e, const std::shared_ptr<const ERepositoryID> & i,
                 const std::shared_ptr<const EAPIMetadataVariable> & m, const std::string & v,
                 const MetadataKeyType t) :
@@ -258,8 +404,13 @@ EFetchableURIKey::~EFetchableURIKey()
 const std::shared_ptr<const FetchableURISpecTree>
 EFetchableURIKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "' from '" + stringify(*_imp->id) + "':");
-    return parse_fetchable_uri(_imp->string_value, _imp->env, *_imp->id->eapi(), _imp->id->is_installed());
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->variable->name(), "' from '", *_imp->id, "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_fetchable_uri(_imp->string_value, _imp->env, *_imp->id->eapi(), _imp->id->is_installed());
+    }
+    return _imp->value;
 }
 
 const std::string
@@ -337,6 +488,9 @@ namespace paludis
         const MetadataKeyType type;
         const bool is_installed;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const SimpleURISpecTree> value;
+
         Imp(const Environment * const e, const std::string & v,
                 const std::shared_ptr<const EAPIMetadataVariable> & m,
                 const std::shared_ptr<const EAPI> & p,
@@ -368,7 +522,10 @@ ESimpleURIKey::~ESimpleURIKey()
 const std::shared_ptr<const SimpleURISpecTree>
 ESimpleURIKey::parse_value() const
 {
-    return parse_simple_uri(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+        _imp->value = ESpecTreeStore::get_instance()->fetch_simple_uri(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    return _imp->value;
 }
 
 const std::string
@@ -412,6 +569,9 @@ namespace paludis
         const MetadataKeyType type;
         const bool is_installed;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const PlainTextSpecTree> value;
+
         Imp(const Environment * const e, const std::string & v,
                 const std::shared_ptr<const EAPIMetadataVariable> & m,
                 const std::shared_ptr<const EAPI> & p,
@@ -442,8 +602,13 @@ EPlainTextSpecKey::~EPlainTextSpecKey()
 const std::shared_ptr<const PlainTextSpecTree>
 EPlainTextSpecKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "':");
-    return parse_plain_text(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->variable->name(), "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_plain_text(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    }
+    return _imp->value;
 }
 
 const std::string
@@ -487,6 +652,9 @@ namespace paludis
         const MetadataKeyType type;
         const bool is_installed;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const PlainTextSpecTree> value;
+
         Imp(const Environment * const e,
                 const std::string & v,
                 const std::shared_ptr<const EAPIMetadataVariable> & m,
@@ -520,8 +688,13 @@ EMyOptionsKey::~EMyOptionsKey()
 const std::shared_ptr<const PlainTextSpecTree>
 EMyOptionsKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "':");
-    return parse_myoptions(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->variable->name(), "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_myoptions(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    }
+    return _imp->value;
 }
 
 const std::string
@@ -565,6 +738,9 @@ namespace paludis
         const MetadataKeyType type;
         const bool is_installed;
 
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const RequiredUseSpecTree> value;
+
         Imp(const Environment * const e,
                 const std::string & v,
                 const std::shared_ptr<const EAPIMetadataVariable> & m,
@@ -599,8 +775,13 @@ ERequiredUseKey::~ERequiredUseKey()
 const std::shared_ptr<const RequiredUseSpecTree>
 ERequiredUseKey::parse_value() const
 {
-    Context context("When parsing metadata key '" + raw_name() + "':");
-    return parse_required_use(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! _imp->value)
+    {
+        Context context("When parsing metadata key '", _imp->variable->name(), "':");
+        _imp->value = ESpecTreeStore::get_instance()->fetch_required_use(_imp->string_value, _imp->env, *_imp->eapi, _imp->is_installed);
+    }
+    return _imp->value;
 }
 
 const std::string
@@ -711,3 +892,8 @@ EMTimeKey::type() const
     return _imp->type;
 }
 
+namespace paludis
+{
+    template class Pimp<ESpecTreeStore>;
+    template class Singleton<ESpecTreeStore>;
+}
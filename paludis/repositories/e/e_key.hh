@@ -23,6 +23,7 @@
 #include <paludis/metadata_key.hh>
 #include <paludis/util/set.hh>
 #include <paludis/util/map-fwd.hh>
+#include <paludis/util/singleton.hh>
 #include <paludis/repositories/e/eapi-fwd.hh>
 
 namespace paludis
@@ -33,6 +34,76 @@ namespace paludis
     {
         class ERepositoryID;
 
+        /**
+         * Parsed spec trees, shared between every key with the same EAPI,
+         * installed status and string value.
+         *
+         * Spec trees are immutable once parsed, so identical dependency,
+         * licence, URI and similar strings only need parsing once.
+         *
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE ESpecTreeStore :
+            public Singleton<ESpecTreeStore>
+        {
+            friend class Singleton<ESpecTreeStore>;
+
+            private:
+                Pimp<ESpecTreeStore> _imp;
+
+                ESpecTreeStore();
+                ~ESpecTreeStore();
+
+            public:
+                ///\name Fetch a parsed tree, parsing it if necessary
+                ///\{
+
+                const std::shared_ptr<const DependencySpecTree> fetch_depend(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const FetchableURISpecTree> fetch_fetchable_uri(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const SimpleURISpecTree> fetch_simple_uri(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const PlainTextSpecTree> fetch_plain_text(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const PlainTextSpecTree> fetch_myoptions(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const RequiredUseSpecTree> fetch_required_use(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                const std::shared_ptr<const LicenseSpecTree> fetch_license(const std::string &,
+                        const Environment * const, const EAPI &, const bool is_installed) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                ///\}
+
+                ///\name Statistics
+                ///\{
+
+                /**
+                 * How many strings have actually been handed to the parser.
+                 */
+                unsigned long parse_count() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * How many fetches were satisfied by an already parsed tree.
+                 */
+                unsigned long reuse_count() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                ///\}
+        };
+
         class EDependenciesKey :
             public MetadataSpecTreeKey<DependencySpecTree>
         {
@@ -241,6 +312,9 @@ namespace paludis
                 virtual MetadataKeyType type() const PALUDIS_ATTRIBUTE((warn_unused_result));
         };
     }
+
+    extern template class Pimp<erepository::ESpecTreeStore>;
+    extern template class Singleton<erepository::ESpecTreeStore>;
 }
 
 #endif
@@ -0,0 +1,84 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/e_key.hh>
+#include <paludis/repositories/e/eapi.hh>
+#include <paludis/repositories/e/dep_parser.hh>
+#include <paludis/repositories/e/spec_tree_pretty_printer.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/unformatted_pretty_printer.hh>
+
+#include <paludis/util/stringify.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+TEST(ESpecTreeStore, Shared)
+{
+    TestEnvironment env;
+    const EAPI & eapi(*EAPIData::get_instance()->eapi_from_string("paludis-1"));
+    const ESpecTreeStore & store(*ESpecTreeStore::get_instance());
+
+    unsigned long parses(store.parse_count()), reuses(store.reuse_count());
+
+    auto a(store.fetch_depend("cat/shared-one || ( cat/shared-two cat/shared-three )", &env, eapi, false));
+    auto b(store.fetch_depend("cat/shared-one || ( cat/shared-two cat/shared-three )", &env, eapi, false));
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(parses + 1, store.parse_count());
+    EXPECT_EQ(reuses + 1, store.reuse_count());
+
+    UnformattedPrettyPrinter ff;
+    SpecTreePrettyPrinter d(ff, { });
+    b->top()->accept(d);
+    EXPECT_EQ("cat/shared-one || ( cat/shared-two cat/shared-three )", stringify(d));
+}
+
+TEST(ESpecTreeStore, Distinct)
+{
+    TestEnvironment env;
+    const EAPI & eapi(*EAPIData::get_instance()->eapi_from_string("paludis-1"));
+    const EAPI & other_eapi(*EAPIData::get_instance()->eapi_from_string("0"));
+    const ESpecTreeStore & store(*ESpecTreeStore::get_instance());
+
+    auto a(store.fetch_plain_text("distinct-one distinct-two", &env, eapi, false));
+    EXPECT_NE(a, store.fetch_plain_text("distinct-one distinct-three", &env, eapi, false));
+    EXPECT_NE(a, store.fetch_plain_text("distinct-one distinct-two", &env, other_eapi, false));
+    EXPECT_NE(a, store.fetch_plain_text("distinct-one distinct-two", &env, eapi, true));
+
+    auto b(store.fetch_myoptions("distinct-one distinct-two", &env, eapi, false));
+    EXPECT_NE(std::static_pointer_cast<const void>(a), std::static_pointer_cast<const void>(b));
+}
+
+TEST(ESpecTreeStore, Errors)
+{
+    TestEnvironment env;
+    const EAPI & eapi(*EAPIData::get_instance()->eapi_from_string("paludis-1"));
+    const ESpecTreeStore & store(*ESpecTreeStore::get_instance());
+
+    unsigned long parses(store.parse_count());
+    EXPECT_THROW(auto PALUDIS_ATTRIBUTE((unused)) x(store.fetch_license("( broken", &env, eapi, false)), EDepParseError);
+    EXPECT_THROW(auto PALUDIS_ATTRIBUTE((unused)) x(store.fetch_license("( broken", &env, eapi, false)), EDepParseError);
+    EXPECT_EQ(parses, store.parse_count());
+}
+
@@ -34,6 +34,7 @@
 #include <paludis/repositories/e/extra_distribution_data.hh>
 #include <paludis/repositories/e/memoised_hashes.hh>
 #include <paludis/repositories/e/ebuild_id.hh>
+#include <paludis/repositories/e/ebuild_binary_metadata_cache.hh>
 #include <paludis/repositories/e/eapi_phase.hh>
 #include <paludis/repositories/e/can_skip_phase.hh>
 #include <paludis/repositories/e/ebuild.hh>
@@ -188,6 +189,24 @@ namespace
             result->add(p->parse_value());
         return result;
     }
+
+    std::shared_ptr<EbuildBinaryMetadataCache> make_binary_cache(const FSPath & f)
+    {
+        if (EbuildBinaryMetadataCache::is_binary_cache(f))
+            return std::make_shared<EbuildBinaryMetadataCache>(f);
+        return nullptr;
+    }
+
+    std::shared_ptr<EbuildBinaryMetadataCache> make_binary_write_cache(const ERepository * const r, const ERepositoryParams & p)
+    {
+        if (! EbuildBinaryMetadataCache::is_binary_cache(p.write_cache()))
+            return nullptr;
+
+        if (p.append_repository_name_to_write_cache())
+            return std::make_shared<EbuildBinaryMetadataCache>(p.write_cache() / stringify(r->name()));
+        else
+            return std::make_shared<EbuildBinaryMetadataCache>(p.write_cache());
+    }
 }
 
 namespace paludis
@@ -212,6 +231,9 @@ namespace paludis
 
         std::shared_ptr<RepositoryNameCache> names_cache;
 
+        const std::shared_ptr<EbuildBinaryMetadataCache> binary_cache;
+        const std::shared_ptr<EbuildBinaryMetadataCache> binary_write_cache;
+
         const std::map<QualifiedPackageName, QualifiedPackageName> provide_map;
 
         mutable std::shared_ptr<Set<UnprefixedChoiceName> > arch_flags;
@@ -285,6 +307,8 @@ namespace paludis
         params(p),
         mutexes(m),
         names_cache(std::make_shared<RepositoryNameCache>(p.names_cache(), r)),
+        binary_cache(make_binary_cache(p.cache())),
+        binary_write_cache(make_binary_write_cache(r, p)),
         has_mirrors(false),
         sets_ptr(std::make_shared<ERepositorySets>(params.environment(), r, p)),
         layout(LayoutFactory::get_instance()->create(params.layout(), params.environment(), r, params.location(), get_master_locations(
@@ -476,7 +500,10 @@ namespace paludis
                 EAPIData::get_instance()->eapi_from_string(params.eapi_when_unknown())->supported()->ebuild_environment_variables()->env_arch(),
                 params.profiles_explicitly_set(),
                 bool(params.master_repositories()),
-                params.ignore_deprecated_profiles());
+                params.ignore_deprecated_profiles(),
+                params.profiles_cache(),
+                params.profile_eapi_when_unspecified(),
+                params.location() / "metadata" / "layout.conf");
     }
 }
 
@@ -784,6 +811,7 @@ ERepository::invalidate()
 {
     _imp.reset(new Imp<ERepository>(this, _imp->params, _imp->mutexes));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 void
@@ -893,10 +921,29 @@ ERepository::environment_updated_profile_variable(const std::string & var) const
     return join(values.begin(), last, " ");
 }
 
+const std::shared_ptr<const EbuildBinaryMetadataCache>
+ERepository::binary_metadata_cache() const
+{
+    return _imp->binary_cache;
+}
+
+const std::shared_ptr<const EbuildBinaryMetadataCache>
+ERepository::binary_metadata_write_cache() const
+{
+    return _imp->binary_write_cache;
+}
+
 void
 ERepository::regenerate_cache() const
 {
     _imp->names_cache->regenerate_cache();
+
+    if (_imp->binary_cache)
+        _imp->binary_cache->regenerate(this);
+
+    if (_imp->binary_write_cache && ! (_imp->binary_cache
+                && _imp->binary_cache->location() == _imp->binary_write_cache->location()))
+        _imp->binary_write_cache->regenerate(this);
 }
 
 std::shared_ptr<const CategoryNamePartSet>
@@ -991,6 +1038,8 @@ ERepository::make_manifest(const QualifiedPackageName & qpn)
         if (! DigestRegistry::get_instance()->get(*it))
             throw ERepositoryConfigurationError("Manifest hash function '" + *it + "' is not supported");
 
+    std::set<std::string> algos(_imp->params.manifest_hashes()->begin(), _imp->params.manifest_hashes()->end());
+
     FSPath package_dir = _imp->layout->package_directory(qpn);
 
     std::vector<std::pair<std::pair<std::string, std::string>, std::string> > lines;
@@ -1014,13 +1063,11 @@ ERepository::make_manifest(const QualifiedPackageName & qpn)
 
             std::string line(file_type + " " + filename + " " + stringify(file.stat().file_size()));
 
+            auto hexsums(DigestRegistry::get_instance()->digest_all(algos, file_stream));
+
             for (Set<std::string>::ConstIterator it(_imp->params.manifest_hashes()->begin()),
                      it_end(_imp->params.manifest_hashes()->end()); it_end != it; ++it)
-            {
-                file_stream.clear();
-                file_stream.seekg(0, std::ios::beg);
-                line += " " + *it + " " + DigestRegistry::get_instance()->get(*it)(file_stream);
-            }
+                line += " " + *it + " " + hexsums.find(*it)->second;
 
             lines.push_back(std::make_pair(std::make_pair(file_type, filename), line));
         }
@@ -1060,9 +1107,11 @@ ERepository::make_manifest(const QualifiedPackageName & qpn)
 
             std::string line("DIST " + f.basename() + " " + stringify(f_stat.file_size()));
 
+            auto hexsums(hashes->get_all(algos, f, file_stream));
+
             for (Set<std::string>::ConstIterator it(_imp->params.manifest_hashes()->begin()),
                      it_end(_imp->params.manifest_hashes()->end()); it_end != it; ++it)
-                line += " " + *it + " " + hashes->get(*it, f, file_stream);
+                line += " " + *it + " " + hexsums.find(*it)->second;
 
             lines.push_back(std::make_pair(std::make_pair("DIST", f.basename()), line));
         }
@@ -1358,6 +1407,10 @@ ERepository::repository_factory_create(
         }
     }
 
+    std::string profiles_cache(f("profiles_cache"));
+    if (profiles_cache.empty())
+        profiles_cache = "/var/empty";
+
     auto sync(std::make_shared<Map<std::string, std::string> >());
     std::vector<std::string> sync_tokens;
     tokenise_whitespace(f("sync"), std::back_inserter(sync_tokens));
@@ -1506,6 +1559,7 @@ ERepository::repository_factory_create(
                 n::profile_eapi_when_unspecified() = profile_eapi,
                 n::profile_layout() = profile_layout,
                 n::profiles() = profiles,
+                n::profiles_cache() = FSPath(profiles_cache).realpath_if_exists(),
                 n::profiles_explicitly_set() = profiles_explicitly_set,
                 n::securitydir() = FSPath(securitydir).realpath_if_exists(),
                 n::setsdir() = FSPath(setsdir).realpath_if_exists(),
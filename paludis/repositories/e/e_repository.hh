@@ -41,6 +41,11 @@ namespace paludis
 {
     class ERepositoryNews;
 
+    namespace erepository
+    {
+        class EbuildBinaryMetadataCache;
+    }
+
     /**
      * A ERepository is a Repository that handles the layout used by
      * Portage for the main Gentoo tree.
@@ -155,8 +160,28 @@ namespace paludis
             const std::shared_ptr<const erepository::Layout> layout() const;
             const std::shared_ptr<const erepository::Profile> profile() const;
 
+            /**
+             * Regenerate our names cache, along with any binary metadata
+             * caches.
+             */
             void regenerate_cache() const;
 
+            /**
+             * Our metadata cache, if our cache key is set to use the binary
+             * format.
+             *
+             * \since 2.4
+             */
+            const std::shared_ptr<const erepository::EbuildBinaryMetadataCache> binary_metadata_cache() const;
+
+            /**
+             * Our metadata write cache, if our write_cache key is set to use
+             * the binary format.
+             *
+             * \since 2.4
+             */
+            const std::shared_ptr<const erepository::EbuildBinaryMetadataCache> binary_metadata_write_cache() const;
+
             /* Keys */
 
             virtual const std::shared_ptr<const MetadataValueKey<std::string> > format_key() const;
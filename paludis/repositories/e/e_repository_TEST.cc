@@ -23,6 +23,7 @@
 #include <paludis/repositories/e/vdb_repository.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/spec_tree_pretty_printer.hh>
+#include <paludis/repositories/e/ebuild_metadata_workers.hh>
 
 #include <paludis/repositories/fake/fake_installed_repository.hh>
 #include <paludis/repositories/fake/fake_package_id.hh>
@@ -35,6 +36,7 @@
 #include <paludis/util/set.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/stringify.hh>
 
 #include <paludis/standard_output_manager.hh>
@@ -48,15 +50,20 @@
 #include <paludis/selection.hh>
 #include <paludis/repository_factory.hh>
 #include <paludis/choice.hh>
+#include <paludis/slot.hh>
 #include <paludis/unformatted_pretty_printer.hh>
 
 #include <paludis/util/indirect_iterator-impl.hh>
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
+#include <map>
 #include <set>
 #include <string>
 
+#include <fcntl.h>
+
 #include "config.h"
 
 #include <gtest/gtest.h>
@@ -90,6 +97,23 @@ namespace
         SafeIFStream s(FSPath(filename).realpath());
         return std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
     }
+
+    /* change one of the values stored in a profile snapshot, so we can tell
+     * whether the snapshot is used or whether the profile is read again */
+    void tamper_with_snapshot(const FSPath & snapshot, const std::string & from, const std::string & to)
+    {
+        std::string text(contents(stringify(snapshot)));
+        std::string old_value("\n" + stringify(from.length()) + " " + from + "\n"),
+            new_value("\n" + stringify(to.length()) + " " + to + "\n");
+
+        std::string::size_type p(text.find(old_value));
+        ASSERT_NE(std::string::npos, p) << "no value '" << from << "' in '" << snapshot << "'";
+        ASSERT_EQ(std::string::npos, text.find(old_value, p + 1)) << "value '" << from << "' is not unique in '" << snapshot << "'";
+        text.replace(p, old_value.length(), new_value);
+
+        SafeOFStream s(snapshot, O_WRONLY | O_TRUNC, true);
+        s << text;
+    }
 }
 
 TEST(ERepository, RepoName)
@@ -472,6 +496,127 @@ TEST(ERepository, MetadataUnparsable)
     }
 }
 
+namespace
+{
+    struct MetadataValueStringifier
+    {
+        UnformattedPrettyPrinter printer;
+
+        std::string visit(const MetadataValueKey<std::string> & k)
+        {
+            return k.parse_value();
+        }
+
+        std::string visit(const MetadataValueKey<long> & k)
+        {
+            return stringify(k.parse_value());
+        }
+
+        std::string visit(const MetadataValueKey<bool> & k)
+        {
+            return stringify(k.parse_value());
+        }
+
+        std::string visit(const MetadataValueKey<FSPath> & k)
+        {
+            return stringify(k.parse_value());
+        }
+
+        std::string visit(const MetadataValueKey<Slot> & k)
+        {
+            return k.parse_value().raw_value();
+        }
+
+        std::string visit(const MetadataValueKey<std::shared_ptr<const Choices> > & k)
+        {
+            std::string result;
+            auto choices(k.parse_value());
+            for (auto c(choices->begin()), c_end(choices->end()) ; c != c_end ; ++c)
+                for (auto v((*c)->begin()), v_end((*c)->end()) ; v != v_end ; ++v)
+                    result.append(stringify((*v)->name_with_prefix()) + "=" + stringify((*v)->enabled()) + " ");
+            return result;
+        }
+
+        std::string visit(const MetadataTimeKey & k)
+        {
+            return stringify(k.parse_value().seconds());
+        }
+
+        std::string visit(const MetadataSectionKey &)
+        {
+            return "";
+        }
+
+        template <typename T_>
+        std::string visit(const T_ & k)
+        {
+            return k.pretty_print_value(printer, { });
+        }
+    };
+
+    std::map<std::string, std::string> generated_metadata()
+    {
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo21"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo21/profiles/profile"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+        std::shared_ptr<Repository> repo(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1)));
+        env.add_repository(1, repo);
+
+        std::map<std::string, std::string> result;
+        MetadataValueStringifier v;
+        const std::shared_ptr<const PackageIDSequence> ids(env[selection::AllVersionsSorted(
+                    generator::InRepository(RepositoryName("test-repo-21")))]);
+        for (auto i(ids->begin()), i_end(ids->end()) ; i != i_end ; ++i)
+        {
+            /* STDERR includes process IDs and the call stack, so it differs */
+            for (auto m((*i)->begin_metadata()), m_end((*i)->end_metadata()) ; m != m_end ; ++m)
+                if ((*m)->raw_name() != "STDERR")
+                    result.insert(std::make_pair(stringify(**i) + " " + (*m)->raw_name(), (*m)->accept_returning<std::string>(v)));
+
+            for (auto m((*i)->begin_masks()), m_end((*i)->end_masks()) ; m != m_end ; ++m)
+                result.insert(std::make_pair(stringify(**i) + " mask " + stringify((*m)->key()), (*m)->description()));
+        }
+
+        return result;
+    }
+}
+
+TEST(ERepository, MetadataWorkers)
+{
+    const std::map<std::string, std::string> without_workers(generated_metadata());
+
+    erepository::EbuildMetadataWorkers::get_instance()->set_max_workers_per_key(2);
+    const std::map<std::string, std::string> with_workers(generated_metadata());
+    erepository::EbuildMetadataWorkers::get_instance()->set_max_workers_per_key(0);
+
+    auto value([&] (const std::string & k) -> std::string {
+            auto i(without_workers.find(k));
+            return without_workers.end() == i ? "(missing)" : i->second;
+            });
+    EXPECT_EQ("The Description", value("cat-one/pkg-one-1:0::test-repo-21 DESCRIPTION"));
+    EXPECT_EQ("foo/bar:=", value("cat-one/pkg-one-3:1::test-repo-21 RDEPEND"));
+    EXPECT_EQ("eapi", value("cat-one/pkg-two-1::test-repo-21 mask E"));
+    EXPECT_EQ("eapi", value("cat-one/pkg-three-1::test-repo-21 mask E"));
+
+    for (auto & m : without_workers)
+    {
+        auto w(with_workers.find(m.first));
+        if (with_workers.end() == w)
+            ADD_FAILURE() << "key '" << m.first << "' is missing when using workers";
+        else
+            EXPECT_EQ(m.second, w->second) << "for key '" << m.first << "'";
+    }
+
+    for (auto & w : with_workers)
+        if (without_workers.end() == without_workers.find(w.first))
+            ADD_FAILURE() << "key '" << w.first << "' only exists when using workers";
+}
+
 namespace
 {
     struct ERepositoryQueryUseTest :
@@ -840,6 +985,138 @@ TEST(ERepository, ProfileMasks)
     }
 }
 
+TEST_F(ERepositoryQueryUseTest, ProfilesCache)
+{
+    FSPath profiles_cache(FSPath::cwd() / "e_repository_TEST_dir" / "profiles_cache");
+
+    for (int pass = 1 ; pass <= 3 ; ++pass)
+    {
+        /* the snapshot is written on the first pass. force flag1 rather than
+         * flag4 in it before the last pass, to show that it is being used */
+        if (3 == pass)
+            tamper_with_snapshot(profiles_cache / "test-repo-9.profile", "flag4", "flag1");
+
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("profiles_cache", stringify(profiles_cache));
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9/profiles/child"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+        std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                        std::bind(from_keys, keys, std::placeholders::_1))));
+        env.add_repository(1, repo);
+
+        const std::shared_ptr<const PackageID> p1(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                                &env, { })), nullptr, { }))]->begin());
+        const std::shared_ptr<const PackageID> p2(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat-two/pkg-two-1",
+                                &env, { })), nullptr, { }))]->begin());
+
+        test_choice(p1, "flag1",     true,  true,  3 == pass);
+        test_choice(p1, "flag2",     false, false, true);
+        test_choice(p1, "flag4",     3 != pass, 3 != pass, 3 != pass);
+        test_choice(p1, "enabled3",  false, false, true);
+        test_choice(p1, "disabled3", true,  true,  true);
+        test_choice(p2, "flag3", false, false, true);
+        test_choice(p2, "flag5", true,  true,  true);
+        test_choice(p1, "test",  true,  true,  true);
+        test_choice(p1, "not_in_iuse_forced_package", false, false, false, "forced_package");
+        test_choice(p2, "not_in_iuse_forced_package", true, true, true, "forced_package");
+
+        EXPECT_TRUE((profiles_cache / (stringify(repo->name()) + ".profile")).stat().is_regular_file());
+    }
+
+    for (int pass = 1 ; pass <= 3 ; ++pass)
+    {
+        if (3 == pass)
+            tamper_with_snapshot(profiles_cache / "test-repo-10.profile", "cat/masked", "cat/not_masked");
+
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("profiles_cache", stringify(profiles_cache));
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo10"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo10/profiles/profile/subprofile"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+        std::shared_ptr<Repository> repo(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1)));
+        env.add_repository(1, repo);
+
+        EXPECT_EQ(3 != pass, (*env[selection::RequireExactlyOne(generator::Matches(
+                            PackageDepSpec(parse_user_package_dep_spec("=cat/masked-0",
+                                    &env, { })), nullptr, { }))]->begin())->masked());
+        EXPECT_TRUE(! (*env[selection::RequireExactlyOne(generator::Matches(
+                            PackageDepSpec(parse_user_package_dep_spec("=cat/was_masked-0",
+                                    &env, { })), nullptr, { }))]->begin())->masked());
+        EXPECT_EQ(3 == pass, (*env[selection::RequireExactlyOne(generator::Matches(
+                            PackageDepSpec(parse_user_package_dep_spec("=cat/not_masked-0",
+                                    &env, { })), nullptr, { }))]->begin())->masked());
+    }
+}
+
+TEST_F(ERepositoryQueryUseTest, ProfilesCacheFallbackEAPI)
+{
+    FSPath profiles_cache(FSPath::cwd() / "e_repository_TEST_dir" / "profiles_cache_eapi");
+    FSPath snapshot(profiles_cache / "test-repo-9.profile");
+    FSPath layout_conf(FSPath::cwd() / "e_repository_TEST_dir" / "repo9" / "metadata" / "layout.conf");
+
+    /* an empty profile_eapi means use whatever layout.conf says */
+    auto check([&] (const std::string & profile_eapi, const bool flag1_forced) {
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("profiles_cache", stringify(profiles_cache));
+        if (! profile_eapi.empty())
+            keys->insert("profile_eapi_when_unspecified", profile_eapi);
+        keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9/profiles/child"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+        std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                        std::bind(from_keys, keys, std::placeholders::_1))));
+        env.add_repository(1, repo);
+
+        const std::shared_ptr<const PackageID> p1(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                                &env, { })), nullptr, { }))]->begin());
+        test_choice(p1, "flag1", true, true, flag1_forced);
+        EXPECT_TRUE(snapshot.stat().is_regular_file());
+    });
+
+    /* the tampered value is used while the fallback EAPI stays the same */
+    check("0", false);
+    tamper_with_snapshot(snapshot, "flag4", "flag1");
+    check("0", true);
+
+    /* and is thrown away when the fallback EAPI changes */
+    check("1", false);
+    tamper_with_snapshot(snapshot, "flag4", "flag1");
+    check("1", true);
+
+    /* or when layout.conf appears or changes, even if the fallback EAPI
+     * it gives us is the same as before */
+    layout_conf.dirname().mkdir(0755, { fspmkdo_ok_if_exists });
+    {
+        SafeOFStream s(layout_conf, O_CREAT | O_WRONLY | O_TRUNC, true);
+        s << "profile_eapi_when_unspecified = 1" << std::endl;
+    }
+    check("", false);
+    tamper_with_snapshot(snapshot, "flag4", "flag1");
+    check("", true);
+
+    {
+        SafeOFStream s(layout_conf, O_WRONLY | O_APPEND, true);
+        s << "thin-manifests = false" << std::endl;
+    }
+    check("", false);
+
+    layout_conf.unlink();
+}
+
 TEST(ERepository, Manifest)
 {
     TestEnvironment env;
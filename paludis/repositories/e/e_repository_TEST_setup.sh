@@ -959,5 +959,77 @@ SLOT="0"
 END
 cd ..
 
+mkdir -p repo21/{eclass,distfiles,profiles/profile} || exit 1
+mkdir -p repo21/cat-one/pkg-{one,two,three} || exit 1
+cd repo21 || exit 1
+echo "test-repo-21" > profiles/repo_name || exit 1
+cat <<END > profiles/categories || exit 1
+cat-one
+END
+cat <<END > profiles/profile/make.defaults
+ARCH=test
+END
+cat <<END > eclass/mine.eclass
+DEPEND="bar/baz"
+IUSE="mine"
+EXPORT_FUNCTIONS src_compile
+mine_src_compile() {
+    :
+}
+END
+cat <<END > cat-one/pkg-one/pkg-one-1.ebuild || exit 1
+DESCRIPTION="The Description"
+HOMEPAGE="http://example.com/"
+SRC_URI="http://example.com/\${P}.tar.bz2"
+SLOT="0"
+IUSE="foo"
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND="foo? ( foo/bar )"
+END
+cat <<"END" > cat-one/pkg-one/pkg-one-2.ebuild || exit 1
+inherit mine
+DESCRIPTION="dquote \" squote ' backslash \\ dollar \$"
+HOMEPAGE="http://example.com/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND="foo/bar"
+END
+cat <<"END" > cat-one/pkg-one/pkg-one-3.ebuild || exit 1
+EAPI="5"
+inherit mine
+DESCRIPTION="The Description"
+HOMEPAGE="http://example.com/"
+SRC_URI=""
+SLOT="1/2"
+IUSE="+foo bar"
+REQUIRED_USE="|| ( foo bar )"
+LICENSE="GPL-2"
+KEYWORDS="~test"
+RDEPEND="foo/bar:="
+END
+cat <<"END" > cat-one/pkg-one/pkg-one-4.exheres-0 || exit 1
+SUMMARY="This is the short description"
+DESCRIPTION="This is the long description"
+HOMEPAGE="http://example.com/"
+DOWNLOADS=""
+SLOT="0"
+MYOPTIONS="foo"
+LICENCES="GPL-2"
+PLATFORMS="test"
+DEPENDENCIES="build: foo/bar run: foo? ( bar/baz )"
+END
+cat <<END > cat-one/pkg-two/pkg-two-1.ebuild || exit 1
+i am a fish
+END
+cat <<END > cat-one/pkg-three/pkg-three-1.ebuild || exit 1
+SLOT="0"
+die "dead at global scope"
+END
+cd ..
+
 cd ..
 
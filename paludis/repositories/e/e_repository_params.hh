@@ -65,6 +65,7 @@ namespace paludis
         typedef Name<struct name_profile_eapi_when_unspecified> profile_eapi_when_unspecified;
         typedef Name<struct name_profile_layout> profile_layout;
         typedef Name<struct name_profiles> profiles;
+        typedef Name<struct name_profiles_cache> profiles_cache;
         typedef Name<struct name_profiles_explicitly_set> profiles_explicitly_set;
         typedef Name<struct name_securitydir> securitydir;
         typedef Name<struct name_setsdir> setsdir;
@@ -106,6 +107,7 @@ namespace paludis
             NamedValue<n::profile_eapi_when_unspecified, std::string> profile_eapi_when_unspecified;
             NamedValue<n::profile_layout, std::string> profile_layout;
             NamedValue<n::profiles, std::shared_ptr<const FSPathSequence> > profiles;
+            NamedValue<n::profiles_cache, FSPath> profiles_cache;
             NamedValue<n::profiles_explicitly_set, bool> profiles_explicitly_set;
             NamedValue<n::securitydir, FSPath> securitydir;
             NamedValue<n::setsdir, FSPath> setsdir;
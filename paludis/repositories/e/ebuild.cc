@@ -23,6 +23,7 @@
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/dep_parser.hh>
 #include <paludis/repositories/e/pipe_command_handler.hh>
+#include <paludis/repositories/e/ebuild_metadata_workers.hh>
 
 #include <paludis/util/system.hh>
 #include <paludis/util/process.hh>
@@ -110,6 +111,20 @@ namespace
             choice = id->choices_key()->parse_value()->find_by_name_with_prefix(ELikeTraceChoiceValue::canonical_name_with_prefix());
         return choice && choice->enabled();
     }
+
+    ProcessPipeCommandFunction make_pipe_command_handler(const EbuildCommandParams & params, const bool in_metadata_generation)
+    {
+        using namespace std::placeholders;
+
+        return std::bind(&pipe_command_handler,
+                params.environment(),
+                params.package_id(),
+                params.permitted_directories(),
+                params.parts(),
+                params.volatile_files(),
+                in_metadata_generation, _1,
+                params.maybe_output_manager());
+    }
 }
 
 bool
@@ -117,8 +132,19 @@ EbuildCommand::operator() ()
 {
     Context context("When running an ebuild command on '" + stringify(*params.package_id()) + "':");
 
-    Process process(ProcessCommand(getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis") + "/ebuild.bash '"
-                + ebuild_file() + "' " + commands()));
+    std::unique_ptr<Process> process(make_process());
+    if (do_run_command(*process))
+        return success();
+    else
+        return failure();
+}
+
+std::unique_ptr<Process>
+EbuildCommand::make_process()
+{
+    std::unique_ptr<Process> result(new Process(ProcessCommand(getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis")
+                    + "/ebuild.bash '" + ebuild_file() + "' " + commands())));
+    Process & process(*result);
 
     if (! params.package_id()->eapi()->supported())
         throw InternalError(PALUDIS_HERE, "Tried to run EbuildCommand on an unsupported EAPI");
@@ -143,17 +169,7 @@ EbuildCommand::operator() ()
         process.setuid_setgid(params.environment()->reduced_uid(), params.environment()->reduced_gid());
     }
 
-    using namespace std::placeholders;
-
-    process.pipe_command_handler("PALUDIS_PIPE_COMMAND",
-                                 std::bind(&pipe_command_handler,
-                                           params.environment(),
-                                           params.package_id(),
-                                           params.permitted_directories(),
-                                           params.parts(),
-                                           params.volatile_files(),
-                                           in_metadata_generation(), _1,
-                                           params.maybe_output_manager()));
+    process.pipe_command_handler("PALUDIS_PIPE_COMMAND", make_pipe_command_handler(params, in_metadata_generation()));
 
     std::shared_ptr<const FSPathSequence> syncers_dirs(params.environment()->syncers_dirs());
     std::shared_ptr<const FSPathSequence> bashrc_files(params.environment()->bashrc_files());
@@ -349,10 +365,7 @@ EbuildCommand::operator() ()
             .capture_stdout(params.maybe_output_manager()->stdout_stream())
             .use_ptys();
 
-    if (do_run_command(process))
-        return success();
-    else
-        return failure();
+    return result;
 }
 
 std::string
@@ -437,12 +450,32 @@ EbuildMetadataCommand::do_run_command(Process & process)
         Context context("When running ebuild command to generate metadata for '" + stringify(*params.package_id()) + "':");
 
         std::stringstream prog, prog_err, metadata;
-        process
-            .capture_stdout(prog)
-            .capture_stderr(prog_err)
-            .capture_output_to_fd(metadata, -1, "PALUDIS_METADATA_FD");
+        int exit_status;
+
+        std::shared_ptr<const EbuildMetadataWorkerResult> worker_result;
+        if (EbuildMetadataWorkers::get_instance()->enabled())
+            worker_result = EbuildMetadataWorkers::get_instance()->run(
+                    params.package_id()->eapi()->name() + " " + stringify(params.builddir()) + " " +
+                    stringify(params.clearenv()) + stringify(params.sandbox()) + stringify(params.sydbox()) + stringify(params.userpriv()),
+                    process, [&] () { return make_process(); },
+                    make_pipe_command_handler(params, in_metadata_generation()), ebuild_file(), commands());
 
-        int exit_status(process.run().wait());
+        if (worker_result)
+        {
+            prog << worker_result->captured_stdout();
+            prog_err << worker_result->captured_stderr();
+            metadata << worker_result->metadata();
+            exit_status = worker_result->exit_status();
+        }
+        else
+        {
+            process
+                .capture_stdout(prog)
+                .capture_stderr(prog_err)
+                .capture_output_to_fd(metadata, -1, "PALUDIS_METADATA_FD");
+
+            exit_status = process.run().wait();
+        }
 
         KeyValueConfigFile f(metadata, { kvcfo_disallow_continuations, kvcfo_disallow_comments , kvcfo_disallow_space_around_equals,
                 kvcfo_disallow_unquoted_values, kvcfo_disallow_source , kvcfo_disallow_variables, kvcfo_preserve_whitespace },
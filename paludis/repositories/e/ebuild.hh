@@ -395,6 +395,13 @@ namespace paludis
                  */
                 virtual bool failure() = 0;
 
+                /**
+                 * Make a Process for our command, set up and ready to run.
+                 *
+                 * \since 2.4
+                 */
+                std::unique_ptr<Process> make_process();
+
                 /**
                  * Run the specified command. Can be overridden if, for example,
                  * the command output needs to be captured.
@@ -114,7 +114,7 @@ EBUILD_MODULES_DIRS="${EBUILD_MODULES_DIRS} ${EBUILD_MODULES_DIR}"
 export PALUDIS_EBUILD_MODULES_DIR="${EBUILD_MODULES_DIR}"
 
 export EBUILD_KILL_PID=$$
-declare -r EBUILD_KILL_PID
+[[ -z ${PALUDIS_EBUILD_WORKER} ]] && declare -r EBUILD_KILL_PID
 
 ebuild_load_module()
 {
@@ -688,5 +688,42 @@ ebuild_main()
     fi
 }
 
-ebuild_main "$@"
+ebuild_worker_main()
+{
+    local paludis_worker_dir paludis_worker_job paludis_worker_status=
+
+    paludis_worker_dir=$(mktemp -d "${PALUDIS_TMPDIR%/}/metadata-worker-XXXXXX" ) || \
+        die "Couldn't create a directory for the metadata worker"
+
+    while true ; do
+        paludis_worker_job=$(paludis_pipe_command WORKER_NEXT_JOB "${EAPI}" "${paludis_worker_status}" "${paludis_worker_dir}" )
+        [[ -z ${paludis_worker_job} ]] && break
+
+        (
+            unset PALUDIS_EBUILD_WORKER
+            eval "${paludis_worker_job}"
+            ebuild_cleanup_slashes ROOT
+
+            export EBUILD_KILL_PID=${BASHPID}
+            readonly EBUILD_KILL_PID
+            unset EBUILD_MODULES_DIRS_EXCLUDE_die_functions
+            ebuild_load_module die_functions
+
+            exec {PALUDIS_METADATA_FD}>"${paludis_worker_dir}"/metadata
+            export PALUDIS_METADATA_FD
+            unset paludis_worker_dir paludis_worker_job paludis_worker_status
+
+            ebuild_main "${PALUDIS_EBUILD_WORKER_EBUILD}" ${PALUDIS_EBUILD_WORKER_COMMANDS}
+        ) >"${paludis_worker_dir}"/stdout 2>"${paludis_worker_dir}"/stderr </dev/null
+        paludis_worker_status=${?}
+    done
+
+    rm -fr "${paludis_worker_dir}"
+}
+
+if [[ -n ${PALUDIS_EBUILD_WORKER} ]] ; then
+    ebuild_worker_main
+else
+    ebuild_main "$@"
+fi
 
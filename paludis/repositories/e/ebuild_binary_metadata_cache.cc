@@ -0,0 +1,521 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/ebuild_binary_metadata_cache.hh>
+#include <paludis/repositories/e/ebuild_flat_metadata_cache.hh>
+#include <paludis/repositories/e/ebuild_id.hh>
+#include <paludis/repositories/e/e_repository.hh>
+
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/task_scheduler.hh>
+#include <paludis/util/pimp-impl.hh>
+
+#include <paludis/name.hh>
+#include <paludis/version_spec.hh>
+
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    /* Everything is in host byte order, and every table entry is made up
+     * of uint32_ts, so the tables can be used directly from the mapping. A
+     * file written on a host with a different byte order fails the version
+     * check, and is ignored. */
+
+    const char binary_cache_magic[8] = { 'P', 'A', 'L', 'U', 'D', 'B', 'M', 'C' };
+    const uint32_t binary_cache_version = 1;
+
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t n_packages;
+        uint32_t n_versions;
+        uint32_t n_keys;
+        uint32_t packages_offset;
+        uint32_t versions_offset;
+        uint32_t keys_offset;
+        uint32_t strings_offset;
+        uint32_t strings_size;
+        uint32_t reserved;
+    };
+
+    /* sorted by name, so we can binary search */
+    struct PackageEntry
+    {
+        StringRef name;
+        uint32_t first_version;
+        uint32_t n_versions;
+    };
+
+    struct VersionEntry
+    {
+        StringRef version;
+        uint32_t first_key;
+        uint32_t n_keys;
+    };
+
+    struct KeyEntry
+    {
+        StringRef key;
+        StringRef value;
+    };
+
+    bool in_range(const uint64_t start, const uint64_t count, const uint64_t item_size, const uint64_t limit)
+    {
+        return start <= limit && count * item_size <= limit - start;
+    }
+
+    struct Mapping
+    {
+        const FSPath location;
+        void * address;
+        std::size_t size;
+
+        const Header * header;
+        const PackageEntry * packages;
+        const VersionEntry * versions;
+        const KeyEntry * keys;
+        const char * strings;
+
+        Mapping(const FSPath & l) :
+            location(l),
+            address(MAP_FAILED),
+            size(0),
+            header(nullptr),
+            packages(nullptr),
+            versions(nullptr),
+            keys(nullptr),
+            strings(nullptr)
+        {
+        }
+
+        ~Mapping()
+        {
+            if (MAP_FAILED != address)
+                ::munmap(address, size);
+        }
+
+        Mapping(const Mapping &) = delete;
+        Mapping & operator= (const Mapping &) = delete;
+
+        bool open()
+        {
+            int fd(::open(stringify(location).c_str(), O_RDONLY | O_CLOEXEC));
+            if (-1 == fd)
+            {
+                Log::get_instance()->message("e.cache.binary.missing", ll_debug, lc_context)
+                    << "Couldn't open binary cache file '" << location << "': " << std::strerror(errno);
+                return false;
+            }
+
+            struct stat st;
+            if (0 != ::fstat(fd, &st) || st.st_size < static_cast<off_t>(sizeof(Header)))
+            {
+                ::close(fd);
+                return broken("file is truncated");
+            }
+
+            size = st.st_size;
+            address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+
+            if (MAP_FAILED == address)
+            {
+                Log::get_instance()->message("e.cache.binary.mmap", ll_warning, lc_context)
+                    << "Couldn't map binary cache file '" << location << "': " << std::strerror(errno);
+                return false;
+            }
+
+            const char * const base(static_cast<const char *>(address));
+            header = reinterpret_cast<const Header *>(base);
+
+            if (0 != std::memcmp(header->magic, binary_cache_magic, sizeof(binary_cache_magic)))
+                return broken("bad magic");
+
+            if (binary_cache_version != header->version)
+                return broken("unsupported version " + stringify(header->version));
+
+            if (0 != (header->packages_offset | header->versions_offset | header->keys_offset) % sizeof(uint32_t))
+                return broken("misaligned table");
+
+            if (! in_range(header->packages_offset, header->n_packages, sizeof(PackageEntry), size)
+                    || ! in_range(header->versions_offset, header->n_versions, sizeof(VersionEntry), size)
+                    || ! in_range(header->keys_offset, header->n_keys, sizeof(KeyEntry), size)
+                    || ! in_range(header->strings_offset, header->strings_size, 1, size))
+                return broken("table out of range");
+
+            packages = reinterpret_cast<const PackageEntry *>(base + header->packages_offset);
+            versions = reinterpret_cast<const VersionEntry *>(base + header->versions_offset);
+            keys = reinterpret_cast<const KeyEntry *>(base + header->keys_offset);
+            strings = base + header->strings_offset;
+
+            return true;
+        }
+
+        bool broken(const std::string & why) const
+        {
+            Log::get_instance()->message("e.cache.binary.broken", ll_warning, lc_context)
+                << "Not using binary cache file '" << location << "': " << why;
+            return false;
+        }
+
+        bool string(const StringRef & r, const char * & s) const
+        {
+            if (! in_range(r.offset, r.length, 1, header->strings_size))
+                return broken("string out of range");
+
+            s = strings + r.offset;
+            return true;
+        }
+
+        bool string(const StringRef & r, std::string & s) const
+        {
+            const char * p;
+            if (! string(r, p))
+                return false;
+
+            s.assign(p, r.length);
+            return true;
+        }
+
+        bool equal(const StringRef & r, const std::string & s) const
+        {
+            const char * p;
+            return string(r, p) && r.length == s.length() && 0 == std::memcmp(p, s.data(), s.length());
+        }
+
+        const PackageEntry * find_package(const std::string & name) const
+        {
+            const PackageEntry * const end(packages + header->n_packages);
+            const PackageEntry * p(std::lower_bound(packages, end, name,
+                        [&] (const PackageEntry & e, const std::string & n) -> bool
+                        {
+                            const char * s;
+                            if (! string(e.name, s))
+                                return false;
+                            int c(std::memcmp(s, n.data(), std::min<std::size_t>(e.name.length, n.length())));
+                            return c < 0 || (0 == c && e.name.length < n.length());
+                        }));
+
+            if (p == end || ! equal(p->name, name))
+                return nullptr;
+
+            return p;
+        }
+    };
+
+    /* Accumulates the contents of a cache file. Strings are shared, since
+     * keys and many values (licences, homepages, eclass lists) repeat. */
+    struct Writer
+    {
+        std::vector<PackageEntry> packages;
+        std::vector<VersionEntry> versions;
+        std::vector<KeyEntry> keys;
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> string_offsets;
+
+        StringRef add_string(const std::string & s)
+        {
+            if (s.length() > std::numeric_limits<uint32_t>::max())
+                throw InternalError(PALUDIS_HERE, "string too long for binary cache");
+
+            auto i(string_offsets.find(s));
+            if (string_offsets.end() == i)
+            {
+                if (strings.length() + s.length() > std::numeric_limits<uint32_t>::max())
+                    throw InternalError(PALUDIS_HERE, "too much data for binary cache");
+
+                i = string_offsets.insert(std::make_pair(s, static_cast<uint32_t>(strings.length()))).first;
+                strings.append(s);
+            }
+
+            return StringRef{ i->second, static_cast<uint32_t>(s.length()) };
+        }
+
+        void write(std::ostream & s) const
+        {
+            Header header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, binary_cache_magic, sizeof(binary_cache_magic));
+            header.version = binary_cache_version;
+            header.n_packages = packages.size();
+            header.n_versions = versions.size();
+            header.n_keys = keys.size();
+            header.packages_offset = sizeof(Header);
+            header.versions_offset = header.packages_offset + packages.size() * sizeof(PackageEntry);
+            header.keys_offset = header.versions_offset + versions.size() * sizeof(VersionEntry);
+            header.strings_offset = header.keys_offset + keys.size() * sizeof(KeyEntry);
+            header.strings_size = strings.length();
+
+            s.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            s.write(reinterpret_cast<const char *>(packages.data()), packages.size() * sizeof(PackageEntry));
+            s.write(reinterpret_cast<const char *>(versions.data()), versions.size() * sizeof(VersionEntry));
+            s.write(reinterpret_cast<const char *>(keys.data()), keys.size() * sizeof(KeyEntry));
+            s.write(strings.data(), strings.length());
+        }
+    };
+
+    typedef std::vector<std::pair<std::string, EbuildFlatMetadataCache::Entries> > PackageEntries;
+
+    std::shared_ptr<const PackageEntries> package_entries(
+            const ERepository * const repo, const QualifiedPackageName & q, const FSPath & location)
+    {
+        Context context("When generating binary cache entries for '" + stringify(q) + "':");
+
+        /* a package we can't load just goes uncached, rather than stopping
+         * every other package from being written */
+        auto result(std::make_shared<PackageEntries>());
+        try
+        {
+            auto ids(repo->package_ids(q, { }));
+            for (auto i(ids->begin()), i_end(ids->end()) ; i != i_end ; ++i)
+            {
+                auto id(std::dynamic_pointer_cast<const EbuildID>(*i));
+                if (! id)
+                    continue;
+
+                EbuildFlatMetadataCache::Entries entries;
+                if (id->metadata_cache_entries(location, entries))
+                    result->push_back(std::make_pair(stringify(id->version()), entries));
+            }
+        }
+        catch (const InternalError &)
+        {
+            throw;
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("e.cache.binary.regenerate.failure", ll_warning, lc_context)
+                << "Not writing binary cache entries for '" << q << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+            result->clear();
+        }
+
+        return result;
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<EbuildBinaryMetadataCache>
+    {
+        const FSPath location;
+
+        mutable std::mutex mutex;
+        mutable bool checked;
+        mutable std::shared_ptr<const Mapping> mapping;
+
+        Imp(const FSPath & l) :
+            location(l),
+            checked(false)
+        {
+        }
+
+        std::shared_ptr<const Mapping> get_mapping() const
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (! checked)
+            {
+                checked = true;
+                Context context("When opening binary cache file '" + stringify(location) + "':");
+                auto m(std::make_shared<Mapping>(location));
+                if (m->open())
+                    mapping = m;
+            }
+
+            return mapping;
+        }
+
+        void forget_mapping() const
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            checked = false;
+            mapping.reset();
+        }
+    };
+}
+
+EbuildBinaryMetadataCache::EbuildBinaryMetadataCache(const FSPath & l) :
+    _imp(l)
+{
+}
+
+EbuildBinaryMetadataCache::~EbuildBinaryMetadataCache()
+{
+}
+
+bool
+EbuildBinaryMetadataCache::is_binary_cache(const FSPath & f)
+{
+    std::string b(f.basename());
+    return b.length() > 9 && 0 == b.compare(b.length() - 9, 9, ".bincache");
+}
+
+const FSPath
+EbuildBinaryMetadataCache::location() const
+{
+    return _imp->location;
+}
+
+bool
+EbuildBinaryMetadataCache::find(const QualifiedPackageName & q, const std::string & version,
+        std::map<std::string, std::string> & result) const
+{
+    auto mapping(_imp->get_mapping());
+    if (! mapping)
+        return false;
+
+    Context context("When looking up '" + stringify(q) + "-" + version + "' in binary cache file '" + stringify(_imp->location) + "':");
+
+    const PackageEntry * p(mapping->find_package(stringify(q)));
+    if (! p)
+        return false;
+
+    if (! in_range(p->first_version, p->n_versions, 1, mapping->header->n_versions))
+        return mapping->broken("version range out of range");
+
+    for (const VersionEntry * v(mapping->versions + p->first_version), * v_end(v + p->n_versions) ; v != v_end ; ++v)
+    {
+        if (! mapping->equal(v->version, version))
+            continue;
+
+        if (! in_range(v->first_key, v->n_keys, 1, mapping->header->n_keys))
+            return mapping->broken("key range out of range");
+
+        for (const KeyEntry * k(mapping->keys + v->first_key), * k_end(k + v->n_keys) ; k != k_end ; ++k)
+        {
+            std::string key, value;
+            if (! mapping->string(k->key, key) || ! mapping->string(k->value, value))
+            {
+                result.clear();
+                return false;
+            }
+            result[key] = value;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void
+EbuildBinaryMetadataCache::regenerate(const ERepository * const repo) const
+{
+    Context context("When regenerating binary cache file '" + stringify(_imp->location) + "':");
+
+    std::map<std::string, std::future<std::shared_ptr<const PackageEntries> > > packages;
+    {
+        TaskScheduler scheduler;
+
+        auto cats(repo->category_names({ }));
+        for (auto c(cats->begin()), c_end(cats->end()) ; c != c_end ; ++c)
+        {
+            auto pkgs(repo->package_names(*c, { }));
+            for (auto p(pkgs->begin()), p_end(pkgs->end()) ; p != p_end ; ++p)
+                packages.insert(std::make_pair(stringify(*p), scheduler.submit(
+                                std::bind(&package_entries, repo, *p, _imp->location))));
+        }
+
+        scheduler.wait();
+    }
+
+    Writer writer;
+    for (auto p(packages.begin()), p_end(packages.end()) ; p != p_end ; ++p)
+    {
+        auto entries(p->second.get());
+        if (entries->empty())
+            continue;
+
+        writer.packages.push_back(PackageEntry{ writer.add_string(p->first),
+                static_cast<uint32_t>(writer.versions.size()), static_cast<uint32_t>(entries->size()) });
+
+        for (auto v(entries->begin()), v_end(entries->end()) ; v != v_end ; ++v)
+        {
+            writer.versions.push_back(VersionEntry{ writer.add_string(v->first),
+                    static_cast<uint32_t>(writer.keys.size()), static_cast<uint32_t>(v->second.size()) });
+
+            for (auto k(v->second.begin()), k_end(v->second.end()) ; k != k_end ; ++k)
+                writer.keys.push_back(KeyEntry{ writer.add_string(k->first), writer.add_string(k->second) });
+        }
+    }
+
+    FSPath temp(_imp->location.dirname() / ("." + _imp->location.basename() + ".new"));
+    try
+    {
+        _imp->location.dirname().mkdir(0755, { fspmkdo_ok_if_exists });
+
+        {
+            SafeOFStream file(temp, -1, true);
+            writer.write(file);
+        }
+
+        temp.rename(_imp->location);
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("e.cache.binary.save.failure", ll_warning, lc_no_context) << "Couldn't write binary cache file '"
+            << _imp->location << "': " << e.message() << " (" << e.what() << ")";
+    }
+    catch (const FSError & e)
+    {
+        Log::get_instance()->message("e.cache.binary.save.failure", ll_warning, lc_no_context) << "Couldn't write binary cache file '"
+            << _imp->location << "': " << e.message() << " (" << e.what() << ")";
+    }
+
+    _imp->forget_mapping();
+}
+
+namespace paludis
+{
+    template class Pimp<EbuildBinaryMetadataCache>;
+}
@@ -0,0 +1,109 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_EBUILD_BINARY_METADATA_CACHE_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_EBUILD_BINARY_METADATA_CACHE_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/name-fwd.hh>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    class ERepository;
+
+    namespace erepository
+    {
+        /**
+         * Implements a metadata cache for an ERepository which holds every
+         * ID in a single memory mapped file.
+         *
+         * Entries are looked up using a per-package offset table, rather
+         * than by opening and splitting a file per ID. Each entry holds the
+         * same keys as a flat_hash cache file, and is validated in the same
+         * way by EbuildFlatMetadataCache::load_keys.
+         *
+         * A cache or write_cache location whose name ends in .bincache uses
+         * this format. Such a cache is only written when the repository's
+         * cache is regenerated, for example by 'cave fix-cache'.
+         *
+         * \see ERepository
+         * \see EbuildFlatMetadataCache
+         * \ingroup grperepository
+         * \nosubgrouping
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE EbuildBinaryMetadataCache
+        {
+            private:
+                Pimp<EbuildBinaryMetadataCache> _imp;
+
+            public:
+                ///\name Basic operations
+                ///\{
+
+                explicit EbuildBinaryMetadataCache(const FSPath & location);
+                ~EbuildBinaryMetadataCache();
+
+                EbuildBinaryMetadataCache(const EbuildBinaryMetadataCache &) = delete;
+                EbuildBinaryMetadataCache & operator= (const EbuildBinaryMetadataCache &) = delete;
+
+                ///\}
+
+                /**
+                 * Should a cache location use this format?
+                 */
+                static bool is_binary_cache(const FSPath &) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Where is our cache file?
+                 */
+                const FSPath location() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                ///\name Cache operations
+                ///\{
+
+                /**
+                 * Fetch the flat_hash keys held for a given package and
+                 * version, returning false if we have none.
+                 *
+                 * The keys still need to be checked for staleness.
+                 */
+                bool find(const QualifiedPackageName &, const std::string & version,
+                        std::map<std::string, std::string> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Rewrite the cache file to hold every ID in a repository.
+                 *
+                 * Metadata is loaded in parallel, reusing any of our entries
+                 * that are still valid.
+                 */
+                void regenerate(const ERepository * const) const;
+
+                ///\}
+        };
+    }
+
+    extern template class Pimp<erepository::EbuildBinaryMetadataCache>;
+}
+
+#endif
@@ -0,0 +1,166 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/e_repository.hh>
+#include <paludis/repositories/e/ebuild_binary_metadata_cache.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/filtered_generator.hh>
+#include <paludis/generator.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/package_id.hh>
+#include <paludis/selection.hh>
+#include <paludis/user_dep_spec.hh>
+
+#include <paludis/util/map.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/stringify.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    std::string from_keys(const std::shared_ptr<const Map<std::string, std::string> > & m,
+            const std::string & k)
+    {
+        Map<std::string, std::string>::ConstIterator mm(m->find(k));
+        if (m->end() == mm)
+            return "";
+        else
+            return mm->second;
+    }
+
+    std::shared_ptr<ERepository> make_repo(TestEnvironment & env, const std::string & cache, const std::string & write_cache,
+            const bool append)
+    {
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "e");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("location", stringify(FSPath::cwd() / "ebuild_binary_metadata_cache_TEST_dir/repo"));
+        keys->insert("profiles", stringify(FSPath::cwd() / "ebuild_binary_metadata_cache_TEST_dir/repo/profiles/profile"));
+        keys->insert("eclassdirs", "ebuild_binary_metadata_cache_TEST_dir/repo/eclass");
+        keys->insert("builddir", stringify(FSPath::cwd() / "ebuild_binary_metadata_cache_TEST_dir" / "build"));
+        keys->insert("cache", cache);
+        keys->insert("write_cache", write_cache);
+        keys->insert("append_repository_name_to_write_cache", append ? "true" : "false");
+        std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                        std::bind(from_keys, keys, std::placeholders::_1))));
+        env.add_repository(1, repo);
+        return repo;
+    }
+
+    std::string description(TestEnvironment & env, const std::string & spec)
+    {
+        std::shared_ptr<const PackageID> id(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec(spec, &env, { })), nullptr, { }))]->begin());
+        if (! id->short_description_key())
+            return "(none)";
+        return id->short_description_key()->parse_value();
+    }
+
+    std::string dir(const std::string & s)
+    {
+        return stringify(FSPath::cwd() / "ebuild_binary_metadata_cache_TEST_dir" / s);
+    }
+}
+
+TEST(EbuildBinaryMetadataCache, IsBinaryCache)
+{
+    EXPECT_TRUE(EbuildBinaryMetadataCache::is_binary_cache(FSPath("/var/cache/paludis/metadata.bincache")));
+    EXPECT_FALSE(EbuildBinaryMetadataCache::is_binary_cache(FSPath("/var/cache/paludis/metadata")));
+    EXPECT_FALSE(EbuildBinaryMetadataCache::is_binary_cache(FSPath("/var/cache/paludis/.bincache")));
+    EXPECT_FALSE(EbuildBinaryMetadataCache::is_binary_cache(FSPath("/var/empty")));
+}
+
+TEST(EbuildBinaryMetadataCache, Regenerate)
+{
+    {
+        TestEnvironment env;
+        auto repo(make_repo(env, dir("repo/metadata/cache"), dir("caches/regenerate.bincache"), false));
+        ASSERT_TRUE(bool(repo->binary_metadata_write_cache()));
+        EXPECT_FALSE(bool(repo->binary_metadata_cache()));
+        EXPECT_EQ(FSPath(dir("caches/regenerate.bincache")), repo->binary_metadata_write_cache()->location());
+
+        repo->regenerate_cache();
+        EXPECT_TRUE(FSPath(dir("caches/regenerate.bincache")).stat().is_regular_file());
+    }
+
+    {
+        TestEnvironment env;
+        auto repo(make_repo(env, "/var/empty", dir("caches/regenerate.bincache"), false));
+
+        std::map<std::string, std::string> keys;
+        ASSERT_TRUE(repo->binary_metadata_write_cache()->find(QualifiedPackageName("cat/generated"), "1", keys));
+        EXPECT_EQ("The Generated Description generated", keys["DESCRIPTION"]);
+        EXPECT_EQ("cat/cached", keys["DEPEND"]);
+        EXPECT_FALSE(repo->binary_metadata_write_cache()->find(QualifiedPackageName("cat/generated"), "2", keys));
+        EXPECT_FALSE(repo->binary_metadata_write_cache()->find(QualifiedPackageName("cat/missing"), "1", keys));
+
+        EXPECT_EQ("The Cached Description cached", description(env, "=cat/cached-1"));
+        EXPECT_EQ("The Generated Description generated", description(env, "=cat/generated-1"));
+    }
+}
+
+TEST(EbuildBinaryMetadataCache, Stale)
+{
+    {
+        TestEnvironment env;
+        auto repo(make_repo(env, dir("repo/metadata/cache"), dir("caches/stale.bincache"), false));
+        repo->regenerate_cache();
+    }
+
+    FSPath(dir("repo/cat/stale/stale-1.ebuild")).utime(Timestamp(120, 0));
+
+    {
+        TestEnvironment env;
+        make_repo(env, "/var/empty", dir("caches/stale.bincache"), false);
+        EXPECT_EQ("The Cached Description cached", description(env, "=cat/cached-1"));
+        EXPECT_EQ("The Generated Description stale", description(env, "=cat/stale-1"));
+    }
+}
+
+TEST(EbuildBinaryMetadataCache, AppendRepositoryName)
+{
+    TestEnvironment env;
+    auto repo(make_repo(env, dir("repo/metadata/cache"), dir("caches/append.bincache"), true));
+    ASSERT_TRUE(bool(repo->binary_metadata_write_cache()));
+    EXPECT_EQ(FSPath(dir("caches/append.bincache/test-repo")), repo->binary_metadata_write_cache()->location());
+
+    repo->regenerate_cache();
+    EXPECT_TRUE(FSPath(dir("caches/append.bincache/test-repo")).stat().is_regular_file());
+}
+
+TEST(EbuildBinaryMetadataCache, Broken)
+{
+    TestEnvironment env;
+    auto repo(make_repo(env, dir("broken.bincache"), "/var/empty", false));
+    ASSERT_TRUE(bool(repo->binary_metadata_cache()));
+
+    std::map<std::string, std::string> keys;
+    EXPECT_FALSE(repo->binary_metadata_cache()->find(QualifiedPackageName("cat/cached"), "1", keys));
+    EXPECT_EQ("The Generated Description cached", description(env, "=cat/cached-1"));
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir ebuild_binary_metadata_cache_TEST_dir || exit 1
+cd ebuild_binary_metadata_cache_TEST_dir || exit 1
+
+mkdir build caches || exit 1
+echo "not a binary cache" > broken.bincache || exit 1
+
+mkdir -p repo/{eclass,distfiles,profiles/profile} || exit 1
+mkdir -p repo/{cat,metadata/cache/cat} || exit 1
+cd repo || exit 1
+echo "test-repo" > profiles/repo_name || exit 1
+cat <<END > profiles/categories || exit 1
+cat
+END
+cat <<END > profiles/profile/make.defaults
+ARCH=test
+END
+
+for p in cached stale ; do
+    mkdir cat/${p}
+    cat <<END > cat/${p}/${p}-1.ebuild || exit 1
+DESCRIPTION="The Generated Description ${p}"
+HOMEPAGE="http://example.com/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND=""
+END
+    cat <<END > metadata/cache/cat/${p}-1 || exit 1
+_mtime_=60
+_guessed_eapi_=0
+DEPEND=the/depend
+RDEPEND=the/rdepend
+SLOT=the-slot
+HOMEPAGE=the-homepage
+LICENSE=the-license
+DESCRIPTION=The Cached Description ${p}
+KEYWORDS=the-keywords
+EAPI=0
+END
+    TZ=UTC touch -t 197001010001 cat/${p}/${p}-1.ebuild || exit 2
+done
+
+mkdir cat/generated
+cat <<END > cat/generated/generated-1.ebuild || exit 1
+DESCRIPTION="The Generated Description generated"
+HOMEPAGE="http://example.com/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND="cat/cached"
+END
+
+cd ..
@@ -302,67 +302,11 @@ namespace
         Log::get_instance()->message("e.cache.success", ll_debug, lc_context) << "Successfully loaded cache file";
         return true;
     }
-}
-
-EbuildFlatMetadataCache::EbuildFlatMetadataCache(const Environment * const v, const FSPath & f,
-        const FSPath & e, std::time_t t, const std::shared_ptr<const EclassMtimes> & m, bool s) :
-    _imp(v, f, e, t, m, s)
-{
-}
-
-EbuildFlatMetadataCache::~EbuildFlatMetadataCache()
-{
-}
-
-bool
-EbuildFlatMetadataCache::load(const std::shared_ptr<const EbuildID> & id, const bool silent_on_stale)
-{
-    using namespace std::placeholders;
-
-    Context context("When loading version metadata from '" + stringify(_imp->filename) + "':");
-
-    if (! _imp->filename_stat.exists())
-    {
-        Log::get_instance()->message("e.cache.failure", _imp->silent ? ll_debug : ll_warning, lc_no_context)
-                << "Couldn't use the cache file at '" << _imp->filename << "': " << std::strerror(errno);
-        return false;
-    }
-
-    SafeIFStream cache(_imp->filename);
-
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(cache, line))
-        lines.push_back(line);
 
-    try
+    bool load_flat_hash(
+        const std::shared_ptr<const EbuildID> & id, std::map<std::string, std::string> & keys, const bool silent_on_stale,
+        Imp<EbuildFlatMetadataCache> * _imp)
     {
-        std::map<std::string, std::string> keys;
-        std::string duplicate;
-        for (std::vector<std::string>::const_iterator it(lines.begin()),
-                 it_end(lines.end()); it_end != it; ++it)
-        {
-            std::string::size_type equals(it->find('='));
-            if (std::string::npos == equals)
-            {
-                Log::get_instance()->message("e.cache.flat_hash.not", ll_debug, lc_context)
-                    << "cache file lacks = on line " << ((it - lines.begin()) + 1) << ", assuming flat_list";
-                return load_flat_list(id, lines, _imp.get());
-            }
-
-            if (! keys.insert(std::make_pair(it->substr(0, equals), it->substr(equals + 1))).second)
-                duplicate = it->substr(0, equals);
-        }
-
-        Context ctx("When loading flat_hash format cache file:");
-
-        if (! duplicate.empty())
-        {
-            Log::get_instance()->message("e.cache.flat_hash.broken", ll_warning, lc_context)
-                << "cache file contains duplicate key '" << duplicate << "'";
-            return false;
-        }
-
         std::map<std::string, std::string>::const_iterator eapi(keys.find("EAPI"));
         if (keys.end() == eapi)
             id->set_eapi("0");
@@ -685,25 +629,117 @@ EbuildFlatMetadataCache::load(const std::shared_ptr<const EbuildID> & id, const
         Log::get_instance()->message("e.cache.success", ll_debug, lc_context) << "Successfully loaded cache file";
         return true;
     }
-    catch (const InternalError &)
+
+    bool cache_load_failed(const std::shared_ptr<const EbuildID> & id, Imp<EbuildFlatMetadataCache> * _imp)
     {
-        throw;
+        try
+        {
+            throw;
+        }
+        catch (const InternalError &)
+        {
+            throw;
+        }
+        catch (const DestringifyError & e)
+        {
+            Log::get_instance()->message("e.cache.failure", ll_warning, lc_no_context) << "Not using cache file at '"
+                << _imp->filename << "' due to destringify exception '" << e.message() << "' (" << e.what() << ")";
+
+            return false;
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("e.cache.failure", ll_warning, lc_no_context) << "Not using cache file at '"
+                << _imp->filename << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+
+            id->set_eapi(EAPIData::get_instance()->unknown_eapi()->name());
+
+            return true;
+        }
     }
-    catch (const DestringifyError & e)
-    {
-        Log::get_instance()->message("e.cache.failure", ll_warning, lc_no_context) << "Not using cache file at '"
-            << _imp->filename << "' due to destringify exception '" << e.message() << "' (" << e.what() << ")";
+}
+
+EbuildFlatMetadataCache::EbuildFlatMetadataCache(const Environment * const v, const FSPath & f,
+        const FSPath & e, std::time_t t, const std::shared_ptr<const EclassMtimes> & m, bool s) :
+    _imp(v, f, e, t, m, s)
+{
+}
 
+EbuildFlatMetadataCache::~EbuildFlatMetadataCache()
+{
+}
+
+bool
+EbuildFlatMetadataCache::load(const std::shared_ptr<const EbuildID> & id, const bool silent_on_stale)
+{
+    using namespace std::placeholders;
+
+    Context context("When loading version metadata from '", _imp->filename, "':");
+
+    if (! _imp->filename_stat.exists())
+    {
+        Log::get_instance()->message("e.cache.failure", _imp->silent ? ll_debug : ll_warning, lc_no_context)
+                << "Couldn't use the cache file at '" << _imp->filename << "': " << std::strerror(errno);
         return false;
     }
-    catch (const Exception & e)
+
+    SafeIFStream cache(_imp->filename);
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(cache, line))
+        lines.push_back(line);
+
+    try
     {
-        Log::get_instance()->message("e.cache.failure", ll_warning, lc_no_context) << "Not using cache file at '"
-            << _imp->filename << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+        std::map<std::string, std::string> keys;
+        std::string duplicate;
+        for (std::vector<std::string>::const_iterator it(lines.begin()),
+                 it_end(lines.end()); it_end != it; ++it)
+        {
+            std::string::size_type equals(it->find('='));
+            if (std::string::npos == equals)
+            {
+                Log::get_instance()->message("e.cache.flat_hash.not", ll_debug, lc_context)
+                    << "cache file lacks = on line " << ((it - lines.begin()) + 1) << ", assuming flat_list";
+                return load_flat_list(id, lines, _imp.get());
+            }
 
-        id->set_eapi(EAPIData::get_instance()->unknown_eapi()->name());
+            if (! keys.insert(std::make_pair(it->substr(0, equals), it->substr(equals + 1))).second)
+                duplicate = it->substr(0, equals);
+        }
 
-        return true;
+        Context ctx("When loading flat_hash format cache file:");
+
+        if (! duplicate.empty())
+        {
+            Log::get_instance()->message("e.cache.flat_hash.broken", ll_warning, lc_context)
+                << "cache file contains duplicate key '" << duplicate << "'";
+            return false;
+        }
+
+        return load_flat_hash(id, keys, silent_on_stale, _imp.get());
+    }
+    catch (...)
+    {
+        return cache_load_failed(id, _imp.get());
+    }
+}
+
+bool
+EbuildFlatMetadataCache::load_keys(const std::shared_ptr<const EbuildID> & id, std::map<std::string, std::string> & keys,
+        const bool silent_on_stale)
+{
+    Context context("When loading version metadata from '", _imp->filename, "':");
+
+    try
+    {
+        Context ctx("When loading flat_hash format cache entry:");
+        return load_flat_hash(id, keys, silent_on_stale, _imp.get());
+    }
+    catch (...)
+    {
+        return cache_load_failed(id, _imp.get());
     }
 }
 
@@ -727,54 +763,24 @@ namespace
     }
 
     template <typename T_>
-    void write_kv(std::ostream & stream, const std::string & key, const T_ & value)
+    void write_kv(EbuildFlatMetadataCache::Entries & entries, const std::string & key, const T_ & value)
     {
         std::string str_value(stringify(value));
         if (! str_value.empty())
-            stream << key << "=" << str_value << std::endl;
+            entries.push_back(std::make_pair(key, str_value));
     }
 }
 
-void
-EbuildFlatMetadataCache::save(const std::shared_ptr<const EbuildID> & id)
+bool
+EbuildFlatMetadataCache::entries(const std::shared_ptr<const EbuildID> & id, Entries & cache)
 {
-    Context context("When saving version metadata to '" + stringify(_imp->filename) + "':");
-
-    try
-    {
-        FSPath cat_dir(_imp->filename.dirname());
-        FSPath repo_dir(cat_dir.dirname());
-        FSPath main_dir(repo_dir.dirname());
-        FSStat main_dir_stat(main_dir);
-
-        if (! main_dir_stat.exists())
-        {
-            Log::get_instance()->message("e.cache.save.no_dir", ll_warning, lc_no_context) << "Directory '"
-                << main_dir << "' does not exist, so cannot save cache file '" << _imp->filename << "' "
-                << "(see the faq for why this directory will not be created automatically)";
-            return;
-        }
-
-        if (repo_dir.mkdir(main_dir_stat.permissions(), { fspmkdo_ok_if_exists }))
-            repo_dir.chmod(main_dir_stat.permissions());
-
-        if (cat_dir.mkdir(main_dir_stat.permissions(), { fspmkdo_ok_if_exists }))
-            cat_dir.chmod(main_dir_stat.permissions());
-    }
-    catch (const FSError & e)
-    {
-        Log::get_instance()->message("e.cache.save.failure", ll_warning, lc_no_context) << "Couldn't create cache directory: " << e.message();
-        return;
-    }
-
     if (! id->eapi()->supported())
     {
         Log::get_instance()->message("e.cache.save.eapi_unsupoprted", ll_warning, lc_no_context) << "Not writing cache file to '"
             << _imp->filename << "' because EAPI '" << id->eapi()->name() << "' is not supported";
-        return;
+        return false;
     }
 
-    std::ostringstream cache;
     write_kv(cache, "_mtime_", _imp->ebuild_stat.mtim().seconds());
     write_kv(cache, "_guessed_eapi_", id->guessed_eapi_name());
 
@@ -929,7 +935,6 @@ EbuildFlatMetadataCache::save(const std::shared_ptr<const EbuildID> & id)
 
         if (! m.scm_revision()->name().empty() && id->scm_revision_key())
             write_kv(cache, m.scm_revision()->name(), id->scm_revision_key()->parse_value());
-
     }
     catch (const InternalError &)
     {
@@ -939,14 +944,57 @@ EbuildFlatMetadataCache::save(const std::shared_ptr<const EbuildID> & id)
     {
         Log::get_instance()->message("e.cache.save.failure", ll_warning, lc_no_context) << "Not writing cache file to '"
             << _imp->filename << "' due to exception '" << e.message() << "' (" << e.what() << ")";
+        return false;
+    }
+
+    return true;
+}
+
+void
+EbuildFlatMetadataCache::save(const std::shared_ptr<const EbuildID> & id)
+{
+    Context context("When saving version metadata to '", _imp->filename, "':");
+
+    try
+    {
+        FSPath cat_dir(_imp->filename.dirname());
+        FSPath repo_dir(cat_dir.dirname());
+        FSPath main_dir(repo_dir.dirname());
+        FSStat main_dir_stat(main_dir);
+
+        if (! main_dir_stat.exists())
+        {
+            Log::get_instance()->message("e.cache.save.no_dir", ll_warning, lc_no_context) << "Directory '"
+                << main_dir << "' does not exist, so cannot save cache file '" << _imp->filename << "' "
+                << "(see the faq for why this directory will not be created automatically)";
+            return;
+        }
+
+        if (repo_dir.mkdir(main_dir_stat.permissions(), { fspmkdo_ok_if_exists }))
+            repo_dir.chmod(main_dir_stat.permissions());
+
+        if (cat_dir.mkdir(main_dir_stat.permissions(), { fspmkdo_ok_if_exists }))
+            cat_dir.chmod(main_dir_stat.permissions());
+    }
+    catch (const FSError & e)
+    {
+        Log::get_instance()->message("e.cache.save.failure", ll_warning, lc_no_context) << "Couldn't create cache directory: " << e.message();
         return;
     }
 
+    Entries cache;
+    if (! entries(id, cache))
+        return;
+
     try
     {
         {
+            std::ostringstream text;
+            for (auto it(cache.begin()), it_end(cache.end()) ; it != it_end ; ++it)
+                text << it->first << "=" << it->second << std::endl;
+
             SafeOFStream cache_file(_imp->filename, -1, true);
-            cache_file << cache.str();
+            cache_file << text.str();
         }
         _imp->filename.utime(Timestamp(_imp->ebuild_stat.mtim().seconds(), 0));
     }
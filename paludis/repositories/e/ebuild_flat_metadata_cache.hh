@@ -24,6 +24,10 @@
 #include <paludis/repositories/e/ebuild_id.hh>
 #include <paludis/repositories/e/eclass_mtimes.hh>
 #include <paludis/util/pimp.hh>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace paludis
 {
@@ -44,6 +48,14 @@ namespace paludis
                 Pimp<EbuildFlatMetadataCache> _imp;
 
             public:
+                /**
+                 * The key and value pairs making up a flat_hash cache entry,
+                 * in the order they are written.
+                 *
+                 * \since 2.4
+                 */
+                typedef std::vector<std::pair<std::string, std::string> > Entries;
+
                 ///\name Basic operations
                 ///\{
 
@@ -59,6 +71,23 @@ namespace paludis
                 bool load(const std::shared_ptr<const EbuildID> &, const bool silent_on_stale);
                 void save(const std::shared_ptr<const EbuildID> &);
 
+                /**
+                 * Load from flat_hash keys which have already been read, for
+                 * example from an EbuildBinaryMetadataCache.
+                 *
+                 * \since 2.4
+                 */
+                bool load_keys(const std::shared_ptr<const EbuildID> &, std::map<std::string, std::string> &,
+                        const bool silent_on_stale);
+
+                /**
+                 * Fetch the flat_hash keys that save() would write, returning
+                 * false if no entry should be written.
+                 *
+                 * \since 2.4
+                 */
+                bool entries(const std::shared_ptr<const EbuildID> &, Entries &);
+
                 ///\}
         };
     }
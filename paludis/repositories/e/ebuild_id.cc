@@ -19,6 +19,7 @@
 
 #include <paludis/repositories/e/ebuild_id.hh>
 #include <paludis/repositories/e/ebuild_flat_metadata_cache.hh>
+#include <paludis/repositories/e/ebuild_binary_metadata_cache.hh>
 #include <paludis/repositories/e/e_repository.hh>
 #include <paludis/repositories/e/e_repository_params.hh>
 #include <paludis/repositories/e/eapi_phase.hh>
@@ -71,6 +72,7 @@
 #include <paludis/util/strip.hh>
 
 #include <set>
+#include <map>
 #include <iterator>
 #include <algorithm>
 #include <ctime>
@@ -235,7 +237,7 @@ EbuildID::need_non_xml_keys_added() const
 
     _imp->has_non_xml_keys = true;
 
-    Context context("When generating metadata for ID '" + canonical_form(idcf_full) + "':");
+    Context context("When generating metadata for ID '", *this, "':");
 
     add_metadata_key(_imp->fs_location);
 
@@ -251,15 +253,41 @@ EbuildID::need_non_xml_keys_added() const
     write_cache_file /= stringify(name().category());
     write_cache_file /= stringify(name().package()) + "-" + stringify(version());
 
+    auto binary_cache(e_repo->binary_metadata_cache());
+    auto binary_write_cache(e_repo->binary_metadata_write_cache());
+
     bool ok(false);
-    if (e_repo->params().cache().basename() != "empty")
+    if (binary_cache)
+    {
+        std::map<std::string, std::string> keys;
+        if (binary_cache->find(name(), stringify(version()), keys))
+        {
+            EbuildFlatMetadataCache metadata_cache(_imp->environment, binary_cache->location(), _imp->fs_location->parse_value(),
+                    _imp->master_mtime, _imp->eclass_mtimes, false);
+            if (metadata_cache.load_keys(shared_from_this(), keys, false))
+                ok = true;
+        }
+    }
+    else if (e_repo->params().cache().basename() != "empty")
     {
         EbuildFlatMetadataCache metadata_cache(_imp->environment, cache_file, _imp->fs_location->parse_value(), _imp->master_mtime, _imp->eclass_mtimes, false);
         if (metadata_cache.load(shared_from_this(), false))
             ok = true;
     }
 
-    if ((! ok) && e_repo->params().write_cache().basename() != "empty")
+    if ((! ok) && binary_write_cache)
+    {
+        /* binary caches are only written in one go, by regenerate_cache */
+        std::map<std::string, std::string> keys;
+        if (binary_write_cache->find(name(), stringify(version()), keys))
+        {
+            EbuildFlatMetadataCache write_metadata_cache(_imp->environment, binary_write_cache->location(), _imp->fs_location->parse_value(),
+                    _imp->master_mtime, _imp->eclass_mtimes, true);
+            if (write_metadata_cache.load_keys(shared_from_this(), keys, true))
+                ok = true;
+        }
+    }
+    else if ((! ok) && e_repo->params().write_cache().basename() != "empty")
     {
         EbuildFlatMetadataCache write_metadata_cache(_imp->environment,
                 write_cache_file, _imp->fs_location->parse_value(), _imp->master_mtime, _imp->eclass_mtimes, true);
@@ -336,7 +364,7 @@ EbuildID::need_non_xml_keys_added() const
             Log::get_instance()->message("e.ebuild.metadata.generated_eapi", ll_debug, lc_context) << "Generated metadata for '"
                 << canonical_form(idcf_full) << "' has EAPI '" << _imp->eapi->name() << "'";
 
-            if (e_repo->params().write_cache().basename() != "empty" && _imp->eapi->supported())
+            if (e_repo->params().write_cache().basename() != "empty" && (! binary_write_cache) && _imp->eapi->supported())
             {
                 EbuildFlatMetadataCache metadata_cache(_imp->environment, write_cache_file, _imp->fs_location->parse_value(), _imp->master_mtime,
                         _imp->eclass_mtimes, false);
@@ -505,7 +533,7 @@ EbuildID::need_xml_keys_added() const
 
     _imp->has_xml_keys = true;
 
-    Context context("When generating XML-related metadata for ID '" + canonical_form(idcf_full) + "':");
+    Context context("When generating XML-related metadata for ID '", *this, "':");
 
     need_non_xml_keys_added();
 
@@ -625,7 +653,7 @@ EbuildID::need_masks_added() const
 
     _imp->has_masks = true;
 
-    Context context("When generating masks for ID '" + canonical_form(idcf_full) + "':");
+    Context context("When generating masks for ID '", *this, "':");
 
     if (! eapi()->supported())
     {
@@ -1706,6 +1734,16 @@ EbuildID::purge_invalid_cache() const
     }
 }
 
+bool
+EbuildID::metadata_cache_entries(const FSPath & cache_file, EbuildFlatMetadataCache::Entries & entries) const
+{
+    need_non_xml_keys_added();
+
+    EbuildFlatMetadataCache metadata_cache(_imp->environment, cache_file, _imp->fs_location->parse_value(), _imp->master_mtime,
+            _imp->eclass_mtimes, true);
+    return metadata_cache.entries(shared_from_this(), entries);
+}
+
 bool
 EbuildID::might_be_binary() const
 {
@@ -25,6 +25,9 @@
 #include <paludis/repositories/e/eapi-fwd.hh>
 #include <paludis/repositories/e/e_repository_id.hh>
 #include <paludis/util/exception.hh>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace paludis
 {
@@ -168,6 +171,15 @@ namespace paludis
 
                 virtual void purge_invalid_cache() const;
 
+                /**
+                 * Fetch the flat_hash keys to store for us in a metadata
+                 * cache file, returning false if we should not be cached.
+                 *
+                 * \since 2.4
+                 */
+                bool metadata_cache_entries(const FSPath & cache_file,
+                        std::vector<std::pair<std::string, std::string> > &) const;
+
                 bool might_be_binary() const;
                 bool is_stable() const;
 
@@ -0,0 +1,396 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/ebuild_metadata_workers.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/make_named_values.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    struct Job
+    {
+        std::string script;
+        ProcessPipeCommandFunction pipe_command_handler;
+        std::shared_ptr<EbuildMetadataWorkerResult> result;
+        bool done;
+    };
+
+    struct Worker
+    {
+        const std::string key;
+        const std::map<std::string, std::string> initial_setenvs;
+
+        std::stringstream output;
+        std::unique_ptr<Process> process;
+        std::unique_ptr<RunningProcessHandle> handle;
+        std::thread monitor;
+
+        std::condition_variable job_condition;
+        Job * job;
+        bool busy;
+        bool finished_a_job;
+
+        Worker(const std::string & k, const std::map<std::string, std::string> & s) :
+            key(k),
+            initial_setenvs(s),
+            job(nullptr),
+            busy(true),
+            finished_a_job(false)
+        {
+        }
+    };
+
+    std::string quote(const std::string & s)
+    {
+        std::string result("'");
+        for (auto c : s)
+            if ('\'' == c)
+                result.append("'\\''");
+            else
+                result.append(1, c);
+        result.append("'");
+        return result;
+    }
+
+    std::string make_script(const Worker & worker, const Process & process,
+            const std::string & ebuild_file, const std::string & commands)
+    {
+        std::string result;
+
+        for (auto & v : worker.initial_setenvs)
+            if (process.setenvs().end() == process.setenvs().find(v.first))
+                result.append("unset " + v.first + "\n");
+
+        for (auto & v : process.setenvs())
+        {
+            auto i(worker.initial_setenvs.find(v.first));
+            if (worker.initial_setenvs.end() == i || i->second != v.second)
+                result.append("export " + v.first + "=" + quote(v.second) + "\n");
+        }
+
+        result.append("PALUDIS_EBUILD_WORKER_EBUILD=" + quote(ebuild_file) + "\n");
+        result.append("PALUDIS_EBUILD_WORKER_COMMANDS=" + quote(commands) + "\n");
+
+        return result;
+    }
+
+    std::vector<std::string> split_command(const std::string & s)
+    {
+        std::vector<std::string> tokens;
+        std::string::size_type p(0), q(s.find('\2'));
+        while (std::string::npos != q)
+        {
+            tokens.push_back(s.substr(p, q - p));
+            p = q + 1;
+            q = s.find('\2', p);
+        }
+        return tokens;
+    }
+
+    std::string read_file(const FSPath & f)
+    {
+        SafeIFStream s(f);
+        return std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<EbuildMetadataWorkers>
+    {
+        std::atomic<unsigned> max_workers_per_key;
+
+        std::mutex mutex;
+        std::condition_variable job_done_condition;
+        std::condition_variable worker_idle_condition;
+        std::map<std::string, std::list<std::shared_ptr<Worker> > > workers;
+        std::list<std::shared_ptr<Worker> > all_workers;
+        std::set<std::string> broken_keys;
+        bool stopping;
+
+        Imp() :
+            max_workers_per_key(0),
+            stopping(false)
+        {
+            std::string s(getenv_with_default(env_vars::metadata_workers, ""));
+            if (! s.empty())
+            {
+                try
+                {
+                    max_workers_per_key = destringify<unsigned>(s);
+                }
+                catch (const DestringifyError &)
+                {
+                    Log::get_instance()->message("e.ebuild.metadata_workers.bad", ll_warning, lc_no_context)
+                        << "Ignoring bad value '" << s << "' for " << env_vars::metadata_workers;
+                }
+            }
+        }
+
+        std::string handle_command(Worker * const worker, const std::string & s)
+        {
+            std::vector<std::string> tokens(split_command(s));
+
+            if ((! tokens.empty()) && "WORKER_NEXT_JOB" == tokens[0])
+            {
+                if (tokens.size() != 4)
+                    return "Ebad WORKER_NEXT_JOB command";
+
+                std::shared_ptr<EbuildMetadataWorkerResult> result;
+                if (! tokens[2].empty())
+                {
+                    FSPath dir(tokens[3]);
+                    result = std::make_shared<EbuildMetadataWorkerResult>(make_named_values<EbuildMetadataWorkerResult>(
+                                n::captured_stderr() = "",
+                                n::captured_stdout() = "",
+                                n::exit_status() = -1,
+                                n::metadata() = ""
+                                ));
+
+                    try
+                    {
+                        result->exit_status() = destringify<int>(tokens[2]);
+                        result->metadata() = read_file(dir / "metadata");
+                        result->captured_stdout() = read_file(dir / "stdout");
+                        result->captured_stderr() = read_file(dir / "stderr");
+                    }
+                    catch (const Exception & e)
+                    {
+                        result->exit_status() = -1;
+                        result->captured_stderr() += "Could not read worker output: " + e.message() + " (" + e.what() + ")";
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (result && worker->job)
+                {
+                    worker->job->result = result;
+                    worker->job->done = true;
+                    worker->job = nullptr;
+                    worker->finished_a_job = true;
+                    job_done_condition.notify_all();
+                }
+
+                if (! worker->job)
+                {
+                    worker->busy = false;
+                    worker_idle_condition.notify_all();
+                }
+
+                worker->job_condition.wait(lock, [&] () { return worker->job || stopping; });
+                if (! worker->job)
+                    return "O";
+                return "O" + worker->job->script;
+            }
+
+            Job * job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job = worker->job;
+            }
+
+            if (job)
+                return job->pipe_command_handler(s);
+            else if (tokens.size() == 3 && "PING" == tokens[0])
+                return "OPONG " + tokens[2];
+            else
+                return "Eno metadata job is running";
+        }
+
+        void monitor(const std::shared_ptr<Worker> & worker)
+        {
+            int exit_status(-1);
+            try
+            {
+                exit_status = worker->handle->wait();
+            }
+            catch (const Exception &)
+            {
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            workers[worker->key].remove(worker);
+
+            if (! stopping)
+            {
+                Log::get_instance()->message("e.ebuild.metadata_workers.died", ll_warning, lc_no_context)
+                    << "Metadata worker exited with status " << exit_status << ", output was '" << worker->output.str() << "'";
+
+                if (! worker->finished_a_job)
+                    broken_keys.insert(worker->key);
+            }
+
+            if (worker->job)
+            {
+                worker->job->done = true;
+                worker->job = nullptr;
+            }
+
+            job_done_condition.notify_all();
+            worker_idle_condition.notify_all();
+        }
+
+        bool start(const std::shared_ptr<Worker> & worker, const std::function<std::unique_ptr<Process> ()> & make_process)
+        {
+            using namespace std::placeholders;
+
+            try
+            {
+                worker->process = make_process();
+                (*worker->process)
+                    .setenv("PALUDIS_EBUILD_WORKER", "yes")
+                    .pipe_command_handler("PALUDIS_PIPE_COMMAND", std::bind(&Imp::handle_command, this, worker.get(), _1))
+                    .capture_stdout(worker->output)
+                    .capture_stderr(worker->output);
+
+                worker->handle.reset(new RunningProcessHandle(worker->process->run()));
+                worker->monitor = std::thread(&Imp::monitor, this, worker);
+                return true;
+            }
+            catch (const Exception & e)
+            {
+                Log::get_instance()->message("e.ebuild.metadata_workers.start_failed", ll_warning, lc_context)
+                    << "Could not start a metadata worker: '" << e.message() << "' (" << e.what() << ")";
+
+                std::unique_lock<std::mutex> lock(mutex);
+                workers[worker->key].remove(worker);
+                broken_keys.insert(worker->key);
+                worker->job = nullptr;
+                worker_idle_condition.notify_all();
+                return false;
+            }
+        }
+    };
+}
+
+EbuildMetadataWorkers::EbuildMetadataWorkers() :
+    _imp()
+{
+}
+
+EbuildMetadataWorkers::~EbuildMetadataWorkers()
+{
+    std::list<std::shared_ptr<Worker> > all_workers;
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        _imp->stopping = true;
+        for (auto & w : _imp->all_workers)
+            w->job_condition.notify_all();
+        std::swap(all_workers, _imp->all_workers);
+    }
+
+    for (auto & w : all_workers)
+        if (w->monitor.joinable())
+            w->monitor.join();
+}
+
+bool
+EbuildMetadataWorkers::enabled() const
+{
+    return 0 != _imp->max_workers_per_key;
+}
+
+void
+EbuildMetadataWorkers::set_max_workers_per_key(const unsigned n)
+{
+    _imp->max_workers_per_key = n;
+}
+
+const std::shared_ptr<const EbuildMetadataWorkerResult>
+EbuildMetadataWorkers::run(
+        const std::string & key,
+        const Process & process,
+        const std::function<std::unique_ptr<Process> ()> & make_process,
+        const ProcessPipeCommandFunction & handler,
+        const std::string & ebuild_file,
+        const std::string & commands)
+{
+    Job job{ "", handler, nullptr, false };
+    std::shared_ptr<Worker> new_worker;
+
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        auto & workers(_imp->workers[key]);
+
+        while (true)
+        {
+            if (_imp->stopping || _imp->broken_keys.end() != _imp->broken_keys.find(key))
+                return nullptr;
+
+            auto w(std::find_if(workers.begin(), workers.end(), [] (const std::shared_ptr<Worker> & x) { return ! x->busy; }));
+            if (workers.end() != w)
+            {
+                (*w)->busy = true;
+                job.script = make_script(**w, process, ebuild_file, commands);
+                (*w)->job = &job;
+                (*w)->job_condition.notify_all();
+                break;
+            }
+            else if (workers.size() < _imp->max_workers_per_key)
+            {
+                new_worker = std::make_shared<Worker>(key, process.setenvs());
+                job.script = make_script(*new_worker, process, ebuild_file, commands);
+                new_worker->job = &job;
+                workers.push_back(new_worker);
+                _imp->all_workers.push_back(new_worker);
+                break;
+            }
+            else
+                _imp->worker_idle_condition.wait(lock);
+        }
+    }
+
+    if (new_worker && ! _imp->start(new_worker, make_process))
+        return nullptr;
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->job_done_condition.wait(lock, [&] () { return job.done; });
+    return job.result;
+}
+
+namespace paludis
+{
+    template class Pimp<EbuildMetadataWorkers>;
+    template class Singleton<EbuildMetadataWorkers>;
+}
@@ -0,0 +1,132 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_EBUILD_METADATA_WORKERS_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_EBUILD_METADATA_WORKERS_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/singleton.hh>
+#include <paludis/util/named_value.hh>
+#include <paludis/util/process.hh>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    namespace n
+    {
+        typedef Name<struct name_captured_stderr> captured_stderr;
+        typedef Name<struct name_captured_stdout> captured_stdout;
+        typedef Name<struct name_exit_status> exit_status;
+        typedef Name<struct name_metadata> metadata;
+    }
+
+    namespace erepository
+    {
+        /**
+         * The result of generating metadata using an EbuildMetadataWorkers
+         * worker.
+         *
+         * \see EbuildMetadataWorkers
+         * \ingroup grperepository
+         * \nosubgrouping
+         * \since 2.4
+         */
+        struct EbuildMetadataWorkerResult
+        {
+            NamedValue<n::captured_stderr, std::string> captured_stderr;
+            NamedValue<n::captured_stdout, std::string> captured_stdout;
+            NamedValue<n::exit_status, int> exit_status;
+            NamedValue<n::metadata, std::string> metadata;
+        };
+
+        /**
+         * Generates metadata using long-lived ebuild.bash processes.
+         *
+         * Normally every metadata generation starts a new ebuild.bash, which
+         * then has to load all of its modules again. If PALUDIS_METADATA_WORKERS
+         * is set to a number, up to that many workers are kept for each EAPI.
+         * Each worker loads its modules once, and then forks a child for
+         * every ebuild it is given. Children talk to us using the usual pipe
+         * commands.
+         *
+         * A worker is started from a new Process set up in the same way as
+         * that of the first metadata command that needs it, and later
+         * commands only send the variables that differ from that Process.
+         *
+         * \see EbuildMetadataCommand
+         * \ingroup grperepository
+         * \nosubgrouping
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE EbuildMetadataWorkers :
+            public Singleton<EbuildMetadataWorkers>
+        {
+            friend class Singleton<EbuildMetadataWorkers>;
+
+            private:
+                Pimp<EbuildMetadataWorkers> _imp;
+
+                EbuildMetadataWorkers();
+                ~EbuildMetadataWorkers();
+
+            public:
+                /**
+                 * Are workers enabled at all?
+                 */
+                bool enabled() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Use up to this many workers for each key, overriding
+                 * PALUDIS_METADATA_WORKERS. Zero disables workers.
+                 *
+                 * Only affects workers started after this call.
+                 */
+                void set_max_workers_per_key(const unsigned);
+
+                /**
+                 * Generate metadata using a worker.
+                 *
+                 * The key must differ whenever anything which ebuild.bash
+                 * uses before it runs any phases differs, for example the
+                 * EAPI. The Process must be set up as for a normal metadata
+                 * run, and is never run by us. If a new worker is needed, it
+                 * is started from a Process made by the function, which must
+                 * be set up in the same way. The pipe command handler is used
+                 * for pipe commands from the child handling this ebuild.
+                 *
+                 * Returns a null pointer if no worker could be used, in which
+                 * case the caller should run the Process itself.
+                 */
+                const std::shared_ptr<const EbuildMetadataWorkerResult> run(
+                        const std::string & key,
+                        const Process &,
+                        const std::function<std::unique_ptr<Process> ()> &,
+                        const ProcessPipeCommandFunction &,
+                        const std::string & ebuild_file,
+                        const std::string & commands) PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+    }
+
+    extern template class Singleton<erepository::EbuildMetadataWorkers>;
+}
+
+#endif
@@ -20,10 +20,10 @@
 #include <paludis/repositories/e/exheres_mask_store.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/dep_parser.hh>
+#include <paludis/repositories/e/mask_spec_index.hh>
 
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/exception.hh>
-#include <paludis/util/hashes.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/safe_ifstream.hh>
@@ -32,21 +32,14 @@
 
 #include <paludis/dep_spec.hh>
 #include <paludis/package_id.hh>
-#include <paludis/match_package.hh>
 #include <paludis/dep_spec_flattener.hh>
 #include <paludis/dep_spec_annotations.hh>
 
 #include <algorithm>
-#include <unordered_map>
-#include <list>
 
 using namespace paludis;
 using namespace paludis::erepository;
 
-typedef std::unordered_map<QualifiedPackageName,
-        std::list<std::pair<PackageDepSpec, std::shared_ptr<const MaskInfo> > >,
-        Hash<QualifiedPackageName> > RepositoryMaskMap;
-
 namespace paludis
 {
     template <>
@@ -57,7 +50,7 @@ namespace paludis
         const std::shared_ptr<const FSPathSequence> files;
         EAPIForFileFunction eapi_for_file;
 
-        RepositoryMaskMap repo_mask;
+        MaskSpecIndex repo_mask;
 
         Imp(const Environment * const e, const RepositoryName & r, const std::shared_ptr<const FSPathSequence> & f, const EAPIForFileFunction & n) :
             env(e),
@@ -163,7 +156,7 @@ ExheresMaskStore::_populate()
                     s != s_end ; ++s)
             {
                 if ((*s)->package_ptr())
-                    _imp->repo_mask[*(*s)->package_ptr()].push_back(std::make_pair(**s, make_mask_info(**s, *f)));
+                    _imp->repo_mask.add(**s, make_mask_info(**s, *f));
                 else
                     Log::get_instance()->message("e.package_mask.bad_spec", ll_warning, lc_context)
                         << "Loading package mask spec '" << **s << "' failed because specification does not restrict to a "
@@ -186,13 +179,6 @@ ExheresMaskStore::_populate()
 const std::shared_ptr<const MasksInfo>
 ExheresMaskStore::query(const std::shared_ptr<const PackageID> & id) const
 {
-    auto result(std::make_shared<MasksInfo>());
-    auto r(_imp->repo_mask.find(id->name()));
-    if (_imp->repo_mask.end() != r)
-        for (auto k(r->second.begin()), k_end(r->second.end()) ; k != k_end ; ++k)
-            if (match_package(*_imp->env, k->first, id, nullptr, { }))
-                result->push_back(*k->second);
-
-    return result;
+    return _imp->repo_mask.query(_imp->env, id);
 }
 
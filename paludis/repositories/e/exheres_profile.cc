@@ -22,6 +22,7 @@
 #include <paludis/repositories/e/e_repository.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/dep_parser.hh>
+#include <paludis/repositories/e/profile_snapshot.hh>
 
 #include <paludis/util/log.hh>
 #include <paludis/util/tokeniser.hh>
@@ -36,6 +37,8 @@
 #include <paludis/util/system.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
 
 #include <paludis/choice.hh>
 #include <paludis/environment.hh>
@@ -45,26 +48,42 @@
 #include <paludis/metadata_key.hh>
 #include <paludis/paludislike_options_conf.hh>
 #include <paludis/dep_spec_flattener.hh>
+#include <paludis/about.hh>
 
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include <functional>
 
 using namespace paludis;
 using namespace paludis::erepository;
 
 namespace
 {
-    const std::shared_ptr<const LineConfigFile> make_config_file(
-            const FSPath & f,
-            const LineConfigFileOptions & o)
-    {
-        return std::make_shared<LineConfigFile>(f, o);
-    }
-
     typedef std::unordered_map<std::string, std::string, Hash<std::string> > EnvironmentVariablesMap;
     typedef std::unordered_map<QualifiedPackageName,
             std::list<std::pair<std::shared_ptr<const PackageDepSpec>, std::shared_ptr<const MaskInfo> > >,
             Hash<QualifiedPackageName> > PackageMaskMap;
+
+    struct ProfileDirectoryTexts
+    {
+        FSPath dir;
+        std::string eapi;
+        std::vector<std::string> options_conf;
+        std::vector<std::string> system_conf;
+
+        ProfileDirectoryTexts(const FSPath & d, const std::string & e) :
+            dir(d),
+            eapi(e)
+        {
+        }
+    };
+
+    const std::string read_text(const FSPath & f)
+    {
+        SafeIFStream file(f);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
 }
 
 namespace paludis
@@ -90,6 +109,20 @@ namespace paludis
 
         const std::shared_ptr<SetSpecTree> system_packages;
 
+        std::unordered_map<std::string, std::string, Hash<std::string> > config_file_texts;
+        std::list<ProfileDirectoryTexts> directory_texts;
+        std::shared_ptr<ProfileSnapshot> snapshot;
+
+        const std::shared_ptr<const LineConfigFile> make_config_file(
+                const FSPath & f,
+                const LineConfigFileOptions & o)
+        {
+            auto t(config_file_texts.find(stringify(f)));
+            if (config_file_texts.end() == t)
+                t = config_file_texts.insert(std::make_pair(stringify(f), read_text(f))).first;
+            return std::make_shared<LineConfigFile>(ConfigFile::Source(t->second), o);
+        }
+
         Imp(
                 const Environment * const e,
                 const EAPIForFileFunction & f,
@@ -101,7 +134,8 @@ namespace paludis
             options_conf(make_named_values<PaludisLikeOptionsConfParams>(
                         n::allow_locking() = true,
                         n::environment() = e,
-                        n::make_config_file() = &make_config_file
+                        n::make_config_file() = std::bind(&Imp::make_config_file, this,
+                            std::placeholders::_1, std::placeholders::_2)
                         )),
             use_expand(std::make_shared<Set<std::string>>()),
             use_expand_hidden(std::make_shared<Set<std::string>>()),
@@ -117,21 +151,180 @@ namespace paludis
     };
 }
 
+namespace
+{
+    void add_system_packages(
+            Pimp<ExheresProfile> & _imp,
+            const std::string & file_text,
+            const EAPI & eapi)
+    {
+        auto specs(parse_commented_set(file_text, _imp->env, eapi));
+
+        DepSpecFlattener<SetSpecTree, PackageDepSpec> flat_specs(_imp->env, nullptr);
+        specs->top()->accept(flat_specs);
+
+        for (auto s(flat_specs.begin()), s_end(flat_specs.end()) ;
+                s != s_end ; ++s)
+            _imp->system_packages->top()->append(std::make_shared<PackageDepSpec>(**s));
+    }
+
+    const std::string snapshot_key(
+            const FSPathSequence & location,
+            const bool has_master_repositories,
+            const std::string & profile_eapi_when_unspecified)
+    {
+        return "exheres " + stringify(PALUDIS_VERSION) + PALUDIS_VERSION_SUFFIX + " " + PALUDIS_GIT_HEAD
+            + "\n" + join(location.begin(), location.end(), "\n")
+            + "\n" + stringify(has_master_repositories)
+            + "\n" + profile_eapi_when_unspecified
+            + "\n" + getenv_with_default("CONFIG_PROTECT", "/etc")
+            + "\n" + getenv_with_default("CONFIG_PROTECT_MASK", "");
+    }
+
+    void save_snapshot(
+            Pimp<ExheresProfile> & _imp,
+            const FSPath & location)
+    {
+        ProfileSnapshot & snapshot(*_imp->snapshot);
+
+        std::vector<std::string> dirs;
+        for (auto d(_imp->directory_texts.begin()), d_end(_imp->directory_texts.end()) ;
+                d != d_end ; ++d)
+            dirs.push_back(stringify(d->dir));
+        snapshot.add_values(dirs);
+
+        for (auto d(_imp->directory_texts.begin()), d_end(_imp->directory_texts.end()) ;
+                d != d_end ; ++d)
+        {
+            snapshot.add_value(d->eapi);
+            snapshot.add_values(d->options_conf);
+            snapshot.add_values(d->system_conf);
+        }
+
+        std::vector<std::string> vars;
+        for (auto v(_imp->environment_variables.begin()), v_end(_imp->environment_variables.end()) ;
+                v != v_end ; ++v)
+        {
+            vars.push_back(v->first);
+            vars.push_back(v->second);
+        }
+        snapshot.add_values(vars);
+
+        snapshot.save(location);
+    }
+
+    void load_from_snapshot(
+            Pimp<ExheresProfile> & _imp,
+            ProfileSnapshot & snapshot)
+    {
+        std::list<ProfileDirectoryTexts> directory_texts;
+        std::vector<std::string> dirs(snapshot.next_values());
+        for (auto d(dirs.begin()), d_end(dirs.end()) ;
+                d != d_end ; ++d)
+        {
+            ProfileDirectoryTexts texts(FSPath(*d), snapshot.next_value());
+            if (texts.eapi != _imp->eapi_for_file(texts.dir / "make.defaults"))
+                throw ProfileSnapshotError("EAPI for profile directory '" + *d + "' has changed");
+
+            texts.options_conf = snapshot.next_values();
+            texts.system_conf = snapshot.next_values();
+            if (texts.options_conf.size() > 1 || texts.system_conf.size() > 1)
+                throw ProfileSnapshotError("Profile snapshot has bad values for profile directory '" + *d + "'");
+
+            if ((! texts.system_conf.empty()) && ! EAPIData::get_instance()->eapi_from_string(texts.eapi)->supported())
+                throw ProfileSnapshotError("Profile snapshot uses unsupported EAPI '" + texts.eapi + "'");
+
+            directory_texts.push_back(texts);
+        }
+
+        std::vector<std::string> vars(snapshot.next_values());
+        if (0 != vars.size() % 2)
+            throw ProfileSnapshotError("Profile snapshot has bad environment variables");
+
+        snapshot.check_finished();
+
+        for (auto d(directory_texts.begin()), d_end(directory_texts.end()) ;
+                d != d_end ; ++d)
+        {
+            if (! d->options_conf.empty())
+            {
+                _imp->config_file_texts[stringify(d->dir / "options.conf")] = d->options_conf.front();
+                _imp->options_conf.add_file(d->dir / "options.conf");
+            }
+
+            if (! d->system_conf.empty())
+                add_system_packages(_imp, d->system_conf.front(), *EAPIData::get_instance()->eapi_from_string(d->eapi));
+
+            _imp->profiles_with_parents->push_back(d->dir);
+        }
+
+        for (auto v(vars.begin()), v_end(vars.end()) ;
+                v != v_end ; v += 2)
+            _imp->environment_variables[*v] = *std::next(v);
+    }
+}
+
 ExheresProfile::ExheresProfile(
         const Environment * const env,
-        const RepositoryName &,
+        const RepositoryName & name,
         const EAPIForFileFunction & eapi_for_file,
         const IsArchFlagFunction &,
         const FSPathSequence & location,
         const std::string &,
         const bool,
         const bool has_master_repositories,
-        const bool) :
+        const bool,
+        const FSPath & profiles_cache,
+        const std::string & profile_eapi_when_unspecified,
+        const FSPath & layout_conf) :
     _imp(env, eapi_for_file, has_master_repositories)
 {
-    for (FSPathSequence::ConstIterator l(location.begin()), l_end(location.end()) ;
-            l != l_end ; ++l)
-        _load_dir(*l);
+    bool use_snapshot(profiles_cache != FSPath("/var/empty")), loaded_from_snapshot(false);
+    std::string key(snapshot_key(location, has_master_repositories, profile_eapi_when_unspecified));
+    FSPath snapshot_file(profiles_cache / (stringify(name) + ".profile"));
+
+    if (use_snapshot)
+    {
+        std::shared_ptr<ProfileSnapshot> snapshot(ProfileSnapshot::load(snapshot_file, key));
+        if (snapshot)
+        {
+            try
+            {
+                load_from_snapshot(_imp, *snapshot);
+                loaded_from_snapshot = true;
+            }
+            catch (const ProfileSnapshotError & e)
+            {
+                Log::get_instance()->message("e.exheres_profile.snapshot.load.bad_values", ll_debug, lc_context)
+                    << "Not using profile snapshot '" << snapshot_file << "' due to exception '" << e.message() << "' ("
+                    << e.what() << ")";
+            }
+        }
+    }
+
+    if (! loaded_from_snapshot)
+    {
+        if (use_snapshot)
+        {
+            /* directories without an eapi file use the fallback EAPI, which
+             * can come from layout.conf */
+            _imp->snapshot = std::make_shared<ProfileSnapshot>(key);
+            _imp->snapshot->add_dependency(layout_conf);
+        }
+
+        for (FSPathSequence::ConstIterator l(location.begin()), l_end(location.end()) ;
+                l != l_end ; ++l)
+            _load_dir(*l);
+
+        if (_imp->snapshot)
+        {
+            save_snapshot(_imp, snapshot_file);
+            _imp->snapshot.reset();
+            _imp->directory_texts.clear();
+        }
+    }
+
+    _imp->config_file_texts.clear();
 
     const std::shared_ptr<const Set<UnprefixedChoiceName> > s(_imp->options_conf.known_choice_value_names(
                 nullptr, ChoicePrefixName("suboptions")));
@@ -157,6 +350,10 @@ ExheresProfile::~ExheresProfile()
 void
 ExheresProfile::_load_dir(const FSPath & f)
 {
+    if (_imp->snapshot)
+        for (auto & d : { "", "eapi", "parents.conf", "options.conf", "system.conf", "make.defaults" })
+            _imp->snapshot->add_dependency(*d ? f / d : f);
+
     if (! f.stat().is_directory_or_symlink_to_directory())
     {
         Log::get_instance()->message("e.exheres_profile.not_a_directory", ll_warning, lc_context) <<
@@ -172,24 +369,21 @@ ExheresProfile::_load_dir(const FSPath & f)
             _load_dir((f / *line).realpath());
     }
 
+    ProfileDirectoryTexts texts(f, _imp->eapi_for_file(f / "make.defaults"));
+
     if ((f / "options.conf").stat().exists())
+    {
         _imp->options_conf.add_file(f / "options.conf");
+        texts.options_conf.push_back(_imp->config_file_texts[stringify(f / "options.conf")]);
+    }
 
     if (! _imp->has_master_repositories)
     {
         if ((f / "system.conf").stat().exists())
         {
-            SafeIFStream file(f / "system.conf");
-            std::string file_text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-            auto eapi(EAPIData::get_instance()->eapi_from_string(_imp->eapi_for_file(f / "system.conf")));
-            auto specs(parse_commented_set(file_text, _imp->env, *EAPIData::get_instance()->eapi_from_string(_imp->eapi_for_file(f / "system.conf"))));
-
-            DepSpecFlattener<SetSpecTree, PackageDepSpec> flat_specs(_imp->env, nullptr);
-            specs->top()->accept(flat_specs);
-
-            for (auto s(flat_specs.begin()), s_end(flat_specs.end()) ;
-                    s != s_end ; ++s)
-                _imp->system_packages->top()->append(std::make_shared<PackageDepSpec>(**s));
+            std::string file_text(read_text(f / "system.conf"));
+            add_system_packages(_imp, file_text, *EAPIData::get_instance()->eapi_from_string(_imp->eapi_for_file(f / "system.conf")));
+            texts.system_conf.push_back(file_text);
         }
     }
 
@@ -209,6 +403,9 @@ ExheresProfile::_load_dir(const FSPath & f)
             _imp->environment_variables[k->first] = k->second;
     }
 
+    if (_imp->snapshot)
+        _imp->directory_texts.push_back(texts);
+
     _imp->profiles_with_parents->push_back(f);
 }
 
@@ -46,7 +46,10 @@ namespace paludis
                         const std::string & arch_var_if_special,
                         const bool profiles_explicitly_set,
                         const bool has_master_repositories,
-                        const bool ignore_deprecated_profiles);
+                        const bool ignore_deprecated_profiles,
+                        const FSPath & profiles_cache,
+                        const std::string & profile_eapi_when_unspecified,
+                        const FSPath & layout_conf);
 
                 virtual ~ExheresProfile();
 
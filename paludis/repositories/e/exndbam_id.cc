@@ -59,11 +59,13 @@ const std::shared_ptr<const Contents>
 ExndbamID::contents() const
 {
     auto v(std::make_shared<Contents>());
-    _ndbam->parse_contents(*this,
-            std::bind(&Contents::add, v.get(), std::placeholders::_1),
-            std::bind(&Contents::add, v.get(), std::placeholders::_1),
-            std::bind(&Contents::add, v.get(), std::placeholders::_1)
-            );
+    _ndbam->parse_contents(*this, *v);
     return v;
 }
 
+void
+ExndbamID::for_each_contents_entry(const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> & f) const
+{
+    _ndbam->for_each_contents_entry(*this, f);
+}
+
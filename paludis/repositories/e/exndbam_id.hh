@@ -44,6 +44,8 @@ namespace paludis
                 virtual std::string fs_location_human_name() const;
                 virtual std::string contents_filename() const;
                 virtual const std::shared_ptr<const Contents> contents() const;
+                virtual void for_each_contents_entry(
+                        const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> &) const;
         };
     }
 }
@@ -39,6 +39,7 @@
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/return_literal_function.hh>
+#include <paludis/util/destringify.hh>
 
 #include <paludis/output_manager.hh>
 #include <paludis/distribution.hh>
@@ -46,6 +47,7 @@
 #include <paludis/ndbam.hh>
 #include <paludis/ndbam_merger.hh>
 #include <paludis/ndbam_unmerger.hh>
+#include <paludis/repository_owners_cache.hh>
 #include <paludis/metadata_key.hh>
 #include <paludis/package_id.hh>
 #include <paludis/action.hh>
@@ -56,6 +58,7 @@
 
 #include <functional>
 #include <mutex>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::erepository;
@@ -66,6 +69,15 @@ namespace
     {
         return s == "exndbam-1";
     }
+
+    std::shared_ptr<const ExndbamID> id_for_entry(NDBAMEntry & e, const Environment * const env,
+            const RepositoryName & repo, NDBAM * const ndbam)
+    {
+        std::unique_lock<std::mutex> l(*e.mutex());
+        if (! e.package_id())
+            e.package_id() = std::make_shared<ExndbamID>(e.name(), e.version(), env, repo, e.fs_location(), ndbam);
+        return std::static_pointer_cast<const ExndbamID>(e.package_id());
+    }
 }
 
 namespace paludis
@@ -75,6 +87,10 @@ namespace paludis
     {
         ExndbamRepositoryParams params;
         mutable NDBAM ndbam;
+        std::shared_ptr<RepositoryOwnersCache> owners_cache;
+
+        mutable std::mutex all_ids_mutex;
+        mutable bool has_all_ids;
 
         std::shared_ptr<const MetadataValueKey<FSPath> > location_key;
         std::shared_ptr<const MetadataValueKey<FSPath> > root_key;
@@ -82,11 +98,13 @@ namespace paludis
         std::shared_ptr<const MetadataValueKey<FSPath> > builddir_key;
         std::shared_ptr<const MetadataValueKey<std::string> > eapi_when_unknown_key;
 
-        Imp(const ExndbamRepositoryParams & p) :
+        Imp(const ExndbamRepository * const r, const ExndbamRepositoryParams & p) :
             params(p),
             ndbam(params.location(), &supported_exndbam, "exndbam-1",
                     EAPIData::get_instance()->eapi_from_string(
                         params.eapi_when_unknown())->supported()->version_spec_options()),
+            owners_cache(std::make_shared<RepositoryOwnersCache>(params.location() / ".cache" / "owners", r, "contents")),
+            has_all_ids(false),
             location_key(std::make_shared<LiteralMetadataValueKey<FSPath> >("location", "location",
                         mkt_significant, params.location())),
             root_key(std::make_shared<LiteralMetadataValueKey<FSPath> >("root", "root",
@@ -115,7 +133,7 @@ ExndbamRepository::ExndbamRepository(const RepositoryName & n, const ExndbamRepo
                 n::environment_variable_interface() = this,
                 n::manifest_interface() = static_cast<RepositoryManifestInterface *>(nullptr)
             )),
-    _imp(p)
+    _imp(this, p)
 {
     _add_metadata_keys();
 }
@@ -165,6 +183,13 @@ ExndbamRepository::repository_factory_create(
                 *DistributionData::get_instance()->distribution_from_string(
                     env->distribution()))->default_eapi_when_unknown();
 
+    bool parallel_load(false);
+    if (! f("parallel_load").empty())
+    {
+        Context item_context("When handling parallel_load key:");
+        parallel_load = destringify<bool>(f("parallel_load"));
+    }
+
     return std::make_shared<ExndbamRepository>(
             RepositoryName(name),
             make_named_values<ExndbamRepositoryParams>(
@@ -172,6 +197,7 @@ ExndbamRepository::repository_factory_create(
                 n::eapi_when_unknown() = eapi_when_unknown,
                 n::environment() = env,
                 n::location() = location,
+                n::parallel_load() = parallel_load,
                 n::root() = root
                 )
             );
@@ -200,28 +226,77 @@ ExndbamRepository::repository_factory_dependencies(
 void
 ExndbamRepository::invalidate()
 {
-    _imp.reset(new Imp<ExndbamRepository>(_imp->params));
+    _imp.reset(new Imp<ExndbamRepository>(this, _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 std::shared_ptr<const PackageIDSequence>
 ExndbamRepository::package_ids(const QualifiedPackageName & q,
         const RepositoryContentMayExcludes &) const
 {
+    if (_imp->params.parallel_load())
+        need_all_ids();
+
     std::shared_ptr<NDBAMEntrySequence> entries(_imp->ndbam.entries(q));
     std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
 
     for (IndirectIterator<NDBAMEntrySequence::ConstIterator> e(entries->begin()), e_end(entries->end()) ;
             e != e_end ; ++e)
+        result->push_back(id_for_entry(*e, _imp->params.environment(), name(), &_imp->ndbam));
+
+    return result;
+}
+
+void
+ExndbamRepository::need_all_ids() const
+{
+    /* we only hold the lock long enough to say that we're loading, so
+     * anyone else can carry on as normal in the meantime. if anything goes
+     * wrong, we go back to loading one package at a time. */
     {
-        std::unique_lock<std::mutex> l(*(*e).mutex());
-        if (! (*e).package_id())
-            (*e).package_id() = std::make_shared<ExndbamID>((*e).name(), (*e).version(), _imp->params.environment(),
-                        name(), (*e).fs_location(), &_imp->ndbam);
-        result->push_back((*e).package_id());
+        std::unique_lock<std::mutex> lock(_imp->all_ids_mutex);
+        if (_imp->has_all_ids)
+            return;
+        _imp->has_all_ids = true;
     }
 
-    return result;
+    Context context("When loading all IDs from '" + stringify(_imp->params.location()) + "':");
+
+    /* NDBAM locks each category and package separately, so each category
+     * can be scanned, and its IDs' key files read, on its own task */
+    std::shared_ptr<const CategoryNamePartSet> categories(_imp->ndbam.category_names());
+    std::vector<std::function<void ()> > tasks;
+    for (CategoryNamePartSet::ConstIterator c(categories->begin()), c_end(categories->end()) ;
+            c != c_end ; ++c)
+    {
+        CategoryNamePart category(*c);
+        tasks.push_back([this, category] () {
+                std::shared_ptr<const QualifiedPackageNameSet> names(_imp->ndbam.package_names(category));
+                for (QualifiedPackageNameSet::ConstIterator q(names->begin()), q_end(names->end()) ;
+                        q != q_end ; ++q)
+                {
+                    std::shared_ptr<NDBAMEntrySequence> entries(_imp->ndbam.entries(*q));
+                    for (IndirectIterator<NDBAMEntrySequence::ConstIterator> e(entries->begin()), e_end(entries->end()) ;
+                            e != e_end ; ++e)
+                        id_for_entry(*e, _imp->params.environment(), name(), &_imp->ndbam)->preload_key_files();
+                }
+            });
+    }
+
+    try
+    {
+        run_load_tasks(tasks);
+    }
+    catch (const InternalError &)
+    {
+        throw;
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("e.exndbam.parallel_load.failure", ll_warning, lc_context)
+            << "Falling back to loading exndbam packages one at a time due to exception '" << e.message() << "' (" << e.what() << ")";
+    }
 }
 
 std::shared_ptr<const QualifiedPackageNameSet>
@@ -501,6 +576,14 @@ ExndbamRepository::merge(const MergeParams & m)
 
     _imp->ndbam.index(m.package_id()->name(), uid_dir.basename());
 
+    {
+        const std::shared_ptr<const PackageIDSequence> ids(package_ids(m.package_id()->name(), { }));
+        for (PackageIDSequence::ConstIterator it(ids->begin()), it_end(ids->end()) ;
+                it != it_end ; ++it)
+            if ((*it)->fs_location_key()->parse_value() == target_ver_dir)
+                _imp->owners_cache->add(*it);
+    }
+
     if (if_overwritten_id)
     {
         UninstallActionOptions uo(make_named_values<UninstallActionOptions>(
@@ -696,6 +779,10 @@ ExndbamRepository::perform_uninstall(
         }
     }
 
+    /* an overwrite's replacement has already been added under the same name */
+    if (! a.options.is_overwrite())
+        _imp->owners_cache->remove(id);
+
     for (FSIterator d(ver_dir, { fsio_inode_sort, fsio_include_dotfiles }), d_end ; d != d_end ; ++d)
         d->unlink();
     ver_dir.rmdir();
@@ -714,6 +801,13 @@ ExndbamRepository::perform_uninstall(
 void
 ExndbamRepository::regenerate_cache() const
 {
+    _imp->owners_cache->regenerate_cache();
+}
+
+std::shared_ptr<const PackageIDSet>
+ExndbamRepository::maybe_candidate_owners(const std::string & q) const
+{
+    return _imp->owners_cache->candidate_owners(q);
 }
 
 void
@@ -35,6 +35,7 @@ namespace paludis
         typedef Name<struct name_eapi_when_unknown> eapi_when_unknown;
         typedef Name<struct name_environment> environment;
         typedef Name<struct name_location> location;
+        typedef Name<struct name_parallel_load> parallel_load;
         typedef Name<struct name_root> root;
     }
 
@@ -48,6 +49,14 @@ namespace paludis
             NamedValue<n::eapi_when_unknown, std::string> eapi_when_unknown;
             NamedValue<n::environment, Environment *> environment;
             NamedValue<n::location, FSPath> location;
+
+            /**
+             * Load every category's IDs at once, using several threads.
+             *
+             * \since 2.4
+             */
+            NamedValue<n::parallel_load, bool> parallel_load;
+
             NamedValue<n::root, FSPath> root;
         };
     }
@@ -61,6 +70,8 @@ namespace paludis
 
             void _add_metadata_keys() const;
 
+            void need_all_ids() const;
+
         protected:
             virtual void need_keys_added() const;
 
@@ -79,6 +90,9 @@ namespace paludis
 
             virtual void regenerate_cache() const;
 
+            virtual std::shared_ptr<const PackageIDSet> maybe_candidate_owners(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /* RepositoryDestinationInterface */
 
             virtual void merge(const MergeParams &);
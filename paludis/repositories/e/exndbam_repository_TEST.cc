@@ -36,7 +36,9 @@
 #include <paludis/choice.hh>
 #include <paludis/filtered_generator.hh>
 #include <paludis/generator.hh>
+#include <paludis/metadata_key.hh>
 #include <paludis/selection.hh>
+#include <paludis/slot.hh>
 #include <paludis/user_dep_spec.hh>
 
 #include <gtest/gtest.h>
@@ -196,6 +198,50 @@ namespace
         std::vector<FSPath> unseen(contents);
         return recursive_image_matches(root, root, unseen) && !unseen.size();
     }
+
+    std::shared_ptr<Repository>
+    make_parallel_repository(Environment & env, const std::string & parallel_load)
+    {
+        using namespace std::placeholders;
+
+        auto keys(std::make_shared<Map<std::string, std::string>>());
+
+        keys->insert("format", "exndbam");
+        keys->insert("location", stringify(exndbam_repository_TEST_dir / "parallel"));
+        keys->insert("builddir", stringify(exndbam_repository_TEST_dir / "build"));
+        keys->insert("root", stringify(exndbam_repository_TEST_dir / "parallel_root"));
+        keys->insert("parallel_load", parallel_load);
+
+        return ExndbamRepository::repository_factory_create(&env,
+                                                            std::bind(from_keys,
+                                                                      keys, _1));
+    }
+
+    std::string describe_installed(const std::string & parallel_load)
+    {
+        TestEnvironment env(exndbam_repository_TEST_dir / "parallel_root");
+        env.add_repository(1, make_parallel_repository(env, parallel_load));
+
+        std::string result;
+        std::shared_ptr<const PackageIDSequence> ids(env[selection::AllVersionsSorted(generator::All())]);
+        for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                i != i_end ; ++i)
+        {
+            result += stringify((*i)->name()) + "-" + stringify((*i)->version());
+            if ((*i)->slot_key())
+                result += " SLOT=" + (*i)->slot_key()->parse_value().raw_value();
+            if ((*i)->choices_key())
+                for (Choices::ConstIterator c((*i)->choices_key()->parse_value()->begin()),
+                        c_end((*i)->choices_key()->parse_value()->end()) ;
+                        c != c_end ; ++c)
+                    for (Choice::ConstIterator v((*c)->begin()), v_end((*c)->end()) ;
+                            v != v_end ; ++v)
+                        result += " " + stringify((*v)->name_with_prefix()) + "=" + stringify((*v)->enabled());
+            result += "\n";
+        }
+
+        return result;
+    }
 }
 
 TEST(ExndbamRepository, RepoName)
@@ -389,3 +435,27 @@ TEST(ExndbamRepository, SelectivePartsCoreAndSelectedParts)
     uninstall(env, "=category/partitioned-1::installed");
 }
 
+TEST(ExndbamRepository, ParallelLoad)
+{
+    {
+        TestEnvironment env(exndbam_repository_TEST_dir / "parallel_root");
+        env.set_want_choice_enabled(ChoicePrefixName("parts"),
+                UnprefixedChoiceName("binaries"),
+                Tribool("true"));
+
+        auto parts(make_exheres_0_repository(env, exndbam_repository_TEST_dir,
+                                             "parts"));
+        auto installed(make_parallel_repository(env, "false"));
+        env.add_repository(0, installed);
+        env.add_repository(1, parts);
+
+        install(env, installed, "=category/partitioned-1::parts", "");
+        install(env, installed, "=other/simple-1::parts", "");
+    }
+
+    std::string sequential(describe_installed("false")), parallel(describe_installed("true"));
+    EXPECT_EQ(sequential, parallel);
+    EXPECT_NE(std::string::npos, parallel.find("category/partitioned-1 SLOT=0"));
+    EXPECT_NE(std::string::npos, parallel.find(" parts:binaries=true"));
+    EXPECT_NE(std::string::npos, parallel.find("other/simple-1 SLOT=1"));
+}
@@ -7,11 +7,12 @@ cd exndbam_repository_TEST_dir || exit 1
 mkdir -p distdir
 mkdir -p build
 mkdir -p root/etc
+mkdir -p parallel_root/etc
 
 mkdir -p repo1/ || exit 1
 
-mkdir -p installed || exit 1
-mkdir -p parts/{metadata,profiles/profile,packages/category/partitioned} || exit 1
+mkdir -p installed parallel || exit 1
+mkdir -p parts/{metadata,profiles/profile,packages/{category/partitioned,other/simple}} || exit 1
 mkdir -p postinsttest postinsttest_src1/{eclass,profiles/profile,cat/pkg} || exit 1
 
 cat <<END > postinsttest_src1/profiles/profile/make.defaults
@@ -65,7 +66,10 @@ cat <<- EOF > parts/profiles/profile/make.defaults
 CHOST="i686-pc-linux-gnu"
 EOF
 echo parts > parts/profiles/repo_name
-echo category > parts/metadata/categories.conf
+cat <<- EOF > parts/metadata/categories.conf
+category
+other
+EOF
 
 cat <<- EOF > parts/packages/category/partitioned/partitioned-0.exheres-0
 PLATFORMS="test"
@@ -105,3 +109,17 @@ src_install() {
 }
 EOF
 
+cat <<- EOF > parts/packages/other/simple/simple-1.exheres-0
+PLATFORMS="test"
+
+SLOT="1"
+
+src_unpack() {
+    edo mkdir -p "\${WORK}"
+}
+
+src_install() {
+    edo mkdir -p "\${IMAGE}"/usr/share/simple
+    edo touch "\${IMAGE}"/usr/share/simple/file
+}
+EOF
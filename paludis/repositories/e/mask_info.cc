@@ -26,6 +26,6 @@ using namespace paludis::erepository;
 
 namespace paludis
 {
-    template class Sequence<MaskInfo>;
-    template class WrappedForwardIterator<Sequence<MaskInfo>::ConstIteratorTag, const MaskInfo>;
+    template class PALUDIS_VISIBLE Sequence<MaskInfo>;
+    template class PALUDIS_VISIBLE WrappedForwardIterator<Sequence<MaskInfo>::ConstIteratorTag, const MaskInfo>;
 }
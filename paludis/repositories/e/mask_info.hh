@@ -20,6 +20,7 @@
 #ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_INFO_HH
 #define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_INFO_HH 1
 
+#include <paludis/util/attributes.hh>
 #include <paludis/util/named_value.hh>
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/sequence.hh>
@@ -46,8 +47,8 @@ namespace paludis
         typedef Sequence<MaskInfo> MasksInfo;
     }
 
-    extern template class Sequence<erepository::MaskInfo>;
-    extern template class WrappedForwardIterator<Sequence<erepository::MaskInfo>::ConstIterator, const erepository::MaskInfo>;
+    extern template class PALUDIS_VISIBLE Sequence<erepository::MaskInfo>;
+    extern template class PALUDIS_VISIBLE WrappedForwardIterator<Sequence<erepository::MaskInfo>::ConstIteratorTag, const erepository::MaskInfo>;
 }
 
 #endif
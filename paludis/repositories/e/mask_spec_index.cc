@@ -0,0 +1,316 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/mask_spec_index.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/package_id.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/slot.hh>
+#include <paludis/slot_requirement.hh>
+#include <paludis/version_requirements.hh>
+#include <paludis/version_operator.hh>
+#include <paludis/version_spec.hh>
+#include <paludis/match_package.hh>
+
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    struct Entry
+    {
+        PackageDepSpec spec;
+        std::shared_ptr<const MaskInfo> mask_info;
+
+        /* if true, being found by the index is necessary but not
+         * sufficient, and we have to do a full match too */
+        bool residual;
+    };
+
+    struct Range
+    {
+        std::shared_ptr<const VersionSpec> lower;
+        bool lower_inclusive;
+        std::shared_ptr<const VersionSpec> upper;
+        bool upper_inclusive;
+        unsigned index;
+    };
+
+    bool lower_bound_before(const Range & a, const Range & b)
+    {
+        if (! b.lower)
+            return false;
+        if (! a.lower)
+            return true;
+        return *a.lower < *b.lower;
+    }
+
+    struct ExactVersionComparator
+    {
+        bool operator() (const std::pair<VersionSpec, unsigned> & a, const VersionSpec & b) const
+        {
+            return a.first < b;
+        }
+
+        bool operator() (const VersionSpec & a, const std::pair<VersionSpec, unsigned> & b) const
+        {
+            return a < b.first;
+        }
+    };
+
+    struct Group
+    {
+        std::vector<std::pair<VersionSpec, unsigned> > exact;
+        std::vector<Range> ranges;
+        std::vector<unsigned> unversioned;
+        std::vector<unsigned> other;
+
+        bool add(const PackageDepSpec &, const unsigned);
+        void query(const VersionSpec &, std::vector<unsigned> &) const;
+    };
+
+    struct NameEntries
+    {
+        std::vector<Entry> entries;
+        Group any_slot;
+        std::map<SlotName, Group> by_slot;
+    };
+
+    struct SlotIndexer
+    {
+        std::shared_ptr<SlotName> slot;
+        bool residual;
+
+        SlotIndexer() :
+            residual(false)
+        {
+        }
+
+        void visit(const SlotExactPartialRequirement & s)
+        {
+            slot = std::make_shared<SlotName>(s.slot());
+        }
+
+        void visit(const SlotAnyPartialLockedRequirement & s)
+        {
+            slot = std::make_shared<SlotName>(s.slot());
+        }
+
+        void visit(const SlotExactFullRequirement & s)
+        {
+            slot = std::make_shared<SlotName>(s.slots().first);
+            residual = true;
+        }
+
+        void visit(const SlotAnyUnlockedRequirement &)
+        {
+        }
+
+        void visit(const SlotAnyAtAllLockedRequirement &)
+        {
+        }
+
+        void visit(const SlotUnknownRewrittenRequirement &)
+        {
+            residual = true;
+        }
+    };
+
+    bool restrict_range(Range & range, const VersionRequirement & r)
+    {
+        switch (r.version_operator().value())
+        {
+            case vo_equal:
+            case vo_greater:
+            case vo_greater_equal:
+                {
+                    bool inclusive(vo_greater != r.version_operator().value());
+                    if ((! range.lower) || (*range.lower < r.version_spec()) ||
+                            (*range.lower == r.version_spec() && range.lower_inclusive && ! inclusive))
+                    {
+                        range.lower = std::make_shared<VersionSpec>(r.version_spec());
+                        range.lower_inclusive = inclusive;
+                    }
+                }
+                if (vo_equal != r.version_operator().value())
+                    return true;
+                /* fall through */
+
+            case vo_less:
+            case vo_less_equal:
+                {
+                    bool inclusive(vo_less != r.version_operator().value());
+                    if ((! range.upper) || (r.version_spec() < *range.upper) ||
+                            (*range.upper == r.version_spec() && range.upper_inclusive && ! inclusive))
+                    {
+                        range.upper = std::make_shared<VersionSpec>(r.version_spec());
+                        range.upper_inclusive = inclusive;
+                    }
+                }
+                return true;
+
+            case vo_tilde:
+            case vo_nice_equal_star:
+            case vo_stupid_equal_star:
+            case vo_tilde_greater:
+            case last_vo:
+                break;
+        }
+
+        return false;
+    }
+
+    bool
+    Group::add(const PackageDepSpec & spec, const unsigned index)
+    {
+        auto requirements(spec.version_requirements_ptr());
+        if ((! requirements) || (requirements->empty() && vr_and == spec.version_requirements_mode()))
+        {
+            unversioned.push_back(index);
+            return true;
+        }
+
+        /* a single requirement means the same thing under and and or */
+        if (vr_and != spec.version_requirements_mode() && 1 != std::distance(requirements->begin(), requirements->end()))
+        {
+            other.push_back(index);
+            return false;
+        }
+
+        Range range{ nullptr, false, nullptr, false, index };
+        for (auto r(requirements->begin()), r_end(requirements->end()) ; r != r_end ; ++r)
+            if (! restrict_range(range, *r))
+            {
+                other.push_back(index);
+                return false;
+            }
+
+        if (range.lower && range.upper && range.lower_inclusive && range.upper_inclusive && *range.lower == *range.upper)
+        {
+            auto e(std::make_pair(*range.lower, index));
+            exact.insert(std::upper_bound(exact.begin(), exact.end(), e,
+                        [] (const std::pair<VersionSpec, unsigned> & a, const std::pair<VersionSpec, unsigned> & b) {
+                            return a.first < b.first;
+                        }), e);
+        }
+        else
+            ranges.insert(std::upper_bound(ranges.begin(), ranges.end(), range, &lower_bound_before), range);
+
+        return true;
+    }
+
+    void
+    Group::query(const VersionSpec & v, std::vector<unsigned> & result) const
+    {
+        std::copy(unversioned.begin(), unversioned.end(), std::back_inserter(result));
+        std::copy(other.begin(), other.end(), std::back_inserter(result));
+
+        auto e(std::equal_range(exact.begin(), exact.end(), v,
+                    ExactVersionComparator()));
+        for (auto i(e.first) ; i != e.second ; ++i)
+            result.push_back(i->second);
+
+        auto r_end(std::partition_point(ranges.begin(), ranges.end(), [&] (const Range & r) { return (! r.lower) || ! (v < *r.lower); }));
+        for (auto r(ranges.begin()) ; r != r_end ; ++r)
+        {
+            if (r->lower && ! r->lower_inclusive && *r->lower == v)
+                continue;
+            if (r->upper && (r->upper_inclusive ? *r->upper < v : ! (v < *r->upper)))
+                continue;
+            result.push_back(r->index);
+        }
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<MaskSpecIndex>
+    {
+        std::unordered_map<QualifiedPackageName, NameEntries, Hash<QualifiedPackageName> > names;
+    };
+}
+
+MaskSpecIndex::MaskSpecIndex() :
+    _imp()
+{
+}
+
+MaskSpecIndex::~MaskSpecIndex() = default;
+
+void
+MaskSpecIndex::add(const PackageDepSpec & spec, const std::shared_ptr<const MaskInfo> & mask_info)
+{
+    SlotIndexer slot_indexer;
+    if (spec.slot_requirement_ptr())
+        spec.slot_requirement_ptr()->accept(slot_indexer);
+
+    NameEntries & n(_imp->names[*spec.package_ptr()]);
+    unsigned index(n.entries.size());
+    bool fully_indexed(slot_indexer.slot ? n.by_slot[*slot_indexer.slot].add(spec, index) : n.any_slot.add(spec, index));
+
+    n.entries.push_back(Entry{ spec, mask_info, (! fully_indexed) || slot_indexer.residual ||
+            spec.in_repository_ptr() || spec.from_repository_ptr() || spec.installed_at_path_ptr() ||
+            spec.installable_to_repository_ptr() || spec.installable_to_path_ptr() ||
+            spec.additional_requirements_ptr() || spec.package_name_part_ptr() || spec.category_name_part_ptr() });
+}
+
+const std::shared_ptr<const MasksInfo>
+MaskSpecIndex::query(const Environment * const env, const std::shared_ptr<const PackageID> & id) const
+{
+    auto result(std::make_shared<MasksInfo>());
+
+    auto n(_imp->names.find(id->name()));
+    if (_imp->names.end() == n)
+        return result;
+
+    std::vector<unsigned> candidates;
+    n->second.any_slot.query(id->version(), candidates);
+
+    if ((! n->second.by_slot.empty()) && id->slot_key())
+    {
+        auto g(n->second.by_slot.find(id->slot_key()->parse_value().match_values().first));
+        if (n->second.by_slot.end() != g)
+            g->second.query(id->version(), candidates);
+    }
+
+    /* keep things in file order */
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (auto c(candidates.begin()), c_end(candidates.end()) ; c != c_end ; ++c)
+    {
+        const Entry & entry(n->second.entries[*c]);
+        if (entry.residual && ! match_package(*env, entry.spec, id, nullptr, { }))
+            continue;
+        result->push_back(*entry.mask_info);
+    }
+
+    return result;
+}
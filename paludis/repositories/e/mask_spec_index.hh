@@ -0,0 +1,72 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_SPEC_INDEX_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_SPEC_INDEX_HH 1
+
+#include <paludis/repositories/e/mask_info.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/dep_spec-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+
+#include <memory>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Holds repository mask specs, indexed by package name, exact slot and
+         * version range, so that a query only has to fully match those specs
+         * which can possibly apply.
+         *
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE MaskSpecIndex
+        {
+            private:
+                Pimp<MaskSpecIndex> _imp;
+
+            public:
+                MaskSpecIndex();
+                ~MaskSpecIndex();
+
+                MaskSpecIndex(const MaskSpecIndex &) = delete;
+                MaskSpecIndex & operator= (const MaskSpecIndex &) = delete;
+
+                /**
+                 * Add a spec, which must have a package name.
+                 */
+                void add(const PackageDepSpec &, const std::shared_ptr<const MaskInfo> &);
+
+                /**
+                 * Find every added spec matching the ID, in the order in which
+                 * they were added.
+                 */
+                const std::shared_ptr<const MasksInfo> query(
+                        const Environment * const,
+                        const std::shared_ptr<const PackageID> &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/mask_spec_index.hh>
+#include <paludis/repositories/e/eapi.hh>
+
+#include <paludis/repositories/fake/fake_package_id.hh>
+#include <paludis/repositories/fake/fake_repository.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/stringify.hh>
+
+#include <paludis/elike_package_dep_spec.hh>
+#include <paludis/match_package.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    std::string tokens(const std::shared_ptr<const MasksInfo> & m)
+    {
+        std::string result;
+        for (auto i(m->begin()), i_end(m->end()) ; i != i_end ; ++i)
+            result.append((result.empty() ? "" : " ") + i->token());
+        return result;
+    }
+}
+
+TEST(MaskSpecIndex, MatchesLikeMatchPackage)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(1, repo);
+
+    for (auto v : { "0.9", "1", "1-r1", "1.1", "1.2", "2", "2.1", "3", "10" })
+        repo->add_version("cat", "pkg", v);
+    for (auto v : { "1_p1", "2_p1", "2.1_p1", "5" })
+        repo->add_version("cat", "pkg", v)->set_slot(SlotName("other"));
+    std::shared_ptr<const PackageID> other_id(repo->add_version("cat", "other", "1"));
+
+    std::shared_ptr<const EAPI> eapi(EAPIData::get_instance()->eapi_from_string("paludis-1"));
+
+    std::vector<std::string> specs{
+        "cat/pkg",
+        "=cat/pkg-1",
+        "=cat/pkg-1-r0",
+        "~cat/pkg-1",
+        "=cat/pkg-1*",
+        ">cat/pkg-1",
+        ">=cat/pkg-1.1",
+        "<cat/pkg-2",
+        "<=cat/pkg-2",
+        "cat/pkg:other",
+        ">=cat/pkg-2:other",
+        "=cat/pkg-2:0",
+        "cat/pkg[>1&<3]",
+        "cat/pkg[>1.1&<=1.2]",
+        "cat/pkg[=1&=2]",
+        "cat/pkg[<1|>3]",
+        "cat/pkg[=2.1|=10]",
+        "cat/pkg[>=3]",
+        "cat/pkg::repo",
+        "cat/pkg::other",
+        ">=cat/pkg-2::repo",
+        "cat/other"
+    };
+
+    MaskSpecIndex index;
+    for (auto s(specs.begin()), s_end(specs.end()) ; s != s_end ; ++s)
+        index.add(parse_elike_package_dep_spec(*s, eapi->supported()->package_dep_spec_parse_options(),
+                    eapi->supported()->version_spec_options()),
+                std::make_shared<MaskInfo>(make_named_values<MaskInfo>(
+                        n::comment() = "",
+                        n::mask_file() = FSPath("/masks"),
+                        n::token() = stringify(s - specs.begin())
+                        )));
+
+    auto all_ids(repo->package_ids(QualifiedPackageName("cat/pkg"), { }));
+    for (auto i(all_ids->begin()), i_end(all_ids->end()) ; i != i_end ; ++i)
+    {
+        std::string expected;
+        for (auto s(specs.begin()), s_end(specs.end()) ; s != s_end ; ++s)
+            if (match_package(env, parse_elike_package_dep_spec(*s, eapi->supported()->package_dep_spec_parse_options(),
+                            eapi->supported()->version_spec_options()), *i, nullptr, { }))
+                expected.append((expected.empty() ? "" : " ") + stringify(s - specs.begin()));
+
+        EXPECT_EQ(expected, tokens(index.query(&env, *i))) << stringify(**i);
+    }
+
+    EXPECT_EQ("21", tokens(index.query(&env, other_id)));
+}
+
+TEST(MaskSpecIndex, Unknown)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(1, repo);
+
+    MaskSpecIndex index;
+    EXPECT_TRUE(index.query(&env, repo->add_version("cat", "pkg", "1"))->empty());
+}
@@ -82,6 +82,48 @@ MemoisedHashes::get(const std::string & algo, const FSPath & file, SafeIFStream
     return i->second.second;
 }
 
+const std::map<std::string, std::string>
+MemoisedHashes::get_all(const std::set<std::string> & algos, const FSPath & file, SafeIFStream & stream) const
+{
+    std::map<std::string, std::string> result;
+    std::set<std::string> missing;
+    Timestamp mtime(file.stat().mtim());
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    for (auto a(algos.begin()), a_end(algos.end()) ; a != a_end ; ++a)
+    {
+        HashesMap::const_iterator i(_imp->hashes.find(std::make_pair(stringify(file), *a)));
+        if (i == _imp->hashes.end() || i->second.first != mtime)
+            missing.insert(*a);
+        else
+            result.insert(std::make_pair(*a, i->second.second));
+    }
+
+    if (! missing.empty())
+    {
+        auto calculated(DigestRegistry::get_instance()->digest_all(missing, stream));
+        stream.clear();
+        stream.seekg(0, std::ios::beg);
+
+        for (auto c(calculated.begin()), c_end(calculated.end()) ; c != c_end ; ++c)
+        {
+            std::pair<std::string, std::string> key(stringify(file), c->first);
+            std::pair<Timestamp, std::string> value(std::make_pair(mtime, c->second));
+
+            HashesMap::iterator i(_imp->hashes.find(key));
+            if (i != _imp->hashes.end())
+                i->second = value;
+            else
+                _imp->hashes.insert(std::make_pair(key, value));
+
+            result.insert(*c);
+        }
+    }
+
+    return result;
+}
+
 namespace paludis
 {
     template class Pimp<MemoisedHashes>;
@@ -25,6 +25,8 @@
 #include <paludis/util/fs_path-fwd.hh>
 #include <paludis/util/safe_ifstream-fwd.hh>
 #include <string>
+#include <map>
+#include <set>
 
 namespace paludis
 {
@@ -40,6 +42,16 @@ namespace paludis
 
                 const std::string get(const std::string & algo, const FSPath & file, SafeIFStream & stream) const;
 
+                /**
+                 * As get, but for several algorithms at once. Any digests not
+                 * already memoised are calculated in a single pass over the
+                 * stream.
+                 *
+                 * \since 2.4
+                 */
+                const std::map<std::string, std::string> get_all(const std::set<std::string> & algos,
+                        const FSPath & file, SafeIFStream & stream) const;
+
             private:
                 MemoisedHashes();
                 ~MemoisedHashes();
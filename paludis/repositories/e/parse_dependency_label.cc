@@ -165,7 +165,7 @@ paludis::erepository::parse_dependency_label(
         const std::string & s,
         const EAPI & e)
 {
-    Context context("When parsing label string '" + s + "' using EAPI '" + e.name() + "':");
+    Context context("When parsing label string '", s, "' using EAPI '", e.name(), "':");
 
     if (s.empty())
         throw EDepParseError(s, "Empty label");
@@ -75,7 +75,7 @@ namespace
 std::shared_ptr<URILabelsDepSpec>
 paludis::erepository::parse_uri_label(const std::string & s, const EAPI & e)
 {
-    Context context("When parsing label string '" + s + "' using EAPI '" + e.name() + "':");
+    Context context("When parsing label string '", s, "' using EAPI '", e.name(), "':");
 
     if (s.empty())
         throw EDepParseError(s, "Empty label");
@@ -48,12 +48,17 @@ ProfileFactory::create(
         const std::string & arch_var_if_special,
         const bool profiles_explicitly_set,
         const bool has_master_repositories,
-        const bool ignore_deprecated_profiles) const
+        const bool ignore_deprecated_profiles,
+        const FSPath & profiles_cache,
+        const std::string & profile_eapi_when_unspecified,
+        const FSPath & layout_conf) const
 {
     if (format == "traditional")
-        return std::make_shared<TraditionalProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles);
+        return std::make_shared<TraditionalProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles, profiles_cache,
+                profile_eapi_when_unspecified, layout_conf);
     if (format == "exheres")
-        return std::make_shared<ExheresProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles);
+        return std::make_shared<ExheresProfile>(env, name, eapi_for_file, is_arch_flag, dirs, arch_var_if_special, profiles_explicitly_set, has_master_repositories, ignore_deprecated_profiles, profiles_cache,
+                profile_eapi_when_unspecified, layout_conf);
 
     throw ConfigurationError("Unrecognised profile '" + format + "'");
 }
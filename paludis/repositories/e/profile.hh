@@ -31,6 +31,7 @@
 #include <paludis/util/tribool.hh>
 #include <paludis/util/wrapped_forward_iterator-fwd.hh>
 #include <paludis/util/map-fwd.hh>
+#include <paludis/util/fs_path-fwd.hh>
 #include <paludis/util/singleton.hh>
 #include <paludis/repositories/e/ebuild_id.hh>
 #include <paludis/repositories/e/mask_info.hh>
@@ -119,7 +120,10 @@ namespace paludis
                         const std::string & arch_var_if_special,
                         const bool profiles_explicitly_set,
                         const bool has_master_repositories,
-                        const bool ignore_deprecated_profiles
+                        const bool ignore_deprecated_profiles,
+                        const FSPath & profiles_cache,
+                        const std::string & profile_eapi_when_unspecified,
+                        const FSPath & layout_conf
                         ) const PALUDIS_ATTRIBUTE((warn_unused_result));
         };
     }
@@ -0,0 +1,313 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/profile_snapshot.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <iterator>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    const std::string magic("paludis-profile-snapshot-1");
+
+    std::string signature(const FSPath & f)
+    {
+        FSStat s(f);
+        if (! s.exists())
+            return "-";
+
+        return stringify(s.mtim().seconds()) + "." + stringify(s.mtim().nanoseconds()) + ":" +
+            stringify(s.lowlevel_id().first) + ":" + stringify(s.lowlevel_id().second) + ":" +
+            stringify(s.is_regular_file() ? s.file_size() : 0);
+    }
+
+    bool parse_count(const std::string & v, std::size_t & n)
+    {
+        if (v.empty() || std::string::npos != v.find_first_not_of("0123456789"))
+            return false;
+
+        std::istringstream s(v);
+        return bool(s >> n);
+    }
+
+    void write_string(std::ostream & s, const std::string & v)
+    {
+        s << v.length() << ' ' << v << '\n';
+    }
+
+    struct Reader
+    {
+        const std::string & text;
+        std::string::size_type pos;
+
+        Reader(const std::string & t) :
+            text(t),
+            pos(0)
+        {
+        }
+
+        bool read(std::string & v)
+        {
+            std::string::size_type space(text.find(' ', pos));
+            if (std::string::npos == space || space == pos)
+                return false;
+
+            std::string::size_type len(0);
+            for (std::string::size_type p(pos) ; p != space ; ++p)
+            {
+                if (text[p] < '0' || text[p] > '9')
+                    return false;
+                len = len * 10 + (text[p] - '0');
+            }
+
+            if (text.length() - space - 1 < len + 1 || '\n' != text[space + 1 + len])
+                return false;
+
+            v = text.substr(space + 1, len);
+            pos = space + 2 + len;
+            return true;
+        }
+
+        bool read_count(std::size_t & n)
+        {
+            std::string v;
+            return read(v) && parse_count(v, n);
+        }
+    };
+}
+
+ProfileSnapshotError::ProfileSnapshotError(const std::string & s) noexcept :
+    Exception(s)
+{
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ProfileSnapshot>
+    {
+        const std::string key;
+        std::vector<std::pair<std::string, std::string> > dependencies;
+        std::vector<std::string> values;
+        std::vector<std::string>::size_type next_value;
+
+        Imp(const std::string & k) :
+            key(k),
+            next_value(0)
+        {
+        }
+    };
+}
+
+ProfileSnapshot::ProfileSnapshot(const std::string & k) :
+    _imp(k)
+{
+}
+
+ProfileSnapshot::~ProfileSnapshot() = default;
+
+void
+ProfileSnapshot::add_dependency(const FSPath & f)
+{
+    _imp->dependencies.push_back(std::make_pair(stringify(f), signature(f)));
+}
+
+void
+ProfileSnapshot::add_value(const std::string & v)
+{
+    _imp->values.push_back(v);
+}
+
+void
+ProfileSnapshot::add_values(const std::vector<std::string> & v)
+{
+    _imp->values.push_back(stringify(v.size()));
+    _imp->values.insert(_imp->values.end(), v.begin(), v.end());
+}
+
+void
+ProfileSnapshot::save(const FSPath & location) const
+{
+    Context context("When saving profile snapshot to '" + stringify(location) + "':");
+
+    FSPath temp(location.dirname() / ("." + location.basename() + ".new"));
+    try
+    {
+        location.dirname().mkdir(0755, { fspmkdo_ok_if_exists });
+
+        {
+            SafeOFStream file(temp, -1, true);
+            write_string(file, magic);
+            write_string(file, _imp->key);
+
+            write_string(file, stringify(_imp->dependencies.size()));
+            for (auto d(_imp->dependencies.begin()), d_end(_imp->dependencies.end()) ;
+                    d != d_end ; ++d)
+            {
+                write_string(file, d->first);
+                write_string(file, d->second);
+            }
+
+            write_string(file, stringify(_imp->values.size()));
+            for (auto v(_imp->values.begin()), v_end(_imp->values.end()) ;
+                    v != v_end ; ++v)
+                write_string(file, *v);
+        }
+
+        temp.rename(location);
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.save.failure", ll_warning, lc_context) << "Couldn't write profile snapshot '"
+            << location << "': " << e.message() << " (" << e.what() << ")";
+    }
+    catch (const FSError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.save.failure", ll_warning, lc_context) << "Couldn't write profile snapshot '"
+            << location << "': " << e.message() << " (" << e.what() << ")";
+    }
+}
+
+const std::shared_ptr<ProfileSnapshot>
+ProfileSnapshot::load(const FSPath & location, const std::string & key)
+{
+    Context context("When loading profile snapshot '" + stringify(location) + "':");
+
+    if (! location.stat().is_regular_file_or_symlink_to_regular_file())
+        return nullptr;
+
+    std::string text;
+    try
+    {
+        SafeIFStream file(location);
+        text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+    catch (const SafeIFStreamError & e)
+    {
+        Log::get_instance()->message("e.profile.snapshot.load.failure", ll_warning, lc_context) << "Couldn't read profile snapshot '"
+            << location << "': " << e.message() << " (" << e.what() << ")";
+        return nullptr;
+    }
+
+    Reader reader(text);
+    std::string v;
+    if ((! reader.read(v)) || v != magic)
+    {
+        Log::get_instance()->message("e.profile.snapshot.load.bad_format", ll_debug, lc_context)
+            << "Not using profile snapshot '" << location << "' because it is not in a format we understand";
+        return nullptr;
+    }
+
+    if ((! reader.read(v)) || v != key)
+    {
+        Log::get_instance()->message("e.profile.snapshot.load.different_key", ll_debug, lc_context)
+            << "Not using profile snapshot '" << location << "' because it is for a different profile configuration";
+        return nullptr;
+    }
+
+    std::shared_ptr<ProfileSnapshot> result(std::make_shared<ProfileSnapshot>(key));
+
+    std::size_t n;
+    if (! reader.read_count(n))
+        return nullptr;
+
+    for ( ; n > 0 ; --n)
+    {
+        std::string f, s;
+        if ((! reader.read(f)) || (! reader.read(s)))
+            return nullptr;
+
+        if (signature(FSPath(f)) != s)
+        {
+            Log::get_instance()->message("e.profile.snapshot.load.stale", ll_debug, lc_context)
+                << "Not using profile snapshot '" << location << "' because '" << f << "' has changed";
+            return nullptr;
+        }
+
+        result->_imp->dependencies.push_back(std::make_pair(f, s));
+    }
+
+    if (! reader.read_count(n))
+        return nullptr;
+
+    result->_imp->values.reserve(n);
+    for ( ; n > 0 ; --n)
+    {
+        if (! reader.read(v))
+            return nullptr;
+        result->_imp->values.push_back(v);
+    }
+
+    if (reader.pos != text.length())
+        return nullptr;
+
+    return result;
+}
+
+const std::string
+ProfileSnapshot::next_value()
+{
+    if (_imp->next_value >= _imp->values.size())
+        throw ProfileSnapshotError("Profile snapshot has too few values");
+
+    return _imp->values[_imp->next_value++];
+}
+
+const std::vector<std::string>
+ProfileSnapshot::next_values()
+{
+    std::string n_s(next_value());
+    std::size_t n;
+    if (! parse_count(n_s, n))
+        throw ProfileSnapshotError("Profile snapshot has a bad count '" + n_s + "'");
+
+    if (_imp->values.size() - _imp->next_value < n)
+        throw ProfileSnapshotError("Profile snapshot has too few values");
+
+    std::vector<std::string> result(_imp->values.begin() + _imp->next_value, _imp->values.begin() + _imp->next_value + n);
+    _imp->next_value += n;
+    return result;
+}
+
+void
+ProfileSnapshot::check_finished() const
+{
+    if (_imp->next_value != _imp->values.size())
+        throw ProfileSnapshotError("Profile snapshot has too many values");
+}
+
+namespace paludis
+{
+    template class Pimp<ProfileSnapshot>;
+}
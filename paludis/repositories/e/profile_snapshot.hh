@@ -0,0 +1,138 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_PROFILE_SNAPSHOT_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_PROFILE_SNAPSHOT_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Thrown if a ProfileSnapshot does not contain what its reader
+         * expected.
+         *
+         * \ingroup grperepository
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE ProfileSnapshotError :
+            public Exception
+        {
+            public:
+                ProfileSnapshotError(const std::string &) noexcept;
+        };
+
+        /**
+         * A saved copy of the data read when loading a profile, which can be
+         * reused for as long as none of the files which contributed to it
+         * have changed.
+         *
+         * A snapshot is a key, describing how the profile was asked for, a
+         * list of contributing files along with their mtimes, inodes and
+         * sizes, and a sequence of string values whose meaning is up to the
+         * profile class which wrote it.
+         *
+         * \see TraditionalProfile
+         * \see ExheresProfile
+         * \ingroup grperepository
+         * \nosubgrouping
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE ProfileSnapshot
+        {
+            private:
+                Pimp<ProfileSnapshot> _imp;
+
+            public:
+                ///\name Basic operations
+                ///\{
+
+                explicit ProfileSnapshot(const std::string & key);
+                ~ProfileSnapshot();
+
+                ProfileSnapshot(const ProfileSnapshot &) = delete;
+                ProfileSnapshot & operator= (const ProfileSnapshot &) = delete;
+
+                ///\}
+
+                ///\name Building a snapshot
+                ///\{
+
+                /**
+                 * Record that a file, which may not exist, contributed to the
+                 * profile.
+                 */
+                void add_dependency(const FSPath &);
+
+                void add_value(const std::string &);
+
+                void add_values(const std::vector<std::string> &);
+
+                /**
+                 * Write ourself to a file. Failures are logged, not thrown.
+                 */
+                void save(const FSPath &) const;
+
+                ///\}
+
+                ///\name Reading a snapshot
+                ///\{
+
+                /**
+                 * Load a snapshot, or return null if there is no usable
+                 * snapshot with the specified key, or if any of its
+                 * contributing files have changed.
+                 */
+                static const std::shared_ptr<ProfileSnapshot> load(const FSPath &, const std::string & key)
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * \throw ProfileSnapshotError if there are no values left.
+                 */
+                const std::string next_value() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Read a sequence written by add_values.
+                 *
+                 * \throw ProfileSnapshotError if there are no values left.
+                 */
+                const std::vector<std::string> next_values() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * \throw ProfileSnapshotError if there are values left.
+                 */
+                void check_finished() const;
+
+                ///\}
+        };
+    }
+
+    extern template class Pimp<erepository::ProfileSnapshot>;
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include <paludis/repositories/e/e_repository_exceptions.hh>
 #include <paludis/repositories/e/e_repository.hh>
 #include <paludis/repositories/e/eapi.hh>
+#include <paludis/repositories/e/profile_snapshot.hh>
 
 #include <paludis/util/log.hh>
 #include <paludis/util/tokeniser.hh>
@@ -43,6 +44,8 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/upper_lower.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/destringify.hh>
 
 #include <paludis/choice.hh>
 #include <paludis/environment.hh>
@@ -50,12 +53,14 @@
 #include <paludis/distribution.hh>
 #include <paludis/package_id.hh>
 #include <paludis/metadata_key.hh>
+#include <paludis/about.hh>
 
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
 #include <algorithm>
 #include <set>
+#include <map>
 #include <vector>
 #include <mutex>
 
@@ -97,6 +102,31 @@ namespace
     };
 
     typedef std::list<StackedValues> StackedValuesList;
+
+    struct ProfileDirectoryLines
+    {
+        FSPath dir;
+        std::shared_ptr<const EAPI> eapi;
+
+        std::vector<std::string> use_mask;
+        std::vector<std::string> use_stable_mask;
+        std::vector<std::string> use_force;
+        std::vector<std::string> use_stable_force;
+        std::vector<std::string> package_use;
+        std::vector<std::string> package_use_mask;
+        std::vector<std::string> package_use_stable_mask;
+        std::vector<std::string> package_use_force;
+        std::vector<std::string> package_use_stable_force;
+
+        ProfileDirectoryLines(const FSPath & d, const std::shared_ptr<const EAPI> & e) :
+            dir(d),
+            eapi(e)
+        {
+        }
+    };
+
+    typedef std::list<std::pair<std::shared_ptr<const EAPI>, std::string> > PackagesLines;
+    typedef std::list<std::pair<std::shared_ptr<const EAPI>, std::pair<std::string, std::shared_ptr<const MaskInfo> > > > PackageMaskLines;
 }
 
 namespace paludis
@@ -132,6 +162,12 @@ namespace paludis
 
         PackageMaskMap package_mask;
 
+        std::list<ProfileDirectoryLines> directory_lines;
+        std::shared_ptr<const EAPI> make_defaults_eapi;
+        PackagesLines packages_lines;
+        PackageMaskLines package_mask_lines;
+        std::shared_ptr<ProfileSnapshot> snapshot;
+
         Imp(const Environment * const e,
                 const EAPIForFileFunction & p,
                 const IsArchFlagFunction & a,
@@ -183,14 +219,27 @@ namespace
             Pimp<TraditionalProfile> & _imp,
             const FSPath & dir);
 
-    void load_basic_use_file(
+    void load_use_expand_vars(
+            Pimp<TraditionalProfile> & _imp,
+            const EAPI & eapi);
+
+    const std::vector<std::string> load_use_file_lines(
+            const FSPath & file);
+
+    void load_basic_use_lines(
             const FSPath & file,
+            const std::vector<std::string> & lines,
             FlagStatusMap & m);
 
-    void load_spec_use_file(
+    void load_spec_use_lines(
             const EAPI & eapi,
             const FSPath & file,
+            const std::vector<std::string> & lines,
             PackageFlagStatusMapList & m);
+
+    void add_stacked_values(
+            Pimp<TraditionalProfile> & _imp,
+            const ProfileDirectoryLines & lines);
 }
 
 namespace
@@ -207,6 +256,9 @@ namespace
     {
         Context context("When adding profile directory '" + stringify(dir) + ":");
 
+        if (_imp->snapshot)
+            _imp->snapshot->add_dependency(dir);
+
         if (! dir.stat().is_directory_or_symlink_to_directory())
         {
             Log::get_instance()->message("e.profile.not_a_directory", ll_warning, lc_context)
@@ -219,22 +271,32 @@ namespace
             throw ERepositoryConfigurationError("Can't use profile directory '" + stringify(dir) +
                     "' because it uses an unsupported EAPI");
 
+        if (_imp->snapshot)
+            for (auto & f : { "eapi", "parent", "make.defaults", "use.mask", "use.force", "package.use", "package.use.mask",
+                    "package.use.force", "use.stable.mask", "use.stable.force", "package.use.stable.mask",
+                    "package.use.stable.force", "packages", "package.mask" })
+                _imp->snapshot->add_dependency(dir / f);
+
         load_profile_parent(_imp, dir);
         load_profile_make_defaults(_imp, dir);
 
-        _imp->stacked_values_list.push_back(StackedValues(stringify(dir)));
-        load_basic_use_file(dir / "use.mask", _imp->stacked_values_list.back().use_mask);
-        load_basic_use_file(dir / "use.force", _imp->stacked_values_list.back().use_force);
-        load_spec_use_file(*eapi, dir / "package.use", _imp->stacked_values_list.back().package_use);
-        load_spec_use_file(*eapi, dir / "package.use.mask", _imp->stacked_values_list.back().package_use_mask);
-        load_spec_use_file(*eapi, dir / "package.use.force", _imp->stacked_values_list.back().package_use_force);
+        ProfileDirectoryLines lines(dir, eapi);
+        lines.use_mask = load_use_file_lines(dir / "use.mask");
+        lines.use_force = load_use_file_lines(dir / "use.force");
+        lines.package_use = load_use_file_lines(dir / "package.use");
+        lines.package_use_mask = load_use_file_lines(dir / "package.use.mask");
+        lines.package_use_force = load_use_file_lines(dir / "package.use.force");
         if (eapi->supported()->profile_options()->use_stable_mask_force())
         {
-            load_basic_use_file(dir / "use.stable.mask", _imp->stacked_values_list.back().use_stable_mask);
-            load_basic_use_file(dir / "use.stable.force", _imp->stacked_values_list.back().use_stable_force);
-            load_spec_use_file(*eapi, dir / "package.use.stable.mask", _imp->stacked_values_list.back().package_use_stable_mask);
-            load_spec_use_file(*eapi, dir / "package.use.stable.force", _imp->stacked_values_list.back().package_use_stable_force);
+            lines.use_stable_mask = load_use_file_lines(dir / "use.stable.mask");
+            lines.use_stable_force = load_use_file_lines(dir / "use.stable.force");
+            lines.package_use_stable_mask = load_use_file_lines(dir / "package.use.stable.mask");
+            lines.package_use_stable_force = load_use_file_lines(dir / "package.use.stable.force");
         }
+        add_stacked_values(_imp, lines);
+
+        if (_imp->snapshot)
+            _imp->directory_lines.push_back(lines);
 
         _imp->packages_file.add_file(dir / "packages");
         _imp->package_mask_file.add_file(dir / "package.mask");
@@ -242,6 +304,26 @@ namespace
         _imp->profiles_with_parents->push_back(dir);
     }
 
+    void add_stacked_values(
+            Pimp<TraditionalProfile> & _imp,
+            const ProfileDirectoryLines & lines)
+    {
+        _imp->stacked_values_list.push_back(StackedValues(stringify(lines.dir)));
+        load_basic_use_lines(lines.dir / "use.mask", lines.use_mask, _imp->stacked_values_list.back().use_mask);
+        load_basic_use_lines(lines.dir / "use.force", lines.use_force, _imp->stacked_values_list.back().use_force);
+        load_spec_use_lines(*lines.eapi, lines.dir / "package.use", lines.package_use, _imp->stacked_values_list.back().package_use);
+        load_spec_use_lines(*lines.eapi, lines.dir / "package.use.mask", lines.package_use_mask,
+                _imp->stacked_values_list.back().package_use_mask);
+        load_spec_use_lines(*lines.eapi, lines.dir / "package.use.force", lines.package_use_force,
+                _imp->stacked_values_list.back().package_use_force);
+        load_basic_use_lines(lines.dir / "use.stable.mask", lines.use_stable_mask, _imp->stacked_values_list.back().use_stable_mask);
+        load_basic_use_lines(lines.dir / "use.stable.force", lines.use_stable_force, _imp->stacked_values_list.back().use_stable_force);
+        load_spec_use_lines(*lines.eapi, lines.dir / "package.use.stable.mask", lines.package_use_stable_mask,
+                _imp->stacked_values_list.back().package_use_stable_mask);
+        load_spec_use_lines(*lines.eapi, lines.dir / "package.use.stable.force", lines.package_use_stable_force,
+                _imp->stacked_values_list.back().package_use_stable_force);
+    }
+
     void load_profile_parent(
             Pimp<TraditionalProfile> & _imp,
             const FSPath & dir)
@@ -295,8 +377,8 @@ namespace
         try
         {
             if (! _imp->has_master_repositories)
-                for (TraditionalProfileFile<LineConfigFile>::ConstIterator i(_imp->packages_file.begin()),
-                        i_end(_imp->packages_file.end()) ; i != i_end ; ++i)
+                for (PackagesLines::const_iterator i(_imp->packages_lines.begin()),
+                        i_end(_imp->packages_lines.end()) ; i != i_end ; ++i)
                 {
                     if (0 != i->second.compare(0, 1, "*", 0, 1))
                         continue;
@@ -320,7 +402,7 @@ namespace
                     " failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
 
-        for (TraditionalProfileFile<TraditionalMaskFile>::ConstIterator line(_imp->package_mask_file.begin()), line_end(_imp->package_mask_file.end()) ;
+        for (PackageMaskLines::const_iterator line(_imp->package_mask_lines.begin()), line_end(_imp->package_mask_lines.end()) ;
                 line != line_end ; ++line)
         {
             if (line->second.first.empty())
@@ -550,7 +632,15 @@ namespace
                 _imp->environment_variables[k->first] = k->second;
         }
 
-        std::string use_expand_var(eapi->supported()->ebuild_environment_variables()->env_use_expand());
+        _imp->make_defaults_eapi = eapi;
+        load_use_expand_vars(_imp, *eapi);
+    }
+
+    void load_use_expand_vars(
+            Pimp<TraditionalProfile> & _imp,
+            const EAPI & eapi)
+    {
+        std::string use_expand_var(eapi.supported()->ebuild_environment_variables()->env_use_expand());
         try
         {
             _imp->use_expand->clear();
@@ -567,7 +657,7 @@ namespace
                 << "Loading '" << use_expand_var << "' failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
 
-        std::string use_expand_unprefixed_var(eapi->supported()->ebuild_environment_variables()->env_use_expand_unprefixed());
+        std::string use_expand_unprefixed_var(eapi.supported()->ebuild_environment_variables()->env_use_expand_unprefixed());
         try
         {
             _imp->use_expand_unprefixed->clear();
@@ -584,7 +674,7 @@ namespace
                 << "Loading '" << use_expand_unprefixed_var << "' failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
 
-        std::string use_expand_implicit_var(eapi->supported()->ebuild_environment_variables()->env_use_expand_implicit());
+        std::string use_expand_implicit_var(eapi.supported()->ebuild_environment_variables()->env_use_expand_implicit());
         try
         {
             _imp->use_expand_implicit->clear();
@@ -601,7 +691,7 @@ namespace
                 << "Loading '" << use_expand_implicit_var << "' failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
 
-        std::string iuse_implicit_var(eapi->supported()->ebuild_environment_variables()->env_iuse_implicit());
+        std::string iuse_implicit_var(eapi.supported()->ebuild_environment_variables()->env_iuse_implicit());
         try
         {
             _imp->iuse_implicit->clear();
@@ -618,7 +708,7 @@ namespace
                 << "Loading '" << iuse_implicit_var << "' failed due to exception: " << e.message() << " (" << e.what() << ")";
         }
 
-        std::string use_expand_values_part_var(eapi->supported()->ebuild_environment_variables()->env_use_expand_values_part());
+        std::string use_expand_values_part_var(eapi.supported()->ebuild_environment_variables()->env_use_expand_values_part());
         try
         {
             _imp->use_expand_values.clear();
@@ -652,16 +742,29 @@ namespace
         }
     }
 
-    void load_basic_use_file(
+    const std::vector<std::string> load_use_file_lines(
+            const FSPath & file)
+    {
+        std::vector<std::string> result;
+        if (! file.stat().exists())
+            return result;
+
+        Context context("When reading use file '" + stringify(file) + ":");
+        LineConfigFile f(file, { lcfo_disallow_continuations });
+        std::copy(f.begin(), f.end(), std::back_inserter(result));
+        return result;
+    }
+
+    void load_basic_use_lines(
             const FSPath & file,
+            const std::vector<std::string> & lines,
             FlagStatusMap & m)
     {
-        if (! file.stat().exists())
+        if (lines.empty())
             return;
 
         Context context("When loading basic use file '" + stringify(file) + ":");
-        LineConfigFile f(file, { lcfo_disallow_continuations });
-        for (LineConfigFile::ConstIterator line(f.begin()), line_end(f.end()) ;
+        for (std::vector<std::string>::const_iterator line(lines.begin()), line_end(lines.end()) ;
                 line != line_end ; ++line)
         {
             std::list<std::string> tokens;
@@ -692,17 +795,17 @@ namespace
         }
     }
 
-    void load_spec_use_file(
+    void load_spec_use_lines(
             const EAPI & eapi,
             const FSPath & file,
+            const std::vector<std::string> & lines,
             PackageFlagStatusMapList & m)
     {
-        if (! file.stat().exists())
+        if (lines.empty())
             return;
 
         Context context("When loading specised use file '" + stringify(file) + ":");
-        LineConfigFile f(file, { lcfo_disallow_continuations });
-        for (LineConfigFile::ConstIterator line(f.begin()), line_end(f.end()) ;
+        for (std::vector<std::string>::const_iterator line(lines.begin()), line_end(lines.end()) ;
                 line != line_end ; ++line)
         {
             std::list<std::string> tokens;
@@ -750,6 +853,203 @@ namespace
     }
 }
 
+namespace
+{
+    const std::string snapshot_key(
+            const FSPathSequence & dirs,
+            const std::string & arch_var_if_special,
+            const bool has_master_repositories,
+            const std::string & profile_eapi_when_unspecified)
+    {
+        return "traditional " + stringify(PALUDIS_VERSION) + PALUDIS_VERSION_SUFFIX + " " + PALUDIS_GIT_HEAD
+            + "\n" + join(dirs.begin(), dirs.end(), "\n")
+            + "\n" + arch_var_if_special
+            + "\n" + stringify(has_master_repositories)
+            + "\n" + profile_eapi_when_unspecified
+            + "\n" + getenv_with_default("CONFIG_PROTECT", "/etc")
+            + "\n" + getenv_with_default("CONFIG_PROTECT_MASK", "");
+    }
+
+    void save_snapshot(
+            Pimp<TraditionalProfile> & _imp,
+            const FSPath & location)
+    {
+        ProfileSnapshot & snapshot(*_imp->snapshot);
+
+        std::vector<std::string> dirs;
+        for (auto d(_imp->directory_lines.begin()), d_end(_imp->directory_lines.end()) ;
+                d != d_end ; ++d)
+            dirs.push_back(stringify(d->dir));
+        snapshot.add_values(dirs);
+
+        for (auto d(_imp->directory_lines.begin()), d_end(_imp->directory_lines.end()) ;
+                d != d_end ; ++d)
+        {
+            snapshot.add_value(d->eapi->name());
+            snapshot.add_values(d->use_mask);
+            snapshot.add_values(d->use_stable_mask);
+            snapshot.add_values(d->use_force);
+            snapshot.add_values(d->use_stable_force);
+            snapshot.add_values(d->package_use);
+            snapshot.add_values(d->package_use_mask);
+            snapshot.add_values(d->package_use_stable_mask);
+            snapshot.add_values(d->package_use_force);
+            snapshot.add_values(d->package_use_stable_force);
+        }
+
+        std::vector<std::string> vars;
+        for (auto v(_imp->environment_variables.begin()), v_end(_imp->environment_variables.end()) ;
+                v != v_end ; ++v)
+        {
+            vars.push_back(v->first);
+            vars.push_back(v->second);
+        }
+        snapshot.add_values(vars);
+        snapshot.add_value(_imp->make_defaults_eapi ? _imp->make_defaults_eapi->name() : "");
+
+        std::vector<std::string> packages;
+        for (auto p(_imp->packages_lines.begin()), p_end(_imp->packages_lines.end()) ;
+                p != p_end ; ++p)
+        {
+            packages.push_back(p->first->name());
+            packages.push_back(p->second);
+        }
+        snapshot.add_values(packages);
+
+        /* lots of package.mask lines share a MaskInfo, so only write each one once */
+        std::map<const MaskInfo *, std::size_t> info_indices;
+        std::vector<std::string> infos, masks;
+        for (auto m(_imp->package_mask_lines.begin()), m_end(_imp->package_mask_lines.end()) ;
+                m != m_end ; ++m)
+        {
+            auto i(info_indices.find(m->second.second.get()));
+            if (info_indices.end() == i)
+            {
+                i = info_indices.insert(std::make_pair(m->second.second.get(), infos.size() / 3)).first;
+                infos.push_back(m->second.second->comment());
+                infos.push_back(stringify(m->second.second->mask_file()));
+                infos.push_back(m->second.second->token());
+            }
+
+            masks.push_back(m->first->name());
+            masks.push_back(m->second.first);
+            masks.push_back(stringify(i->second));
+        }
+        snapshot.add_values(infos);
+        snapshot.add_values(masks);
+
+        snapshot.save(location);
+    }
+
+    std::shared_ptr<const EAPI> snapshot_eapi(const std::string & name)
+    {
+        auto eapi(EAPIData::get_instance()->eapi_from_string(name));
+        if (! eapi->supported())
+            throw ProfileSnapshotError("Profile snapshot uses unsupported EAPI '" + name + "'");
+        return eapi;
+    }
+
+    void load_from_snapshot(
+            Pimp<TraditionalProfile> & _imp,
+            ProfileSnapshot & snapshot)
+    {
+        std::list<ProfileDirectoryLines> directory_lines;
+        std::vector<std::string> dirs(snapshot.next_values());
+        for (auto d(dirs.begin()), d_end(dirs.end()) ;
+                d != d_end ; ++d)
+        {
+            ProfileDirectoryLines lines(FSPath(*d), snapshot_eapi(snapshot.next_value()));
+            if (lines.eapi->name() != _imp->eapi_for_file(lines.dir / "use.mask"))
+                throw ProfileSnapshotError("EAPI for profile directory '" + *d + "' has changed");
+
+            lines.use_mask = snapshot.next_values();
+            lines.use_stable_mask = snapshot.next_values();
+            lines.use_force = snapshot.next_values();
+            lines.use_stable_force = snapshot.next_values();
+            lines.package_use = snapshot.next_values();
+            lines.package_use_mask = snapshot.next_values();
+            lines.package_use_stable_mask = snapshot.next_values();
+            lines.package_use_force = snapshot.next_values();
+            lines.package_use_stable_force = snapshot.next_values();
+            directory_lines.push_back(lines);
+        }
+
+        std::vector<std::string> vars(snapshot.next_values());
+        if (0 != vars.size() % 2)
+            throw ProfileSnapshotError("Profile snapshot has bad environment variables");
+
+        std::string make_defaults_eapi_name(snapshot.next_value());
+        std::shared_ptr<const EAPI> make_defaults_eapi;
+        if (! make_defaults_eapi_name.empty())
+            make_defaults_eapi = snapshot_eapi(make_defaults_eapi_name);
+
+        std::vector<std::string> packages(snapshot.next_values());
+        if (0 != packages.size() % 2)
+            throw ProfileSnapshotError("Profile snapshot has bad packages lines");
+
+        PackagesLines packages_lines;
+        for (auto p(packages.begin()), p_end(packages.end()) ;
+                p != p_end ; p += 2)
+            packages_lines.push_back(std::make_pair(snapshot_eapi(*p), *next(p)));
+
+        std::vector<std::string> infos(snapshot.next_values());
+        if (0 != infos.size() % 3)
+            throw ProfileSnapshotError("Profile snapshot has bad package.mask information");
+
+        std::vector<std::shared_ptr<const MaskInfo> > mask_infos;
+        for (auto i(infos.begin()), i_end(infos.end()) ;
+                i != i_end ; i += 3)
+            mask_infos.push_back(std::make_shared<MaskInfo>(make_named_values<MaskInfo>(
+                            n::comment() = *i,
+                            n::mask_file() = FSPath(*next(i)),
+                            n::token() = *next(i, 2)
+                            )));
+
+        std::vector<std::string> masks(snapshot.next_values());
+        if (0 != masks.size() % 3)
+            throw ProfileSnapshotError("Profile snapshot has bad package.mask lines");
+
+        PackageMaskLines package_mask_lines;
+        for (auto m(masks.begin()), m_end(masks.end()) ;
+                m != m_end ; m += 3)
+        {
+            std::size_t index;
+            try
+            {
+                index = destringify<std::size_t>(*next(m, 2));
+            }
+            catch (const DestringifyError &)
+            {
+                throw ProfileSnapshotError("Profile snapshot has a bad package.mask information index");
+            }
+
+            if (index >= mask_infos.size())
+                throw ProfileSnapshotError("Profile snapshot has a bad package.mask information index");
+
+            package_mask_lines.push_back(std::make_pair(snapshot_eapi(*m), std::make_pair(*next(m), mask_infos.at(index))));
+        }
+
+        snapshot.check_finished();
+
+        for (auto d(directory_lines.begin()), d_end(directory_lines.end()) ;
+                d != d_end ; ++d)
+        {
+            add_stacked_values(_imp, *d);
+            _imp->profiles_with_parents->push_back(d->dir);
+        }
+
+        for (auto v(vars.begin()), v_end(vars.end()) ;
+                v != v_end ; v += 2)
+            _imp->environment_variables[*v] = *next(v);
+
+        if (make_defaults_eapi)
+            load_use_expand_vars(_imp, *make_defaults_eapi);
+
+        _imp->packages_lines = packages_lines;
+        _imp->package_mask_lines = package_mask_lines;
+    }
+}
+
 TraditionalProfile::TraditionalProfile(
         const Environment * const env,
         const RepositoryName & name,
@@ -759,7 +1059,10 @@ TraditionalProfile::TraditionalProfile(
         const std::string & arch_var_if_special,
         const bool profiles_explicitly_set,
         const bool has_master_repositories,
-        const bool ignore_deprecated_profiles) :
+        const bool ignore_deprecated_profiles,
+        const FSPath & profiles_cache,
+        const std::string & profile_eapi_when_unspecified,
+        const FSPath & layout_conf) :
     _imp(env, eapi_for_file, is_arch_flag, has_master_repositories)
 {
     Context context("When loading profiles '" + join(dirs.begin(), dirs.end(), "' '") + "' for repository '" + stringify(name) + "':");
@@ -767,19 +1070,64 @@ TraditionalProfile::TraditionalProfile(
     if (dirs.empty())
         throw ERepositoryConfigurationError("No profiles directories specified");
 
-    load_environment(_imp);
-
-    for (FSPathSequence::ConstIterator d(dirs.begin()), d_end(dirs.end()) ;
-            d != d_end ; ++d)
-    {
-        Context subcontext("When using directory '" + stringify(*d) + "':");
-
-        if (profiles_explicitly_set && ! ignore_deprecated_profiles)
+    if (profiles_explicitly_set && ! ignore_deprecated_profiles)
+        for (FSPathSequence::ConstIterator d(dirs.begin()), d_end(dirs.end()) ;
+                d != d_end ; ++d)
             if ((*d / "deprecated").stat().is_regular_file_or_symlink_to_regular_file())
                 Log::get_instance()->message("e.profile.deprecated", ll_warning, lc_context) << "Profile directory '" << *d
                     << "' is deprecated. See the file '" << (*d / "deprecated") << "' for details";
 
-        load_profile_directory_recursively(_imp, *d);
+    bool use_snapshot(profiles_cache != FSPath("/var/empty")), loaded_from_snapshot(false);
+    std::string key(snapshot_key(dirs, arch_var_if_special, has_master_repositories, profile_eapi_when_unspecified));
+    FSPath snapshot_file(profiles_cache / (stringify(name) + ".profile"));
+
+    if (use_snapshot)
+    {
+        std::shared_ptr<ProfileSnapshot> snapshot(ProfileSnapshot::load(snapshot_file, key));
+        if (snapshot)
+        {
+            try
+            {
+                load_from_snapshot(_imp, *snapshot);
+                loaded_from_snapshot = true;
+            }
+            catch (const ProfileSnapshotError & e)
+            {
+                Log::get_instance()->message("e.profile.snapshot.load.bad_values", ll_debug, lc_context)
+                    << "Not using profile snapshot '" << snapshot_file << "' due to exception '" << e.message() << "' ("
+                    << e.what() << ")";
+            }
+        }
+    }
+
+    if (! loaded_from_snapshot)
+    {
+        if (use_snapshot)
+        {
+            /* directories without an eapi file use the fallback EAPI, which
+             * can come from layout.conf */
+            _imp->snapshot = std::make_shared<ProfileSnapshot>(key);
+            _imp->snapshot->add_dependency(layout_conf);
+        }
+
+        load_environment(_imp);
+
+        for (FSPathSequence::ConstIterator d(dirs.begin()), d_end(dirs.end()) ;
+                d != d_end ; ++d)
+        {
+            Context subcontext("When using directory '" + stringify(*d) + "':");
+            load_profile_directory_recursively(_imp, *d);
+        }
+
+        std::copy(_imp->packages_file.begin(), _imp->packages_file.end(), std::back_inserter(_imp->packages_lines));
+        std::copy(_imp->package_mask_file.begin(), _imp->package_mask_file.end(), std::back_inserter(_imp->package_mask_lines));
+
+        if (_imp->snapshot)
+        {
+            save_snapshot(_imp, snapshot_file);
+            _imp->snapshot.reset();
+            _imp->directory_lines.clear();
+        }
     }
 
     make_vars_from_file_vars(_imp);
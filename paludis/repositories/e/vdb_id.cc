@@ -24,12 +24,14 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/log.hh>
-#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/mapped_file.hh>
 #include <paludis/util/destringify.hh>
 #include <paludis/util/timestamp.hh>
 #include <paludis/contents.hh>
 #include <paludis/literal_metadata_key.hh>
 
+#include <functional>
+#include <cstring>
 #include <vector>
 
 using namespace paludis;
@@ -61,69 +63,101 @@ VDBID::contents_filename() const
     return "CONTENTS";
 }
 
-const std::shared_ptr<const Contents>
-VDBID::contents() const
+namespace
 {
     // NOTE(compnerd) VDB does not support parts
-    static const std::string kNoPart = "";
+    const std::string kNoPart = "";
 
-    FSPath contents_location(fs_location_key()->parse_value() / "CONTENTS");
-    Context context("When creating contents from '" + stringify(contents_location) + "':");
-
-    auto value(std::make_shared<Contents>());
-
-    if (! contents_location.stat().is_regular_file_or_symlink_to_regular_file())
+    /* calls f with the tokens of each line of a CONTENTS file that we know
+     * how to handle, stopping early if it returns false */
+    void each_contents_line(const FSPath & contents_location, const std::function<bool (const std::vector<std::string> &)> & f)
     {
-        Log::get_instance()->message("e.contents.not_a_file", ll_warning, lc_context) << "Could not read CONTENTS file '" <<
-            contents_location << "'";
-        return value;
-    }
-
-    SafeIFStream ff(contents_location);
+        Context context("When creating contents from '" + stringify(contents_location) + "':");
 
-    std::string line;
-    unsigned line_number(0);
-    while (std::getline(ff, line))
-    {
-        ++line_number;
-
-        std::vector<std::string> tokens;
-        if (! VDBContentsTokeniser::tokenise(line, std::back_inserter(tokens)))
+        if (! contents_location.stat().is_regular_file_or_symlink_to_regular_file())
         {
-            Log::get_instance()->message("e.contents.broken", ll_warning, lc_context) << "CONTENTS has broken line '" <<
-                line_number << "', skipping";
-            continue;
+            Log::get_instance()->message("e.contents.not_a_file", ll_warning, lc_context) << "Could not read CONTENTS file '" <<
+                contents_location << "'";
+            return;
         }
 
-        if ("obj" == tokens.at(0))
-        {
-            auto e(std::make_shared<ContentsFileEntry>(FSPath(tokens.at(1)),
-                                                       kNoPart));
-            e->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
-                            Timestamp(destringify<time_t>(tokens.at(3)), 0)));
-            e->add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string>>("md5", "md5", mkt_normal, tokens.at(2)));
-            value->add(e);
-        }
-        else if ("dir" == tokens.at(0))
-        {
-            std::shared_ptr<ContentsEntry> e(std::make_shared<ContentsDirEntry>(FSPath(tokens.at(1))));
-            value->add(e);
-        }
-        else if ("sym" == tokens.at(0))
+        MappedFile m(contents_location);
+
+        std::vector<std::string> tokens;
+        unsigned line_number(0);
+        for (const char * l(m.data()), * l_end(m.data() + m.size()) ; l != l_end ; )
         {
-            auto e(std::make_shared<ContentsSymEntry>(FSPath(tokens.at(1)),
-                                                      tokens.at(2), kNoPart));
-            e->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
-                            Timestamp(destringify<time_t>(tokens.at(3)), 0)));
-            value->add(e);
+            const char * e(static_cast<const char *>(std::memchr(l, '\n', l_end - l)));
+            std::string line(l, e ? e : l_end);
+            l = e ? e + 1 : l_end;
+            ++line_number;
+
+            tokens.clear();
+            if (! VDBContentsTokeniser::tokenise(line, std::back_inserter(tokens)))
+            {
+                Log::get_instance()->message("e.contents.broken", ll_warning, lc_context) << "CONTENTS has broken line '" <<
+                    line_number << "', skipping";
+                continue;
+            }
+
+            if ("obj" == tokens.at(0) || "dir" == tokens.at(0) || "sym" == tokens.at(0) ||
+                    "misc" == tokens.at(0) || "fif" == tokens.at(0) || "dev" == tokens.at(0))
+            {
+                if (! f(tokens))
+                    return;
+            }
+            else
+                Log::get_instance()->message("e.contents.unknown", ll_warning, lc_context) << "CONTENTS has unsupported entry type '" <<
+                    tokens.at(0) << "', skipping";
         }
-        else if ("misc" == tokens.at(0) || "fif" == tokens.at(0) || "dev" == tokens.at(0))
-            value->add(std::shared_ptr<ContentsEntry>(std::make_shared<ContentsOtherEntry>(FSPath(tokens.at(1)))));
-        else
-            Log::get_instance()->message("e.contents.unknown", ll_warning, lc_context) << "CONTENTS has unsupported entry type '" <<
-                tokens.at(0) << "', skipping";
     }
+}
+
+const std::shared_ptr<const Contents>
+VDBID::contents() const
+{
+    auto value(std::make_shared<Contents>());
+
+    each_contents_line(fs_location_key()->parse_value() / "CONTENTS", [&] (const std::vector<std::string> & tokens) {
+            if ("obj" == tokens.at(0))
+                value->add_file(FSPath(tokens.at(1)), kNoPart, tokens.at(2),
+                        Timestamp(destringify<time_t>(tokens.at(3)), 0), false);
+            else if ("dir" == tokens.at(0))
+                value->add_dir(FSPath(tokens.at(1)));
+            else if ("sym" == tokens.at(0))
+                value->add_sym(FSPath(tokens.at(1)), tokens.at(2), kNoPart,
+                        Timestamp(destringify<time_t>(tokens.at(3)), 0), false);
+            else
+                value->add_other(FSPath(tokens.at(1)));
+            return true;
+            });
 
     return value;
 }
 
+void
+VDBID::for_each_contents_entry(const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> & f) const
+{
+    each_contents_line(fs_location_key()->parse_value() / "CONTENTS", [&] (const std::vector<std::string> & tokens) {
+            if ("obj" == tokens.at(0))
+            {
+                auto e(std::make_shared<ContentsFileEntry>(FSPath(tokens.at(1)), kNoPart));
+                e->add_metadata_key(std::make_shared<LiteralMetadataValueKey<std::string>>("md5", "md5", mkt_normal, tokens.at(2)));
+                e->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
+                                Timestamp(destringify<time_t>(tokens.at(3)), 0)));
+                return f(e);
+            }
+            else if ("dir" == tokens.at(0))
+                return f(std::make_shared<ContentsDirEntry>(FSPath(tokens.at(1))));
+            else if ("sym" == tokens.at(0))
+            {
+                auto e(std::make_shared<ContentsSymEntry>(FSPath(tokens.at(1)), tokens.at(2), kNoPart));
+                e->add_metadata_key(std::make_shared<LiteralMetadataTimeKey>("mtime", "mtime", mkt_normal,
+                                Timestamp(destringify<time_t>(tokens.at(3)), 0)));
+                return f(e);
+            }
+            else
+                return f(std::make_shared<ContentsOtherEntry>(FSPath(tokens.at(1))));
+            });
+}
+
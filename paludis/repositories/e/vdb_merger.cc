@@ -165,7 +165,8 @@ VDBMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, const
     display_merge(et_file, renamed_file, flags,
                   src.basename() == dst_name ? "" : dst_name);
 
-    *_imp->contents_file << "obj " << tidy_real << " " << md5.hexsum() << " " << timestamp.seconds() << std::endl;
+    const std::string line("obj " + tidy_real + " " + md5.hexsum() + " " + stringify(timestamp.seconds()));
+    in_order([this, line] () { *_imp->contents_file << line << std::endl; });
 }
 
 void
@@ -176,7 +177,7 @@ VDBMerger::record_install_dir(const FSPath & src, const FSPath & dst_dir, const
 
     display_merge(et_dir, dir, flags);
 
-    *_imp->contents_file << "dir " << tidy << std::endl;
+    in_order([this, tidy] () { *_imp->contents_file << "dir " << tidy << std::endl; });
 }
 
 void
@@ -186,7 +187,7 @@ VDBMerger::record_install_under_dir(const FSPath & dst_dir, const FSMergerStatus
 
     display_merge(et_dir, dst_dir, flags);
 
-    *_imp->contents_file << "dir " << tidy << std::endl;
+    in_order([this, tidy] () { *_imp->contents_file << "dir " << tidy << std::endl; });
 }
 
 void
@@ -199,7 +200,8 @@ VDBMerger::record_install_sym(const FSPath & src, const FSPath & dst_dir, const
 
     display_merge(et_sym, sym, flags);
 
-    *_imp->contents_file << "sym " << tidy << " -> " << target << " " << timestamp.seconds() << std::endl;
+    const std::string line("sym " + tidy + " -> " + target + " " + stringify(timestamp.seconds()));
+    in_order([this, line] () { *_imp->contents_file << line << std::endl; });
 }
 
 void
@@ -208,7 +210,7 @@ VDBMerger::on_error(bool is_check, const std::string & s)
     make_check_fail();
 
     if (is_check)
-        _imp->params.output_manager()->stdout_stream() << "." << std::endl << "!!! " << s << std::endl;
+        in_order([this, s] () { _imp->params.output_manager()->stdout_stream() << "." << std::endl << "!!! " << s << std::endl; });
     else
         throw FSMergerError(s);
 }
@@ -308,7 +310,7 @@ VDBMerger::on_enter_dir(bool is_check, const FSPath)
     if (! is_check)
         return;
 
-    _imp->params.output_manager()->stdout_stream() << "." << std::flush;
+    in_order([this] () { _imp->params.output_manager()->stdout_stream() << "." << std::flush; });
 }
 
 void
@@ -346,6 +348,6 @@ VDBMerger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
 void
 VDBMerger::display_override(const std::string & message) const
 {
-    _imp->params.output_manager()->stdout_stream() << message << std::endl;
+    in_order([this, message] () { _imp->params.output_manager()->stdout_stream() << message << std::endl; });
 }
 
@@ -43,6 +43,7 @@
 #include <paludis/package_id.hh>
 #include <paludis/repositories/e/ebuild.hh>
 #include <paludis/repository_name_cache.hh>
+#include <paludis/repository_owners_cache.hh>
 #include <paludis/set_file.hh>
 #include <paludis/version_operator.hh>
 #include <paludis/version_requirements.hh>
@@ -97,6 +98,18 @@
 using namespace paludis;
 using namespace paludis::erepository;
 
+namespace
+{
+    std::vector<FSPath> package_dirs(const FSPath & category_dir)
+    {
+        std::vector<FSPath> result;
+        for (FSIterator d(category_dir, { fsio_inode_sort, fsio_want_directories, fsio_deref_symlinks_for_wants }), d_end ;
+                d != d_end ; ++d)
+            result.push_back(*d);
+        return result;
+    }
+}
+
 typedef std::unordered_map<CategoryNamePart, std::shared_ptr<QualifiedPackageNameSet>, Hash<CategoryNamePart> > CategoryMap;
 typedef std::unordered_map<QualifiedPackageName, std::shared_ptr<PackageIDSequence>, Hash<QualifiedPackageName> > IDMap;
 typedef std::map<std::pair<QualifiedPackageName, VersionSpec>, std::shared_ptr<std::list<QualifiedPackageName> > > ProvidesMap;
@@ -112,9 +125,11 @@ namespace paludis
 
         mutable CategoryMap categories;
         mutable bool has_category_names;
+        mutable bool has_all_package_ids;
         mutable IDMap ids;
 
         std::shared_ptr<RepositoryNameCache> names_cache;
+        std::shared_ptr<RepositoryOwnersCache> owners_cache;
 
         Imp(const VDBRepository * const, const VDBRepositoryParams &, std::shared_ptr<std::recursive_mutex> = std::make_shared<std::recursive_mutex>());
         ~Imp();
@@ -132,7 +147,9 @@ namespace paludis
         params(p),
         big_nasty_mutex(m),
         has_category_names(false),
+        has_all_package_ids(false),
         names_cache(std::make_shared<RepositoryNameCache>(p.names_cache(), r)),
+        owners_cache(std::make_shared<RepositoryOwnersCache>(p.location() / ".cache" / "owners", r, "CONTENTS")),
         location_key(std::make_shared<LiteralMetadataValueKey<FSPath> >("location", "location",
                     mkt_significant, params.location())),
         root_key(std::make_shared<LiteralMetadataValueKey<FSPath> >("root", "root",
@@ -324,6 +341,13 @@ VDBRepository::repository_factory_create(
                 *DistributionData::get_instance()->distribution_from_string(
                     env->distribution()))->default_eapi_when_unknown();
 
+    bool parallel_load(false);
+    if (! f("parallel_load").empty())
+    {
+        Context item_context("When handling parallel_load key:");
+        parallel_load = destringify<bool>(f("parallel_load"));
+    }
+
     return std::make_shared<VDBRepository>(make_named_values<VDBRepositoryParams>(
                 n::builddir() = builddir,
                 n::eapi_when_unknown() = eapi_when_unknown,
@@ -331,6 +355,7 @@ VDBRepository::repository_factory_create(
                 n::location() = location,
                 n::name() = RepositoryName(name),
                 n::names_cache() = names_cache,
+                n::parallel_load() = parallel_load,
                 n::root() = root
                 ));
 }
@@ -528,6 +553,10 @@ VDBRepository::perform_uninstall(
         }
     }
 
+    /* an overwrite's replacement has already been added under the same name */
+    if (! a.options.is_overwrite())
+        _imp->owners_cache->remove(id);
+
     /* remove vdb entry */
     for (FSIterator d(pkg_dir, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
         d->unlink();
@@ -569,6 +598,7 @@ VDBRepository::invalidate()
     std::unique_lock<std::recursive_mutex> lock(*_imp->big_nasty_mutex);
     _imp.reset(new Imp<VDBRepository>(this, _imp->params, _imp->big_nasty_mutex));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 void
@@ -577,6 +607,15 @@ VDBRepository::regenerate_cache() const
     std::unique_lock<std::recursive_mutex> lock(*_imp->big_nasty_mutex);
 
     _imp->names_cache->regenerate_cache();
+    _imp->owners_cache->regenerate_cache();
+}
+
+std::shared_ptr<const PackageIDSet>
+VDBRepository::maybe_candidate_owners(const std::string & q) const
+{
+    std::unique_lock<std::recursive_mutex> lock(*_imp->big_nasty_mutex);
+
+    return _imp->owners_cache->candidate_owners(q);
 }
 
 std::shared_ptr<const CategoryNamePartSet>
@@ -750,6 +789,8 @@ VDBRepository::merge(const MergeParams & m)
 
     merger.merge();
 
+    _imp->owners_cache->add(new_id ? new_id : make_id(m.package_id()->name(), m.package_id()->version(), vdb_dir));
+
     if (is_replace)
     {
         UninstallActionOptions uo(make_named_values<UninstallActionOptions>(
@@ -836,12 +877,89 @@ VDBRepository::need_package_ids(const CategoryNamePart & c) const
     if (_imp->categories[c])
         return;
 
+    if (_imp->params.parallel_load() && ! _imp->has_all_package_ids)
+    {
+        need_all_package_ids();
+        if (_imp->categories[c])
+            return;
+    }
+
     Context context("When loading package names from '" + stringify(_imp->params.location()) +
             "' in category '" + stringify(c) + "':");
 
+    add_package_ids(c, package_dirs(_imp->params.location() / stringify(c)));
+}
+
+void
+VDBRepository::need_all_package_ids() const
+{
+    std::unique_lock<std::recursive_mutex> lock(*_imp->big_nasty_mutex);
+
+    if (_imp->has_all_package_ids)
+        return;
+
+    /* if anything goes wrong, we go back to loading one category at a time */
+    _imp->has_all_package_ids = true;
+
+    need_category_names();
+
+    Context context("When loading all package names from '" + stringify(_imp->params.location()) + "':");
+
+    /* listing each category is almost all waiting for the filesystem, so
+     * we do all of them at once. creating IDs needs the lock, which we hold,
+     * so that happens here afterwards. */
+    std::vector<CategoryNamePart> categories;
+    for (CategoryMap::const_iterator c(_imp->categories.begin()), c_end(_imp->categories.end()) ;
+            c != c_end ; ++c)
+        if (! c->second)
+            categories.push_back(c->first);
+
+    try
+    {
+        std::vector<std::vector<FSPath> > dirs(categories.size());
+        std::vector<std::function<void ()> > list_tasks;
+        for (std::size_t i(0) ; i < categories.size() ; ++i)
+            list_tasks.push_back([&, i] () {
+                    dirs[i] = package_dirs(_imp->params.location() / stringify(categories[i]));
+                });
+        run_load_tasks(list_tasks);
+
+        for (std::size_t i(0) ; i < categories.size() ; ++i)
+            add_package_ids(categories[i], dirs[i]);
+
+        /* nothing else can see these IDs until we release the lock, so reading
+         * their key files cannot wait upon anyone who wants it */
+        std::vector<std::function<void ()> > preload_tasks;
+        for (const auto & c : categories)
+            for (QualifiedPackageNameSet::ConstIterator q(_imp->categories[c]->begin()), q_end(_imp->categories[c]->end()) ;
+                    q != q_end ; ++q)
+                for (PackageIDSequence::ConstIterator i(_imp->ids[*q]->begin()), i_end(_imp->ids[*q]->end()) ;
+                        i != i_end ; ++i)
+                {
+                    std::shared_ptr<const EInstalledRepositoryID> id(std::static_pointer_cast<const EInstalledRepositoryID>(*i));
+                    preload_tasks.push_back([id] () { id->preload_key_files(); });
+                }
+        run_load_tasks(preload_tasks);
+    }
+    catch (const InternalError &)
+    {
+        throw;
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("e.vdb.parallel_load.failure", ll_warning, lc_context)
+            << "Falling back to loading VDB categories one at a time due to exception '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+void
+VDBRepository::add_package_ids(const CategoryNamePart & c, const std::vector<FSPath> & dirs) const
+{
+    std::unique_lock<std::recursive_mutex> lock(*_imp->big_nasty_mutex);
+
     std::shared_ptr<QualifiedPackageNameSet> q(std::make_shared<QualifiedPackageNameSet>());
 
-    for (FSIterator d(_imp->params.location() / stringify(c), { fsio_inode_sort, fsio_want_directories, fsio_deref_symlinks_for_wants }), d_end ;
+    for (std::vector<FSPath>::const_iterator d(dirs.begin()), d_end(dirs.end()) ;
             d != d_end ; ++d)
         try
         {
@@ -28,6 +28,7 @@
 #include <paludis/util/map.hh>
 #include <paludis/repositories/e/e_repository_id.hh>
 #include <memory>
+#include <vector>
 
 /** \file
  * Declarations for VDBRepository.
@@ -45,6 +46,7 @@ namespace paludis
         typedef Name<struct name_location> location;
         typedef Name<struct name_name> name;
         typedef Name<struct name_names_cache> names_cache;
+        typedef Name<struct name_parallel_load> parallel_load;
         typedef Name<struct name_root> root;
     }
 
@@ -58,6 +60,14 @@ namespace paludis
             NamedValue<n::location, FSPath> location;
             NamedValue<n::name, RepositoryName> name;
             NamedValue<n::names_cache, FSPath> names_cache;
+
+            /**
+             * Load every category's IDs at once, using several threads.
+             *
+             * \since 2.4
+             */
+            NamedValue<n::parallel_load, bool> parallel_load;
+
             NamedValue<n::root, FSPath> root;
         };
     }
@@ -81,6 +91,8 @@ namespace paludis
 
             void need_category_names() const;
             void need_package_ids(const CategoryNamePart &) const;
+            void need_all_package_ids() const;
+            void add_package_ids(const CategoryNamePart &, const std::vector<FSPath> &) const;
 
             const std::shared_ptr<const erepository::ERepositoryID> package_id_if_exists(const QualifiedPackageName &,
                     const VersionSpec &) const
@@ -108,6 +120,9 @@ namespace paludis
 
             virtual void regenerate_cache() const;
 
+            virtual std::shared_ptr<const PackageIDSet> maybe_candidate_owners(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual void perform_uninstall(
                     const std::shared_ptr<const erepository::ERepositoryID> & id,
                     const UninstallAction &) const;
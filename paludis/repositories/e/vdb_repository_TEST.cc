@@ -41,6 +41,7 @@
 #include <paludis/user_dep_spec.hh>
 #include <paludis/action.hh>
 #include <paludis/choice.hh>
+#include <paludis/slot.hh>
 #include <paludis/unformatted_pretty_printer.hh>
 #include <paludis/contents.hh>
 
@@ -198,6 +199,52 @@ TEST(VDBRepository, QueryUse)
     EXPECT_TRUE(! e1->choices_key()->parse_value()->find_by_name_with_prefix(ChoiceNameWithPrefix("kernel_freebsd")));
 }
 
+namespace
+{
+    std::string describe_installed(const std::string & parallel_load)
+    {
+        TestEnvironment env;
+        std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+        keys->insert("format", "vdb");
+        keys->insert("names_cache", "/var/empty");
+        keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "repo1"));
+        keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "build"));
+        keys->insert("parallel_load", parallel_load);
+        std::shared_ptr<Repository> repo(VDBRepository::VDBRepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1)));
+        env.add_repository(1, repo);
+
+        std::string result;
+        std::shared_ptr<const PackageIDSequence> ids(env[selection::AllVersionsSorted(generator::All())]);
+        for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                i != i_end ; ++i)
+        {
+            result += stringify((*i)->name()) + "-" + stringify((*i)->version());
+            if ((*i)->slot_key())
+                result += " SLOT=" + (*i)->slot_key()->parse_value().raw_value();
+            if ((*i)->choices_key())
+                for (Choices::ConstIterator c((*i)->choices_key()->parse_value()->begin()),
+                        c_end((*i)->choices_key()->parse_value()->end()) ;
+                        c != c_end ; ++c)
+                    for (Choice::ConstIterator v((*c)->begin()), v_end((*c)->end()) ;
+                            v != v_end ; ++v)
+                        result += " " + stringify((*v)->name_with_prefix()) + "=" + stringify((*v)->enabled());
+            result += "\n";
+        }
+
+        return result;
+    }
+}
+
+TEST(VDBRepository, ParallelLoad)
+{
+    std::string sequential(describe_installed("false")), parallel(describe_installed("true"));
+    EXPECT_EQ(sequential, parallel);
+    EXPECT_NE(std::string::npos, parallel.find("cat-one/pkg-one-1 SLOT=0"));
+    EXPECT_NE(std::string::npos, parallel.find(" flag1=true flag2=true flag3=false"));
+    EXPECT_NE(std::string::npos, parallel.find("cat-two/pkg-two-2"));
+}
+
 TEST(VDBRepository, Contents)
 {
     TestEnvironment env;
@@ -248,6 +295,49 @@ TEST(VDBRepository, Contents)
         gatherer._str);
 }
 
+TEST(VDBRepository, ContentsStreaming)
+{
+    TestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "vdb");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "repo1"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "build"));
+    keys->insert("world", stringify(FSPath::cwd() / "vdb_repository_TEST_dir" / "world-no-match-no-eol"));
+    std::shared_ptr<Repository> repo(VDBRepository::VDBRepository::repository_factory_create(&env,
+                std::bind(from_keys, keys, std::placeholders::_1)));
+    env.add_repository(1, repo);
+
+    std::shared_ptr<const PackageID> e1(*env[selection::RequireExactlyOne(generator::Matches(
+                    PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                            &env, { })), nullptr, { }))]->begin());
+
+    ContentsGatherer expected;
+    auto contents(e1->contents());
+    std::for_each(indirect_iterator(contents->begin()),
+                  indirect_iterator(contents->end()),
+                  accept_visitor(expected));
+
+    ContentsGatherer streamed;
+    e1->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & e) {
+            e->accept(streamed);
+            return true;
+            });
+    EXPECT_EQ(expected._str, streamed._str);
+
+    ContentsGatherer partial;
+    int seen(0);
+    e1->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & e) {
+            e->accept(partial);
+            return ++seen < 3;
+            });
+    EXPECT_EQ(3, seen);
+    EXPECT_EQ("directory\n/directory\n"
+            "file\n/directory/file\n"
+            "symlink\n/directory/symlink\ntarget\n",
+            partial._str);
+}
+
 TEST(VDBRepository, Reinstall)
 {
     TestEnvironment env;
@@ -27,10 +27,13 @@
 #include <paludis/util/options.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/set.hh>
 
 #include <paludis/metadata_key.hh>
 #include <paludis/standard_output_manager.hh>
@@ -48,6 +51,7 @@
 #include <algorithm>
 #include <iterator>
 #include <vector>
+#include <set>
 
 #include <gtest/gtest.h>
 
@@ -118,6 +122,19 @@ namespace
                                       "_VERSION_", std::bind(&FSPath::basename, _1)));
     }
 
+    std::string owners(const std::shared_ptr<const Repository> & repo, const std::string & q)
+    {
+        std::shared_ptr<const PackageIDSet> ids(repo->maybe_candidate_owners(q));
+        if (! ids)
+            return "(null)";
+
+        std::set<std::string> result;
+        for (PackageIDSet::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                i != i_end ; ++i)
+            result.insert(stringify(**i));
+        return join(result.begin(), result.end(), " ");
+    }
+
     std::string read_file(const FSPath & f)
     {
         SafeIFStream s(f);
@@ -331,3 +348,95 @@ TEST(NamesCache, Incremental)
     }
 }
 
+TEST(OwnersCache, Incremental)
+{
+    TestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "e");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "ownersincrtest_src"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "ownersincrtest_src/profiles/profile"));
+    keys->insert("layout", "traditional");
+    keys->insert("eapi_when_unknown", "0");
+    keys->insert("eapi_when_unspecified", "0");
+    keys->insert("profile_eapi", "0");
+    keys->insert("distdir", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "distdir"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "build"));
+    keys->insert("root", stringify(FSPath("vdb_repository_TEST_cache_dir/root").realpath()));
+    std::shared_ptr<Repository> repo(ERepository::repository_factory_create(&env,
+                std::bind(from_keys, keys, std::placeholders::_1)));
+    env.add_repository(1, repo);
+
+    keys = std::make_shared<Map<std::string, std::string>>();
+    keys->insert("format", "vdb");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "ownersincrtest"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "vdb_repository_TEST_cache_dir" / "build"));
+    keys->insert("root", stringify(FSPath("vdb_repository_TEST_cache_dir/root").realpath()));
+    std::shared_ptr<Repository> vdb_repo(VDBRepository::VDBRepository::repository_factory_create(&env,
+                std::bind(from_keys, keys, std::placeholders::_1)));
+    env.add_repository(0, vdb_repo);
+
+    UninstallAction uninstall_action(make_named_values<UninstallActionOptions>(
+                n::config_protect() = "",
+                n::if_for_install_id() = nullptr,
+                n::ignore_for_unmerge() = &ignore_nothing,
+                n::is_overwrite() = false,
+                n::make_output_manager() = &make_standard_output_manager,
+                n::override_contents() = nullptr,
+                n::want_phase() = &want_all_phases
+            ));
+
+    EXPECT_EQ("", owners(vdb_repo, "common"));
+
+    install(env, vdb_repo, "=cat1/pkg1-1::ownersincrtest_src", "");
+    install(env, vdb_repo, "=cat1/pkg2-1::ownersincrtest_src", "");
+    vdb_repo->invalidate();
+
+    EXPECT_EQ("cat1/pkg1-1::installed", owners(vdb_repo, "/usr/share/pkg1/1"));
+    EXPECT_EQ("cat1/pkg1-1::installed cat1/pkg2-1::installed", owners(vdb_repo, "common"));
+    EXPECT_EQ("", owners(vdb_repo, "/usr/share/pkg1/2"));
+
+    install(env, vdb_repo, "=cat1/pkg1-2::ownersincrtest_src", "=cat1/pkg1-1::installed");
+    vdb_repo->invalidate();
+
+    EXPECT_EQ("cat1/pkg1-2::installed", owners(vdb_repo, "/usr/share/pkg1/2"));
+    EXPECT_EQ("", owners(vdb_repo, "/usr/share/pkg1/1"));
+    EXPECT_EQ("cat1/pkg1-2::installed cat1/pkg2-1::installed", owners(vdb_repo, "common"));
+
+    install(env, vdb_repo, "=cat1/pkg1-2::ownersincrtest_src", "=cat1/pkg1-2::installed");
+    vdb_repo->invalidate();
+
+    EXPECT_EQ("cat1/pkg1-2::installed", owners(vdb_repo, "/usr/share/pkg1/2"));
+
+    {
+        const std::shared_ptr<const PackageID> inst_id(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat1/pkg2-1::installed",
+                                &env, { })), nullptr, { }))]->begin());
+        inst_id->perform_action(uninstall_action);
+        vdb_repo->invalidate();
+    }
+
+    EXPECT_EQ("cat1/pkg1-2::installed", owners(vdb_repo, "common"));
+    EXPECT_EQ("", owners(vdb_repo, "/usr/share/pkg2/common"));
+
+    FSPath("vdb_repository_TEST_cache_dir/ownersincrtest/.cache/owners/_IDS_").unlink();
+    vdb_repo->invalidate();
+    EXPECT_EQ("(null)", owners(vdb_repo, "common"));
+
+    vdb_repo->regenerate_cache();
+    EXPECT_EQ("cat1/pkg1-2::installed", owners(vdb_repo, "common"));
+
+    /* as if another package manager had reinstalled the same version */
+    {
+        FSPath contents("vdb_repository_TEST_cache_dir/ownersincrtest/cat1/pkg1-2/CONTENTS");
+        std::string text(read_file(contents));
+        SafeOFStream f(contents, -1, true);
+        f << text << "obj /usr/share/pkg1/other d41d8cd98f00b204e9800998ecf8427e 1234567890" << std::endl;
+    }
+    vdb_repo->invalidate();
+    EXPECT_EQ("(null)", owners(vdb_repo, "other"));
+
+    vdb_repo->regenerate_cache();
+    EXPECT_EQ("cat1/pkg1-2::installed", owners(vdb_repo, "other"));
+}
@@ -39,3 +39,25 @@ SLOT="0"
 END
 cp namesincrtest_src/cat3/pkg1/pkg1-{1,2}.ebuild
 
+
+mkdir -p ownersincrtest/.cache/owners ownersincrtest_src/{eclass,profiles/profile,cat1/{pkg1,pkg2}} || exit 1
+echo paludis-owners-2 >ownersincrtest/.cache/owners/_VERSION_
+echo installed >>ownersincrtest/.cache/owners/_VERSION_
+touch ownersincrtest/.cache/owners/_IDS_
+
+cp namesincrtest_src/profiles/profile/make.defaults ownersincrtest_src/profiles/profile/
+echo ownersincrtest_src >ownersincrtest_src/profiles/repo_name
+echo cat1 >ownersincrtest_src/profiles/categories
+
+cat <<"END" >ownersincrtest_src/cat1/pkg1/pkg1-1.ebuild
+KEYWORDS="test"
+SLOT="0"
+
+src_install() {
+    dodir /usr/share/${PN} || die
+    touch "${D}"/usr/share/${PN}/${PV} || die
+    touch "${D}"/usr/share/${PN}/common || die
+}
+END
+cp ownersincrtest_src/cat1/pkg1/pkg1-{1,2}.ebuild
+cp ownersincrtest_src/cat1/{pkg1/pkg1,pkg2/pkg2}-1.ebuild
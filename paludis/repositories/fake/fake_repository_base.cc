@@ -173,6 +173,7 @@ FakeRepositoryBase::add_version(const std::string & c, const std::string & p,
 void
 FakeRepositoryBase::invalidate()
 {
+    notify_invalidated();
 }
 
 const Environment *
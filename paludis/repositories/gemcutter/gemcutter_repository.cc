@@ -138,6 +138,7 @@ GemcutterRepository::invalidate()
 {
     _imp.reset(new Imp<GemcutterRepository>(this, _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 bool
@@ -149,6 +149,7 @@ RepositoryRepository::invalidate()
 {
     _imp.reset(new Imp<RepositoryRepository>(this, _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 bool
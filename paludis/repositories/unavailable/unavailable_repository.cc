@@ -159,6 +159,7 @@ UnavailableRepository::invalidate()
 {
     _imp.reset(new Imp<UnavailableRepository>(this, _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 bool
@@ -550,16 +550,17 @@ InstalledUnpackagedID::long_description_key() const
 const std::shared_ptr<const Contents>
 InstalledUnpackagedID::contents() const
 {
-    using namespace std::placeholders;
     auto v(std::make_shared<Contents>());
-    _imp->ndbam->parse_contents(*this,
-            std::bind(&Contents::add, v.get(), std::placeholders::_1),
-            std::bind(&Contents::add, v.get(), std::placeholders::_1),
-            std::bind(&Contents::add, v.get(), std::placeholders::_1)
-            );
+    _imp->ndbam->parse_contents(*this, *v);
     return v;
 }
 
+void
+InstalledUnpackagedID::for_each_contents_entry(const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> & f) const
+{
+    _imp->ndbam->for_each_contents_entry(*this, f);
+}
+
 const std::shared_ptr<const MetadataTimeKey>
 InstalledUnpackagedID::installed_time_key() const
 {
@@ -86,6 +86,8 @@ namespace paludis
                         const std::shared_ptr<OutputManager> & output_manager) const;
 
                 virtual const std::shared_ptr<const Contents> contents() const;
+                virtual void for_each_contents_entry(
+                        const std::function<bool (const std::shared_ptr<const ContentsEntry> &)> &) const;
         };
     }
 }
@@ -389,6 +389,7 @@ InstalledUnpackagedRepository::invalidate()
 {
     _imp.reset(new Imp<InstalledUnpackagedRepository>(_imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 void
@@ -181,6 +181,7 @@ UnpackagedRepository::invalidate()
 {
     _imp.reset(new Imp<UnpackagedRepository>(name(), _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 void
@@ -153,6 +153,7 @@ UnwrittenRepository::invalidate()
 {
     _imp.reset(new Imp<UnwrittenRepository>(this, _imp->params));
     _add_metadata_keys();
+    notify_invalidated();
 }
 
 bool
@@ -34,6 +34,7 @@
 #include <paludis/metadata_key.hh>
 #include <paludis/distribution-impl.hh>
 #include <paludis/environment.hh>
+#include <paludis/notifier_callback.hh>
 #include <functional>
 #include <map>
 #include <list>
@@ -108,9 +109,11 @@ namespace paludis
     template <>
     struct Imp<Repository>
     {
+        const Environment * const env;
         const RepositoryName name;
 
-        Imp(const RepositoryName & n) :
+        Imp(const Environment * const e, const RepositoryName & n) :
+            env(e),
             name(n)
         {
         }
@@ -122,7 +125,7 @@ Repository::Repository(
         const RepositoryName & our_name,
         const RepositoryCapabilities & caps) :
     RepositoryCapabilities(caps),
-    _imp(our_name)
+    _imp(env, our_name)
 {
     std::string reason(RepositoryDistributionData::get_instance()->data_from_distribution(
                 *DistributionData::get_instance()->distribution_from_string(
@@ -144,6 +147,12 @@ Repository::name() const
     return _imp->name;
 }
 
+void
+Repository::notify_invalidated() const
+{
+    _imp->env->trigger_notifier_callback(NotifierCallbackRepositoryInvalidatedEvent(_imp->name));
+}
+
 std::shared_ptr<const CategoryNamePartSet>
 Repository::category_names_containing_package(const PackageNamePart & p, const RepositoryContentMayExcludes &) const
 {
@@ -159,6 +168,12 @@ Repository::category_names_containing_package(const PackageNamePart & p, const R
     return result;
 }
 
+std::shared_ptr<const PackageIDSet>
+Repository::maybe_candidate_owners(const std::string &) const
+{
+    return nullptr;
+}
+
 void
 Repository::regenerate_cache() const
 {
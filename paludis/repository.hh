@@ -258,6 +258,15 @@ namespace paludis
 
             ///\}
 
+            /**
+             * Tell the Environment that our in memory cache has been
+             * invalidated, so that it can drop anything it has cached. Must
+             * be called by invalidate().
+             *
+             * \since 2.4
+             */
+            void notify_invalidated() const;
+
         public:
             ///\name Basic operations
             ///\{
@@ -412,6 +421,23 @@ namespace paludis
             virtual const std::shared_ptr<const Set<std::string> > maybe_expand_licence_nonrecursively(
                     const std::string &) const = 0;
 
+            /**
+             * Fetch IDs that might own a file, using an index if we have one.
+             *
+             * If the query starts with a slash, it is treated as a full path,
+             * and otherwise as a basename.
+             *
+             * Used to optimise owner queries. May return a null pointer, if we
+             * have no usable index, in which case callers must check the
+             * contents of every ID. Otherwise the result may include IDs that
+             * do not in fact own the file, so callers must still check the
+             * contents of each candidate, but it will not omit any owners.
+             *
+             * \since 2.4
+             */
+            virtual std::shared_ptr<const PackageIDSet> maybe_candidate_owners(
+                    const std::string &) const;
+
             ///\}
 
             ///\name Repository behaviour methods
@@ -419,6 +445,8 @@ namespace paludis
 
             /**
              * Invalidate any in memory cache.
+             *
+             * \since 2.4 implementations must call notify_invalidated()
              */
             virtual void invalidate() = 0;
 
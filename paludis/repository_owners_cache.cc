@@ -0,0 +1,535 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/repository_owners_cache.hh>
+#include <paludis/repository.hh>
+#include <paludis/package_id.hh>
+#include <paludis/contents.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/name.hh>
+#include <paludis/version_spec.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+using namespace paludis;
+
+namespace
+{
+    typedef std::pair<std::string, std::string> OwnersCacheLine;
+    typedef std::vector<OwnersCacheLine> OwnersCacheBucket;
+    typedef std::unordered_map<std::string, std::shared_ptr<PackageIDSequence> > OwnersCacheIDMap;
+
+    std::string basename_of(const std::string & s)
+    {
+        std::string::size_type p(s.rfind('/'));
+        return std::string::npos == p ? s : s.substr(p + 1);
+    }
+
+    /* this needs to be stable between runs and builds, so we can't use
+     * std::hash. fnv-1a is good enough to spread names over the buckets. */
+    std::string bucket_name(const std::string & basename)
+    {
+        uint32_t h(2166136261U);
+        for (std::string::const_iterator c(basename.begin()), c_end(basename.end()) ;
+                c != c_end ; ++c)
+        {
+            h ^= static_cast<unsigned char>(*c);
+            h *= 16777619U;
+        }
+
+        char result[3];
+        std::snprintf(result, sizeof(result), "%02x", static_cast<unsigned>(h & 0xff));
+        return result;
+    }
+
+    std::string key_for(const PackageID & id)
+    {
+        return stringify(id.name()) + "-" + stringify(id.version());
+    }
+
+    /* another package manager can reinstall the same version with different
+     * contents, so we also remember what the contents file looked like */
+    std::string signature_for(const PackageID & id, const std::string & contents_filename)
+    {
+        if (! id.fs_location_key())
+            return "-";
+
+        FSStat f(id.fs_location_key()->parse_value() / contents_filename);
+        if (! f.exists())
+            return "-";
+
+        return stringify(f.mtim().seconds()) + "." + stringify(f.mtim().nanoseconds()) + ":" + stringify(f.file_size());
+    }
+}
+
+namespace paludis
+{
+    template<>
+    struct Imp<RepositoryOwnersCache>
+    {
+        mutable std::mutex mutex;
+
+        mutable bool usable;
+        mutable bool checked;
+        const FSPath location;
+        const Repository * const repo;
+        const std::string contents_filename;
+
+        mutable std::shared_ptr<std::set<std::pair<std::string, std::string> > > indexed_ids;
+        mutable std::shared_ptr<OwnersCacheIDMap> current_ids;
+
+        Imp(const FSPath & l, const Repository * const r, const std::string & c) :
+            usable(true),
+            checked(false),
+            location(l),
+            repo(r),
+            contents_filename(c)
+        {
+        }
+
+        void erase_indexed_id(const std::string &) const;
+
+        bool check() const;
+        void load_indexed_ids() const;
+        void write_indexed_ids() const;
+        bool load_current_ids() const;
+        OwnersCacheBucket load_bucket(const std::string &) const;
+        void write_bucket(const std::string &, OwnersCacheBucket &) const;
+        void write_version() const;
+    };
+}
+
+bool
+Imp<RepositoryOwnersCache>::check() const
+{
+    if (checked || ! usable)
+        return usable;
+
+    if (! (location / "_VERSION_").stat().exists())
+    {
+        Log::get_instance()->message("repository.owners_cache.unversioned", ll_debug, lc_context)
+            << "Owners cache for '" << repo->name() << "' has not been generated, so cannot be used. "
+            "Perhaps you need to regenerate the cache using 'cave fix-cache'?";
+        usable = false;
+        return usable;
+    }
+
+    SafeIFStream vvf(location / "_VERSION_");
+    std::string line;
+    std::getline(vvf, line);
+    if (line != "paludis-owners-2")
+    {
+        Log::get_instance()->message("repository.owners_cache.unsupported", ll_warning, lc_context)
+            << "Owners cache for '" << repo->name() << "' has version string '" << line
+            << "', which is not supported. Was it generated using a different Paludis version? Perhaps you need to regenerate "
+            "the cache using 'cave fix-cache'?";
+        usable = false;
+        return usable;
+    }
+
+    std::getline(vvf, line);
+    if (line != stringify(repo->name()))
+    {
+        Log::get_instance()->message("repository.owners_cache.different", ll_warning, lc_context)
+            << "Owners cache for '" << repo->name() << "' was generated for repository '" << line
+            << "', so it cannot be used.";
+        usable = false;
+        return usable;
+    }
+
+    checked = true;
+    return usable;
+}
+
+void
+Imp<RepositoryOwnersCache>::load_indexed_ids() const
+{
+    if (indexed_ids)
+        return;
+
+    indexed_ids = std::make_shared<std::set<std::pair<std::string, std::string> > >();
+
+    FSPath ff(location / "_IDS_");
+    if (ff.stat().exists())
+    {
+        SafeIFStream f(ff);
+        std::string line;
+        while (std::getline(f, line))
+        {
+            std::string::size_type p(line.find(' '));
+            if (std::string::npos == p)
+                continue;
+            indexed_ids->insert(std::make_pair(line.substr(0, p), line.substr(p + 1)));
+        }
+    }
+}
+
+void
+Imp<RepositoryOwnersCache>::erase_indexed_id(const std::string & key) const
+{
+    auto i(indexed_ids->lower_bound(std::make_pair(key, std::string())));
+    while (indexed_ids->end() != i && i->first == key)
+        indexed_ids->erase(i++);
+}
+
+void
+Imp<RepositoryOwnersCache>::write_indexed_ids() const
+{
+    try
+    {
+        SafeOFStream f(location / "_IDS_", -1, true);
+        for (auto i(indexed_ids->begin()), i_end(indexed_ids->end()) ;
+                i != i_end ; ++i)
+            f << i->first << " " << i->second << std::endl;
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("repository.owners_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write '" << (location / "_IDS_") << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+bool
+Imp<RepositoryOwnersCache>::load_current_ids() const
+{
+    if (current_ids)
+        return true;
+
+    load_indexed_ids();
+
+    std::shared_ptr<OwnersCacheIDMap> result(std::make_shared<OwnersCacheIDMap>());
+
+    std::shared_ptr<const CategoryNamePartSet> cats(repo->category_names({ }));
+    for (CategoryNamePartSet::ConstIterator c(cats->begin()), c_end(cats->end()) ;
+            c != c_end ; ++c)
+    {
+        std::shared_ptr<const QualifiedPackageNameSet> pkgs(repo->package_names(*c, { }));
+        for (QualifiedPackageNameSet::ConstIterator p(pkgs->begin()), p_end(pkgs->end()) ;
+                p != p_end ; ++p)
+        {
+            std::shared_ptr<const PackageIDSequence> ids(repo->package_ids(*p, { }));
+            for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                    i != i_end ; ++i)
+            {
+                std::string key(key_for(**i));
+                if (indexed_ids->end() == indexed_ids->find(std::make_pair(key, signature_for(**i, contents_filename))))
+                {
+                    Log::get_instance()->message("repository.owners_cache.stale", ll_warning, lc_context)
+                        << "Owners cache for '" << repo->name() << "' does not include the current contents of '" << **i
+                        << "', so it cannot be used. Was it installed using a different package manager? Perhaps "
+                        "you need to regenerate the cache using 'cave fix-cache'?";
+                    usable = false;
+                    return false;
+                }
+
+                OwnersCacheIDMap::iterator r(result->find(key));
+                if (result->end() == r)
+                    r = result->insert(std::make_pair(key, std::make_shared<PackageIDSequence>())).first;
+                r->second->push_back(*i);
+            }
+        }
+    }
+
+    current_ids = result;
+    return true;
+}
+
+OwnersCacheBucket
+Imp<RepositoryOwnersCache>::load_bucket(const std::string & b) const
+{
+    OwnersCacheBucket result;
+
+    FSPath ff(location / b);
+    if (ff.stat().exists())
+    {
+        SafeIFStream f(ff);
+        std::string line;
+        while (std::getline(f, line))
+        {
+            std::string::size_type p(line.find(' '));
+            if (std::string::npos == p)
+                continue;
+            result.push_back(std::make_pair(line.substr(0, p), line.substr(p + 1)));
+        }
+    }
+
+    return result;
+}
+
+void
+Imp<RepositoryOwnersCache>::write_bucket(const std::string & b, OwnersCacheBucket & lines) const
+{
+    FSPath ff(location / b);
+
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    if (lines.empty())
+    {
+        if (ff.stat().exists())
+        {
+            try
+            {
+                ff.unlink();
+            }
+            catch (const FSError & e)
+            {
+                Log::get_instance()->message("repository.owners_cache.unlink_failed", ll_warning, lc_context)
+                    << "Cannot unlink '" << ff << "': " << e.message() << " (" << e.what() << ")";
+            }
+        }
+        return;
+    }
+
+    try
+    {
+        SafeOFStream f(ff, -1, true);
+        for (OwnersCacheBucket::const_iterator l(lines.begin()), l_end(lines.end()) ;
+                l != l_end ; ++l)
+            f << l->first << " " << l->second << std::endl;
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("repository.owners_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write '" << ff << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+void
+Imp<RepositoryOwnersCache>::write_version() const
+{
+    try
+    {
+        SafeOFStream f(location / "_VERSION_", -1, true);
+        f << "paludis-owners-2" << std::endl;
+        f << repo->name() << std::endl;
+    }
+    catch (const SafeOFStreamError & e)
+    {
+        Log::get_instance()->message("repository.owners_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write to '" << location << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+RepositoryOwnersCache::RepositoryOwnersCache(
+        const FSPath & location,
+        const Repository * const repo,
+        const std::string & contents_filename) :
+    _imp(location, repo, contents_filename)
+{
+}
+
+RepositoryOwnersCache::~RepositoryOwnersCache()
+{
+}
+
+std::shared_ptr<const PackageIDSet>
+RepositoryOwnersCache::candidate_owners(const std::string & q) const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! _imp->check())
+        return nullptr;
+
+    Context context("When using owners cache at '" + stringify(_imp->location) + "':");
+
+    if (! _imp->load_current_ids())
+        return nullptr;
+
+    bool full((! q.empty()) && '/' == q.at(0));
+    std::string q_basename(basename_of(q));
+
+    std::shared_ptr<PackageIDSet> result(std::make_shared<PackageIDSet>());
+    OwnersCacheBucket lines(_imp->load_bucket(bucket_name(q_basename)));
+    for (OwnersCacheBucket::const_iterator i(lines.begin()), i_end(lines.end()) ;
+            i != i_end ; ++i)
+    {
+        if (full ? i->second != q : basename_of(i->second) != q_basename)
+            continue;
+
+        OwnersCacheIDMap::const_iterator r(_imp->current_ids->find(i->first));
+        if (_imp->current_ids->end() != r)
+            std::copy(r->second->begin(), r->second->end(), result->inserter());
+    }
+
+    return result;
+}
+
+void
+RepositoryOwnersCache::regenerate_cache() const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    Context context("When generating repository owners cache at '"
+            + stringify(_imp->location) + "':");
+
+    if (_imp->location.stat().is_directory())
+        for (FSIterator i(_imp->location, { fsio_inode_sort }), i_end ; i != i_end ; ++i)
+            i->unlink();
+
+    _imp->location.dirname().mkdir(0755, { fspmkdo_ok_if_exists });
+    _imp->location.mkdir(0755, { fspmkdo_ok_if_exists });
+
+    std::map<std::string, OwnersCacheBucket> buckets;
+    _imp->indexed_ids = std::make_shared<std::set<std::pair<std::string, std::string> > >();
+    _imp->current_ids.reset();
+
+    std::shared_ptr<const CategoryNamePartSet> cats(_imp->repo->category_names({ }));
+    for (CategoryNamePartSet::ConstIterator c(cats->begin()), c_end(cats->end()) ;
+            c != c_end ; ++c)
+    {
+        std::shared_ptr<const QualifiedPackageNameSet> pkgs(_imp->repo->package_names(*c, { }));
+        for (QualifiedPackageNameSet::ConstIterator p(pkgs->begin()), p_end(pkgs->end()) ;
+                p != p_end ; ++p)
+        {
+            std::shared_ptr<const PackageIDSequence> ids(_imp->repo->package_ids(*p, { }));
+            for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                    i != i_end ; ++i)
+            {
+                std::string key(key_for(**i));
+                _imp->indexed_ids->insert(std::make_pair(key, signature_for(**i, _imp->contents_filename)));
+
+                std::shared_ptr<const Contents> contents((*i)->contents());
+                if (! contents)
+                    continue;
+
+                for (Contents::ConstIterator e(contents->begin()), e_end(contents->end()) ;
+                        e != e_end ; ++e)
+                {
+                    std::string path(stringify((*e)->location_key()->parse_value()));
+                    buckets[bucket_name(basename_of(path))].push_back(std::make_pair(key, path));
+                }
+            }
+        }
+    }
+
+    for (std::map<std::string, OwnersCacheBucket>::iterator b(buckets.begin()), b_end(buckets.end()) ;
+            b != b_end ; ++b)
+        _imp->write_bucket(b->first, b->second);
+
+    _imp->write_indexed_ids();
+    _imp->write_version();
+
+    _imp->usable = true;
+    _imp->checked = true;
+}
+
+void
+RepositoryOwnersCache::add(const std::shared_ptr<const PackageID> & id)
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! _imp->check())
+        return;
+
+    Context context("When adding '" + stringify(*id) + "' to owners cache at '" + stringify(_imp->location) + "':");
+
+    std::string key(key_for(*id));
+    std::map<std::string, std::set<std::string> > paths;
+
+    std::shared_ptr<const Contents> contents(id->contents());
+    if (contents)
+        for (Contents::ConstIterator e(contents->begin()), e_end(contents->end()) ;
+                e != e_end ; ++e)
+        {
+            std::string path(stringify((*e)->location_key()->parse_value()));
+            paths[bucket_name(basename_of(path))].insert(path);
+        }
+
+    for (std::map<std::string, std::set<std::string> >::const_iterator b(paths.begin()), b_end(paths.end()) ;
+            b != b_end ; ++b)
+    {
+        OwnersCacheBucket lines(_imp->load_bucket(b->first));
+        for (std::set<std::string>::const_iterator p(b->second.begin()), p_end(b->second.end()) ;
+                p != p_end ; ++p)
+            lines.push_back(std::make_pair(key, *p));
+        _imp->write_bucket(b->first, lines);
+    }
+
+    _imp->load_indexed_ids();
+    _imp->indexed_ids->insert(std::make_pair(key, signature_for(*id, _imp->contents_filename)));
+    _imp->write_indexed_ids();
+    _imp->current_ids.reset();
+}
+
+void
+RepositoryOwnersCache::remove(const std::shared_ptr<const PackageID> & id)
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! _imp->check())
+        return;
+
+    Context context("When removing '" + stringify(*id) + "' from owners cache at '" + stringify(_imp->location) + "':");
+
+    std::string key(key_for(*id));
+    std::set<std::string> buckets;
+
+    std::shared_ptr<const Contents> contents(id->contents());
+    if (contents)
+        for (Contents::ConstIterator e(contents->begin()), e_end(contents->end()) ;
+                e != e_end ; ++e)
+            buckets.insert(bucket_name(basename_of(stringify((*e)->location_key()->parse_value()))));
+
+    /* anything we miss here is harmless, since callers check the contents of
+     * any candidates we return */
+    for (std::set<std::string>::const_iterator b(buckets.begin()), b_end(buckets.end()) ;
+            b != b_end ; ++b)
+    {
+        OwnersCacheBucket lines(_imp->load_bucket(*b));
+        lines.erase(std::remove_if(lines.begin(), lines.end(),
+                    [&] (const OwnersCacheLine & line) { return line.first == key; }),
+                lines.end());
+        _imp->write_bucket(*b, lines);
+    }
+
+    _imp->load_indexed_ids();
+    _imp->erase_indexed_id(key);
+    _imp->write_indexed_ids();
+    _imp->current_ids.reset();
+}
+
+bool
+RepositoryOwnersCache::usable() const
+{
+    return _imp->usable;
+}
+
+namespace paludis
+{
+    template class Pimp<RepositoryOwnersCache>;
+}
@@ -0,0 +1,122 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORY_OWNERS_CACHE_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORY_OWNERS_CACHE_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <memory>
+#include <string>
+
+/** \file
+ * Declarations for RepositoryOwnersCache, which is used by some installed
+ * Repository subclasses to implement a file to package index.
+ *
+ * \ingroup g_repository
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    class Repository;
+
+    /**
+     * Used by various installed Repository subclasses to map contents entries
+     * back to the IDs that own them, without having to load the contents of
+     * every installed ID.
+     *
+     * The cache is keyed upon basename, so it can answer both full path and
+     * basename queries. It may contain stale entries, so callers must still
+     * check the contents of any candidate IDs, but if it is usable it will
+     * not omit any owners. It is only usable if every ID's contents file
+     * still has the mtime and size it had when the ID was indexed.
+     *
+     * \see Repository
+     * \ingroup g_repository
+     * \nosubgrouping
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE RepositoryOwnersCache
+    {
+        private:
+            Pimp<RepositoryOwnersCache> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            RepositoryOwnersCache(
+                    const FSPath & location,
+                    const Repository * const repo,
+                    const std::string & contents_filename);
+
+            ~RepositoryOwnersCache();
+
+            RepositoryOwnersCache(const RepositoryOwnersCache &) = delete;
+            RepositoryOwnersCache & operator= (const RepositoryOwnersCache &) = delete;
+
+            ///\}
+
+            ///\name Cache helper functions
+            ///\{
+
+            /**
+             * Implement Repository::maybe_candidate_owners.
+             *
+             * If the query starts with a slash, it is treated as a full path,
+             * and otherwise as a basename. May return a zero pointer, if the
+             * cache has not been generated or does not cover every ID in the
+             * repository, in which case the caller must search every ID.
+             */
+            std::shared_ptr<const PackageIDSet> candidate_owners(const std::string &) const;
+
+            /**
+             * Whether or not our cache is usable.
+             *
+             * Initially this will be true. After the first query the value may
+             * change to false (the query will return a zero pointer too).
+             */
+            bool usable() const PALUDIS_ATTRIBUTE((nothrow));
+
+            /**
+             * Implement cache regeneration.
+             */
+            void regenerate_cache() const;
+
+            /**
+             * Add the contents of a newly merged ID to the cache.
+             */
+            void add(const std::shared_ptr<const PackageID> &);
+
+            /**
+             * Remove the contents of an ID that is being uninstalled from the
+             * cache.
+             */
+            void remove(const std::shared_ptr<const PackageID> &);
+
+            ///\}
+    };
+}
+
+#endif
@@ -25,6 +25,7 @@ namespace paludis
     namespace resolver
     {
         class Decider;
+        class DeciderJournal;
     }
 }
 
@@ -53,6 +53,7 @@
 #include <paludis/util/tribool.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/visitor_cast.hh>
+#include <paludis/util/hashes.hh>
 #include <paludis/environment.hh>
 #include <paludis/notifier_callback.hh>
 #include <paludis/repository.hh>
@@ -80,12 +81,93 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_set>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::resolver;
 
+namespace
+{
+    enum JournalOpKind
+    {
+        jok_create,
+        jok_constraint,
+        jok_decision
+    };
+
+    struct JournalOp
+    {
+        JournalOpKind kind;
+        Resolvent resolvent;
+        std::shared_ptr<const Constraint> constraint;
+        std::shared_ptr<Decision> decision;
+    };
+
+    struct JournalStep
+    {
+        /* empty for things done outside of a step, which we never replay */
+        std::string key;
+        std::vector<JournalOp> ops;
+        bool complete;
+    };
+}
+
 namespace paludis
 {
+    template <>
+    struct Imp<DeciderJournal>
+    {
+        std::vector<JournalStep> steps;
+        std::unordered_set<Resolvent, Hash<Resolvent> > restarted;
+
+        std::vector<JournalStep>::size_type position;
+        bool replaying;
+        bool in_step;
+
+        unsigned replayed_steps;
+        unsigned computed_steps;
+
+        Imp() :
+            position(0),
+            replaying(false),
+            in_step(false),
+            replayed_steps(0),
+            computed_steps(0)
+        {
+        }
+
+        void start()
+        {
+            position = 0;
+            replaying = true;
+            in_step = false;
+            replayed_steps = 0;
+            computed_steps = 0;
+        }
+
+        void stop_replaying()
+        {
+            if (replaying)
+            {
+                steps.resize(position);
+                replaying = false;
+            }
+        }
+
+        void record(const JournalOp & op)
+        {
+            if (! in_step)
+            {
+                stop_replaying();
+                if (steps.empty() || ! steps.back().key.empty())
+                    steps.push_back(JournalStep{ "", { }, true });
+            }
+
+            steps.back().ops.push_back(op);
+        }
+    };
+
     template <>
     struct Imp<Decider>
     {
@@ -94,20 +176,128 @@ namespace paludis
 
         const std::shared_ptr<ResolutionsByResolvent> resolutions_by_resolvent;
 
+        const std::shared_ptr<DeciderJournal> journal;
+
         Imp(const Environment * const e, const ResolverFunctions & f,
-                const std::shared_ptr<ResolutionsByResolvent> & l) :
+                const std::shared_ptr<ResolutionsByResolvent> & l,
+                const std::shared_ptr<DeciderJournal> & j) :
             env(e),
             fns(f),
-            resolutions_by_resolvent(l)
+            resolutions_by_resolvent(l),
+            journal(j)
         {
         }
     };
 }
 
+DeciderJournal::DeciderJournal() :
+    _imp()
+{
+}
+
+DeciderJournal::~DeciderJournal()
+{
+}
+
+void
+DeciderJournal::restarted(const Resolvent & r)
+{
+    _imp->restarted.insert(r);
+
+    auto s(_imp->steps.begin());
+    for (auto s_end(_imp->steps.end()) ; s != s_end ; ++s)
+    {
+        if (! s->complete)
+            break;
+
+        if (s->ops.end() != std::find_if(s->ops.begin(), s->ops.end(), [&] (const JournalOp & op) {
+                    return jok_create == op.kind && _imp->restarted.end() != _imp->restarted.find(op.resolvent); }))
+            break;
+    }
+
+    _imp->steps.erase(s, _imp->steps.end());
+}
+
+unsigned
+DeciderJournal::replayed_steps() const
+{
+    return _imp->replayed_steps;
+}
+
+unsigned
+DeciderJournal::computed_steps() const
+{
+    return _imp->computed_steps;
+}
+
 Decider::Decider(const Environment * const e, const ResolverFunctions & f,
         const std::shared_ptr<ResolutionsByResolvent> & l) :
-    _imp(e, f, l)
+    _imp(e, f, l, std::make_shared<DeciderJournal>())
+{
+    _imp->journal->_imp->start();
+}
+
+Decider::Decider(const Environment * const e, const ResolverFunctions & f,
+        const std::shared_ptr<ResolutionsByResolvent> & l,
+        const std::shared_ptr<DeciderJournal> & j) :
+    _imp(e, f, l, j)
+{
+    _imp->journal->_imp->start();
+}
+
+bool
+Decider::_replay_or_begin_step(const std::string & key)
+{
+    Imp<DeciderJournal> & journal(*_imp->journal->_imp.get());
+
+    if (journal.replaying && journal.position < journal.steps.size() && journal.steps[journal.position].key == key)
+    {
+        /* everything before this step happened exactly as it did last time,
+         * and this step does not involve anything whose initial constraints
+         * have changed, so it will do exactly what it did last time */
+        const JournalStep & step(journal.steps[journal.position]);
+        for (auto o(step.ops.begin()), o_end(step.ops.end()) ;
+                o != o_end ; ++o)
+            switch (o->kind)
+            {
+                case jok_create:
+                    _imp->resolutions_by_resolvent->insert_new(_create_resolution_for_resolvent(o->resolvent));
+                    break;
+
+                case jok_constraint:
+                    _resolution_for_resolvent(o->resolvent, false)->constraints()->add(o->constraint);
+                    break;
+
+                case jok_decision:
+                    _resolution_for_resolvent(o->resolvent, false)->decision() = o->decision;
+                    break;
+            }
+
+        ++journal.position;
+        ++journal.replayed_steps;
+        return true;
+    }
+
+    journal.stop_replaying();
+    journal.steps.push_back(JournalStep{ key, { }, false });
+    journal.in_step = true;
+    ++journal.computed_steps;
+    return false;
+}
+
+void
+Decider::_end_step()
+{
+    Imp<DeciderJournal> & journal(*_imp->journal->_imp.get());
+    journal.steps.back().complete = true;
+    journal.in_step = false;
+}
+
+void
+Decider::_set_decision(const std::shared_ptr<Resolution> & resolution, const std::shared_ptr<Decision> & decision)
 {
+    resolution->decision() = decision;
+    _imp->journal->_imp->record(JournalOp{ jok_decision, resolution->resolvent(), nullptr, decision });
 }
 
 Decider::~Decider()
@@ -151,9 +341,12 @@ Decider::_resolve_decide_with_dependencies()
             _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
             changed = true;
-            _decide(*i);
-
-            _add_dependencies_if_necessary(*i);
+            if (! _replay_or_begin_step("decide " + stringify((*i)->resolvent())))
+            {
+                _decide(*i);
+                _add_dependencies_if_necessary(*i);
+                _end_step();
+            }
         }
     }
 }
@@ -254,10 +447,10 @@ Decider::_resolve_dependents()
         if ((! remove) && (! resolution->decision()))
         {
             if (! _try_to_find_decision_for(resolution, false, false, false, false, false))
-                resolution->decision() = std::make_shared<BreakDecision>(
-                        resolvent,
-                        *s,
-                        true);
+                _set_decision(resolution, std::make_shared<BreakDecision>(
+                            resolvent,
+                            *s,
+                            true));
             else
             {
                 /* we'll do the actual deciding plus deps etc later */
@@ -492,6 +685,7 @@ Decider::_resolution_for_resolvent(const Resolvent & r, const Tribool if_not_exi
         {
             std::shared_ptr<Resolution> resolution(_create_resolution_for_resolvent(r));
             i = _imp->resolutions_by_resolvent->insert_new(resolution);
+            _imp->journal->_imp->record(JournalOp{ jok_create, r, nullptr, nullptr });
         }
         else if (if_not_exist.is_false())
             throw InternalError(PALUDIS_HERE, "resolver bug: expected resolution for "
@@ -627,6 +821,7 @@ Decider::_apply_resolution_constraint(
             _made_wrong_decision(resolution, constraint);
 
     resolution->constraints()->add(constraint);
+    _imp->journal->_imp->record(JournalOp{ jok_constraint, resolution->resolvent(), constraint, nullptr });
 }
 
 namespace
@@ -923,8 +1118,17 @@ Decider::_made_wrong_decision(
         const std::shared_ptr<Resolution> & resolution,
         const std::shared_ptr<const Constraint> & constraint)
 {
-    /* can we find a resolution that works for all our constraints? */
-    std::shared_ptr<Resolution> adapted_resolution(std::make_shared<Resolution>(*resolution));
+    /* can we find a resolution that works for all our constraints? copy the
+     * constraints rather than sharing them, so that the new constraint is
+     * only added to the real resolution by our caller, and only once */
+    std::shared_ptr<Resolution> adapted_resolution(std::make_shared<Resolution>(make_named_values<Resolution>(
+                    n::constraints() = std::make_shared<Constraints>(),
+                    n::decision() = resolution->decision(),
+                    n::resolvent() = resolution->resolvent()
+                    )));
+    for (Constraints::ConstIterator c(resolution->constraints()->begin()), c_end(resolution->constraints()->end()) ;
+            c != c_end ; ++c)
+        adapted_resolution->constraints()->add(*c);
     adapted_resolution->constraints()->add(constraint);
 
     if (_imp->fns.allowed_to_restart_fn()(adapted_resolution))
@@ -934,13 +1138,13 @@ Decider::_made_wrong_decision(
         if (decision)
         {
             resolution->decision()->accept(WrongDecisionVisitor([&] () { _suggest_restart_with(resolution, constraint, decision); }));
-            resolution->decision() = decision;
+            _set_decision(resolution, decision);
         }
         else
-            resolution->decision() = _cannot_decide_for(adapted_resolution);
+            _set_decision(resolution, _cannot_decide_for(adapted_resolution));
     }
     else
-        resolution->decision() = _cannot_decide_for(adapted_resolution);
+        _set_decision(resolution, _cannot_decide_for(adapted_resolution));
 }
 
 void
@@ -1006,9 +1210,9 @@ Decider::_decide(const std::shared_ptr<Resolution> & resolution)
     std::shared_ptr<Decision> decision(_try_to_find_decision_for(
                 resolution, _imp->fns.allow_choice_changes_fn()(resolution), false, true, false, true));
     if (decision)
-        resolution->decision() = decision;
+        _set_decision(resolution, decision);
     else
-        resolution->decision() = _cannot_decide_for(resolution);
+        _set_decision(resolution, _cannot_decide_for(resolution));
 }
 
 void
@@ -1920,6 +2124,9 @@ Decider::add_target_with_reason(const PackageOrBlockDepSpec & spec, const std::s
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
+    if (_replay_or_begin_step("target " + stringify(spec)))
+        return;
+
     /* empty resolvents is always ok for blockers, since blocking on things
      * that don't exist is fine */
     bool empty_is_ok(spec.if_block());
@@ -1946,6 +2153,8 @@ Decider::add_target_with_reason(const PackageOrBlockDepSpec & spec, const std::s
                 c != c_end ; ++c)
             _apply_resolution_constraint(dep_resolution, *c);
     }
+
+    _end_step();
 }
 
 void
@@ -49,11 +49,56 @@
 #include <paludis/changed_choices-fwd.hh>
 #include <paludis/name-fwd.hh>
 #include <tuple>
+#include <string>
 
 namespace paludis
 {
     namespace resolver
     {
+        /**
+         * Records what each step of a Decider did, so that a Decider created
+         * after a restart can replay the steps which the restart could not
+         * have affected, rather than working them out again.
+         *
+         * A step is adding a target, or deciding upon a resolution and adding
+         * its dependencies. Replaying stops at the first step which does not
+         * match, and at anything done outside of a step.
+         *
+         * \since 2.4
+         */
+        class PALUDIS_VISIBLE DeciderJournal
+        {
+            friend class Decider;
+
+            private:
+                Pimp<DeciderJournal> _imp;
+
+            public:
+                DeciderJournal();
+                ~DeciderJournal();
+
+                DeciderJournal(const DeciderJournal &) = delete;
+                DeciderJournal & operator= (const DeciderJournal &) = delete;
+
+                /**
+                 * The initial constraints for this resolvent have changed,
+                 * so forget the step which created its resolution, and every
+                 * step after it.
+                 */
+                void restarted(const Resolvent &);
+
+                /**
+                 * How many steps did the most recent Decider replay?
+                 */
+                unsigned replayed_steps() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * How many steps did the most recent Decider work out for
+                 * itself?
+                 */
+                unsigned computed_steps() const PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+
         class PALUDIS_VISIBLE Decider
         {
             private:
@@ -154,6 +199,10 @@ namespace paludis
                         const ChangesToMakeDecision &) const;
 
                 void _decide(const std::shared_ptr<Resolution> & resolution);
+                void _set_decision(const std::shared_ptr<Resolution> &, const std::shared_ptr<Decision> &);
+
+                bool _replay_or_begin_step(const std::string &);
+                void _end_step();
                 void _copy_other_destination_constraints(const std::shared_ptr<Resolution> & resolution);
 
                 const std::shared_ptr<Decision> _try_to_find_decision_for(
@@ -235,6 +284,13 @@ namespace paludis
                 Decider(const Environment * const,
                         const ResolverFunctions &,
                         const std::shared_ptr<ResolutionsByResolvent> &);
+
+                ///\since 2.4
+                Decider(const Environment * const,
+                        const ResolverFunctions &,
+                        const std::shared_ptr<ResolutionsByResolvent> &,
+                        const std::shared_ptr<DeciderJournal> &);
+
                 ~Decider();
 
                 void resolve();
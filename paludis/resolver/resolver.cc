@@ -28,6 +28,7 @@
 #include <paludis/resolver/job_list.hh>
 #include <paludis/resolver/job_lists.hh>
 #include <paludis/resolver/nag.hh>
+#include <paludis/resolver/suggest_restart.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/sequence.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
@@ -56,10 +57,11 @@ namespace paludis
 
         const std::shared_ptr<Resolved> resolved;
 
+        const std::shared_ptr<DeciderJournal> journal;
         const std::shared_ptr<Decider> decider;
         const std::shared_ptr<Orderer> orderer;
 
-        Imp(const Environment * const e, const ResolverFunctions & f) :
+        Imp(const Environment * const e, const ResolverFunctions & f, const std::shared_ptr<DeciderJournal> & j) :
             env(e),
             fns(f),
             resolved(std::make_shared<Resolved>(make_named_values<Resolved>(
@@ -76,7 +78,8 @@ namespace paludis
                             n::untaken_change_or_remove_decisions() = std::make_shared<Decisions<ChangeOrRemoveDecision>>(),
                             n::untaken_unable_to_make_decisions() = std::make_shared<Decisions<UnableToMakeDecision>>()
                             ))),
-            decider(std::make_shared<Decider>(e, f, resolved->resolutions_by_resolvent())),
+            journal(j),
+            decider(std::make_shared<Decider>(e, f, resolved->resolutions_by_resolvent(), journal)),
             orderer(std::make_shared<Orderer>(e, f, resolved))
         {
         }
@@ -84,7 +87,12 @@ namespace paludis
 }
 
 Resolver::Resolver(const Environment * const e, const ResolverFunctions & f) :
-    _imp(e, f)
+    _imp(e, f, std::make_shared<DeciderJournal>())
+{
+}
+
+Resolver::Resolver(const Environment * const e, const ResolverFunctions & f, const std::shared_ptr<DeciderJournal> & j) :
+    _imp(e, f, j)
 {
 }
 
@@ -92,6 +100,25 @@ Resolver::~Resolver()
 {
 }
 
+const std::shared_ptr<Resolver>
+Resolver::restarted(const SuggestRestart & e) const
+{
+    _imp->journal->restarted(e.resolvent());
+    return std::shared_ptr<Resolver>(new Resolver(_imp->env, _imp->fns, _imp->journal));
+}
+
+unsigned
+Resolver::reused_steps() const
+{
+    return _imp->journal->replayed_steps();
+}
+
+unsigned
+Resolver::computed_steps() const
+{
+    return _imp->journal->computed_steps();
+}
+
 void
 Resolver::add_target(const PackageOrBlockDepSpec & spec, const std::string & extra_information)
 {
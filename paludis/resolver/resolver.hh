@@ -24,6 +24,7 @@
 #include <paludis/resolver/reason-fwd.hh>
 #include <paludis/resolver/resolver_functions-fwd.hh>
 #include <paludis/resolver/decider-fwd.hh>
+#include <paludis/resolver/suggest_restart-fwd.hh>
 #include <paludis/resolver/resolved-fwd.hh>
 #include <paludis/resolver/sanitised_dependencies-fwd.hh>
 #include <paludis/resolver/package_or_block_dep_spec-fwd.hh>
@@ -47,12 +48,44 @@ namespace paludis
             private:
                 Pimp<Resolver> _imp;
 
+                Resolver(
+                        const Environment * const,
+                        const ResolverFunctions &,
+                        const std::shared_ptr<DeciderJournal> &);
+
             public:
                 Resolver(
                         const Environment * const,
                         const ResolverFunctions &);
                 ~Resolver();
 
+                /**
+                 * Return a new Resolver to use after the given restart. It
+                 * reuses whatever work the restart cannot have affected.
+                 *
+                 * The caller must update the initial constraints, and then
+                 * add the same targets, in the same order, as for this
+                 * Resolver.
+                 *
+                 * \since 2.4
+                 */
+                const std::shared_ptr<Resolver> restarted(const SuggestRestart &) const
+                    PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * How many decider steps did we reuse from before a restart?
+                 *
+                 * \since 2.4
+                 */
+                unsigned reused_steps() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * How many decider steps did we work out for ourselves?
+                 *
+                 * \since 2.4
+                 */
+                unsigned computed_steps() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
                 void add_target(const PackageOrBlockDepSpec &, const std::string & extra_information);
                 void add_target(const SetName &, const std::string & extra_information);
                 void purge();
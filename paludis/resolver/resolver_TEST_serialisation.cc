@@ -66,41 +66,51 @@ namespace
         {
             data.reset();
         }
+
+        void check_round_trip(const SerialiserFormat format)
+        {
+            std::shared_ptr<const Resolved> resolved;
+            {
+                std::shared_ptr<const Resolved> orig_resolved(data->get_resolved("serialisation/target"));
+                StringListStream str;
+                Serialiser ser(str, format);
+                orig_resolved->serialise(ser);
+                str.nothing_more_to_write();
+
+                Deserialiser deser(&data->env, str);
+                EXPECT_EQ(format, deser.format());
+                Deserialisation desern("ResolverLists", deser);
+                resolved = std::make_shared<Resolved>(Resolved::deserialise(desern));
+            }
+
+            this->check_resolved(resolved,
+                    n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                        .change(QualifiedPackageName("serialisation/dep"))
+                        .change(QualifiedPackageName("serialisation/target"))
+                        .finished()),
+                    n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                        .unable(QualifiedPackageName("serialisation/error"))
+                        .finished()),
+                    n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                        .finished()),
+                    n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                        .finished()),
+                    n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                        .change(QualifiedPackageName("serialisation/suggestion"))
+                        .finished()),
+                    n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                        .finished())
+                    );
+        }
     };
 }
 
 TEST_F(ResolverSerialisationTestCase, Serialisation)
 {
-    std::shared_ptr<const Resolved> resolved;
-    {
-        std::shared_ptr<const Resolved> orig_resolved(data->get_resolved("serialisation/target"));
-        StringListStream str;
-        Serialiser ser(str);
-        orig_resolved->serialise(ser);
-        str.nothing_more_to_write();
-
-        Deserialiser deser(&data->env, str);
-        Deserialisation desern("ResolverLists", deser);
-        resolved = std::make_shared<Resolved>(Resolved::deserialise(desern));
-    }
-
-    this->check_resolved(resolved,
-            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
-                .change(QualifiedPackageName("serialisation/dep"))
-                .change(QualifiedPackageName("serialisation/target"))
-                .finished()),
-            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
-                .unable(QualifiedPackageName("serialisation/error"))
-                .finished()),
-            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
-                .finished()),
-            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
-                .finished()),
-            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
-                .change(QualifiedPackageName("serialisation/suggestion"))
-                .finished()),
-            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
-                .finished())
-            );
+    check_round_trip(sf_text);
 }
 
+TEST_F(ResolverSerialisationTestCase, BinarySerialisation)
+{
+    check_round_trip(sf_binary);
+}
@@ -24,6 +24,8 @@
 #include <paludis/resolver/constraint.hh>
 #include <paludis/resolver/resolvent.hh>
 #include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/resolved.hh>
+#include <paludis/resolver/resolutions_by_resolvent.hh>
 
 #include <paludis/environments/test/test_environment.hh>
 
@@ -36,6 +38,7 @@
 #include <paludis/util/make_shared_copy.hh>
 
 #include <paludis/user_dep_spec.hh>
+#include <paludis/serialise.hh>
 #include <paludis/repository_factory.hh>
 
 #include <paludis/resolver/resolver_test.hh>
@@ -44,6 +47,7 @@
 #include <functional>
 #include <algorithm>
 #include <map>
+#include <sstream>
 
 using namespace paludis;
 using namespace paludis::resolver;
@@ -65,6 +69,20 @@ namespace
             data.reset();
         }
     };
+
+    std::map<std::string, std::string> constraints_by_resolvent(const std::shared_ptr<const Resolved> & resolved)
+    {
+        std::map<std::string, std::string> result;
+        for (const auto & r : *resolved->resolutions_by_resolvent())
+        {
+            std::stringstream k, v;
+            Serialiser ks(k), vs(v);
+            r->resolvent().serialise(ks);
+            r->constraints()->serialise(vs);
+            result.insert(std::make_pair(k.str(), v.str()));
+        }
+        return result;
+    }
 }
 
 TEST_F(ResolverSimpleTestCase, NoDeps)
@@ -159,3 +177,117 @@ TEST_F(ResolverSimpleTestCase, PostDeps)
             );
 }
 
+
+TEST_F(ResolverSimpleTestCase, Restart)
+{
+    PackageDepSpec target(parse_user_package_dep_spec("restart/target", &data->env, { }));
+
+    std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(&data->env, data->get_resolver_functions()));
+    int restarts(0);
+    while (true)
+    {
+        try
+        {
+            resolver->add_target(target, "");
+            resolver->resolve();
+            break;
+        }
+        catch (const SuggestRestart & e)
+        {
+            ++restarts;
+            data->get_initial_constraints_for_helper.add_suggested_restart(e);
+            resolver = resolver->restarted(e);
+        }
+    }
+
+    EXPECT_EQ(1, restarts);
+    EXPECT_EQ(1u, resolver->reused_steps());
+    EXPECT_EQ(4u, resolver->computed_steps());
+
+    /* replaying must give exactly the constraints a fresh run does */
+    std::shared_ptr<Resolver> fresh(std::make_shared<Resolver>(&data->env, data->get_resolver_functions()));
+    fresh->add_target(target, "");
+    fresh->resolve();
+    EXPECT_EQ(0u, fresh->reused_steps());
+    EXPECT_EQ(constraints_by_resolvent(fresh->resolved()), constraints_by_resolvent(resolver->resolved()));
+
+    this->check_resolved(resolver->resolved(),
+            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/a-dep"))
+                .change(QualifiedPackageName("restart/b-dep"))
+                .change(QualifiedPackageName("restart/z-dep"))
+                .change(QualifiedPackageName("restart/target"))
+                .finished()),
+            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart/a-dep"))
+                .finished()),
+            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished())
+            );
+}
+
+TEST_F(ResolverSimpleTestCase, RestartAfterUnable)
+{
+    PackageDepSpec target(parse_user_package_dep_spec("restart-unable/target", &data->env, { }));
+    data->allowed_to_restart_helper.add_no_restarts_for_spec(parse_user_package_dep_spec("restart-unable/n-dep", &data->env, { }));
+
+    std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(&data->env, data->get_resolver_functions()));
+    int restarts(0);
+    while (true)
+    {
+        try
+        {
+            resolver->add_target(target, "");
+            resolver->resolve();
+            break;
+        }
+        catch (const SuggestRestart & e)
+        {
+            ++restarts;
+            data->get_initial_constraints_for_helper.add_suggested_restart(e);
+            resolver = resolver->restarted(e);
+        }
+    }
+
+    EXPECT_EQ(1, restarts);
+    EXPECT_EQ(4u, resolver->reused_steps());
+    EXPECT_EQ(3u, resolver->computed_steps());
+
+    std::shared_ptr<Resolver> fresh(std::make_shared<Resolver>(&data->env, data->get_resolver_functions()));
+    fresh->add_target(target, "");
+    fresh->resolve();
+    EXPECT_EQ(constraints_by_resolvent(fresh->resolved()), constraints_by_resolvent(resolver->resolved()));
+
+    /* the constraint that made n-dep unable must only be there once */
+    for (const auto & r : *resolver->resolved()->resolutions_by_resolvent())
+        if (r->resolvent().package() == QualifiedPackageName("restart-unable/n-dep"))
+            EXPECT_EQ(2, std::distance(r->constraints()->begin(), r->constraints()->end()));
+
+    this->check_resolved(resolver->resolved(),
+            n::taken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart-unable/a-dep"))
+                .change(QualifiedPackageName("restart-unable/b-dep"))
+                .change(QualifiedPackageName("restart-unable/m-dep"))
+                .change(QualifiedPackageName("restart-unable/x-dep"))
+                .change(QualifiedPackageName("restart-unable/target"))
+                .finished()),
+            n::taken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .unable(QualifiedPackageName("restart-unable/n-dep"))
+                .finished()),
+            n::taken_unconfirmed_decisions() = make_shared_copy(DecisionChecks()
+                .change(QualifiedPackageName("restart-unable/a-dep"))
+                .finished()),
+            n::taken_unorderable_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_change_or_remove_decisions() = make_shared_copy(DecisionChecks()
+                .finished()),
+            n::untaken_unable_to_make_decisions() = make_shared_copy(DecisionChecks()
+                .finished())
+            );
+}
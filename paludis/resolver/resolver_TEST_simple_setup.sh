@@ -130,5 +130,112 @@ SLOT="0"
 DEPENDENCIES=""
 END
 
+# restart
+echo 'restart' >> metadata/categories.conf
+
+mkdir -p 'packages/restart/target'
+cat <<END > packages/restart/target/target-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart/a-dep restart/b-dep restart/z-dep"
+END
+
+mkdir -p 'packages/restart/a-dep'
+cat <<END > packages/restart/a-dep/a-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+cat <<END > packages/restart/a-dep/a-dep-2.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+mkdir -p 'packages/restart/b-dep'
+cat <<END > packages/restart/b-dep/b-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart/a-dep[<2]"
+END
+
+mkdir -p 'packages/restart/z-dep'
+cat <<END > packages/restart/z-dep/z-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+# restart-unable
+echo 'restart-unable' >> metadata/categories.conf
+
+mkdir -p 'packages/restart-unable/target'
+cat <<END > packages/restart-unable/target/target-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart-unable/n-dep restart-unable/x-dep restart-unable/m-dep"
+END
+
+mkdir -p 'packages/restart-unable/n-dep'
+cat <<END > packages/restart-unable/n-dep/n-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+cat <<END > packages/restart-unable/n-dep/n-dep-2.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+mkdir -p 'packages/restart-unable/x-dep'
+cat <<END > packages/restart-unable/x-dep/x-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart-unable/n-dep[<2]"
+END
+
+mkdir -p 'packages/restart-unable/m-dep'
+cat <<END > packages/restart-unable/m-dep/m-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart-unable/a-dep restart-unable/b-dep"
+END
+
+mkdir -p 'packages/restart-unable/a-dep'
+cat <<END > packages/restart-unable/a-dep/a-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+cat <<END > packages/restart-unable/a-dep/a-dep-2.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+mkdir -p 'packages/restart-unable/b-dep'
+cat <<END > packages/restart-unable/b-dep/b-dep-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: restart-unable/a-dep[<2]"
+END
+
 cd ..
 
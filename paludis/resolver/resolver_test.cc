@@ -197,18 +197,19 @@ ResolverTestData::get_resolver_functions()
 const std::shared_ptr<const Resolved>
 ResolverTestData::get_resolved(const PackageOrBlockDepSpec & target)
 {
+    std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(&env, get_resolver_functions()));
     while (true)
     {
         try
         {
-            Resolver resolver(&env, get_resolver_functions());
-            resolver.add_target(target, "");
-            resolver.resolve();
-            return resolver.resolved();
+            resolver->add_target(target, "");
+            resolver->resolve();
+            return resolver->resolved();
         }
         catch (const SuggestRestart & e)
         {
             get_initial_constraints_for_helper.add_suggested_restart(e);
+            resolver = resolver->restarted(e);
         }
     }
 }
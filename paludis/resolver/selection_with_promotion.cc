@@ -76,6 +76,14 @@ namespace
             {
                 return "all versions sorted from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                std::string k(_fg.cache_key());
+                if (k.empty())
+                    return "";
+                return "all_versions_sorted_with_promotion:" + k;
+            }
     };
 }
 
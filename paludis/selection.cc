@@ -99,6 +99,12 @@ Selection::as_string() const
     return _imp->handler->as_string();
 }
 
+std::string
+Selection::cache_key() const
+{
+    return _imp->handler->cache_key();
+}
+
 namespace
 {
     std::string slot_as_string(const std::shared_ptr<const PackageID> & id)
@@ -109,6 +115,14 @@ namespace
             return "(none)";
     }
 
+    std::string make_cache_key(const std::string & name, const FilteredGenerator & fg)
+    {
+        std::string k(fg.cache_key());
+        if (k.empty())
+            return "";
+        return name + ":" + k;
+    }
+
     class SomeArbitraryVersionSelectionHandler :
         public SelectionHandler
     {
@@ -154,6 +168,11 @@ namespace
             {
                 return "some arbitrary version from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("some_arbitrary_version", _fg);
+            }
     };
 
     class BestVersionOnlySelectionHandler :
@@ -200,6 +219,11 @@ namespace
             {
                 return "best version of each package from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("best_version_only", _fg);
+            }
     };
 
     class AllVersionsSortedSelectionHandler :
@@ -241,6 +265,11 @@ namespace
             {
                 return "all versions sorted from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("all_versions_sorted", _fg);
+            }
     };
 
     class AllVersionsUnsortedSelectionHandler :
@@ -281,6 +310,11 @@ namespace
             {
                 return "all versions in some arbitrary order from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("all_versions_unsorted", _fg);
+            }
     };
 
     class AllVersionsGroupedBySlotSelectioHandler :
@@ -348,6 +382,11 @@ namespace
             {
                 return "all versions grouped by slot from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("all_versions_grouped_by_slot", _fg);
+            }
     };
 
     class BestVersionInEachSlotSelectionHandler :
@@ -415,6 +454,11 @@ namespace
             {
                 return "best version in each slot from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("best_version_in_each_slot", _fg);
+            }
     };
 
     class RequireExactlyOneSelectionHandler :
@@ -459,6 +503,11 @@ namespace
             {
                 return "the single version from " + stringify(_fg);
             }
+
+            virtual std::string cache_key() const
+            {
+                return make_cache_key("require_exactly_one", _fg);
+            }
     };
 }
 
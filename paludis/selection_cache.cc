@@ -0,0 +1,160 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/selection_cache.hh>
+#include <paludis/selection.hh>
+#include <paludis/environment.hh>
+#include <paludis/package_id.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/hashes.hh>
+#include <unordered_map>
+#include <mutex>
+
+using namespace paludis;
+
+namespace paludis
+{
+    template <>
+    struct Imp<SelectionCache>
+    {
+        mutable std::mutex mutex;
+        mutable std::unordered_map<std::string, std::shared_ptr<const PackageIDSequence>, Hash<std::string> > results;
+        mutable unsigned long generation, hits, misses;
+
+        Imp() :
+            generation(0),
+            hits(0),
+            misses(0)
+        {
+        }
+    };
+
+    template <>
+    struct Imp<ScopedSelectionCache>
+    {
+        Environment * const env;
+        const std::shared_ptr<SelectionCache> cache;
+
+        Imp(Environment * const e) :
+            env(e),
+            cache(std::make_shared<SelectionCache>())
+        {
+        }
+    };
+}
+
+namespace
+{
+    std::shared_ptr<PackageIDSequence> copy_of(const PackageIDSequence & s)
+    {
+        std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
+        std::copy(s.begin(), s.end(), result->back_inserter());
+        return result;
+    }
+}
+
+SelectionCache::SelectionCache() :
+    _imp()
+{
+}
+
+SelectionCache::~SelectionCache()
+{
+}
+
+std::shared_ptr<PackageIDSequence>
+SelectionCache::perform_select(const Environment * const env, const Selection & selection) const
+{
+    const std::string key(selection.cache_key());
+    if (key.empty())
+        return selection.perform_select(env);
+
+    unsigned long generation;
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        auto r(_imp->results.find(key));
+        if (r != _imp->results.end())
+        {
+            ++_imp->hits;
+            return copy_of(*r->second);
+        }
+
+        ++_imp->misses;
+        generation = _imp->generation;
+    }
+
+    /* don't hold the lock whilst selecting, since selecting can recurse */
+    std::shared_ptr<PackageIDSequence> result(selection.perform_select(env));
+
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        if (generation == _imp->generation)
+            _imp->results.insert(std::make_pair(key, copy_of(*result)));
+    }
+
+    return result;
+}
+
+void
+SelectionCache::clear() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->results.clear();
+    ++_imp->generation;
+}
+
+unsigned long
+SelectionCache::hits() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    return _imp->hits;
+}
+
+unsigned long
+SelectionCache::misses() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    return _imp->misses;
+}
+
+ScopedSelectionCache::ScopedSelectionCache(Environment * const e) :
+    _imp(e)
+{
+    _imp->env->add_selection_cache(_imp->cache);
+}
+
+ScopedSelectionCache::~ScopedSelectionCache()
+{
+    _imp->env->remove_selection_cache(_imp->cache);
+}
+
+const std::shared_ptr<const SelectionCache>
+ScopedSelectionCache::cache() const
+{
+    return _imp->cache;
+}
+
+namespace paludis
+{
+    template class Pimp<SelectionCache>;
+    template class Pimp<ScopedSelectionCache>;
+}
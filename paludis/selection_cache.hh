@@ -0,0 +1,136 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_SELECTION_CACHE_HH
+#define PALUDIS_GUARD_PALUDIS_SELECTION_CACHE_HH 1
+
+#include <paludis/selection_cache-fwd.hh>
+#include <paludis/selection-fwd.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <memory>
+
+/** \file
+ * Declarations for the SelectionCache class.
+ *
+ * \ingroup g_selections
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    /**
+     * Remembers the results of Environment::operator[], for code which
+     * performs the same Selection many times.
+     *
+     * Only a Selection with a non-empty Selection::cache_key() is cached.
+     * Anything else is passed straight through. An Environment clears its
+     * caches when a Repository is invalidated, or when its configuration
+     * changes.
+     *
+     * \see ScopedSelectionCache
+     * \ingroup g_selections
+     * \nosubgrouping
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE SelectionCache
+    {
+        private:
+            Pimp<SelectionCache> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            SelectionCache();
+            ~SelectionCache();
+
+            SelectionCache(const SelectionCache &) = delete;
+            SelectionCache & operator= (const SelectionCache &) = delete;
+
+            ///\}
+
+            /**
+             * Perform a selection, using a cached result if we have one.
+             *
+             * The result is always a fresh sequence, which the caller may
+             * modify.
+             */
+            std::shared_ptr<PackageIDSequence> perform_select(
+                    const Environment * const,
+                    const Selection &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Forget every cached result.
+             */
+            void clear() const;
+
+            /**
+             * How many selections have been answered from the cache?
+             */
+            unsigned long hits() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * How many cacheable selections have had to be performed?
+             */
+            unsigned long misses() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    /**
+     * Adds a SelectionCache to an Environment for as long as we exist.
+     *
+     * \see SelectionCache
+     * \ingroup g_selections
+     * \nosubgrouping
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE ScopedSelectionCache
+    {
+        private:
+            Pimp<ScopedSelectionCache> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            explicit ScopedSelectionCache(Environment * const);
+            ~ScopedSelectionCache();
+
+            ScopedSelectionCache(const ScopedSelectionCache &) = delete;
+            ScopedSelectionCache & operator= (const ScopedSelectionCache &) = delete;
+
+            ///\}
+
+            /**
+             * Our cache, for looking at its counters.
+             */
+            const std::shared_ptr<const SelectionCache> cache() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    extern template class Pimp<SelectionCache>;
+    extern template class Pimp<ScopedSelectionCache>;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/selection_cache.hh>
+#include <paludis/selection.hh>
+#include <paludis/generator.hh>
+#include <paludis/filter.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/user_dep_spec.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/make_named_values.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct SelectionCacheTest :
+        testing::Test
+    {
+        TestEnvironment env;
+        std::shared_ptr<FakeRepository> repo;
+
+        void SetUp()
+        {
+            repo = std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                        n::environment() = &env,
+                        n::name() = RepositoryName("repo")));
+            repo->add_version("cat", "pkg", "1");
+            repo->add_version("cat", "pkg", "2");
+            env.add_repository(1, repo);
+        }
+
+        long count(const Selection & s)
+        {
+            std::shared_ptr<const PackageIDSequence> ids(env[s]);
+            return std::distance(ids->begin(), ids->end());
+        }
+    };
+}
+
+TEST_F(SelectionCacheTest, CacheKeys)
+{
+    PackageDepSpec d(parse_user_package_dep_spec("cat/pkg", &env, { }));
+
+    EXPECT_EQ(selection::AllVersionsSorted(generator::Matches(d, nullptr, { })).cache_key(),
+            selection::AllVersionsSorted(generator::Matches(d, nullptr, { })).cache_key());
+    EXPECT_NE(selection::AllVersionsSorted(generator::Matches(d, nullptr, { })).cache_key(),
+            selection::BestVersionOnly(generator::Matches(d, nullptr, { })).cache_key());
+    EXPECT_NE(selection::AllVersionsSorted(generator::Matches(d, nullptr, { })).cache_key(),
+            selection::AllVersionsSorted(generator::Matches(d, nullptr, { mpo_ignore_additional_requirements })).cache_key());
+    EXPECT_NE(selection::AllVersionsSorted(generator::Matches(d, nullptr, { })).cache_key(),
+            selection::AllVersionsSorted(generator::Matches(d, nullptr, { }) | filter::NotMasked()).cache_key());
+    EXPECT_NE(selection::AllVersionsSorted(generator::Package(QualifiedPackageName("cat/pkg")) & generator::All()).cache_key(),
+            selection::AllVersionsSorted(generator::All() & generator::Package(QualifiedPackageName("cat/pkg"))).cache_key());
+
+    EXPECT_EQ("", selection::AllVersionsSorted(generator::All() | filter::ByFunction(
+                    [] (const std::shared_ptr<const PackageID> &) { return false; }, "everything")).cache_key());
+    EXPECT_NE("", selection::AllVersionsSorted(generator::All() | filter::NotMasked()).cache_key());
+}
+
+TEST_F(SelectionCacheTest, HitsAndMisses)
+{
+    ScopedSelectionCache cache(&env);
+    Selection s(selection::AllVersionsSorted(generator::Package(QualifiedPackageName("cat/pkg"))));
+
+    EXPECT_EQ(2, count(s));
+    EXPECT_EQ(1u, cache.cache()->misses());
+    EXPECT_EQ(0u, cache.cache()->hits());
+
+    std::shared_ptr<PackageIDSequence> r(env[s]);
+    r->push_back(*r->begin());
+    EXPECT_EQ(2, count(s));
+    EXPECT_EQ(1u, cache.cache()->misses());
+    EXPECT_EQ(2u, cache.cache()->hits());
+
+    Selection u(selection::AllVersionsSorted(generator::All() | filter::ByFunction(
+                    [] (const std::shared_ptr<const PackageID> &) { return false; }, "everything")));
+    EXPECT_EQ(2, count(u));
+    EXPECT_EQ(1u, cache.cache()->misses());
+    EXPECT_EQ(2u, cache.cache()->hits());
+}
+
+TEST_F(SelectionCacheTest, Invalidation)
+{
+    ScopedSelectionCache cache(&env);
+    Selection s(selection::AllVersionsSorted(generator::Package(QualifiedPackageName("cat/pkg"))));
+
+    EXPECT_EQ(2, count(s));
+
+    repo->add_version("cat", "pkg", "3");
+    EXPECT_EQ(2, count(s));
+
+    repo->invalidate();
+    EXPECT_EQ(3, count(s));
+    EXPECT_EQ(2u, cache.cache()->misses());
+}
+
+TEST_F(SelectionCacheTest, Scope)
+{
+    Selection s(selection::AllVersionsSorted(generator::Package(QualifiedPackageName("cat/pkg"))));
+
+    {
+        ScopedSelectionCache cache(&env);
+        EXPECT_EQ(2, count(s));
+    }
+
+    repo->add_version("cat", "pkg", "3");
+    EXPECT_EQ(3, count(s));
+}
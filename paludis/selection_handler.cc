@@ -25,3 +25,9 @@ SelectionHandler::~SelectionHandler()
 {
 }
 
+std::string
+SelectionHandler::cache_key() const
+{
+    return "";
+}
+
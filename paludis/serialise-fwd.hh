@@ -20,12 +20,17 @@
 #ifndef PALUDIS_GUARD_PALUDIS_SERIALISE_FWD_HH
 #define PALUDIS_GUARD_PALUDIS_SERIALISE_FWD_HH 1
 
+#include <paludis/util/attributes.hh>
+#include <iosfwd>
+
 namespace paludis
 {
     class Serialiser;
 
     class Deserialiser;
     class Deserialisation;
+
+#include <paludis/serialise-se.hh>
 }
 
 #endif
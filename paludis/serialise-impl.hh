@@ -25,6 +25,7 @@
 #include <paludis/util/destringify.hh>
 #include <paludis/util/options.hh>
 #include <paludis/util/tokeniser.hh>
+#include <paludis/util/stringify.hh>
 #include <paludis/package_id-fwd.hh>
 #include <paludis/dep_spec-fwd.hh>
 #include <type_traits>
@@ -95,9 +96,7 @@ namespace paludis
                 ss << i;
             }
 
-            s.raw_stream() << "\"";
-            s.escape_write(ss.str());
-            s.raw_stream() << "\";";
+            s.write_string(ss.str());
         }
     };
 
@@ -132,7 +131,7 @@ namespace paludis
                 SerialiserObjectWriterHandler<is_container_, false, typename RemoveSharedPtr<T_>::Type>::write(
                         s, *t);
             else
-                s.raw_stream() << "null;";
+                s.write_null();
         }
     };
 
@@ -166,7 +165,7 @@ namespace paludis
     {
         static void write(Serialiser & s, const T_ & t)
         {
-            s.raw_stream() << "c(";
+            SerialiserObjectWriter w(s.object("c"));
             unsigned n(0);
             for (typename SerialiserConstIteratorType<T_>::Type i(t.begin()), i_end(t.end()) ;
                     i != i_end ; ++i)
@@ -175,7 +174,7 @@ namespace paludis
                     typename SerialiserConstIteratorType<T_>::Type>::value_type ItemValueType;
                 typedef typename std::remove_reference<ItemValueType>::type ItemType;
 
-                s.raw_stream() << ++n << "=";
+                s.write_member_name(stringify(++n));
                 SerialiserObjectWriterHandler<
                     false,
                     ! std::is_same<ItemType, typename RemoveSharedPtr<ItemType>::Type>::value,
@@ -183,10 +182,8 @@ namespace paludis
                         >::write(s, *i);
             }
 
-            s.raw_stream() << "count=";
+            s.write_member_name("count");
             SerialiserObjectWriterHandler<false, false, int>::write(s, n);
-
-            s.raw_stream() << ");";
         }
     };
 
@@ -199,7 +196,7 @@ namespace paludis
             const std::string & item_name,
             const T_ & t)
     {
-        _serialiser.raw_stream() << item_name << "=";
+        _serialiser.write_member_name(item_name);
 
         SerialiserObjectWriterHandler<
             SerialiserFlagsInclude<Flags_, serialise::container>::value,
@@ -24,6 +24,7 @@
 #include <paludis/util/sequence-impl.hh>
 #include <paludis/util/join.hh>
 #include <paludis/util/member_iterator-impl.hh>
+#include <paludis/util/hashes.hh>
 #include <paludis/package_id.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/selection.hh>
@@ -33,9 +34,82 @@
 #include <paludis/elike_package_dep_spec.hh>
 #include <list>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 using namespace paludis;
 
+namespace
+{
+    /* The binary format is a header, followed by a sequence of tokens. Each
+     * string is written in full the first time it is used, and thereafter as
+     * an index into the strings we have already seen. */
+    const char binary_magic[] = { '\0', 'P', 'B', 'S' };
+    const char binary_version(1);
+
+    const char tag_object('O');
+    const char tag_member('M');
+    const char tag_end_object(')');
+    const char tag_string('S');
+    const char tag_null('N');
+
+    void write_varint(std::ostream & s, std::size_t n)
+    {
+        while (n >= 0x80)
+        {
+            s.put(static_cast<char>((n & 0x7f) | 0x80));
+            n >>= 7;
+        }
+        s.put(static_cast<char>(n));
+    }
+
+    std::size_t read_varint(std::istream & s)
+    {
+        std::size_t result(0);
+        for (unsigned shift(0) ; ; shift += 7)
+        {
+            char c;
+            if (shift >= 8 * sizeof(std::size_t) || ! s.get(c))
+                throw InternalError(PALUDIS_HERE, "can't parse varint");
+
+            result |= static_cast<std::size_t>(static_cast<unsigned char>(c) & 0x7f) << shift;
+            if (! (static_cast<unsigned char>(c) & 0x80))
+                return result;
+        }
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<Serialiser>
+    {
+        std::ostream & stream;
+        const SerialiserFormat format;
+        std::unordered_map<std::string, std::size_t, Hash<std::string> > strings;
+
+        Imp(std::ostream & s, const SerialiserFormat f) :
+            stream(s),
+            format(f)
+        {
+        }
+
+        void write_interned(const std::string & t)
+        {
+            auto i(strings.find(t));
+            if (i != strings.end())
+                write_varint(stream, i->second);
+            else
+            {
+                write_varint(stream, 0);
+                write_varint(stream, t.length());
+                stream.write(t.data(), t.length());
+                strings.insert(std::make_pair(t, strings.size() + 1));
+            }
+        }
+    };
+}
+
 SerialiserObjectWriter::SerialiserObjectWriter(Serialiser & s) :
     _serialiser(s)
 {
@@ -43,60 +117,167 @@ SerialiserObjectWriter::SerialiserObjectWriter(Serialiser & s) :
 
 SerialiserObjectWriter::~SerialiserObjectWriter()
 {
-    _serialiser.raw_stream() << ");";
+    _serialiser.write_end_object();
 }
 
 Serialiser::Serialiser(std::ostream & s) :
-    _stream(s)
+    _imp(s, sf_text)
 {
 }
 
+Serialiser::Serialiser(std::ostream & s, const SerialiserFormat f) :
+    _imp(s, f)
+{
+    if (sf_binary == _imp->format)
+    {
+        _imp->stream.write(binary_magic, sizeof(binary_magic));
+        _imp->stream.put(binary_version);
+    }
+}
+
 Serialiser::~Serialiser()
 {
 }
 
+SerialiserFormat
+Serialiser::format() const
+{
+    return _imp->format;
+}
+
 std::ostream &
 Serialiser::raw_stream()
 {
-    return _stream;
+    return _imp->stream;
 }
 
 SerialiserObjectWriter
 Serialiser::object(const std::string & c)
 {
-    raw_stream() << c << "(";
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << c << "(";
+            break;
+
+        case sf_binary:
+            _imp->stream.put(tag_object);
+            _imp->write_interned(c);
+            break;
+
+        case last_sf:
+            throw InternalError(PALUDIS_HERE, "bad format");
+    }
+
     return SerialiserObjectWriter(*this);
 }
 
+void
+Serialiser::write_member_name(const std::string & n)
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << n << "=";
+            return;
+
+        case sf_binary:
+            _imp->stream.put(tag_member);
+            _imp->write_interned(n);
+            return;
+
+        case last_sf:
+            break;
+    }
+
+    throw InternalError(PALUDIS_HERE, "bad format");
+}
+
+void
+Serialiser::write_string(const std::string & t)
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << "\"";
+            escape_write(t);
+            raw_stream() << "\";";
+            return;
+
+        case sf_binary:
+            _imp->stream.put(tag_string);
+            _imp->write_interned(t);
+            return;
+
+        case last_sf:
+            break;
+    }
+
+    throw InternalError(PALUDIS_HERE, "bad format");
+}
+
+void
+Serialiser::write_null()
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << "null;";
+            return;
+
+        case sf_binary:
+            _imp->stream.put(tag_null);
+            return;
+
+        case last_sf:
+            break;
+    }
+
+    throw InternalError(PALUDIS_HERE, "bad format");
+}
+
+void
+Serialiser::write_end_object()
+{
+    switch (_imp->format)
+    {
+        case sf_text:
+            raw_stream() << ");";
+            return;
+
+        case sf_binary:
+            _imp->stream.put(tag_end_object);
+            return;
+
+        case last_sf:
+            break;
+    }
+
+    throw InternalError(PALUDIS_HERE, "bad format");
+}
+
 void
 SerialiserObjectWriterHandler<false, false, bool>::write(Serialiser & s, const bool t)
 {
-    if (t)
-        s.raw_stream() << "\"true\";";
-    else
-        s.raw_stream() << "\"false\";";
+    s.write_string(t ? "true" : "false");
 }
 
 void
 SerialiserObjectWriterHandler<false, false, int>::write(Serialiser & s, const int i)
 {
-    s.raw_stream() << "\"" << i << "\";";
+    s.write_string(stringify(i));
 }
 
 void
 SerialiserObjectWriterHandler<false, false, std::string>::write(Serialiser & s, const std::string & t)
 {
-    s.raw_stream() << "\"";
-    s.escape_write(t);
-    s.raw_stream() << "\";";
+    s.write_string(t);
 }
 
 void
 SerialiserObjectWriterHandler<false, false, const PackageID>::write(Serialiser & s, const PackageID & t)
 {
-    s.raw_stream() << "\"";
-    s.escape_write(stringify(t.uniquely_identifying_spec()));
-    s.raw_stream() << "\";";
+    s.write_string(stringify(t.uniquely_identifying_spec()));
 }
 
 void
@@ -125,12 +306,35 @@ namespace paludis
     {
         const Environment * const env;
         std::istream & stream;
+        SerialiserFormat format;
+
+        std::vector<std::string> strings;
+        mutable std::unordered_map<std::string, std::shared_ptr<const PackageID>, Hash<std::string> > ids;
 
         Imp(const Environment * const e, std::istream & s) :
             env(e),
-            stream(s)
+            stream(s),
+            format(sf_text)
         {
         }
+
+        const std::string & read_interned()
+        {
+            std::size_t n(read_varint(stream));
+            if (0 == n)
+            {
+                std::size_t len(read_varint(stream));
+                std::string t(len, '\0');
+                if (len != 0 && ! stream.read(&t[0], len))
+                    throw InternalError(PALUDIS_HERE, "can't parse string");
+                strings.push_back(std::move(t));
+                return strings.back();
+            }
+            else if (n > strings.size())
+                throw InternalError(PALUDIS_HERE, "bad string index '" + stringify(n) + "'");
+            else
+                return strings[n - 1];
+        }
     };
 
     template <>
@@ -174,6 +378,21 @@ namespace paludis
 Deserialiser::Deserialiser(const Environment * const e, std::istream & s) :
     _imp(e, s)
 {
+    if (binary_magic[0] == _imp->stream.peek())
+    {
+        char magic[sizeof(binary_magic)];
+        if ((! _imp->stream.read(magic, sizeof(magic))) || (! std::equal(magic, magic + sizeof(magic), binary_magic)))
+            throw InternalError(PALUDIS_HERE, "bad binary serialisation header");
+
+        char version;
+        if (! _imp->stream.get(version))
+            throw InternalError(PALUDIS_HERE, "bad binary serialisation header");
+        if (binary_version != version)
+            throw InternalError(PALUDIS_HERE, "unsupported binary serialisation version '"
+                    + stringify(static_cast<int>(version)) + "'");
+
+        _imp->format = sf_binary;
+    }
 }
 
 Deserialiser::~Deserialiser()
@@ -192,9 +411,78 @@ Deserialiser::environment() const
     return _imp->env;
 }
 
+SerialiserFormat
+Deserialiser::format() const
+{
+    return _imp->format;
+}
+
+const std::shared_ptr<const PackageID>
+Deserialiser::fetch_package_id(const std::string & s) const
+{
+    auto i(_imp->ids.find(s));
+    if (i != _imp->ids.end())
+        return i->second;
+
+    Context context("When finding package ID '", s, "':");
+
+    std::shared_ptr<const PackageID> result(*(*_imp->env)[
+        selection::RequireExactlyOne(generator::Matches(
+                    parse_elike_package_dep_spec(s,
+                        { epdso_allow_tilde_greater_deps, epdso_nice_equal_star,
+                        epdso_allow_ranged_deps, epdso_allow_use_deps, epdso_allow_use_deps_portage,
+                        epdso_allow_use_dep_defaults, epdso_allow_repository_deps, epdso_allow_slot_star_deps,
+                        epdso_allow_slot_equal_deps, epdso_allow_slot_equal_deps_portage,
+                        epdso_allow_slot_deps, epdso_allow_key_requirements,
+                        epdso_allow_use_dep_question_defaults, epdso_allow_subslot_deps },
+                        { vso_flexible_dashes, vso_flexible_dots, vso_ignore_case,
+                        vso_letters_anywhere, vso_dotted_suffixes }), nullptr, { }))]->begin());
+
+    _imp->ids.insert(std::make_pair(s, result));
+    return result;
+}
+
 Deserialisation::Deserialisation(const std::string & i, Deserialiser & d) :
     _imp(d, i)
 {
+    if (sf_binary == d.format())
+    {
+        std::istream & stream(d.stream());
+
+        char c;
+        if (! stream.get(c))
+            throw InternalError(PALUDIS_HERE, "can't parse binary token");
+
+        switch (c)
+        {
+            case tag_string:
+                _imp->string_value = d._imp->read_interned();
+                return;
+
+            case tag_null:
+                _imp->null = true;
+                return;
+
+            case tag_object:
+                _imp->class_name = d._imp->read_interned();
+                while (true)
+                {
+                    if (! stream.get(c))
+                        throw InternalError(PALUDIS_HERE, "can't parse binary object");
+
+                    if (tag_end_object == c)
+                        return;
+                    else if (tag_member != c)
+                        throw InternalError(PALUDIS_HERE, "can't parse binary object");
+
+                    std::string k(d._imp->read_interned());
+                    _imp->children.push_back(std::make_shared<Deserialisation>(k, d));
+                }
+        }
+
+        throw InternalError(PALUDIS_HERE, "bad binary token '" + stringify(static_cast<int>(c)) + "'");
+    }
+
     char c;
     if (! d.stream().get(c))
         throw InternalError(PALUDIS_HERE, "can't parse string");
@@ -368,23 +656,16 @@ DeserialisatorHandler<std::shared_ptr<const PackageID> >::handle(Deserialisation
     if (v.null())
         return nullptr;
 
-    return *(*v.deserialiser().environment())[
-        selection::RequireExactlyOne(generator::Matches(
-                    parse_elike_package_dep_spec(v.string_value(),
-                        { epdso_allow_tilde_greater_deps, epdso_nice_equal_star,
-                        epdso_allow_ranged_deps, epdso_allow_use_deps, epdso_allow_use_deps_portage,
-                        epdso_allow_use_dep_defaults, epdso_allow_repository_deps, epdso_allow_slot_star_deps,
-                        epdso_allow_slot_equal_deps, epdso_allow_slot_equal_deps_portage,
-                        epdso_allow_slot_deps, epdso_allow_key_requirements,
-                        epdso_allow_use_dep_question_defaults, epdso_allow_subslot_deps },
-                        { vso_flexible_dashes, vso_flexible_dots, vso_ignore_case,
-                        vso_letters_anywhere, vso_dotted_suffixes }), nullptr, { }))]->begin();
+    return v.deserialiser().fetch_package_id(v.string_value());
 }
 
 namespace paludis
 {
+    template class Pimp<Serialiser>;
     template class Pimp<Deserialiser>;
     template class Pimp<Deserialisation>;
     template class Pimp<Deserialisator>;
     template class WrappedForwardIterator<Deserialisation::ConstIteratorTag, const std::shared_ptr<Deserialisation> >;
 }
+
+#include <paludis/serialise-se.cc>
@@ -25,6 +25,7 @@
 #include <paludis/util/wrapped_forward_iterator-fwd.hh>
 #include <paludis/serialise-fwd.hh>
 #include <paludis/environment-fwd.hh>
+#include <paludis/package_id-fwd.hh>
 #include <memory>
 #include <string>
 #include <ostream>
@@ -70,32 +71,79 @@ namespace paludis
     class PALUDIS_VISIBLE Serialiser
     {
         private:
-            std::ostream & _stream;
+            Pimp<Serialiser> _imp;
 
         public:
             Serialiser(std::ostream &);
+
+            ///\since 2.4
+            Serialiser(std::ostream &, const SerialiserFormat);
+
             ~Serialiser();
 
             SerialiserObjectWriter object(const std::string & class_name)
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            ///\since 2.4
+            SerialiserFormat format() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            ///\name Low level writing
+            ///\{
+
+            ///\since 2.4
+            void write_member_name(const std::string &);
+
+            ///\since 2.4
+            void write_string(const std::string &);
+
+            ///\since 2.4
+            void write_null();
+
+            ///\since 2.4
+            void write_end_object();
+
+            ///\}
+
+            /**
+             * Only meaningful for sf_text.
+             */
             std::ostream & raw_stream() PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            /**
+             * Only meaningful for sf_text.
+             */
             void escape_write(const std::string &);
     };
 
     class PALUDIS_VISIBLE Deserialiser
     {
+        friend class Deserialisation;
+
         private:
             Pimp<Deserialiser> _imp;
 
         public:
+            /**
+             * Constructor. The format is detected from the stream.
+             */
             Deserialiser(const Environment * const, std::istream &);
             ~Deserialiser();
 
             const Environment * environment() const PALUDIS_ATTRIBUTE((warn_unused_result));
 
             std::istream & stream() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            ///\since 2.4
+            SerialiserFormat format() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Find the PackageID with the given uniquely identifying spec.
+             * Each spec is only looked up once per Deserialiser.
+             *
+             * \since 2.4
+             */
+            const std::shared_ptr<const PackageID> fetch_package_id(const std::string &) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
     class PALUDIS_VISIBLE Deserialisation
@@ -153,6 +201,7 @@ namespace paludis
             const std::string &,
             const std::string &) PALUDIS_VISIBLE PALUDIS_ATTRIBUTE((warn_unused_result));
 
+    extern template class Pimp<Serialiser>;
     extern template class Pimp<Deserialiser>;
     extern template class Pimp<Deserialisation>;
     extern template class Pimp<Deserialisator>;
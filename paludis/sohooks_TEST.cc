@@ -75,6 +75,14 @@ paludis_hook_run_3(const Environment * env, const Hook & hook, const std::shared
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
+extern "C"
+void
+paludis_hook_finish_batch(const Environment *, const std::string & hook_name)
+{
+    SafeOFStream f(FSPath("hooker_TEST_dir/batch_so.out"), O_CREAT | O_WRONLY | O_APPEND, false);
+    f << hook_name << std::endl;
+}
+
 extern "C"
 void
 paludis_hook_add_dependencies(const Environment * env, const Hook & hook,
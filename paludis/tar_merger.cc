@@ -119,7 +119,9 @@ TarMerger::TarMerger(const TarMergerParams & p) :
                 n::maybe_output_manager() = p.maybe_output_manager(),
                 n::merged_entries() = p.merged_entries(),
                 n::no_chown() = p.no_chown(),
-                n::options() = p.options(),
+                /* everything goes into a single archive handle, so we can't
+                 * merge sibling directories at the same time */
+                n::options() = p.options() - mo_parallel,
                 n::permit_destination() = p.permit_destination(),
                 n::root() = p.root()
                 )),
@@ -137,6 +137,42 @@ TEST(TarMerger, Works)
     EXPECT_EQ("/bin/cat", (FSPath("tar_merger_TEST_dir") / "simple_extract" / "rewritesym").readlink());
 }
 
+TEST(TarMerger, IgnoresParallel)
+{
+    auto output(FSPath("tar_merger_TEST_dir") / "parallel.tar");
+
+    TestEnvironment env;
+    TestTarMerger merger(make_named_values<TarMergerParams>(
+                n::compression() = tmc_none,
+                n::environment() = &env,
+                n::fix_mtimes_before() = Timestamp(0, 0),
+                n::get_new_ids_or_minus_one() = &get_new_ids_or_minus_one,
+                n::image() = FSPath("tar_merger_TEST_dir") / "simple",
+                n::install_under() = FSPath("/"),
+                n::maybe_output_manager() = nullptr,
+                n::merged_entries() = std::make_shared<FSPathSet>(),
+                n::no_chown() = true,
+                n::options() = MergerOptions() + mo_rewrite_symlinks + mo_parallel,
+                n::permit_destination() = std::bind(return_literal_function(true)),
+                n::root() = FSPath("/"),
+                n::tar_file() = output
+                ));
+
+    ASSERT_TRUE(merger.check());
+    merger.merge();
+    output = FSPath(stringify(output));
+    ASSERT_TRUE(output.stat().is_regular_file());
+
+    Process untar_process(ProcessCommand({"sh", "-c", "tar xf ../parallel.tar 2>&1"}));
+    untar_process.chdir(FSPath("tar_merger_TEST_dir/parallel_extract"));
+    ASSERT_EQ(0, untar_process.run().wait());
+
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "parallel_extract" / "file").stat().is_regular_file());
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "parallel_extract" / "subdir" / "another").stat().is_regular_file());
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "parallel_extract" / "subdir" / "subsubdir" / "script").stat().is_regular_file());
+    EXPECT_TRUE((FSPath("tar_merger_TEST_dir") / "parallel_extract" / "goodsym").stat().is_symlink());
+}
+
 #else
 
 TEST(TarMerger, NotAvailable)
@@ -227,7 +227,7 @@ namespace
                     {
                         flag.erase(0, exclude.size());
 
-                        Context cc("When parsing exclude requirement '" + flag + "':");
+                        Context cc("When parsing exclude requirement '", flag, "':");
                         if (!env) throw PackageDepSpecError("Environment is null");
 
                         std::shared_ptr<const AdditionalPackageDepSpecRequirement> req(std::make_shared<ExcludeRequirement>(
@@ -360,7 +360,7 @@ paludis::parse_user_package_dep_spec(const std::string & ss, const Environment *
 {
     using namespace std::placeholders;
 
-    Context context("When parsing user package dep spec '" + ss + "':");
+    Context context("When parsing user package dep spec '", ss, "':");
 
     bool had_bracket_version_requirements(false);
     PartiallyMadePackageDepSpecOptions o;
@@ -388,7 +388,7 @@ paludis::envless_parse_package_dep_spec_for_tests(const std::string & ss)
 {
     using namespace std::placeholders;
 
-    Context context("When parsing test package dep spec '" + ss + "':");
+    Context context("When parsing test package dep spec '", ss, "':");
 
     bool had_bracket_version_requirements(false);
     PartiallyMadePackageDepSpecOptions o;
@@ -1014,7 +1014,7 @@ UserKeyRequirement::requirement_met(
         const std::shared_ptr<const PackageID> & from_id,
         const ChangedChoices * const) const
 {
-    Context context("When working out whether '" + stringify(*id) + "' matches " + as_raw_string() + ":");
+    Context context("When working out whether '", *id, "' matches key requirement on '", _imp->key, "':");
 
     const MetadataKey * key(nullptr);
     const Mask * mask(nullptr);
@@ -1186,7 +1186,7 @@ ExcludeRequirement::requirement_met(
         const std::shared_ptr<const PackageID> & from_id,
         const ChangedChoices * const) const
 {
-    Context context("When working out whether '" + stringify(*id) + "' matches " + as_raw_string() + ":");
+    Context context("When working out whether '", *id, "' matches exclude requirement '", _s, "':");
 
     return std::make_pair(!match_package(*env, _s, id, from_id, { }), as_human_string(from_id));
 }
@@ -21,6 +21,16 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/singleton-impl.hh>
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
+#include <paludis/util/thread_pool.hh>
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <streambuf>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <deque>
+#include <list>
 #include <map>
 
 using namespace paludis;
@@ -28,6 +38,121 @@ using namespace paludis;
 namespace
 {
     typedef std::map<std::string, DigestRegistry::Function> FunctionMap;
+
+    typedef std::shared_ptr<const std::vector<char> > Block;
+
+    const std::size_t block_size(1 << 16);
+    const std::size_t max_queued_blocks(4);
+
+    /* Blocks read from the input stream, waiting to be consumed by one
+     * algorithm. A zero pointer marks the end of the input. */
+    struct BlockQueue
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<Block> blocks;
+        bool abandoned;
+
+        BlockQueue() :
+            abandoned(false)
+        {
+        }
+
+        void push(const Block & block)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&] () { return abandoned || blocks.size() < max_queued_blocks; });
+            if (! abandoned)
+            {
+                blocks.push_back(block);
+                condition.notify_all();
+            }
+        }
+
+        Block pop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&] () { return ! blocks.empty(); });
+            Block result(blocks.front());
+            blocks.pop_front();
+            condition.notify_all();
+            return result;
+        }
+
+        void abandon()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            abandoned = true;
+            blocks.clear();
+            condition.notify_all();
+        }
+    };
+
+    class BlockQueueStreamBuf :
+        public std::streambuf
+    {
+        private:
+            BlockQueue & _queue;
+            Block _current;
+            bool _done;
+
+        protected:
+            virtual int_type underflow()
+            {
+                while (! _done)
+                {
+                    _current = _queue.pop();
+                    if (! _current)
+                        _done = true;
+                    else if (! _current->empty())
+                    {
+                        char * const b(const_cast<char *>(&(*_current)[0]));
+                        setg(b, b, b + _current->size());
+                        return traits_type::to_int_type(*gptr());
+                    }
+                }
+
+                return traits_type::eof();
+            }
+
+        public:
+            BlockQueueStreamBuf(BlockQueue & q) :
+                _queue(q),
+                _done(false)
+            {
+            }
+    };
+
+    struct Consumer
+    {
+        std::string algo;
+        DigestRegistry::Function function;
+        BlockQueue queue;
+        std::string result;
+        std::exception_ptr exception;
+
+        Consumer(const std::string & a, const DigestRegistry::Function & f) :
+            algo(a),
+            function(f)
+        {
+        }
+
+        void run() throw ()
+        {
+            try
+            {
+                BlockQueueStreamBuf buf(queue);
+                std::istream stream(&buf);
+                result = function(stream);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            queue.abandon();
+        }
+    };
 }
 
 namespace paludis
@@ -62,6 +187,68 @@ DigestRegistry::get(const std::string & algo) const
     return it->second;
 }
 
+std::map<std::string, std::string>
+DigestRegistry::digest_all(const std::set<std::string> & algos, std::istream & stream) const
+{
+    std::map<std::string, std::string> result;
+
+    std::list<Consumer> consumers;
+    for (auto a(algos.begin()), a_end(algos.end()) ; a != a_end ; ++a)
+    {
+        Function f(get(*a));
+        if (f)
+            consumers.emplace_back(*a, f);
+    }
+
+    if (consumers.empty())
+        return result;
+
+    if (1 == consumers.size())
+    {
+        result.insert(std::make_pair(consumers.begin()->algo, consumers.begin()->function(stream)));
+        return result;
+    }
+
+    {
+        ThreadPool pool;
+        for (auto c(consumers.begin()), c_end(consumers.end()) ; c != c_end ; ++c)
+            pool.create_thread(std::bind(&Consumer::run, &*c));
+
+        try
+        {
+            while (stream)
+            {
+                std::shared_ptr<std::vector<char> > block(std::make_shared<std::vector<char> >(block_size));
+                stream.read(&(*block)[0], block_size);
+                if (stream.gcount() <= 0)
+                    break;
+
+                block->resize(stream.gcount());
+                for (auto c(consumers.begin()), c_end(consumers.end()) ; c != c_end ; ++c)
+                    c->queue.push(block);
+            }
+        }
+        catch (...)
+        {
+            for (auto c(consumers.begin()), c_end(consumers.end()) ; c != c_end ; ++c)
+                c->queue.push(Block());
+            throw;
+        }
+
+        for (auto c(consumers.begin()), c_end(consumers.end()) ; c != c_end ; ++c)
+            c->queue.push(Block());
+    }
+
+    for (auto c(consumers.begin()), c_end(consumers.end()) ; c != c_end ; ++c)
+    {
+        if (c->exception)
+            std::rethrow_exception(c->exception);
+        result.insert(std::make_pair(c->algo, c->result));
+    }
+
+    return result;
+}
+
 DigestRegistry::AlgorithmsConstIterator
 DigestRegistry::begin_algorithms() const
 {
@@ -28,6 +28,8 @@
 #include <paludis/util/wrapped_forward_iterator-fwd.hh>
 #include <functional>
 #include <utility>
+#include <map>
+#include <set>
 
 namespace paludis
 {
@@ -46,6 +48,20 @@ namespace paludis
 
             Function get(const std::string & algo) const;
 
+            /**
+             * Calculate several digests of a stream, reading it only once.
+             *
+             * The stream is read in blocks, and each block is handed to every
+             * requested algorithm. If more than one algorithm is requested,
+             * each runs in its own thread. Unsupported algorithms are ignored,
+             * and are not present in the result.
+             *
+             * \since 2.4
+             */
+            std::map<std::string, std::string> digest_all(
+                    const std::set<std::string> & algos,
+                    std::istream & stream) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             struct AlgorithmsConstIteratorTag;
             typedef WrappedForwardIterator<AlgorithmsConstIteratorTag, const std::pair<const std::string, Function> > AlgorithmsConstIterator;
 
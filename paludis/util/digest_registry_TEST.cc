@@ -0,0 +1,85 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/digest_registry.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    std::string one(const std::string & algo, const std::string & data)
+    {
+        std::stringstream ss(data);
+        return DigestRegistry::get_instance()->get(algo)(ss);
+    }
+
+    void check_all(const std::string & data)
+    {
+        std::set<std::string> algos;
+        for (auto a(DigestRegistry::get_instance()->begin_algorithms()), a_end(DigestRegistry::get_instance()->end_algorithms()) ;
+                a != a_end ; ++a)
+            algos.insert(a->first);
+        algos.insert("UNSUPPORTED");
+
+        std::stringstream ss(data);
+        auto result(DigestRegistry::get_instance()->digest_all(algos, ss));
+
+        EXPECT_EQ(algos.size() - 1, result.size());
+        EXPECT_TRUE(result.end() == result.find("UNSUPPORTED"));
+        for (auto r(result.begin()), r_end(result.end()) ; r != r_end ; ++r)
+            EXPECT_EQ(one(r->first, data), r->second) << r->first;
+    }
+}
+
+TEST(DigestRegistry, DigestAllEmpty)
+{
+    check_all("");
+}
+
+TEST(DigestRegistry, DigestAllShort)
+{
+    check_all("The quick brown fox jumps over the lazy dog");
+}
+
+TEST(DigestRegistry, DigestAllLong)
+{
+    std::string data;
+    for (int i(0) ; i < 300000 ; ++i)
+        data.append(1, static_cast<char>(i * 7 + (i >> 8)));
+    check_all(data);
+}
+
+TEST(DigestRegistry, DigestAllSingle)
+{
+    std::stringstream ss("abc");
+    auto result(DigestRegistry::get_instance()->digest_all({ "MD5" }, ss));
+    ASSERT_EQ(1u, result.size());
+    EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", result.find("MD5")->second);
+}
+
+TEST(DigestRegistry, DigestAllNone)
+{
+    std::stringstream ss("abc");
+    EXPECT_TRUE(DigestRegistry::get_instance()->digest_all({ "UNSUPPORTED" }, ss).empty());
+}
@@ -25,6 +25,7 @@
 #include <paludis/util/elf_relocation_section.hh>
 #include <paludis/util/elf_symbol_section.hh>
 #include <paludis/util/elf_types.hh>
+#include <paludis/util/mapped_file.hh>
 
 #include <paludis/util/byte_swap.hh>
 #include <paludis/util/pimp-impl.hh>
@@ -137,6 +138,28 @@ namespace
             }
     };
 
+    template <typename ElfType_>
+    bool is_valid_ident(const char * const ident)
+    {
+        // Check the magic \177ELF bytes
+        if ( ! (    (   ident[EI_MAG0] == ELFMAG0)
+                    && (ident[EI_MAG1] == ELFMAG1)
+                    && (ident[EI_MAG2] == ELFMAG2)
+                    && (ident[EI_MAG3] == ELFMAG3)
+                    ) )
+            return false;
+
+        // Check the ELF file version
+        if (ident[EI_VERSION] != EV_CURRENT)
+            return false;
+
+        // Check whether the endianness is valid
+        if ((ident[EI_DATA] != ELFDATA2LSB) && (ident[EI_DATA] != ELFDATA2MSB))
+            return false;
+
+        return (ident[EI_CLASS] == ElfType_::elf_class);
+    }
+
     template <typename ElfType_>
     class StringResolvingVisitor
     {
@@ -238,23 +261,7 @@ ElfObject<ElfType_>::is_valid_elf(std::istream & stream)
         std::vector<char> ident(EI_NIDENT,0);
         stream.read(&ident.front(), EI_NIDENT);
 
-        // Check the magic \177ELF bytes
-        if ( ! (    (   ident[EI_MAG0] == ELFMAG0)
-                    && (ident[EI_MAG1] == ELFMAG1)
-                    && (ident[EI_MAG2] == ELFMAG2)
-                    && (ident[EI_MAG3] == ELFMAG3)
-                    ) )
-            return false;
-
-        // Check the ELF file version
-        if (ident[EI_VERSION] != EV_CURRENT)
-            return false;
-
-        // Check whether the endianness is valid
-        if ((ident[EI_DATA] != ELFDATA2LSB) && (ident[EI_DATA] != ELFDATA2MSB))
-            return false;
-
-        return (ident[EI_CLASS] == ElfType_::elf_class);
+        return is_valid_ident<ElfType_>(&ident.front());
     }
     catch (const std::ios_base::failure &)
     {
@@ -263,6 +270,13 @@ ElfObject<ElfType_>::is_valid_elf(std::istream & stream)
     }
 }
 
+template <typename ElfType_>
+bool
+ElfObject<ElfType_>::is_valid_elf(const MappedFile & file)
+{
+    return file.size() >= EI_NIDENT && is_valid_ident<ElfType_>(file.data());
+}
+
 template <typename ElfType_>
 ElfObject<ElfType_>::ElfObject(std::istream & stream) :
     _imp()
@@ -270,95 +284,109 @@ ElfObject<ElfType_>::ElfObject(std::istream & stream) :
     try
     {
         StreamExceptions exns(stream, std::ios::eofbit | std::ios::failbit | std::ios::badbit);
+        _load(ElfSource(stream));
+    }
+    catch (const std::ios_base::failure &)
+    {
+        throw InvalidElfFileError("file is truncated, or an offset points past the end of the file");
+    }
+}
 
-        stream.seekg(0, std::ios::beg);
-        stream.read(reinterpret_cast<char *>(&_hdr), sizeof(typename ElfType_::Header));
-        bool need_byte_swap(_hdr.e_ident[EI_DATA] != native_byte_order);
-        if (need_byte_swap)
-            ByteSwapElfHeader<ElfType_>::swap_in_place(_hdr);
+template <typename ElfType_>
+ElfObject<ElfType_>::ElfObject(const std::shared_ptr<const MappedFile> & file) :
+    _imp()
+{
+    _load(ElfSource(file));
+}
 
-        std::vector<typename ElfType_::SectionHeader> shdrs;
-        if (_hdr.e_shoff)
-        {
-            if (sizeof(typename ElfType_::SectionHeader) != _hdr.e_shentsize)
-                throw InvalidElfFileError(
-                    "bad e_shentsize: got " + stringify(_hdr.e_shentsize) + ", expected " +
-                    stringify(sizeof(typename ElfType_::SectionHeader)));
+template <typename ElfType_>
+void
+ElfObject<ElfType_>::_load(const ElfSource & source)
+{
+    source.read(0, sizeof(typename ElfType_::Header), &_hdr);
+    bool need_byte_swap(_hdr.e_ident[EI_DATA] != native_byte_order);
+    if (need_byte_swap)
+        ByteSwapElfHeader<ElfType_>::swap_in_place(_hdr);
+
+    std::vector<typename ElfType_::SectionHeader> shdrs;
+    if (_hdr.e_shoff)
+    {
+        if (sizeof(typename ElfType_::SectionHeader) != _hdr.e_shentsize)
+            throw InvalidElfFileError(
+                "bad e_shentsize: got " + stringify(_hdr.e_shentsize) + ", expected " +
+                stringify(sizeof(typename ElfType_::SectionHeader)));
 
-            stream.seekg(0, std::ios::end);
-            typename ElfType_::Word max_shdrs(
-                (typename ElfType_::Word(stream.tellg()) - _hdr.e_shoff) / sizeof(typename ElfType_::SectionHeader));
-            stream.seekg(_hdr.e_shoff, std::ios::beg);
+        uint64_t file_size(source.size());
+        if (_hdr.e_shoff > file_size)
+            throw InvalidElfFileError("section headers start at offset " + stringify(_hdr.e_shoff) +
+                    ", but the file is only " + stringify(file_size) + " bytes long");
+        typename ElfType_::Word max_shdrs((file_size - _hdr.e_shoff) / sizeof(typename ElfType_::SectionHeader));
 
-            if (_hdr.e_shnum)
-            {
-                if (_hdr.e_shnum > max_shdrs)
-                    throw InvalidElfFileError(
-                        "file claims to contain " + stringify(_hdr.e_shnum) +
-                        " section headers, but is only big enough to contain " + stringify(max_shdrs));
-                std::vector<typename ElfType_::SectionHeader> my_shdrs(_hdr.e_shnum);
-
-                stream.read(reinterpret_cast<char *>(&my_shdrs.front()), sizeof(typename ElfType_::SectionHeader) * _hdr.e_shnum);
-                if (need_byte_swap)
-                    std::for_each(my_shdrs.begin(), my_shdrs.end(),
-                                  &ByteSwapSectionHeader<ElfType_>::swap_in_place);
-                shdrs.swap(my_shdrs);
-            }
-            else
-            {
-                typename ElfType_::SectionHeader first_shdr;
-                stream.read(reinterpret_cast<char *>(&first_shdr), sizeof(typename ElfType_::SectionHeader));
-                if (need_byte_swap)
-                    ByteSwapSectionHeader<ElfType_>::swap_in_place(first_shdr);
-                if (0 == first_shdr.sh_size)
-                    throw InvalidElfFileError("got non-zero e_shoff and zero e_shnum, but sh_size of the first section is zero");
-
-                if (first_shdr.sh_size > max_shdrs)
-                    throw InvalidElfFileError(
-                        "file claims to contain " + stringify(first_shdr.sh_size) +
-                        " section headers, but is only big enough to contain " + stringify(max_shdrs));
-                std::vector<typename ElfType_::SectionHeader> my_shdrs(first_shdr.sh_size);
-
-                my_shdrs[0] = first_shdr;
-                stream.read(reinterpret_cast<char *>(&my_shdrs[1]), sizeof(typename ElfType_::SectionHeader) * (first_shdr.sh_size - 1));
-                if (need_byte_swap)
-                    std::for_each(next(my_shdrs.begin()), my_shdrs.end(),
-                                  &ByteSwapSectionHeader<ElfType_>::swap_in_place);
-                shdrs.swap(my_shdrs);
-            }
+        if (_hdr.e_shnum)
+        {
+            if (_hdr.e_shnum > max_shdrs)
+                throw InvalidElfFileError(
+                    "file claims to contain " + stringify(_hdr.e_shnum) +
+                    " section headers, but is only big enough to contain " + stringify(max_shdrs));
+            std::vector<typename ElfType_::SectionHeader> my_shdrs(_hdr.e_shnum);
+
+            source.read(_hdr.e_shoff, sizeof(typename ElfType_::SectionHeader) * _hdr.e_shnum, my_shdrs.data());
+            if (need_byte_swap)
+                std::for_each(my_shdrs.begin(), my_shdrs.end(),
+                              &ByteSwapSectionHeader<ElfType_>::swap_in_place);
+            shdrs.swap(my_shdrs);
         }
-
-        for (typename std::vector<typename ElfType_::SectionHeader>::iterator i = shdrs.begin(); i != shdrs.end(); ++i)
+        else
         {
-            if (i->sh_type == SHT_STRTAB)
-                _imp->sections.push_back(std::make_shared<StringSection<ElfType_> >(_imp->sections.size(), *i, stream, need_byte_swap));
-            else if ( (i->sh_type == SHT_SYMTAB) || (i->sh_type == SHT_DYNSYM) )
-                _imp->sections.push_back(std::make_shared<SymbolSection<ElfType_> >(_imp->sections.size(), *i, stream, need_byte_swap));
-            else if (i->sh_type == SHT_DYNAMIC)
-                _imp->sections.push_back(std::make_shared<DynamicSection<ElfType_> >(_imp->sections.size(), *i, stream, need_byte_swap));
-            else if (i->sh_type == SHT_REL)
-                _imp->sections.push_back(std::make_shared<RelocationSection<ElfType_, Relocation<ElfType_> > >(_imp->sections.size(), *i, stream, need_byte_swap));
-            else if (i->sh_type == SHT_RELA)
-                _imp->sections.push_back(std::make_shared<RelocationSection<ElfType_, RelocationA<ElfType_> > >(_imp->sections.size(), *i, stream, need_byte_swap));
-            else
-                _imp->sections.push_back(std::make_shared<GenericSection<ElfType_> >(_imp->sections.size(), *i));
+            typename ElfType_::SectionHeader first_shdr;
+            source.read(_hdr.e_shoff, sizeof(typename ElfType_::SectionHeader), &first_shdr);
+            if (need_byte_swap)
+                ByteSwapSectionHeader<ElfType_>::swap_in_place(first_shdr);
+            if (0 == first_shdr.sh_size)
+                throw InvalidElfFileError("got non-zero e_shoff and zero e_shnum, but sh_size of the first section is zero");
+
+            if (first_shdr.sh_size > max_shdrs)
+                throw InvalidElfFileError(
+                    "file claims to contain " + stringify(first_shdr.sh_size) +
+                    " section headers, but is only big enough to contain " + stringify(max_shdrs));
+            std::vector<typename ElfType_::SectionHeader> my_shdrs(first_shdr.sh_size);
+
+            my_shdrs[0] = first_shdr;
+            source.read(_hdr.e_shoff + sizeof(typename ElfType_::SectionHeader),
+                    sizeof(typename ElfType_::SectionHeader) * (first_shdr.sh_size - 1), &my_shdrs[1]);
+            if (need_byte_swap)
+                std::for_each(next(my_shdrs.begin()), my_shdrs.end(),
+                              &ByteSwapSectionHeader<ElfType_>::swap_in_place);
+            shdrs.swap(my_shdrs);
         }
-
-        if (! _hdr.e_shstrndx)
-            return;
-        typename ElfType_::Half shstrndx(SHN_XINDEX == _hdr.e_shstrndx ? shdrs[0].sh_link : _hdr.e_shstrndx);
-        if (_imp->sections.size() <= shstrndx)
-            throw InvalidElfFileError(
-                "section name table has index " + stringify(shstrndx) +
-                ", but only found " + stringify(_imp->sections.size()) + " sections");
-
-        littlelf_internals::SectionNameResolvingVisitor<ElfType_> res(section_begin(), section_end());
-        _imp->sections[shstrndx]->accept(res);
     }
-    catch (const std::ios_base::failure &)
+
+    for (typename std::vector<typename ElfType_::SectionHeader>::iterator i = shdrs.begin(); i != shdrs.end(); ++i)
     {
-        throw InvalidElfFileError("file is truncated, or an offset points past the end of the file");
+        if (i->sh_type == SHT_STRTAB)
+            _imp->sections.push_back(std::make_shared<StringSection<ElfType_> >(_imp->sections.size(), *i, source, need_byte_swap));
+        else if ( (i->sh_type == SHT_SYMTAB) || (i->sh_type == SHT_DYNSYM) )
+            _imp->sections.push_back(std::make_shared<SymbolSection<ElfType_> >(_imp->sections.size(), *i, source, need_byte_swap));
+        else if (i->sh_type == SHT_DYNAMIC)
+            _imp->sections.push_back(std::make_shared<DynamicSection<ElfType_> >(_imp->sections.size(), *i, source, need_byte_swap));
+        else if (i->sh_type == SHT_REL)
+            _imp->sections.push_back(std::make_shared<RelocationSection<ElfType_, Relocation<ElfType_> > >(_imp->sections.size(), *i, source, need_byte_swap));
+        else if (i->sh_type == SHT_RELA)
+            _imp->sections.push_back(std::make_shared<RelocationSection<ElfType_, RelocationA<ElfType_> > >(_imp->sections.size(), *i, source, need_byte_swap));
+        else
+            _imp->sections.push_back(std::make_shared<GenericSection<ElfType_> >(_imp->sections.size(), *i));
     }
+
+    if (! _hdr.e_shstrndx)
+        return;
+    typename ElfType_::Half shstrndx(SHN_XINDEX == _hdr.e_shstrndx ? shdrs[0].sh_link : _hdr.e_shstrndx);
+    if (_imp->sections.size() <= shstrndx)
+        throw InvalidElfFileError(
+            "section name table has index " + stringify(shstrndx) +
+            ", but only found " + stringify(_imp->sections.size()) + " sections");
+
+    littlelf_internals::SectionNameResolvingVisitor<ElfType_> res(section_begin(), section_end());
+    _imp->sections[shstrndx]->accept(res);
 }
 
 template <typename ElfType_>
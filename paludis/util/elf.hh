@@ -25,7 +25,9 @@
 #include <paludis/util/exception.hh>
 #include <paludis/util/pimp.hh>
 #include <paludis/util/wrapped_forward_iterator-fwd.hh>
+#include <paludis/util/mapped_file-fwd.hh>
 #include <iosfwd>
+#include <memory>
 
 #include <elf.h>
 
@@ -50,9 +52,25 @@ namespace paludis
 
             typename ElfType_::Header _hdr;
 
+            void _load(const ElfSource &);
+
         public:
             static bool is_valid_elf(std::istream & stream);
+
+            ///\since 2.4
+            static bool is_valid_elf(const MappedFile &);
+
             ElfObject(std::istream & stream);
+
+            /**
+             * Read from a MappedFile. String tables are used in place, and
+             * symbols and relocations are not parsed until they are first
+             * needed, so this is much cheaper than reading from a stream if
+             * only some sections are of interest.
+             *
+             * \since 2.4
+             */
+            explicit ElfObject(const std::shared_ptr<const MappedFile> &);
             ~ElfObject();
 
             /**
@@ -32,7 +32,6 @@
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
 
-#include <istream>
 #include <map>
 #include <vector>
 #include <stdexcept>
@@ -295,7 +294,7 @@ DynamicEntries<ElfType_>::has_entry(typename ElfType_::DynamicTag identifier) co
 }
 
 template <typename ElfType_>
-DynamicSection<ElfType_>::DynamicSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, std::istream & stream, bool need_byte_swap) :
+DynamicSection<ElfType_>::DynamicSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, const ElfSource & source, bool need_byte_swap) :
     Section<ElfType_>(index, shdr),
     _imp()
 {
@@ -304,9 +303,8 @@ DynamicSection<ElfType_>::DynamicSection(typename ElfType_::Word index, const ty
             "bad sh_entsize for " + this->description() + ": got " + stringify(shdr.sh_entsize) + ", expected " +
             stringify(sizeof(typename ElfType_::DynamicEntry)));
 
-    stream.seekg(shdr.sh_offset, std::ios::beg);
     std::vector<typename ElfType_::DynamicEntry> tmp_entries(shdr.sh_size / sizeof(typename ElfType_::DynamicEntry));
-    stream.read( reinterpret_cast<char *>(&tmp_entries.front()), shdr.sh_size );
+    source.read(shdr.sh_offset, tmp_entries.size() * sizeof(typename ElfType_::DynamicEntry), tmp_entries.data());
     if (need_byte_swap)
         std::for_each(tmp_entries.begin(), tmp_entries.end(),
                       &ByteSwapDynamicEntry<ElfType_>::swap_in_place);
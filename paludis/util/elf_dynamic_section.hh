@@ -202,7 +202,8 @@ namespace paludis
             Pimp<DynamicSection> _imp;
 
         public:
-            DynamicSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, std::istream &, bool);
+            ///\since 2.4 takes an ElfSource
+            DynamicSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, const ElfSource &, bool);
             virtual ~DynamicSection();
 
             virtual std::string get_type() const;
@@ -26,7 +26,7 @@
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/stringify.hh>
 #include <algorithm>
-#include <istream>
+#include <cstring>
 #include <vector>
 
 using namespace paludis;
@@ -36,7 +36,21 @@ namespace paludis
     template <typename ElfType_, typename Relocation_>
     struct Imp<RelocationSection<ElfType_, Relocation_> >
     {
-        std::vector<typename Relocation_::Entry> relocations;
+        std::shared_ptr<const MappedFile> mapped_file;
+        const char * mapped_relocations;
+        std::size_t count;
+        bool need_byte_swap;
+
+        mutable bool loaded;
+        mutable std::vector<typename Relocation_::Entry> relocations;
+
+        Imp() :
+            mapped_relocations(nullptr),
+            count(0),
+            need_byte_swap(false),
+            loaded(true)
+        {
+        }
     };
 
     template <typename ElfType_, typename Relocation_>
@@ -99,7 +113,7 @@ template <typename ElfType_> const std::string RelocationA<ElfType_>::type_name
 
 template <typename ElfType_, typename Relocation_>
 RelocationSection<ElfType_, Relocation_>::RelocationSection(
-    typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, std::istream & stream, bool need_byte_swap) :
+    typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, const ElfSource & source, bool need_byte_swap) :
     Section<ElfType_>(index, shdr),
     _imp()
 {
@@ -108,9 +122,19 @@ RelocationSection<ElfType_, Relocation_>::RelocationSection(
             "bad sh_entsize for " + this->description() + ": got " + stringify(shdr.sh_entsize) + ", expected " +
             stringify(sizeof(typename Relocation_::Type)));
 
-    std::vector<typename Relocation_::Type> relocations(shdr.sh_size / sizeof(typename Relocation_::Type));
-    stream.seekg(shdr.sh_offset, std::ios::beg);
-    stream.read(reinterpret_cast<char *>(&relocations.front()), shdr.sh_size);
+    _imp->count = shdr.sh_size / sizeof(typename Relocation_::Type);
+    _imp->need_byte_swap = need_byte_swap;
+
+    if (source.mapped_file())
+    {
+        _imp->mapped_file = source.mapped_file();
+        _imp->mapped_relocations = source.view(shdr.sh_offset, _imp->count * sizeof(typename Relocation_::Type));
+        _imp->loaded = false;
+        return;
+    }
+
+    std::vector<typename Relocation_::Type> relocations(_imp->count);
+    source.read(shdr.sh_offset, _imp->count * sizeof(typename Relocation_::Type), relocations.data());
     if (need_byte_swap)
         std::for_each(relocations.begin(), relocations.end(),
                       &ByteSwapRelocation<ElfType_, Relocation_>::swap_in_place);
@@ -119,6 +143,26 @@ RelocationSection<ElfType_, Relocation_>::RelocationSection(
         _imp->relocations.push_back(typename Relocation_::Entry(*i));
 }
 
+template <typename ElfType_, typename Relocation_>
+void
+RelocationSection<ElfType_, Relocation_>::_load() const
+{
+    if (_imp->loaded)
+        return;
+
+    _imp->relocations.reserve(_imp->count);
+    for (std::size_t n(0) ; n < _imp->count ; ++n)
+    {
+        /* the mapping need not be suitably aligned, so copy rather than cast */
+        typename Relocation_::Type relocation;
+        std::memcpy(&relocation, _imp->mapped_relocations + n * sizeof(typename Relocation_::Type), sizeof(relocation));
+        if (_imp->need_byte_swap)
+            ByteSwapRelocation<ElfType_, Relocation_>::swap_in_place(relocation);
+        _imp->relocations.push_back(typename Relocation_::Entry(relocation));
+    }
+    _imp->loaded = true;
+}
+
 template <typename ElfType_, typename Relocation_>
 RelocationSection<ElfType_, Relocation_>::~RelocationSection()
 {
@@ -128,6 +172,7 @@ template <typename ElfType_, typename Relocation_>
 typename RelocationSection<ElfType_, Relocation_>::RelocationIterator
 RelocationSection<ElfType_, Relocation_>::relocation_begin() const
 {
+    _load();
     return RelocationIterator(_imp->relocations.begin());
 }
 
@@ -135,6 +180,7 @@ template <typename ElfType_, typename Relocation_>
 typename RelocationSection<ElfType_, Relocation_>::RelocationIterator
 RelocationSection<ElfType_, Relocation_>::relocation_end() const
 {
+    _load();
     return RelocationIterator(_imp->relocations.end());
 }
 
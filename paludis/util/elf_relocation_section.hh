@@ -103,8 +103,14 @@ namespace paludis
         private:
             Pimp<RelocationSection> _imp;
 
+            void _load() const;
+
         public:
-            RelocationSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, std::istream &, bool);
+            /**
+             * \since 2.4 takes an ElfSource. If it is mapped, relocations
+             * are not parsed until they are first needed.
+             */
+            RelocationSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, const ElfSource &, bool);
             virtual ~RelocationSection();
 
             virtual std::string get_type() const
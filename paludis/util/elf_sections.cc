@@ -20,13 +20,71 @@
 
 #include <paludis/util/elf_sections.hh>
 #include <paludis/util/elf_types.hh>
+#include <paludis/util/elf.hh>
+#include <paludis/util/mapped_file.hh>
 #include <paludis/util/stringify.hh>
 
 #include <istream>
 #include <algorithm>
+#include <stdexcept>
+#include <cstring>
 
 using namespace paludis;
 
+ElfSource::ElfSource(std::istream & s) :
+    _stream(&s)
+{
+}
+
+ElfSource::ElfSource(const std::shared_ptr<const MappedFile> & m) :
+    _stream(nullptr),
+    _mapped_file(m)
+{
+}
+
+void
+ElfSource::read(uint64_t offset, uint64_t size, void * dest) const
+{
+    if (0 == size)
+        return;
+
+    if (_stream)
+    {
+        _stream->seekg(offset, std::ios::beg);
+        _stream->read(static_cast<char *>(dest), size);
+    }
+    else
+        std::memcpy(dest, view(offset, size), size);
+}
+
+const char *
+ElfSource::view(uint64_t offset, uint64_t size) const
+{
+    if (! _mapped_file)
+        return nullptr;
+
+    if (offset > _mapped_file->size() || size > _mapped_file->size() - offset)
+        throw InvalidElfFileError("file is truncated, or an offset points past the end of the file");
+
+    return _mapped_file->data() + offset;
+}
+
+const std::shared_ptr<const MappedFile> &
+ElfSource::mapped_file() const
+{
+    return _mapped_file;
+}
+
+uint64_t
+ElfSource::size() const
+{
+    if (_mapped_file)
+        return _mapped_file->size();
+
+    _stream->seekg(0, std::ios::end);
+    return _stream->tellg();
+}
+
 template <typename ElfType_>
 Section<ElfType_>::Section(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr) :
     _index(index),
@@ -68,14 +126,17 @@ GenericSection<ElfType_>::get_type() const
 }
 
 template <typename ElfType_>
-StringSection<ElfType_>::StringSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, std::istream & stream, bool) :
+StringSection<ElfType_>::StringSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, const ElfSource & source, bool) :
     Section<ElfType_>(index, shdr),
-    _stringTable(shdr.sh_size, ' ')
+    _mapped_file(source.mapped_file()),
+    _mapped_table(source.view(shdr.sh_offset, shdr.sh_size)),
+    _size(shdr.sh_size)
 {
-    std::string tmp_table(shdr.sh_size, '\0');
-    stream.seekg(shdr.sh_offset, std::ios::beg);
-    stream.read(&tmp_table[0], shdr.sh_size);
-    std::copy(tmp_table.begin(), tmp_table.end(), _stringTable.begin());
+    if (! _mapped_file)
+    {
+        _stringTable.resize(shdr.sh_size);
+        source.read(shdr.sh_offset, shdr.sh_size, &_stringTable[0]);
+    }
 }
 
 template <typename ElfType_>
@@ -87,8 +148,12 @@ template <typename ElfType_>
 std::string
 StringSection<ElfType_>::get_string(typename ElfType_::Word index) const
 {
-    typename ElfType_::Word end(_stringTable.find_first_of('\0', index));
-    return _stringTable.substr(index, end-index);
+    const char * const table(_mapped_file ? _mapped_table : _stringTable.data());
+    if (index > _size)
+        throw std::out_of_range("string index " + stringify(index) + " is past the end of the string table");
+
+    const char * const end(static_cast<const char *>(std::memchr(table + index, '\0', _size - index)));
+    return std::string(table + index, end ? end : table + _size);
 }
 
 template <typename ElfType_>
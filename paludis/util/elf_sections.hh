@@ -23,8 +23,12 @@
 
 #include <string>
 #include <iosfwd>
+#include <memory>
+#include <cstdint>
+#include <paludis/util/attributes.hh>
 #include <paludis/util/visitor.hh>
 #include <paludis/util/type_list.hh>
+#include <paludis/util/mapped_file-fwd.hh>
 
 namespace paludis
 {
@@ -44,6 +48,48 @@ namespace paludis
         template <typename ElfType_> class SectionNameResolvingVisitor;
     }
 
+    /**
+     * Where an ElfObject and its sections get their data from: either a
+     * stream, or a MappedFile.
+     *
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE ElfSource
+    {
+        private:
+            std::istream * const _stream;
+            const std::shared_ptr<const MappedFile> _mapped_file;
+
+        public:
+            explicit ElfSource(std::istream &);
+            explicit ElfSource(const std::shared_ptr<const MappedFile> &);
+
+            /**
+             * Copy size bytes starting at offset into dest.
+             *
+             * If we are reading from a stream, errors are reported however
+             * the stream's exception mask says they should be.
+             */
+            void read(uint64_t offset, uint64_t size, void * dest) const;
+
+            /**
+             * Return a pointer to size bytes starting at offset, which
+             * remains valid for as long as mapped_file() does, or null if we
+             * are reading from a stream.
+             */
+            const char * view(uint64_t offset, uint64_t size) const;
+
+            /**
+             * Our MappedFile, or null if we are reading from a stream.
+             */
+            const std::shared_ptr<const MappedFile> & mapped_file() const;
+
+            /**
+             * The size of our file.
+             */
+            uint64_t size() const;
+    };
+
     template <typename ElfType_>
     class Section :
         public virtual paludis::DeclareAbstractAcceptMethods<Section<ElfType_>, typename paludis::MakeTypeList<
@@ -129,15 +175,22 @@ namespace paludis
     {
         private:
             std::string _stringTable;
+            std::shared_ptr<const MappedFile> _mapped_file;
+            const char * _mapped_table;
+            typename ElfType_::Word _size;
 
         public:
-            StringSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, std::istream &, bool);
+            /**
+             * \since 2.4 takes an ElfSource. If it is mapped, the string
+             * table is not copied.
+             */
+            StringSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, const ElfSource &, bool);
             virtual ~StringSection();
 
             std::string get_string(typename ElfType_::Word) const;
             typename ElfType_::Word get_max_string() const
             {
-                return _stringTable.length();
+                return _size;
             }
 
             virtual std::string get_type() const;
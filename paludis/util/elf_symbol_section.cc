@@ -30,7 +30,7 @@
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/stringify.hh>
 
-#include <istream>
+#include <cstring>
 #include <vector>
 #include <stdexcept>
 #include <algorithm>
@@ -42,7 +42,23 @@ namespace paludis
     template <typename ElfType_>
     struct Imp<SymbolSection<ElfType_> >
     {
-        std::vector<Symbol<ElfType_> > symbols;
+        std::shared_ptr<const MappedFile> mapped_file;
+        const char * mapped_symbols;
+        std::size_t count;
+        bool need_byte_swap;
+
+        mutable bool loaded;
+        mutable Section<ElfType_> * pending_string_section;
+        mutable std::vector<Symbol<ElfType_> > symbols;
+
+        Imp() :
+            mapped_symbols(nullptr),
+            count(0),
+            need_byte_swap(false),
+            loaded(true),
+            pending_string_section(nullptr)
+        {
+        }
     };
 
     template <typename ElfType_>
@@ -162,7 +178,7 @@ Symbol<ElfType_>::~Symbol()
 }
 
 template <typename ElfType_>
-SymbolSection<ElfType_>::SymbolSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, std::istream & stream, bool need_byte_swap) :
+SymbolSection<ElfType_>::SymbolSection(typename ElfType_::Word index, const typename ElfType_::SectionHeader & shdr, const ElfSource & source, bool need_byte_swap) :
     Section<ElfType_>(index, shdr),
     _imp(),
     _type("invalid")
@@ -177,9 +193,19 @@ SymbolSection<ElfType_>::SymbolSection(typename ElfType_::Word index, const type
             "bad sh_entsize for " + this->description() + ": got " + stringify(shdr.sh_entsize) + ", expected " +
             stringify(sizeof(typename ElfType_::Symbol)));
 
-    std::vector<typename ElfType_::Symbol> symbols(shdr.sh_size / sizeof(typename ElfType_::Symbol));
-    stream.seekg(shdr.sh_offset, std::ios::beg);
-    stream.read( reinterpret_cast<char *>(&symbols.front()), shdr.sh_size );
+    _imp->count = shdr.sh_size / sizeof(typename ElfType_::Symbol);
+    _imp->need_byte_swap = need_byte_swap;
+
+    if (source.mapped_file())
+    {
+        _imp->mapped_file = source.mapped_file();
+        _imp->mapped_symbols = source.view(shdr.sh_offset, _imp->count * sizeof(typename ElfType_::Symbol));
+        _imp->loaded = false;
+        return;
+    }
+
+    std::vector<typename ElfType_::Symbol> symbols(_imp->count);
+    source.read(shdr.sh_offset, _imp->count * sizeof(typename ElfType_::Symbol), symbols.data());
     if (need_byte_swap)
         std::for_each(symbols.begin(), symbols.end(),
                       &ByteSwapSymbol<ElfType_>::swap_in_place);
@@ -188,6 +214,35 @@ SymbolSection<ElfType_>::SymbolSection(typename ElfType_::Word index, const type
         _imp->symbols.push_back(Symbol<ElfType_>(*i));
 }
 
+template <typename ElfType_>
+void
+SymbolSection<ElfType_>::_load() const
+{
+    if (_imp->loaded)
+        return;
+
+    _imp->symbols.reserve(_imp->count);
+    for (std::size_t n(0) ; n < _imp->count ; ++n)
+    {
+        /* the mapping need not be suitably aligned, so copy rather than cast */
+        typename ElfType_::Symbol symbol;
+        std::memcpy(&symbol, _imp->mapped_symbols + n * sizeof(typename ElfType_::Symbol), sizeof(symbol));
+        if (_imp->need_byte_swap)
+            ByteSwapSymbol<ElfType_>::swap_in_place(symbol);
+        _imp->symbols.push_back(Symbol<ElfType_>(symbol));
+    }
+    _imp->loaded = true;
+
+    if (_imp->pending_string_section)
+    {
+        Section<ElfType_> * const string_section(_imp->pending_string_section);
+        _imp->pending_string_section = nullptr;
+        littlelf_internals::SymbolStringResolvingVisitor<ElfType_> v(
+            *this, _imp->symbols.begin(), _imp->symbols.end());
+        string_section->accept(v);
+    }
+}
+
 template <typename ElfType_>
 SymbolSection<ElfType_>::~SymbolSection()
 {
@@ -197,6 +252,12 @@ template <typename ElfType_>
 void
 SymbolSection<ElfType_>::resolve_symbols(Section<ElfType_> & string_section)
 {
+    if (! _imp->loaded)
+    {
+        _imp->pending_string_section = &string_section;
+        return;
+    }
+
     littlelf_internals::SymbolStringResolvingVisitor<ElfType_> v(
         *this, _imp->symbols.begin(), _imp->symbols.end());
     string_section.accept(v);
@@ -206,6 +267,7 @@ template <typename ElfType_>
 typename SymbolSection<ElfType_>::SymbolIterator
 SymbolSection<ElfType_>::symbol_begin() const
 {
+    _load();
     return SymbolIterator(_imp->symbols.begin());
 }
 
@@ -213,6 +275,7 @@ template <typename ElfType_>
 typename SymbolSection<ElfType_>::SymbolIterator
 SymbolSection<ElfType_>::symbol_end() const
 {
+    _load();
     return SymbolIterator(_imp->symbols.end());
 }
 
@@ -87,8 +87,14 @@ namespace paludis
             Pimp<SymbolSection> _imp;
             std::string _type;
 
+            void _load() const;
+
         public:
-            SymbolSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, std::istream &, bool);
+            /**
+             * \since 2.4 takes an ElfSource. If it is mapped, symbols are
+             * not parsed until they are first needed.
+             */
+            SymbolSection(typename ElfType_::Word, const typename ElfType_::SectionHeader &, const ElfSource &, bool);
             virtual ~SymbolSection();
 
             virtual std::string get_type() const
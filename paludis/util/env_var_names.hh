@@ -38,12 +38,14 @@ namespace paludis
         const std::string home("PALUDIS_HOME");
         const std::string hooker_dir("PALUDIS_HOOKER_DIR");
         const std::string ignore_hooks_named("PALUDIS_IGNORE_HOOKS_NAMED");
+        const std::string metadata_workers("PALUDIS_METADATA_WORKERS");
         const std::string no_chown("PALUDIS_NO_CHOWN");
         const std::string no_global_fetchers("PALUDIS_NO_GLOBAL_FETCHERS");
         const std::string no_global_hooks("PALUDIS_NO_GLOBAL_HOOKS");
         const std::string no_global_sets("PALUDIS_NO_GLOBAL_SETS");
         const std::string no_global_syncers("PALUDIS_NO_GLOBAL_SYNCERS");
         const std::string no_xml("PALUDIS_NO_XML");
+        const std::string parallel_merge("PALUDIS_PARALLEL_MERGE");
         const std::string portage_bashrc("PALUDIS_PORTAGE_BASHRC");
         const std::string python_dir("PALUDIS_PYTHON_DIR");
         const std::string reduced_gid("PALUDIS_REDUCED_GID");
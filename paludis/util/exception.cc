@@ -35,26 +35,67 @@ using namespace paludis;
 
 namespace
 {
-    PALUDIS_TLS std::list<std::string> * context = 0;
+    PALUDIS_TLS const Context * context = 0;
+
+    /* innermost first, so callers must push_front */
+    template <typename F_>
+    void for_each_context(const F_ & f)
+    {
+        for (const Context * c(context) ; c ; c = c->previous())
+            f(*c);
+    }
 }
 
-Context::Context(const std::string & s)
+Context::Context(const std::string & s) :
+    _text(s),
+    _n_parts(0)
 {
-    if (! context)
-        context = new std::list<std::string>;
-    context->push_back(s);
+    _push();
+}
+
+Context::Context(const char * const s) :
+    _n_parts(1)
+{
+    _parts[0] = Part{ s, &_render_literal };
+    _push();
+}
+
+void
+Context::_push()
+{
+    _previous = context;
+    context = this;
 }
 
 Context::~Context()
 {
-    if (! context)
-        throw InternalError(PALUDIS_HERE, "no context");
-    context->pop_back();
-    if (context->empty())
-    {
-        delete context;
-        context = 0;
-    }
+    if (context != this)
+        throw InternalError(PALUDIS_HERE, "context stack corrupted");
+    context = _previous;
+}
+
+std::string
+Context::_render_literal(const void * v)
+{
+    return static_cast<const char *>(v);
+}
+
+std::string
+Context::text() const
+{
+    if (0 == _n_parts)
+        return _text;
+
+    std::string result;
+    for (unsigned i(0) ; i != _n_parts ; ++i)
+        result.append(_parts[i].render(_parts[i].value));
+    return result;
+}
+
+const Context *
+Context::previous() const
+{
+    return _previous;
 }
 
 std::string
@@ -63,7 +104,9 @@ Context::backtrace(const std::string & delim)
     if (! context)
         return "";
 
-    return join(context->begin(), context->end(), delim) + delim;
+    std::list<std::string> texts;
+    for_each_context([&] (const Context & c) { texts.push_front(c.text()); });
+    return join(texts.begin(), texts.end(), delim) + delim;
 }
 
 namespace paludis
@@ -74,8 +117,7 @@ namespace paludis
 
         ContextData()
         {
-            if (context)
-                local_context.assign(context->begin(), context->end());
+            for_each_context([&] (const Context & c) { local_context.push_front(c.text()); });
         }
 
         ContextData(const ContextData & other) :
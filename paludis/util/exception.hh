@@ -21,8 +21,11 @@
 #define PALUDIS_GUARD_PALUDIS_EXCEPTION_HH 1
 
 #include <paludis/util/attributes.hh>
+#include <paludis/util/stringify.hh>
 #include <string>
 #include <exception>
+#include <type_traits>
+#include <cstddef>
 
 /** \file
  * Declaration for the Exception base class, the InternalError exception
@@ -40,12 +43,60 @@ namespace paludis
     /**
      * Backtrace context class.
      *
+     * Contexts form a per-thread stack, which is only turned into text if
+     * an Exception is constructed or a message is logged. Rather than
+     * building a string up front, a Context can be given a string literal
+     * followed by alternating values and literals, which are only
+     * stringified if the text is needed:
+     *
+     * \code
+     * Context context("When loading '", filename, "' for '", *id, "':");
+     * \endcode
+     *
+     * Values are held by reference, and so must be lvalues which outlive
+     * the Context.
+     *
      * \ingroup g_exceptions
      * \nosubgrouping
      */
     class PALUDIS_VISIBLE Context
     {
         private:
+            struct Part
+            {
+                const void * value;
+                std::string (* render)(const void *);
+            };
+
+            enum { max_parts = 7 };
+
+            const Context * _previous;
+            const std::string _text;
+            Part _parts[max_parts];
+            unsigned _n_parts;
+
+            void _push();
+
+            static std::string _render_literal(const void *);
+
+            template <typename T_>
+            static std::string _render(const void * v)
+            {
+                return stringify(*static_cast<const T_ *>(v));
+            }
+
+            template <typename T_>
+            static Part _part(T_ & v)
+            {
+                return Part{ &v, &_render<typename std::remove_cv<T_>::type> };
+            }
+
+            template <std::size_t n_>
+            static Part _part(const char (& v)[n_])
+            {
+                return Part{ v, &_render_literal };
+            }
+
             Context(const Context &);
             const Context & operator= (const Context &);
 
@@ -55,10 +106,48 @@ namespace paludis
 
             Context(const std::string &);
 
+            /**
+             * Constructor, from a string literal, which is not copied.
+             *
+             * \since 2.4
+             */
+            Context(const char * const);
+
+            /**
+             * Constructor, from a string literal followed by values and
+             * further literals, which are only stringified if needed.
+             *
+             * \since 2.4
+             */
+            template <typename... T_>
+            Context(const char * const first, T_ & ... rest) :
+                _n_parts(1 + sizeof...(T_))
+            {
+                static_assert(1 + sizeof...(T_) <= max_parts, "Too many parts for a Context");
+                const Part parts[] = { Part{ first, &_render_literal }, _part(rest)... };
+                for (unsigned i(0) ; i != _n_parts ; ++i)
+                    _parts[i] = parts[i];
+                _push();
+            }
+
             ~Context();
 
             ///\}
 
+            /**
+             * Our text.
+             *
+             * \since 2.4
+             */
+            std::string text() const;
+
+            /**
+             * The Context that was current when we were created, if any.
+             *
+             * \since 2.4
+             */
+            const Context * previous() const;
+
             /**
              * Current context.
              */
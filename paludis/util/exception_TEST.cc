@@ -0,0 +1,114 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/util/exception.hh>
+
+#include <ostream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct Counted
+    {
+        std::string text;
+        mutable int renders;
+
+        Counted(const std::string & t) :
+            text(t),
+            renders(0)
+        {
+        }
+    };
+
+    std::ostream & operator<< (std::ostream & s, const Counted & c)
+    {
+        ++c.renders;
+        return s << c.text;
+    }
+
+    struct TestError :
+        Exception
+    {
+        TestError() :
+            Exception("test")
+        {
+        }
+    };
+}
+
+TEST(Context, Backtrace)
+{
+    EXPECT_EQ("", Context::backtrace("|"));
+
+    {
+        Context a("outer");
+        {
+            Context b(std::string("middle"));
+            {
+                std::string name("inner");
+                Context c("start '", name, "' end");
+                EXPECT_EQ("outer|middle|start 'inner' end|", Context::backtrace("|"));
+            }
+            EXPECT_EQ("outer|middle|", Context::backtrace("|"));
+        }
+    }
+
+    EXPECT_EQ("", Context::backtrace("|"));
+}
+
+TEST(Context, Lazy)
+{
+    Counted first("one"), second("two");
+    int number(3);
+
+    {
+        Context context("a ", first, " b ", second, " c ", number, " d");
+        EXPECT_EQ(0, first.renders);
+        EXPECT_EQ(0, second.renders);
+
+        EXPECT_EQ("a one b two c 3 d", context.text());
+        EXPECT_EQ(1, first.renders);
+        EXPECT_EQ(1, second.renders);
+    }
+}
+
+TEST(Context, Exception)
+{
+    Counted value("value");
+    try
+    {
+        Context outer("outer");
+        Context inner("inner '", value, "'");
+        EXPECT_EQ(0, value.renders);
+        throw TestError();
+    }
+    catch (const Exception & e)
+    {
+        EXPECT_EQ(1, value.renders);
+        EXPECT_EQ("outer|inner 'value'|", e.backtrace("|"));
+        EXPECT_FALSE(e.empty());
+    }
+
+    EXPECT_TRUE(TestError().empty());
+}
@@ -21,7 +21,7 @@ add(`create_iterator',                   `hh', `fwd', `impl', `gtest')
 add(`damerau_levenshtein',               `hh', `cc', `gtest')
 add(`destringify',                       `hh', `cc', `gtest')
 add(`deferred_construction_ptr',         `hh', `cc', `fwd', `gtest')
-add(`digest_registry',                   `hh', `cc')
+add(`digest_registry',                   `hh', `cc', `gtest')
 add(`discard_output_stream',             `hh', `cc')
 add(`elf',                               `hh', `cc')
 add(`elf_dynamic_section',               `hh', `cc')
@@ -31,7 +31,7 @@ add(`elf_symbol_section',                `hh', `cc')
 add(`elf_types',                         `hh')
 add(`enum_iterator',                     `hh', `cc', `fwd', `gtest')
 add(`env_var_names',                     `hh', `cc')
-add(`exception',                         `hh', `cc')
+add(`exception',                         `hh', `cc', `gtest')
 add(`executor',                          `hh', `cc', `fwd')
 add(`extract_host_from_url',             `hh', `cc', `fwd', `gtest')
 add(`fd_holder',                         `hh')
@@ -49,6 +49,7 @@ add(`log',                               `hh', `cc', `se', `gtest')
 add(`make_named_values',                 `hh', `cc')
 add(`make_shared_copy',                  `hh', `fwd')
 add(`map',                               `hh', `fwd', `impl', `cc')
+add(`mapped_file',                       `hh', `cc', `fwd', `gtest', `testscript')
 add(`member_iterator',                   `hh', `fwd', `impl', `gtest')
 add(`md5',                               `hh', `cc', `gtest')
 add(`named_value',                       `hh', `cc', `fwd')
@@ -81,6 +82,7 @@ add(`string_list_stream',                `hh', `cc', `fwd', `gtest')
 add(`strip',                             `hh', `cc', `gtest')
 add(`system',                            `hh', `cc', `gtest')
 add(`tail_output_stream',                `hh', `cc', `fwd', `gtest')
+add(`task_scheduler',                    `hh', `cc', `gtest')
 add(`tee_output_stream',                 `hh', `cc', `fwd')
 add(`thread_pool',                       `hh', `cc', `gtest')
 add(`timestamp',                         `hh', `cc', `fwd')
@@ -193,6 +193,15 @@ FSStat::lowlevel_id() const
     return std::make_pair(_imp->st.st_dev, _imp->st.st_ino);
 }
 
+nlink_t
+FSStat::link_count() const
+{
+    if (! _imp->exists)
+        throw FSError("Filesystem entry '" + stringify(_imp->path) + "' does not exist");
+
+    return _imp->st.st_nlink;
+}
+
 namespace paludis
 {
     template class Pimp<FSStat>;
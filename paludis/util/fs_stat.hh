@@ -100,6 +100,15 @@ namespace paludis
              */
             std::pair<dev_t, ino_t> lowlevel_id() const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Return the number of hard links to this entry.
+             *
+             * \exception FSError If we don't exist or the stat call fails.
+             * \since 2.4
+             */
+            nlink_t link_count() const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
     extern template class Pimp<FSStat>;
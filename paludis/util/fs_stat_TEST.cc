@@ -24,6 +24,7 @@
 #include <paludis/util/log.hh>
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/options.hh>
+#include <paludis/util/stringify.hh>
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -159,6 +160,22 @@ TEST(FSStat, Size)
     EXPECT_THROW(size_t PALUDIS_ATTRIBUTE((unused)) x = e.stat().file_size(), FSError);
 }
 
+TEST(FSStat, LinkCount)
+{
+    FSPath f("fs_stat_TEST_dir/ten_bytes");
+    FSPath g("fs_stat_TEST_dir/ten_bytes_link");
+    FSPath e("fs_stat_TEST_dir/no_such_file");
+
+    EXPECT_EQ(1u, f.stat().link_count());
+    ASSERT_EQ(0, ::link(stringify(f).c_str(), stringify(g).c_str()));
+    EXPECT_EQ(2u, f.stat().link_count());
+    EXPECT_EQ(2u, g.stat().link_count());
+    g.unlink();
+    EXPECT_EQ(1u, f.stat().link_count());
+
+    EXPECT_THROW(nlink_t PALUDIS_ATTRIBUTE((unused)) x = e.stat().link_count(), FSError);
+}
+
 TEST(FSStat, Symlink)
 {
     FSPath f("fs_stat_TEST_dir/new_sym");
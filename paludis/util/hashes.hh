@@ -126,7 +126,7 @@ namespace paludis
     {
         std::size_t operator() (const WrappedValue<Tag_> & v) const
         {
-            return Hash<typename WrappedValueTraits<Tag_>::UnderlyingType>()(v.value());
+            return v.hash();
         }
     };
 
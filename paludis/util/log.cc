@@ -150,6 +150,11 @@ Log::_message(const std::string & id, const LogLevel l, const LogContext c, cons
 {
     std::unique_lock<std::mutex> lock(_imp->mutex);
 
+    /* rendering the backtrace stringifies every lazy Context part, so
+     * don't do it for messages nobody will see */
+    if (l < _imp->log_level)
+        return;
+
     if (lc_context == c)
         _imp->message(id, l, c,
 #ifdef __linux__
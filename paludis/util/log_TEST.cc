@@ -18,6 +18,7 @@
  */
 
 #include <paludis/util/log.hh>
+#include <paludis/util/exception.hh>
 
 #include <sstream>
 
@@ -50,6 +51,23 @@ namespace
     {
         return Monkey();
     }
+
+    struct Counted
+    {
+        mutable int renders;
+
+        Counted() :
+            renders(0)
+        {
+        }
+    };
+
+    std::ostream &
+    operator<< (std::ostream & s, const Counted & c)
+    {
+        ++c.renders;
+        return s << "counted";
+    }
 }
 
 TEST(Log, Messages)
@@ -104,3 +122,23 @@ TEST(Log, Exceptions)
     EXPECT_TRUE(s.str().empty());
 }
 
+TEST(Log, ContextNotRenderedBelowLevel)
+{
+    Log::destroy_instance();
+
+    std::stringstream s;
+    Log::get_instance()->set_log_stream(&s);
+    Log::get_instance()->set_log_level(ll_warning);
+
+    Counted counted;
+    Context context("In ", counted, ":");
+
+    Log::get_instance()->message("test.log", ll_debug, lc_context) << "hidden";
+    EXPECT_TRUE(s.str().empty());
+    EXPECT_EQ(0, counted.renders);
+
+    Log::get_instance()->message("test.log", ll_warning, lc_context) << "shown";
+    EXPECT_TRUE(std::string::npos != s.str().find("In counted:"));
+    EXPECT_EQ(1, counted.renders);
+}
+
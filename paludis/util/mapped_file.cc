@@ -0,0 +1,119 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/pimp-impl.hh>
+
+#include <cstring>
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace paludis;
+
+namespace paludis
+{
+    template <>
+    struct Imp<MappedFile>
+    {
+        void * data;
+        std::size_t size;
+
+        Imp() :
+            data(nullptr),
+            size(0)
+        {
+        }
+    };
+}
+
+MappedFile::MappedFile(const FSPath & f) :
+    _imp()
+{
+    Context context("When mapping '" + stringify(f) + "':");
+
+    int fd(open(stringify(f).c_str(), O_RDONLY | O_CLOEXEC));
+    if (-1 == fd)
+        throw MappedFileError("Could not open '" + stringify(f) + "': " + strerror(errno));
+
+    struct stat st;
+    if (-1 == fstat(fd, &st))
+    {
+        int e(errno);
+        ::close(fd);
+        throw MappedFileError("Could not stat '" + stringify(f) + "': " + strerror(e));
+    }
+
+    if (! S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        throw MappedFileError("Could not map '" + stringify(f) + "': not a regular file");
+    }
+
+    if (0 != st.st_size)
+    {
+        void * result(mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+        if (MAP_FAILED == result)
+        {
+            int e(errno);
+            ::close(fd);
+            throw MappedFileError("Could not map '" + stringify(f) + "': " + strerror(e));
+        }
+
+        _imp->data = result;
+        _imp->size = st.st_size;
+    }
+
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_imp->data)
+        munmap(_imp->data, _imp->size);
+}
+
+const char *
+MappedFile::data() const
+{
+    return static_cast<const char *>(_imp->data);
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return _imp->size;
+}
+
+MappedFileError::MappedFileError(const std::string & s) throw () :
+    Exception(s)
+{
+}
+
+namespace paludis
+{
+    template class Pimp<MappedFile>;
+}
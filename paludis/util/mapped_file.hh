@@ -0,0 +1,98 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_MAPPED_FILE_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_MAPPED_FILE_HH 1
+
+#include <paludis/util/mapped_file-fwd.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <cstddef>
+
+/** \file
+ * Declarations for MappedFile.
+ *
+ * \ingroup g_fs
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    /**
+     * A read-only mapping of the contents of a regular file.
+     *
+     * \ingroup g_fs
+     * \since 2.4
+     * \nosubgrouping
+     */
+    class PALUDIS_VISIBLE MappedFile
+    {
+        private:
+            Pimp<MappedFile> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * \throw MappedFileError if the file cannot be opened or mapped.
+             */
+            explicit MappedFile(const FSPath &);
+            ~MappedFile();
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile & operator= (const MappedFile &) = delete;
+
+            ///\}
+
+            /**
+             * The start of the file's contents. May be null if the file is
+             * empty.
+             */
+            const char * data() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * The size of the file, as it was when we mapped it.
+             */
+            std::size_t size() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    /**
+     * Thrown by MappedFile if an error occurs.
+     *
+     * \ingroup g_fs
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE MappedFileError :
+        public Exception
+    {
+        public:
+            MappedFileError(const std::string &) throw ();
+    };
+
+    extern template class Pimp<MappedFile>;
+}
+
+#endif
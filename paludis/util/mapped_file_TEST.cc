@@ -0,0 +1,47 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/fs_path.hh>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+TEST(MappedFile, Contents)
+{
+    MappedFile f(FSPath("mapped_file_TEST_dir/ten_bytes"));
+    ASSERT_EQ(10u, f.size());
+    EXPECT_EQ("0123456789", std::string(f.data(), f.size()));
+}
+
+TEST(MappedFile, Empty)
+{
+    MappedFile f(FSPath("mapped_file_TEST_dir/empty"));
+    EXPECT_EQ(0u, f.size());
+}
+
+TEST(MappedFile, Errors)
+{
+    EXPECT_THROW(MappedFile(FSPath("mapped_file_TEST_dir/no_such_file")), MappedFileError);
+    EXPECT_THROW(MappedFile(FSPath("mapped_file_TEST_dir/dir")), MappedFileError);
+}
@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir mapped_file_TEST_dir || exit 2
+cd mapped_file_TEST_dir || exit 3
+
+echo -n '0123456789' > ten_bytes || exit 4
+touch empty || exit 5
+mkdir dir || exit 6
@@ -919,6 +919,12 @@ Process::setenv(const std::string & a, const std::string & b)
     return *this;
 }
 
+const std::map<std::string, std::string> &
+Process::setenvs() const
+{
+    return _imp->setenvs;
+}
+
 Process &
 Process::clearenv()
 {
@@ -28,6 +28,7 @@
 
 #include <string>
 #include <iosfwd>
+#include <map>
 #include <memory>
 #include <functional>
 #include <initializer_list>
@@ -100,6 +101,9 @@ namespace paludis
             Process & setenv(const std::string &, const std::string &);
             Process & clearenv();
 
+            ///\since 2.4
+            const std::map<std::string, std::string> & setenvs() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             Process & chdir(const FSPath &);
             Process & use_ptys();
             Process & setuid_setgid(uid_t, gid_t);
@@ -0,0 +1,241 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/task_scheduler.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace paludis;
+
+namespace
+{
+    typedef std::function<void ()> Task;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    PALUDIS_TLS const void * current_scheduler = 0;
+    PALUDIS_TLS unsigned current_worker = 0;
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<TaskScheduler>
+    {
+        std::vector<std::unique_ptr<WorkerQueue> > queues;
+        std::vector<std::thread> threads;
+
+        std::atomic<unsigned> queued, outstanding, sleepers, next_queue;
+        std::atomic<bool> cancelled;
+
+        std::mutex mutex;
+        std::condition_variable work_condition, done_condition;
+        std::exception_ptr exception;
+        bool stopping;
+
+        Imp() :
+            queued(0),
+            outstanding(0),
+            sleepers(0),
+            next_queue(0),
+            cancelled(false),
+            stopping(false)
+        {
+        }
+
+        bool take(const unsigned i, Task & task)
+        {
+            {
+                WorkerQueue & q(*queues[i]);
+                std::unique_lock<std::mutex> lock(q.mutex);
+                if (! q.tasks.empty())
+                {
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                    return true;
+                }
+            }
+
+            for (unsigned j(1), j_end(queues.size()) ; j != j_end ; ++j)
+            {
+                WorkerQueue & q(*queues[(i + j) % j_end]);
+                std::unique_lock<std::mutex> lock(q.mutex);
+                if (! q.tasks.empty())
+                {
+                    task = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void work(const unsigned i)
+        {
+            current_scheduler = this;
+            current_worker = i;
+
+            while (true)
+            {
+                Task task;
+                if (take(i, task))
+                {
+                    --queued;
+
+                    if (! cancelled)
+                    {
+                        try
+                        {
+                            task();
+                        }
+                        catch (...)
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            if (! exception)
+                                exception = std::current_exception();
+                            cancelled = true;
+                        }
+                    }
+
+                    task = Task();
+
+                    if (0 == --outstanding)
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        done_condition.notify_all();
+                    }
+
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                ++sleepers;
+                work_condition.wait(lock, [&] () { return stopping || 0 != queued; });
+                --sleepers;
+
+                if (stopping && 0 == queued)
+                    return;
+            }
+        }
+    };
+}
+
+TaskScheduler::TaskScheduler(const unsigned n_workers) :
+    _imp()
+{
+    unsigned n(n_workers);
+    if (0 == n)
+        n = std::thread::hardware_concurrency();
+    if (0 == n)
+        n = 1;
+
+    for (unsigned i(0) ; i != n ; ++i)
+        _imp->queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+
+    for (unsigned i(0) ; i != n ; ++i)
+        _imp->threads.emplace_back(std::bind(&Imp<TaskScheduler>::work, _imp.get(), i));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        _imp->done_condition.wait(lock, [&] () { return 0 == _imp->outstanding; });
+        _imp->stopping = true;
+        _imp->work_condition.notify_all();
+    }
+
+    for (auto & t : _imp->threads)
+        t.join();
+}
+
+void
+TaskScheduler::post(const std::function<void ()> & task)
+{
+    ++_imp->outstanding;
+    ++_imp->queued;
+
+    unsigned i;
+    if (current_scheduler == _imp.get())
+        i = current_worker;
+    else
+        i = _imp->next_queue++ % _imp->queues.size();
+
+    {
+        WorkerQueue & q(*_imp->queues[i]);
+        std::unique_lock<std::mutex> lock(q.mutex);
+        q.tasks.push_back(task);
+    }
+
+    if (0 != _imp->sleepers)
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        _imp->work_condition.notify_one();
+    }
+}
+
+void
+TaskScheduler::wait()
+{
+    std::exception_ptr exception;
+
+    {
+        std::unique_lock<std::mutex> lock(_imp->mutex);
+        _imp->done_condition.wait(lock, [&] () { return 0 == _imp->outstanding; });
+        std::swap(exception, _imp->exception);
+        _imp->cancelled = false;
+    }
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void
+TaskScheduler::cancel()
+{
+    _imp->cancelled = true;
+}
+
+bool
+TaskScheduler::cancelled() const
+{
+    return _imp->cancelled;
+}
+
+unsigned
+TaskScheduler::number_of_workers() const
+{
+    return _imp->threads.size();
+}
+
+namespace paludis
+{
+    template class Pimp<TaskScheduler>;
+}
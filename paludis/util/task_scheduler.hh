@@ -0,0 +1,175 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_TASK_SCHEDULER_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_TASK_SCHEDULER_HH 1
+
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+/** \file
+ * Declarations for the TaskScheduler class.
+ *
+ * \ingroup g_threads
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    namespace task_scheduler_internals
+    {
+        template <typename T_>
+        struct RunTask
+        {
+            static void run(std::promise<T_> & p, const std::function<T_ ()> & f)
+            {
+                p.set_value(f());
+            }
+        };
+
+        template <>
+        struct RunTask<void>
+        {
+            static void run(std::promise<void> & p, const std::function<void ()> & f)
+            {
+                f();
+                p.set_value();
+            }
+        };
+    }
+
+    /**
+     * Runs tasks using a bounded number of worker threads.
+     *
+     * Each worker has its own queue of tasks. Tasks posted from inside a
+     * worker go onto that worker's queue, and an idle worker steals tasks
+     * from the other queues, so tasks which create further tasks (for example,
+     * when walking a directory tree) do not contend upon a single lock.
+     *
+     * If a task throws, any tasks which have not yet started are discarded,
+     * and the exception is rethrown by the next call to wait().
+     *
+     * \ingroup g_threads
+     * \nosubgrouping
+     * \since 2.4
+     */
+    class PALUDIS_VISIBLE TaskScheduler
+    {
+        private:
+            Pimp<TaskScheduler> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * Constructor.
+             *
+             * \param n_workers The number of worker threads to use. If zero,
+             *     one worker per hardware thread is used.
+             */
+            explicit TaskScheduler(const unsigned n_workers = 0);
+
+            /**
+             * Destructor. Waits for any outstanding tasks to finish, but does
+             * not rethrow any exception they threw.
+             */
+            ~TaskScheduler();
+
+            TaskScheduler(const TaskScheduler &) = delete;
+            TaskScheduler & operator= (const TaskScheduler &) = delete;
+
+            ///\}
+
+            /**
+             * Queue a task. Any exception it throws is rethrown by wait().
+             */
+            void post(const std::function<void ()> &);
+
+            /**
+             * Queue a task, and return a future holding its result.
+             *
+             * If the task throws, the exception is held by the future, and
+             * is also rethrown by wait(). If the task is discarded due to an
+             * exception elsewhere, its future holds a std::future_error.
+             */
+            template <typename F_>
+            std::future<typename std::result_of<F_ ()>::type> submit(const F_ & f)
+            {
+                typedef typename std::result_of<F_ ()>::type Result;
+
+                auto promise(std::make_shared<std::promise<Result> >());
+                std::function<Result ()> func(f);
+                post([promise, func] () {
+                        try
+                        {
+                            task_scheduler_internals::RunTask<Result>::run(*promise, func);
+                        }
+                        catch (...)
+                        {
+                            promise->set_exception(std::current_exception());
+                            throw;
+                        }
+                    });
+
+                return promise->get_future();
+            }
+
+            /**
+             * Wait until every queued task, including any queued by other
+             * tasks, has finished or been discarded.
+             *
+             * If any task threw, rethrows the first such exception. The
+             * scheduler may then be used again.
+             *
+             * Must not be called from inside a task.
+             */
+            void wait();
+
+            /**
+             * Discard any tasks which have not yet started. Tasks which are
+             * currently running are not interrupted.
+             */
+            void cancel();
+
+            /**
+             * Has cancel() been called, or has a task thrown, since the last
+             * call to wait()?
+             *
+             * Long running tasks may check this to finish early.
+             */
+            bool cancelled() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * How many worker threads do we have?
+             */
+            unsigned number_of_workers() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    extern template class Pimp<TaskScheduler>;
+}
+
+#endif
@@ -0,0 +1,117 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2014 Ciaran McCreesh
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/task_scheduler.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    void make_one(int & b)
+    {
+        b = 1;
+    }
+
+    void fan_out(TaskScheduler & s, std::atomic<int> & count, const int depth)
+    {
+        ++count;
+        if (depth > 0)
+            for (int x(0) ; x < 4 ; ++x)
+                s.post(std::bind(&fan_out, std::ref(s), std::ref(count), depth - 1));
+    }
+
+    void throw_one()
+    {
+        throw InternalError(PALUDIS_HERE, "oops");
+    }
+}
+
+TEST(TaskScheduler, Works)
+{
+    const int n_tasks = 1000;
+    std::vector<int> t(n_tasks, 0);
+    TaskScheduler s(4);
+    ASSERT_EQ(4u, s.number_of_workers());
+
+    for (int x(0) ; x < n_tasks ; ++x)
+        s.post(std::bind(&make_one, std::ref(t[x])));
+    s.wait();
+
+    ASSERT_EQ(n_tasks, std::count(t.begin(), t.end(), 1));
+}
+
+TEST(TaskScheduler, Nested)
+{
+    std::atomic<int> count(0);
+    TaskScheduler s(3);
+    s.post(std::bind(&fan_out, std::ref(s), std::ref(count), 5));
+    s.wait();
+
+    ASSERT_EQ(1 + 4 + 16 + 64 + 256 + 1024, count.load());
+}
+
+TEST(TaskScheduler, Futures)
+{
+    TaskScheduler s;
+    std::vector<std::future<int> > results;
+    for (int x(0) ; x < 100 ; ++x)
+        results.push_back(s.submit([x] () { return x * x; }));
+
+    for (int x(0) ; x < 100 ; ++x)
+        ASSERT_EQ(x * x, results[x].get());
+}
+
+TEST(TaskScheduler, Exceptions)
+{
+    TaskScheduler s(2);
+    std::future<void> f(s.submit(&throw_one));
+    EXPECT_THROW(s.wait(), InternalError);
+    EXPECT_THROW(f.get(), InternalError);
+    EXPECT_FALSE(s.cancelled());
+
+    std::atomic<int> count(0);
+    s.post(std::bind(&fan_out, std::ref(s), std::ref(count), 0));
+    s.wait();
+    ASSERT_EQ(1, count.load());
+}
+
+TEST(TaskScheduler, Cancel)
+{
+    TaskScheduler s(1);
+    std::atomic<int> count(0);
+    std::promise<void> go;
+    std::shared_future<void> started(go.get_future());
+
+    s.post([&] () { started.wait(); s.cancel(); });
+    for (int x(0) ; x < 100 ; ++x)
+        s.post(std::bind(&fan_out, std::ref(s), std::ref(count), 0));
+    go.set_value();
+    s.wait();
+
+    ASSERT_EQ(0, count.load());
+    ASSERT_FALSE(s.cancelled());
+}
@@ -22,6 +22,7 @@
 
 #include <paludis/util/attributes.hh>
 #include <iosfwd>
+#include <type_traits>
 
 namespace paludis
 {
@@ -31,6 +32,24 @@ namespace paludis
     template <typename Tag_>
     struct WrappedValueTraits;
 
+    /**
+     * Specialise this to derive from std::true_type to make every
+     * WrappedValue<Tag_> with the same value share one pooled copy of it.
+     *
+     * Interned values compare equal by pointer and cache their hash, but
+     * constructing one from an underlying value costs a pool lookup.
+     *
+     * \since 2.4
+     */
+    template <typename Tag_>
+    struct WrappedValueInterned :
+        std::false_type
+    {
+    };
+
+    template <typename Tag_, bool interned_>
+    struct WrappedValueHolder;
+
     template <typename Type_>
     struct WrappedValueDevoid;
 
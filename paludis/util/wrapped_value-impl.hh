@@ -21,10 +21,69 @@
 #define PALUDIS_GUARD_PALUDIS_UTIL_WRAPPED_VALUE_IMPL_HH 1
 
 #include <paludis/util/wrapped_value.hh>
+#include <paludis/util/pool-impl.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/hashes.hh>
 #include <ostream>
 
 namespace paludis
 {
+    template <typename Tag_>
+    struct WrappedValueHolder<Tag_, false>
+    {
+        const typename WrappedValueTraits<Tag_>::UnderlyingType value;
+
+        explicit WrappedValueHolder(const typename WrappedValueTraits<Tag_>::UnderlyingType & v) :
+            value(v)
+        {
+        }
+
+        static const std::shared_ptr<const WrappedValueHolder> create(const typename WrappedValueTraits<Tag_>::UnderlyingType & v)
+        {
+            return std::make_shared<const WrappedValueHolder>(v);
+        }
+
+        static bool same_value(const WrappedValueHolder & a, const WrappedValueHolder & b)
+        {
+            return &a == &b || a.value == b.value;
+        }
+
+        std::size_t hash() const
+        {
+            return Hash<typename WrappedValueTraits<Tag_>::UnderlyingType>()(value);
+        }
+    };
+
+    template <typename Tag_>
+    struct WrappedValueHolder<Tag_, true>
+    {
+        const typename WrappedValueTraits<Tag_>::UnderlyingType value;
+        const std::size_t cached_hash;
+
+        explicit WrappedValueHolder(const typename WrappedValueTraits<Tag_>::UnderlyingType & v) :
+            value(v),
+            cached_hash(Hash<typename WrappedValueTraits<Tag_>::UnderlyingType>()(v))
+        {
+        }
+
+        static const std::shared_ptr<const WrappedValueHolder> create(const typename WrappedValueTraits<Tag_>::UnderlyingType & v)
+        {
+            return Pool<WrappedValueHolder>::get_instance()->create(v);
+        }
+
+        static bool same_value(const WrappedValueHolder & a, const WrappedValueHolder & b)
+        {
+            /* everything comes from the pool, so equal values are the same object */
+            return &a == &b;
+        }
+
+        std::size_t hash() const
+        {
+            return cached_hash;
+        }
+    };
+
     template <typename Tag_, typename Extra_>
     struct WrappedValueValidate
     {
@@ -48,7 +107,7 @@ namespace paludis
             const typename WrappedValueDevoid<typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type & p)
     {
         if (WrappedValueValidate<Tag_, typename WrappedValueTraits<Tag_>::ValidationParamsType>::Type::validate(v, p))
-            _value = std::make_shared<typename WrappedValueTraits<Tag_>::UnderlyingType>(v);
+            _value = WrappedValueHolder<Tag_, WrappedValueInterned<Tag_>::value>::create(v);
         else
             throw typename WrappedValueTraits<Tag_>::ExceptionType(v);
     }
@@ -65,14 +124,21 @@ namespace paludis
     bool
     WrappedValue<Tag_>::WrappedValue::operator< (const WrappedValue & other) const
     {
-        return value() < other.value();
+        return _value != other._value && value() < other.value();
     }
 
     template <typename Tag_>
     bool
     WrappedValue<Tag_>::WrappedValue::operator== (const WrappedValue & other) const
     {
-        return value() == other.value();
+        return WrappedValueHolder<Tag_, WrappedValueInterned<Tag_>::value>::same_value(*_value, *other._value);
+    }
+
+    template <typename Tag_>
+    std::size_t
+    WrappedValue<Tag_>::WrappedValue::hash() const
+    {
+        return _value->hash();
     }
 
     template <typename Tag_>
@@ -90,7 +156,7 @@ namespace paludis
     const typename WrappedValueTraits<Tag_>::UnderlyingType &
     WrappedValue<Tag_>::value() const
     {
-        return *_value;
+        return _value->value;
     }
 
     template <typename Tag_>
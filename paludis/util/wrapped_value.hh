@@ -44,7 +44,7 @@ namespace paludis
         public relational_operators::HasRelationalOperators
     {
         private:
-            std::shared_ptr<const typename WrappedValueTraits<Tag_>::UnderlyingType> _value;
+            std::shared_ptr<const WrappedValueHolder<Tag_, WrappedValueInterned<Tag_>::value> > _value;
 
         public:
             explicit WrappedValue(
@@ -60,6 +60,9 @@ namespace paludis
 
             bool operator< (const WrappedValue &) const PALUDIS_ATTRIBUTE((warn_unused_result));
             bool operator== (const WrappedValue &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            ///\since 2.4
+            std::size_t hash() const PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 }
 
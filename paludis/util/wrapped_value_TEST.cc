@@ -38,6 +38,8 @@ namespace
 
     typedef WrappedValue<struct CheeseTag> Cheese;
 
+    typedef WrappedValue<struct VoleTag> Vole;
+
     struct PALUDIS_VISIBLE NoCheeseError
     {
         NoCheeseError(const std::string &)
@@ -73,6 +75,25 @@ namespace paludis
             return s == "stilton" || (s == "camembert" && ! tasty);
         }
     };
+
+    template <>
+    struct WrappedValueTraits<VoleTag>
+    {
+        typedef std::string UnderlyingType;
+        typedef void ValidationParamsType;
+        typedef NotADormouseError ExceptionType;
+
+        static bool validate(const std::string & s)
+        {
+            return ! s.empty();
+        }
+    };
+
+    template <>
+    struct WrappedValueInterned<VoleTag> :
+        std::true_type
+    {
+    };
 }
 
 TEST(Dormouse, Works)
@@ -99,3 +120,25 @@ TEST(Cheese, Works)
     ASSERT_EQ("camembert", cheese.value());
 }
 
+TEST(Vole, Interned)
+{
+    Vole a("microtus agrestis"), b(std::string("microtus") + " agrestis"), c("arvicola amphibius");
+
+    EXPECT_EQ(&a.value(), &b.value());
+    EXPECT_NE(&a.value(), &c.value());
+
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+    EXPECT_FALSE(a == c);
+    EXPECT_TRUE(c < a);
+    EXPECT_FALSE(a < b);
+}
+
+TEST(Dormouse, NotInterned)
+{
+    Dormouse a("glis glis"), b("glis glis");
+
+    EXPECT_NE(&a.value(), &b.value());
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+}
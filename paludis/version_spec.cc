@@ -30,6 +30,7 @@
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/options.hh>
+#include <paludis/util/hashes.hh>
 #include <paludis/version_spec.hh>
 #include <vector>
 #include <limits>
@@ -58,12 +59,66 @@ namespace paludis
         std::string text;
         Parts parts;
 
+        /* parts, encoded so that compare is a memcmp */
+        std::string key;
+        bool key_usable;
+
         const VersionSpecOptions options;
 
         Imp(const VersionSpecOptions & o) :
+            key_usable(false),
             options(o)
         {
         }
+
+        /* Each part becomes its type, followed by its value. For floatlike
+         * parts the value is the digits with trailing zeroes removed and a
+         * terminating zero byte, and for anything else it is a two byte
+         * length (0xffff for _suffix-scm) followed by the value. Ignorable
+         * parts and trailing zero revisions compare equal to the end of the
+         * version, so they are left out, and then the end of the version is
+         * a vsct_empty type. Anything too long to encode falls back to the
+         * slow comparison. */
+        void make_key()
+        {
+            key.clear();
+            key_usable = false;
+
+            Parts::const_iterator p_end(parts.end());
+            while (p_end != parts.begin() && (
+                        (vsct_revision == previous(p_end)->type() && "0" == previous(p_end)->number_value()) ||
+                        vsct_ignore == previous(p_end)->type()))
+                --p_end;
+
+            for (Parts::const_iterator p(parts.begin()) ; p != p_end ; ++p)
+            {
+                if (vsct_ignore == p->type())
+                    continue;
+
+                key.append(1, static_cast<char>(p->type()));
+                if (vsct_floatlike == p->type())
+                {
+                    const std::string & v(p->number_value());
+                    std::string::size_type n(v.find_last_not_of('0'));
+                    key.append(v, 0, std::string::npos == n ? 0 : n + 1);
+                    key.append(1, '\0');
+                }
+                else if ("MAX" == p->number_value())
+                    key.append(2, '\xff');
+                else
+                {
+                    const std::string & v(p->number_value());
+                    if (v.length() >= 0xffff)
+                        return;
+                    key.append(1, static_cast<char>(v.length() >> 8));
+                    key.append(1, static_cast<char>(v.length() & 0xff));
+                    key.append(v);
+                }
+            }
+
+            key.append(1, static_cast<char>(vsct_empty));
+            key_usable = true;
+        }
     };
 
     template <>
@@ -88,7 +143,7 @@ namespace paludis
 VersionSpec::VersionSpec(const std::string & text, const VersionSpecOptions & options) :
     _imp(options)
 {
-    Context c("When parsing version spec '" + text + "':");
+    Context c("When parsing version spec '", text, "':");
 
     if (text.empty())
         throw BadVersionSpecError(text, "cannot be empty");
@@ -330,6 +385,8 @@ VersionSpec::VersionSpec(const std::string & text, const VersionSpecOptions & op
     /* trailing stuff? */
     if (! parser.eof())
         throw BadVersionSpecError(text, "unexpected trailing text '" + text.substr(parser.offset()) + "'");
+
+    _imp->make_key();
 }
 
 VersionSpec::VersionSpec(const VersionSpec & other) :
@@ -337,6 +394,8 @@ VersionSpec::VersionSpec(const VersionSpec & other) :
 {
     _imp->text = other._imp->text;
     _imp->parts = other._imp->parts;
+    _imp->key = other._imp->key;
+    _imp->key_usable = other._imp->key_usable;
 }
 
 const VersionSpec &
@@ -346,6 +405,8 @@ VersionSpec::operator= (const VersionSpec & other)
     {
         _imp->text = other._imp->text;
         _imp->parts = other._imp->parts;
+        _imp->key = other._imp->key;
+        _imp->key_usable = other._imp->key_usable;
     }
     return *this;
 }
@@ -500,6 +561,12 @@ namespace
 int
 VersionSpec::compare(const VersionSpec & other) const
 {
+    if (_imp->key_usable && other._imp->key_usable)
+    {
+        int c(_imp->key.compare(other._imp->key));
+        return c < 0 ? -1 : c > 0 ? 1 : 0;
+    }
+
     return componentwise_compare(_imp->parts, other._imp->parts, compare_comparator);
 }
 
@@ -524,6 +591,9 @@ VersionSpec::stupid_equal_star_compare(const VersionSpec & other) const
 std::size_t
 VersionSpec::hash() const
 {
+    if (_imp->key_usable)
+        return Hash<std::string>()(_imp->key);
+
     size_t result(0);
 
     const std::size_t h_shift = std::numeric_limits<std::size_t>::digits - 5;
@@ -609,6 +679,7 @@ VersionSpec::remove_revision() const
         if (std::string::npos == result._imp->text.find_first_not_of("0123456789.", p + 2))
             result._imp->text.erase(p);
 
+    result._imp->make_key();
     return result;
 }
 
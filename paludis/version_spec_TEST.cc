@@ -469,6 +469,19 @@ TEST(VersionSpec, Ordering)
     }
 }
 
+TEST(VersionSpec, LongNumbers)
+{
+    std::string big(70000, '9');
+    ASSERT_TRUE(VersionSpec("1." + big, { }) > VersionSpec("1.9", { }));
+    ASSERT_TRUE(VersionSpec("1.9", { }) < VersionSpec("1." + big, { }));
+    ASSERT_TRUE(VersionSpec(big, { }) > VersionSpec("1", { }));
+    ASSERT_TRUE(VersionSpec("1", { }) < VersionSpec(big, { }));
+    ASSERT_TRUE(VersionSpec(big + "-r0", { }) == VersionSpec("0" + big, { }));
+    ASSERT_TRUE(VersionSpec(big + "-r0", { }).hash() == VersionSpec("0" + big, { }).hash());
+    ASSERT_TRUE(VersionSpec(big + "-r1", { }).remove_revision() == VersionSpec(big, { }));
+    ASSERT_TRUE(VersionSpec("1.2-r1", { }).remove_revision().hash() == VersionSpec("1.2", { }).hash());
+}
+
 TEST(VersionSpec, Components)
 {
     VersionSpec v1("1.2x_pre3_rc-scm", { });
@@ -28,9 +28,11 @@
 
 #include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/task_scheduler.hh>
 
 #include <iostream>
 #include <set>
+#include <list>
 #include <algorithm>
 #include <cstdlib>
 
@@ -140,12 +142,22 @@ FixCacheCommand::run(
                 r != r_end; ++r)
             repository_names.insert(r->name());
 
+    TaskScheduler scheduler;
+    std::list<std::future<void> > done;
+
     for (std::set<RepositoryName>::const_iterator r(repository_names.begin()), r_end(repository_names.end()) ;
             r != r_end; ++r)
     {
-        cout << fuc(fs_fixing(), fv<'s'>(stringify(*r)));
         const std::shared_ptr<Repository> repo(env->fetch_repository(*r));
-        repo->regenerate_cache();
+        done.push_back(scheduler.submit(std::bind(&Repository::regenerate_cache, repo)));
+    }
+
+    auto d(done.begin());
+    for (std::set<RepositoryName>::const_iterator r(repository_names.begin()), r_end(repository_names.end()) ;
+            r != r_end; ++r, ++d)
+    {
+        cout << fuc(fs_fixing(), fv<'s'>(stringify(*r)));
+        d->get();
     }
 
     return EXIT_SUCCESS;
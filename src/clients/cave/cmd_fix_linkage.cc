@@ -61,13 +61,16 @@ namespace
         args::ArgsGroup g_linkage_options;
         args::StringSetArg a_libraries;
         args::SwitchArg a_exact;
+        args::StringArg a_cache_file;
 
         FixLinkageCommandLine() :
             g_execution_options(main_options_section(), "Execution Options", "Control execution."),
             a_execute(&g_execution_options, "execute", 'x', "Execute the suggested actions", true),
             g_linkage_options(main_options_section(), "Linkage options", "Options relating to linkage"),
             a_libraries(&g_linkage_options, "library", 'l', "Only rebuild packages linked against this library, even if it exists. May be specified multiple times."),
-            a_exact(&g_linkage_options, "exact", 'e', "Rebuild the same package version that is currently installed", true)
+            a_exact(&g_linkage_options, "exact", 'e', "Rebuild the same package version that is currently installed", true),
+            a_cache_file(&g_linkage_options, "cache-file", '\0', "Remember what was found in each file in this file, so "
+                    "that later runs only need to examine files which have changed.")
         {
             add_usage_line("[ -x|--execute ] [ --library foo.so.1 ] [ -- options for 'cave resolve' ]");
 
@@ -184,7 +187,8 @@ FixLinkageCommand::run(
         DisplayCallback display_callback("Searching: ");
         ScopedNotifierCallback display_callback_holder(env.get(),
                 NotifierCallbackFunction(std::cref(display_callback)));
-        finder = std::make_shared<BrokenLinkageFinder>(env.get(), libraries);
+        finder = std::make_shared<BrokenLinkageFinder>(env.get(), libraries,
+                cmdline.a_cache_file.specified() ? std::make_shared<FSPath>(cmdline.a_cache_file.argument()) : nullptr);
     }
 
     if (finder->begin_broken_packages() == finder->end_broken_packages())
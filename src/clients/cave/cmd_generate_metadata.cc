@@ -28,7 +28,7 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/visitor_cast.hh>
-#include <paludis/util/thread_pool.hh>
+#include <paludis/util/task_scheduler.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/generator.hh>
 #include <paludis/filtered_generator.hh>
@@ -41,12 +41,12 @@
 #include <paludis/metadata_key.hh>
 #include <paludis/notifier_callback.hh>
 #include <paludis/slot.hh>
+#include <paludis/repositories/e/ebuild_metadata_workers.hh>
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
 #include <mutex>
 #include <map>
-#include <thread>
 #include <unistd.h>
 
 #include "command_command_line.hh"
@@ -79,11 +79,18 @@ namespace
         args::ArgsGroup g_filters;
         args::StringSetArg a_matching;
 
+        args::ArgsGroup g_generation_options;
+        args::IntegerArg a_persistent_workers;
+
         GenerateMetadataCommandLine() :
             g_filters(main_options_section(), "Filters", "Filter the output. Each filter may be specified more than once."),
             a_matching(&g_filters, "matching", 'm', "Consider only IDs matching this spec. Note that certain specs "
                     "may force metadata generation anyway, e.g. to see whether a slot matches.",
-                    args::StringSetArg::StringSetArgOptions())
+                    args::StringSetArg::StringSetArgOptions()),
+            g_generation_options(main_options_section(), "Generation Options", "Control how metadata is generated."),
+            a_persistent_workers(&g_generation_options, "persistent-workers", 'w', "Use up to this many long-lived "
+                    "worker processes for each EAPI, rather than starting a new process for every ID. Equivalent to "
+                    "setting PALUDIS_METADATA_WORKERS.")
         {
             add_usage_line("[ --matching spec ]");
         }
@@ -226,43 +233,34 @@ namespace
         void visit(const NotifierCallbackLinkageStepEvent &) const
         {
         }
+
+        void visit(const NotifierCallbackRepositoryInvalidatedEvent &) const
+        {
+        }
     };
 
-    void worker(std::mutex & mutex, PackageIDSequence::ConstIterator & i, const PackageIDSequence::ConstIterator & i_end, bool & fail,
+    void generate_one(std::mutex & mutex, const std::shared_ptr<const PackageID> & id, bool & fail,
             DisplayCallback & display_callback)
     {
-        while (true)
-        {
-            std::shared_ptr<const PackageID> id;
+        for (PackageID::MetadataConstIterator m(id->begin_metadata()), m_end(id->end_metadata()); m_end != m; ++m)
+            try
+            {
+                MetadataVisitor v;
+                (*m)->accept(v);
+            }
+            catch (const InternalError &)
+            {
+                throw;
+            }
+            catch (const Exception & e)
             {
                 std::unique_lock<std::mutex> lock(mutex);
-                if (i != i_end)
-                    id = *i++;
+                std::cerr << "When processing '" << *id << "' got exception '" << e.message() << "' (" << e.what() << ")" << std::endl;
+                fail = true;
+                break;
             }
 
-            if (! id)
-                return;
-
-            for (PackageID::MetadataConstIterator m(id->begin_metadata()), m_end(id->end_metadata()); m_end != m; ++m)
-                try
-                {
-                    MetadataVisitor v;
-                    (*m)->accept(v);
-                }
-                catch (const InternalError &)
-                {
-                    throw;
-                }
-                catch (const Exception & e)
-                {
-                    std::unique_lock<std::mutex> lock(mutex);
-                    std::cerr << "When processing '" << **i << "' got exception '" << e.message() << "' (" << e.what() << ")" << std::endl;
-                    fail = true;
-                    break;
-                }
-
-                display_callback(DoneOne());
-        }
+        display_callback(DoneOne());
     }
 }
 
@@ -284,6 +282,13 @@ GenerateMetadataCommand::run(
     if (cmdline.begin_parameters() != cmdline.end_parameters())
         throw args::DoHelp("generate-metadata takes no parameters");
 
+    if (cmdline.a_persistent_workers.specified())
+    {
+        if (cmdline.a_persistent_workers.argument() < 0)
+            throw args::DoHelp("--" + cmdline.a_persistent_workers.long_name() + " must not be negative");
+        erepository::EbuildMetadataWorkers::get_instance()->set_max_workers_per_key(cmdline.a_persistent_workers.argument());
+    }
+
     Generator g((generator::All()));
     if (cmdline.a_matching.specified())
     {
@@ -300,19 +305,16 @@ GenerateMetadataCommand::run(
     bool fail(false);
     std::mutex mutex;
 
-    PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end());
     {
         DisplayCallback callback;
         callback.total = std::distance(ids->begin(), ids->end());
         ScopedNotifierCallback display_callback_holder(env.get(), NotifierCallbackFunction(std::cref(callback)));
-        ThreadPool pool;
+        TaskScheduler scheduler;
 
-        unsigned n_procs(std::thread::hardware_concurrency());
-        if (n_procs == 0)
-            n_procs = 1;
+        for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ; i != i_end ; ++i)
+            scheduler.post(std::bind(&generate_one, std::ref(mutex), *i, std::ref(fail), std::ref(callback)));
 
-        for (int n(0), n_end(n_procs) ; n != n_end ; ++n)
-            pool.create_thread(std::bind(&worker, std::ref(mutex), std::ref(i), std::cref(i_end), std::ref(fail), std::ref(callback)));
+        scheduler.wait();
     }
 
     return fail ? EXIT_FAILURE : EXIT_SUCCESS;
@@ -47,6 +47,7 @@
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/iterator_funcs.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/task_scheduler.hh>
 
 #include <cstdlib>
 #include <iostream>
@@ -54,6 +55,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 #include <unistd.h>
 
 #include "config.h"
@@ -191,8 +193,32 @@ namespace
         void visit(const NotifierCallbackLinkageStepEvent &) const
         {
         }
+
+        void visit(const NotifierCallbackRepositoryInvalidatedEvent &) const
+        {
+        }
+    };
+
+    struct CandidateDetails
+    {
+        std::string short_desc;
+        std::string long_desc;
+        bool is_visible;
     };
 
+    void get_details(const std::shared_ptr<const PackageID> & id, CandidateDetails & details,
+            const DisplayCallback & display_callback)
+    {
+        display_callback(ManageStep{"Generating metadata"});
+
+        if (id->short_description_key())
+            details.short_desc = id->short_description_key()->parse_value();
+        if (id->long_description_key())
+            details.long_desc = id->long_description_key()->parse_value();
+
+        details.is_visible = ! id->masked();
+    }
+
     struct ManageSearchIndexCommandLine :
         CaveCommandCommandLine
     {
@@ -260,24 +286,33 @@ ManageSearchIndexCommand::run(
 
         display_callback(ManageStep{"Querying"});
         auto ids((*env)[selection::AllVersionsSorted(generator::All())]);
-        display_callback.total = display_callback.steps + std::distance(ids->begin(), ids->end()) + 1;
+        display_callback.total = display_callback.steps + 2 * std::distance(ids->begin(), ids->end()) + 1;
+
+        /* metadata generation is the slow part, so do it in parallel, and
+         * then write everything out in order */
+        std::vector<CandidateDetails> details(std::distance(ids->begin(), ids->end()));
+        {
+            TaskScheduler scheduler;
+            auto d(details.begin());
+            for (auto i(ids->begin()), i_end(ids->end()) ;
+                    i != i_end ; ++i, ++d)
+                scheduler.post(std::bind(&get_details, *i, std::ref(*d), std::cref(display_callback)));
+            scheduler.wait();
+        }
 
         SearchExtrasHandle::get_instance()->starting_adds_function(db);
 
         bool is_best(false), had_best_visible(false);
         std::string old_name;
+        auto d(details.rbegin());
         for (auto i(ids->rbegin()), i_end(ids->rend()) ;
-                i != i_end ; ++i)
+                i != i_end ; ++i, ++d)
         {
             display_callback(ManageStep{"Writing"});
 
-            std::string name(stringify((*i)->name())), short_desc, long_desc;
-            if ((*i)->short_description_key())
-                short_desc = (*i)->short_description_key()->parse_value();
-            if ((*i)->long_description_key())
-                long_desc = (*i)->long_description_key()->parse_value();
-
-            bool is_visible(! (*i)->masked());
+            std::string name(stringify((*i)->name()));
+            const std::string & short_desc(d->short_desc), & long_desc(d->long_desc);
+            bool is_visible(d->is_visible);
 
             if (name != old_name)
             {
@@ -131,14 +131,10 @@ namespace
 
             void operator()(const std::shared_ptr<const PackageID>& package)
             {
-                const auto contents(package->contents());
-
-                if (! contents)
-                    return;
-
-                for (auto entry(contents->begin()), end(contents->end());
-                        entry != end; ++entry)
-                    _contents->insert((*entry)->location_key()->parse_value());
+                package->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & entry) {
+                        _contents->insert(entry->location_key()->parse_value());
+                        return true;
+                        });
             }
 
         private:
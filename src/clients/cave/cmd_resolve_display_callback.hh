@@ -54,6 +54,8 @@ namespace paludis
                 void visit(const NotifierCallbackResolverStageEvent &) const;
 
                 void visit(const NotifierCallbackLinkageStepEvent &) const;
+
+                void visit(const NotifierCallbackRepositoryInvalidatedEvent &) const;
         };
     }
 }
@@ -247,6 +247,10 @@ namespace
         void visit(const NotifierCallbackLinkageStepEvent &) const
         {
         }
+
+        void visit(const NotifierCallbackRepositoryInvalidatedEvent &) const
+        {
+        }
     };
 
     void step(DisplayCallback & display_callback, const std::string & s)
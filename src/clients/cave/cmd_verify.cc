@@ -27,7 +27,6 @@
 #include <paludis/args/do_help.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/make_named_values.hh>
-#include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/md5.hh>
@@ -236,12 +235,11 @@ VerifyCommand::run(
     for (PackageIDSequence::ConstIterator i(entries->begin()), i_end(entries->end()) ;
             i != i_end ; ++i)
     {
-        auto contents((*i)->contents());
-        if (! contents)
-            continue;
-
         Verifier v(*i);
-        std::for_each(indirect_iterator(contents->begin()), indirect_iterator(contents->end()), accept_visitor(v));
+        (*i)->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & e) {
+                e->accept(v);
+                return true;
+                });
         exit_status |= v.exit_status;
     }
 
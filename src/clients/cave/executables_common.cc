@@ -33,7 +33,6 @@
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/fs_stat.hh>
-#include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/system.hh>
 #include <paludis/util/tokeniser.hh>
 
@@ -131,9 +130,10 @@ paludis::cave::executables_common(
     for (auto i(best ? entries->last() : entries->begin()), i_end(entries->end()) ;
             i != i_end ; ++i)
     {
-        auto contents((*i)->contents());
-        if (contents)
-            std::for_each(indirect_iterator(contents->begin()), indirect_iterator(contents->end()), accept_visitor(ed));
+        (*i)->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & e) {
+                e->accept(ed);
+                return true;
+                });
     }
 
     return EXIT_SUCCESS;
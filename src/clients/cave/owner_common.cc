@@ -34,8 +34,10 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/set.hh>
 #include <algorithm>
 #include <functional>
+#include <map>
 
 using namespace paludis;
 
@@ -84,33 +86,63 @@ paludis::cave::owner_common(
     if (query.length() >= 2 && '/' == query.at(query.length() - 1))
         query.erase(query.length() - 1);
 
+    /* full path and basename queries can use a repository's owners index, if
+     * it has one, to avoid loading the contents of every installed ID */
+    bool use_index(false);
+
     if ("full" == type)
+    {
         handler = handle_full;
+        use_index = ! query.empty() && '/' == query.at(0);
+    }
     else if ("basename" == type)
+    {
         handler = handle_basename;
+        use_index = ! query.empty() && std::string::npos == query.find('/');
+    }
     else if ("partial" == type)
         handler = handle_partial;
     else
     {
         if (! query.empty() && '/' == query.at(0))
+        {
             handler = handle_full;
+            use_index = true;
+        }
         else if (std::string::npos != query.find("/"))
             handler = handle_partial;
         else
+        {
             handler = handle_basename;
+            use_index = ! query.empty();
+        }
     }
 
+    std::map<RepositoryName, std::shared_ptr<const PackageIDSet> > candidates;
+
     std::shared_ptr<const PackageIDSequence> ids((*env)[selection::AllVersionsSorted(generator::All() |
                 filter::InstalledAtRoot(env->preferred_root_key()->parse_value()) | matching )]);
 
     for (PackageIDSequence::ConstIterator p(ids->begin()), p_end(ids->end()); p != p_end; ++p)
     {
-        std::shared_ptr<const Contents> contents((*p)->contents());
-        if (! contents)
-            continue;
+        if (use_index)
+        {
+            auto c(candidates.find((*p)->repository_name()));
+            if (candidates.end() == c)
+                c = candidates.insert(std::make_pair((*p)->repository_name(),
+                            env->fetch_repository((*p)->repository_name())->maybe_candidate_owners(query))).first;
+
+            if (c->second && c->second->end() == c->second->find(*p))
+                continue;
+        }
+
+        bool matched(false);
+        (*p)->for_each_contents_entry([&] (const std::shared_ptr<const ContentsEntry> & e) {
+                matched = handler(query, e);
+                return ! matched;
+                });
 
-        if (contents->end() != std::find_if(contents->begin(), contents->end(), std::bind(handler, query,
-                        std::placeholders::_1)))
+        if (matched)
         {
             callback(*p);
             found = true;
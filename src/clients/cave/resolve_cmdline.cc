@@ -437,11 +437,30 @@ ResolveCommandLineProgramOptions::ResolveCommandLineProgramOptions(args::ArgsHan
     a_update_world_program(&g_program_options, "update-world-program", '\0', "The program used to perform "
             "world updates. Defaults to '$CAVE update-world'."),
     a_graph_program(&g_program_options, "graph-program", '\0', "The program used to create Graphviz graphs. "
-            "Defaults to 'dot'.")
+            "Defaults to 'dot'."),
+    a_serialisation_format(&g_program_options, "serialisation-format", '\0', "How resolutions are passed "
+            "to the programs above. The programs accept either format.",
+            args::EnumArg::EnumArgOptions
+            ("binary",                'b', "A compact binary format")
+            ("text",                  't', "A quoted text format, which is easier to debug"),
+            "binary"
+            )
 {
     a_graph_program.set_argument("dot");
 }
 
+SerialiserFormat
+ResolveCommandLineProgramOptions::serialisation_format() const
+{
+    if (a_serialisation_format.argument() == "binary")
+        return sf_binary;
+    else if (a_serialisation_format.argument() == "text")
+        return sf_text;
+    else
+        throw args::DoHelp("Don't understand argument '" + a_serialisation_format.argument() + "' to '--"
+                + a_serialisation_format.long_name() + "'");
+}
+
 ResolveCommandLineImportOptions::ResolveCommandLineImportOptions(args::ArgsHandler * const h) :
     ArgsSection(h, "Import Options"),
     g_import_options(this, "Import Options", "Options controlling additional imported packages. These options "
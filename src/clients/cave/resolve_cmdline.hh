@@ -22,6 +22,7 @@
 
 #include "command_command_line.hh"
 #include <paludis/environment-fwd.hh>
+#include <paludis/serialise-fwd.hh>
 #include <memory>
 #include "config.h"
 
@@ -185,6 +186,9 @@ namespace paludis
             args::StringArg a_perform_program;
             args::StringArg a_update_world_program;
             args::StringArg a_graph_program;
+            args::EnumArg a_serialisation_format;
+
+            SerialiserFormat serialisation_format() const;
         };
 
         struct ResolveCommandLineImportOptions :
@@ -27,6 +27,7 @@
 #include "command_command_line.hh"
 #include "parse_spec_with_nice_error.hh"
 
+#include <paludis/util/log.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/system.hh>
@@ -95,6 +96,7 @@
 
 #include <paludis/user_dep_spec.hh>
 #include <paludis/notifier_callback.hh>
+#include <paludis/selection_cache.hh>
 #include <paludis/environment.hh>
 #include <paludis/serialise-impl.hh>
 #include <paludis/package_id.hh>
@@ -229,11 +231,11 @@ namespace
                     + resolution_options.a_reinstall_scm.long_name() + "'");
     }
 
-    void serialise_resolved(StringListStream & ser_stream, const Resolved & resolved)
+    void serialise_resolved(StringListStream & ser_stream, const Resolved & resolved, const SerialiserFormat format)
     {
         try
         {
-            Serialiser ser(ser_stream);
+            Serialiser ser(ser_stream, format);
             resolved.serialise(ser);
             ser_stream.nothing_more_to_write();
         }
@@ -259,7 +261,8 @@ namespace
         StringListStream ser_stream;
         std::thread ser_thread(std::bind(&serialise_resolved,
                     std::ref(ser_stream),
-                    std::cref(*resolved)));
+                    std::cref(*resolved),
+                    program_options.serialisation_format()));
 
         int result;
 
@@ -337,7 +340,8 @@ namespace
         StringListStream ser_stream;
         std::thread ser_thread(std::bind(&serialise_resolved,
                     std::ref(ser_stream),
-                    std::cref(*resolved)));
+                    std::cref(*resolved),
+                    program_options.serialisation_format()));
 
         std::shared_ptr<Sequence<std::string> > args(std::make_shared<Sequence<std::string>>());
 
@@ -400,9 +404,9 @@ namespace
         return result;
     }
 
-    void serialise_job_lists(StringListStream & ser_stream, const JobLists & job_lists)
+    void serialise_job_lists(StringListStream & ser_stream, const JobLists & job_lists, const SerialiserFormat format)
     {
-        Serialiser ser(ser_stream);
+        Serialiser ser(ser_stream, format);
         job_lists.serialise(ser);
         ser_stream.nothing_more_to_write();
     }
@@ -475,7 +479,7 @@ namespace
         if (program_options.a_execute_resolution_program.specified() || resolution_options.a_execute.specified())
         {
             StringListStream ser_stream;
-            serialise_job_lists(ser_stream, *resolved->job_lists());
+            serialise_job_lists(ser_stream, *resolved->job_lists(), program_options.serialisation_format());
 
             std::string command;
             if (program_options.a_execute_resolution_program.specified())
@@ -600,7 +604,10 @@ namespace
         }
     };
 
+    typedef std::pair<unsigned, unsigned> ReusedAndComputedSteps;
+
     void display_restarts_if_requested(const std::list<SuggestRestart> & restarts,
+            const std::list<ReusedAndComputedSteps> & steps,
             const ResolveCommandLineResolutionOptions & resolution_options)
     {
         if (! resolution_options.a_dump_restarts.specified())
@@ -608,6 +615,11 @@ namespace
 
         std::cout << "Dumping restarts:" << std::endl << std::endl;
 
+        /* the first entry in steps is for before we restarted at all */
+        auto s(steps.begin());
+        if (s != steps.end())
+            ++s;
+
         for (std::list<SuggestRestart>::const_iterator r(restarts.begin()), r_end(restarts.end()) ;
                 r != r_end ; ++r)
         {
@@ -628,6 +640,12 @@ namespace
                 std::cout << ", nothing is fine too";
             std::cout << " " << r->problematic_constraint()->reason()->accept_returning<std::string>(ShortReasonName());
             std::cout << std::endl;
+
+            if (s != steps.end())
+            {
+                std::cout << "    Afterwards, reused " << s->first << " of " << (s->first + s->second) << " steps" << std::endl;
+                ++s;
+            }
         }
 
         std::cout << std::endl;
@@ -1151,6 +1169,7 @@ paludis::cave::resolve_common(
     bool is_set(false);
     std::shared_ptr<const Sequence<std::string> > targets_cleaned_up;
     std::list<SuggestRestart> restarts;
+    std::list<ReusedAndComputedSteps> steps;
 
     try
     {
@@ -1158,6 +1177,7 @@ paludis::cave::resolve_common(
             DisplayCallback display_callback("Resolving: ");
             ScopedNotifierCallback display_callback_holder(env.get(),
                     NotifierCallbackFunction(std::cref(display_callback)));
+            ScopedSelectionCache selection_cache(env.get());
 
             bool first(true);
             while (true)
@@ -1190,14 +1210,16 @@ paludis::cave::resolve_common(
                     }
 
                     resolver->resolve();
+                    steps.push_back(std::make_pair(resolver->reused_steps(), resolver->computed_steps()));
                     break;
                 }
                 catch (const SuggestRestart & e)
                 {
                     restarts.push_back(e);
+                    steps.push_back(std::make_pair(resolver->reused_steps(), resolver->computed_steps()));
                     display_callback(ResolverRestart());
                     get_initial_constraints_for_helper.add_suggested_restart(e);
-                    resolver = std::make_shared<Resolver>(env.get(), resolver_functions);
+                    resolver = resolver->restarted(e);
 
                     if (restarts.size() > 9000)
                         throw InternalError(PALUDIS_HERE, "Restarted over nine thousand times. Something's "
@@ -1205,10 +1227,14 @@ paludis::cave::resolve_common(
                                 "a look.");
                 }
             }
+
+            Log::get_instance()->message("resolve.selection_cache", ll_debug, lc_context)
+                << "Selection cache had " << selection_cache.cache()->hits() << " hits and "
+                << selection_cache.cache()->misses() << " misses";
         }
 
         if (! restarts.empty())
-            display_restarts_if_requested(restarts, resolution_options);
+            display_restarts_if_requested(restarts, steps, resolution_options);
 
         dump_if_requested(env, resolver, resolution_options);
 
@@ -1255,7 +1281,7 @@ paludis::cave::resolve_common(
     catch (...)
     {
         if (! restarts.empty())
-            display_restarts_if_requested(restarts, resolution_options);
+            display_restarts_if_requested(restarts, steps, resolution_options);
 
         dump_if_requested(env, resolver, resolution_options);
         throw;